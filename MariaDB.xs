@@ -227,6 +227,72 @@ more_results(sth)
     OUTPUT:
       RETVAL
 
+void
+mariadb_fetch_chunk(sth, max_rows=&PL_sv_undef)
+    SV *	sth
+    SV *	max_rows
+  PPCODE:
+{
+  D_imp_sth(sth);
+  ST(0) = mariadb_st_fetch_chunk(sth, imp_sth, SvOK(max_rows) ? SvIV(max_rows) : -1);
+  XSRETURN(1);
+}
+
+void
+mariadb_fetch_columns(sth, max_rows=&PL_sv_undef, pack=&PL_sv_undef)
+    SV *	sth
+    SV *	max_rows
+    SV *	pack
+  PPCODE:
+{
+  D_imp_sth(sth);
+  ST(0) = mariadb_st_fetch_columns(sth, imp_sth, SvOK(max_rows) ? SvIV(max_rows) : -1, SvTRUE(pack));
+  XSRETURN(1);
+}
+
+void
+fetchrow_hashref(sth, keyattrib=&PL_sv_undef)
+    SV *	sth
+    SV *	keyattrib
+  PPCODE:
+{
+  D_imp_sth(sth);
+  ST(0) = mariadb_st_fetchrow_hashref(sth, imp_sth, SvOK(keyattrib) ? SvPV_nolen(keyattrib) : NULL);
+  XSRETURN(1);
+}
+
+void
+fetchall_hashref(sth, key_field)
+    SV *	sth
+    SV *	key_field
+  PPCODE:
+{
+  D_imp_sth(sth);
+  ST(0) = mariadb_st_fetchall_hashref(sth, imp_sth, key_field);
+  XSRETURN(1);
+}
+
+void
+_execute_for_fetch(sth, fetch_tuple_sub, tuple_status=&PL_sv_undef)
+    SV *	sth
+    SV *	fetch_tuple_sub
+    SV *	tuple_status
+  PPCODE:
+{
+  IV tuples, rc_total, err_count;
+  int rc;
+  D_imp_sth(sth);
+  rc = mariadb_st_execute_for_fetch(sth, imp_sth, fetch_tuple_sub, tuple_status, &tuples, &rc_total, &err_count);
+  if (rc < 0)
+    XSRETURN_UNDEF;
+  if (rc == 0)
+    XSRETURN_EMPTY;
+  EXTEND(SP, 3);
+  mPUSHi(tuples);
+  mPUSHi(rc_total);
+  mPUSHi(err_count);
+}
+
 SV *
 rows(sth)
     SV* sth
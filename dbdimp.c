@@ -216,93 +216,67 @@ count_params(imp_dbh_t *imp_dbh, pTHX_ char *statement, STRLEN statement_len, bo
 }
 
 /*
-  allocate memory in statement handle per number of placeholders
+  Arrays which live as long as the statement are allocated in one block,
+  size of every array except the last one is rounded up, so the following
+  array is suitably aligned
 */
-static imp_sth_ph_t *alloc_param(int num_params)
-{
-  imp_sth_ph_t *params;
-
-  if (num_params)
-    Newz(908, params, num_params, imp_sth_ph_t);
-  else
-    params= NULL;
-
-  return params;
-}
-
-
-/*
-  allocate memory in MYSQL_BIND bind structure per
-  number of placeholders
-*/
-static MYSQL_BIND *alloc_bind(int num_params)
-{
-  MYSQL_BIND *bind;
-
-  if (num_params)
-    Newz(908, bind, num_params, MYSQL_BIND);
-  else
-    bind= NULL;
-
-  return bind;
-}
+#define ARENA_ALIGN(size) (((size) + 15) & ~(size_t)15)
 
 /*
-  allocate memory in fbind imp_sth_phb_t structure per
-  number of placeholders
+  allocate memory in statement handle per number of placeholders, for
+  server side prepared statement together with MYSQL_BIND bind and
+  imp_sth_phb_t fbind structures; everything is freed by free_param
 */
-static imp_sth_phb_t *alloc_fbind(int num_params)
+static void alloc_param(imp_sth_t *imp_sth, int num_params, bool with_bind)
 {
-  imp_sth_phb_t *fbind;
-
-  if (num_params)
-    Newz(908, fbind, num_params, imp_sth_phb_t);
-  else
-    fbind= NULL;
-
-  return fbind;
-}
-
-/*
-  alloc memory for imp_sth_fbh_t fbuffer per number of fields
-*/
-static imp_sth_fbh_t *alloc_fbuffer(int num_fields)
-{
-  imp_sth_fbh_t *fbh;
-
-  if (num_fields)
-    Newz(908, fbh, num_fields, imp_sth_fbh_t);
-  else
-    fbh= NULL;
-
-  return fbh;
+  size_t params_size= ARENA_ALIGN(num_params * sizeof(imp_sth_ph_t));
+  size_t bind_size= with_bind ? ARENA_ALIGN(num_params * sizeof(MYSQL_BIND)) : 0;
+  size_t fbind_size= with_bind ? num_params * sizeof(imp_sth_phb_t) : 0;
+  char *arena;
+
+  Newxz(arena, params_size + bind_size + fbind_size, char);
+  imp_sth->params= (imp_sth_ph_t *) arena;
+  imp_sth->bind= with_bind ? (MYSQL_BIND *) (arena + params_size) : NULL;
+  imp_sth->fbind= with_bind ? (imp_sth_phb_t *) (arena + params_size + bind_size) : NULL;
 }
 
 /*
-  free MYSQL_BIND bind struct
+  alloc memory for imp_sth_fbh_t fbuffer and MYSQL_BIND buffer per number
+  of fields together with data_size bytes for initial column buffers;
+  returns pointer to the column buffers, everything is freed by free_fbuffer
 */
-static void free_bind(MYSQL_BIND *bind)
+static char *alloc_fbuffer(imp_sth_t *imp_sth, int num_fields, size_t data_size)
 {
-  if (bind)
-    Safefree(bind);
+  size_t fbh_size= ARENA_ALIGN(num_fields * sizeof(imp_sth_fbh_t));
+  size_t buffer_size= ARENA_ALIGN(num_fields * sizeof(MYSQL_BIND));
+  char *arena;
+
+  Newxz(arena, fbh_size + buffer_size + data_size, char);
+  imp_sth->fbh= (imp_sth_fbh_t *) arena;
+  imp_sth->buffer= (MYSQL_BIND *) (arena + fbh_size);
+  imp_sth->fbh_num_fields= num_fields;
+  return arena + fbh_size + buffer_size;
 }
 
 /*
-   free imp_sth_phb_t fbind structure
+  free imp_sth_fbh_t fbh structure with column buffers grown during fetch
 */
-static void free_fbind(imp_sth_phb_t *fbind)
+static void free_fbuffer(imp_sth_t *imp_sth)
 {
-  if (fbind)
-    Safefree(fbind);
-}
+  int i;
 
-/*
-  free imp_sth_fbh_t fbh structure
-*/
-static void free_fbuffer(imp_sth_fbh_t *fbh)
-{
-  if (fbh)
-    Safefree(fbh);
+  if (imp_sth->fbh)
+  {
+    for (i= 0; i < imp_sth->fbh_num_fields; i++)
+    {
+      if (imp_sth->fbh[i].data_allocated)
+        Safefree(imp_sth->fbh[i].data);
+    }
+    Safefree(imp_sth->fbh);
+    imp_sth->fbh= NULL;
+    imp_sth->buffer= NULL;
+    imp_sth->fbh_num_fields= 0;
+  }
 }
 
 /*
@@ -317,13 +291,35 @@ free_param(pTHX_ imp_sth_ph_t *params, int num_params)
     for (i= 0;  i < num_params;  i++)
     {
       imp_sth_ph_t *ph= params+i;
-      if (ph->value)
-        Safefree(ph->value);
+      if (ph->sv)
+        SvREFCNT_dec(ph->sv);
+      if (ph->stream)
+        SvREFCNT_dec(ph->stream);
     }
     Safefree(params);
   }
 }
 
+/*
+  free cached keys of fetchrow_hashref
+*/
+static void
+free_hash_keys(pTHX_ imp_sth_t *imp_sth)
+{
+  mariadb_hash_keys_t *keys = imp_sth->hash_keys;
+  if (keys)
+  {
+    Safefree(keys->attrib);
+    SvREFCNT_dec(keys->names);
+    Safefree(keys->key);
+    Safefree(keys->klen);
+    Safefree(keys->hash);
+    Safefree(keys->row);
+    Safefree(keys);
+    imp_sth->hash_keys = NULL;
+  }
+}
+
 enum perl_type {
   PERL_TYPE_UNDEF,
   PERL_TYPE_INTEGER,
@@ -430,10 +426,64 @@ static bool mysql_type_needs_allocated_buffer(enum enum_field_types type)
   case MYSQL_TYPE_LONGLONG:
   case MYSQL_TYPE_FLOAT:
   case MYSQL_TYPE_DOUBLE:
+  case MYSQL_TYPE_DATE:
+  case MYSQL_TYPE_TIME:
+  case MYSQL_TYPE_DATETIME:
+  case MYSQL_TYPE_TIMESTAMP:
+    return FALSE;
+
+  default:
+    return TRUE;
+  }
+}
+
+/*
+  Returns true if MySQL type is BLOB or TEXT column which is subject of LongReadLen
+*/
+static bool mysql_type_is_long(enum enum_field_types type)
+{
+  switch (type) {
+  case MYSQL_TYPE_TINY_BLOB:
+  case MYSQL_TYPE_MEDIUM_BLOB:
+  case MYSQL_TYPE_LONG_BLOB:
+  case MYSQL_TYPE_BLOB:
+    return TRUE;
+
+  default:
     return FALSE;
+  }
+}
+
+/*
+  Returns true if MySQL type is DATE, TIME, DATETIME or TIMESTAMP
+*/
+static bool mysql_type_is_temporal(enum enum_field_types type)
+{
+  switch (type) {
+  case MYSQL_TYPE_DATE:
+  case MYSQL_TYPE_NEWDATE:
+  case MYSQL_TYPE_TIME:
+  case MYSQL_TYPE_DATETIME:
+  case MYSQL_TYPE_TIMESTAMP:
+    return TRUE;
 
   default:
+    return FALSE;
+  }
+}
+
+/*
+  Returns true if MySQL type is DECIMAL
+*/
+static bool mysql_type_is_decimal(enum enum_field_types type)
+{
+  switch (type) {
+  case MYSQL_TYPE_DECIMAL:
+  case MYSQL_TYPE_NEWDECIMAL:
     return TRUE;
+
+  default:
+    return FALSE;
   }
 }
 
@@ -460,6 +510,51 @@ static bool mysql_field_needs_allocated_buffer(MYSQL_FIELD *field)
     return FALSE;
 }
 
+/*
+  Returns type of MYSQL_BIND buffer into which is column fetched
+*/
+static enum enum_field_types mysql_field_buffer_type(MYSQL_FIELD *field)
+{
+  if (mysql_field_needs_string_type(field))
+    return MYSQL_TYPE_STRING;
+
+  switch (field->type) {
+  case MYSQL_TYPE_NULL:
+  case MYSQL_TYPE_TINY:
+  case MYSQL_TYPE_SHORT:
+  case MYSQL_TYPE_LONG:
+  case MYSQL_TYPE_LONGLONG:
+  case MYSQL_TYPE_FLOAT:
+  case MYSQL_TYPE_DOUBLE:
+  case MYSQL_TYPE_TIME:
+  case MYSQL_TYPE_DATE:
+  case MYSQL_TYPE_DATETIME:
+  case MYSQL_TYPE_TIMESTAMP:
+  case MYSQL_TYPE_BLOB:
+    return field->type;
+
+  default:
+    return MYSQL_TYPE_STRING;
+  }
+}
+
+/*
+  Returns initial size of fetch buffer for column with allocated buffer.
+  Columns with small declared length get buffer for the whole value, so
+  they are never refetched. Buffers of longer columns start small and grow
+  in mariadb_st_fetch_next, the grown size is kept for following rows and
+  executions of the statement.
+*/
+#define FIELD_BUFFER_DECLARED_MAX 4096
+#define FIELD_BUFFER_INITIAL 256
+
+static unsigned long mysql_field_buffer_length(MYSQL_FIELD *field)
+{
+  if (field->length > 0 && field->length <= FIELD_BUFFER_DECLARED_MAX)
+    return field->length;
+  return FIELD_BUFFER_INITIAL;
+}
+
 /*
   Returns true if DBI SQL type should be treated as binary sequence of octets, not UNICODE string
 */
@@ -520,425 +615,1272 @@ PERL_STATIC_INLINE bool mysql_charsetnr_is_utf8(unsigned int id)
       || (id >= 608 && id <= 610) || id == 1057 || (id >= 1069 && id <= 1070) || id == 1107 || id == 1216 || id == 1238 || id == 1248 || id == 1270);
 }
 
-/* 
-  count embedded options
+/*
+  Conversion of text protocol column value to Perl scalar, same for all rows of result set
 */
-static int count_embedded_options(char *st)
+static enum mariadb_conv mysql_field_conv(MYSQL_FIELD *field)
 {
-  int rc;
-  char c;
-  char *ptr;
+  if (mysql_type_is_temporal(field->type))
+    return MARIADB_CONV_TEMPORAL;
 
-  ptr= st;
-  rc= 0;
+  if (mysql_type_is_decimal(field->type))
+    return MARIADB_CONV_DECIMAL;
 
-  if (st)
-  {
-    while ((c= *ptr++))
-    {
-      if (c == ',')
-        rc++;
-    }
-    rc++;
-  }
+  switch (mysql_to_perl_type(field->type)) {
+  case PERL_TYPE_UNDEF:
+    return MARIADB_CONV_NULL;
 
-  return rc;
+  case PERL_TYPE_INTEGER:
+    if (!mysql_field_needs_string_type(field))
+      return (field->flags & UNSIGNED_FLAG) ? MARIADB_CONV_UNSIGNED : MARIADB_CONV_INTEGER;
+    return MARIADB_CONV_BINARY;
+
+  case PERL_TYPE_NUMERIC:
+    if (!mysql_field_needs_string_type(field))
+      return MARIADB_CONV_DOUBLE;
+    return MARIADB_CONV_BINARY;
+
+  default:
+    /* TEXT columns can be returned as MYSQL_TYPE_BLOB, so always check for charset */
+    return mysql_charsetnr_is_utf8(field->charsetnr) ? MARIADB_CONV_UTF8 : MARIADB_CONV_BINARY;
+  }
 }
 
 /*
-  Free embedded options
+  Returns true if fbh and MYSQL_BIND buffers bound by the previous
+  mariadb_st_describe() of server side prepared statement can be used
+  for a new result set with the supplied metadata. Length of columns is
+  not compared, buffers of string columns grow in mariadb_st_fetch_next.
 */
-static int free_embedded_options(char ** options_list, int options_count)
+static bool fbuffer_matches_fields(imp_sth_t *imp_sth, MYSQL_FIELD *fields, int num_fields)
 {
   int i;
+  imp_sth_fbh_t *fbh;
+  MYSQL_BIND *buffer;
 
-  for (i= 0; i < options_count; i++)
-  {
-    if (options_list[i])
-      Safefree(options_list[i]);
+  if (!imp_sth->fbh || imp_sth->fbh_num_fields != num_fields)
+    return FALSE;
+
+  for (
+       fbh= imp_sth->fbh, buffer= imp_sth->buffer, i= 0;
+       i < num_fields;
+       i++, fbh++, buffer++
+      )
+  {
+    if (buffer->buffer_type != mysql_field_buffer_type(&fields[i]) ||
+        !buffer->is_unsigned != !(fields[i].flags & UNSIGNED_FLAG) ||
+        fbh->is_utf8 != mysql_charsetnr_is_utf8(fields[i].charsetnr) ||
+        fbh->decimals != fields[i].decimals ||
+        fbh->is_decimal != mysql_type_is_decimal(fields[i].type))
+      return FALSE;
   }
-  Safefree(options_list);
 
-  return 1;
+  return TRUE;
 }
 
 /*
- Print out embedded option settings
-
+  Parse decimal integer sent by server in text protocol without creating string scalar
+  Returns false if value is not a plain integer or does not fit into UV
 */
-static int print_embedded_options(PerlIO *stream, char ** options_list, int options_count)
+static bool parse_mysql_integer(const char *str, STRLEN len, UV *value, bool *negative)
 {
-  int i;
+  const char *end = str + len;
+  UV val = 0;
+  unsigned int digit;
 
-  for (i=0; i<options_count; i++)
+  *negative = FALSE;
+  if (str < end && *str == '-')
   {
-    if (options_list[i])
-        PerlIO_printf(stream,
-                      "Embedded server, parameter[%d]=%s\n",
-                      i, options_list[i]);
+    *negative = TRUE;
+    str++;
   }
-  return 1;
+
+  if (str == end)
+    return FALSE;
+
+  for (; str < end; str++)
+  {
+    digit = (unsigned char)*str - '0';
+    if (digit > 9 || val > (UV_MAX - digit) / 10)
+      return FALSE;
+    val = val * 10 + digit;
+  }
+
+  *value = val;
+  return TRUE;
 }
 
 /*
-
+  Parse at most max_digits decimal digits, at least one digit is required
 */
-static char **fill_out_embedded_options(char *options,
-                                 int options_type,
-                                 STRLEN slen, int cnt)
+static bool parse_mysql_time_number(const char **str, const char *end, unsigned int max_digits, unsigned long *value)
 {
-  int  ind, len;
-  char c;
-  char *ptr;
-  char **options_list= NULL;
-  dTHX;
+  const char *start = *str;
+  unsigned long val = 0;
 
-  Newz(908, options_list, cnt, char *);
+  while (*str < end && (unsigned int)(*str - start) < max_digits && **str >= '0' && **str <= '9')
+  {
+    val = val * 10 + (**str - '0');
+    (*str)++;
+  }
 
-  ptr= options;
-  ind= 0;
+  if (*str == start)
+    return FALSE;
 
-  if (options_type == 0)
+  *value = val;
+  return TRUE;
+}
+
+/*
+  Parse DATE, TIME, DATETIME or TIMESTAMP value sent by server in text protocol
+  Returns false if value does not have expected format
+*/
+static bool parse_mysql_time(const char *str, STRLEN len, MYSQL_TIME *tm)
+{
+  const char *end = str + len;
+  const char *start;
+  unsigned long val;
+
+  memset(tm, 0, sizeof(*tm));
+
+  if (str < end && *str == '-')
   {
-    /* server_groups list NULL terminated */
-    options_list[cnt]= (char *) NULL;
+    tm->neg = TRUE;
+    str++;
   }
 
-  if (options_type == 1)
+  if (!parse_mysql_time_number(&str, end, 9, &val))
+    return FALSE;
+
+  if (str < end && *str == '-')
   {
-    /* first item in server_options list is ignored. fill it with \0 */
-    Newz(908, options_list[0], 1, char);
-    ind++;
+    if (tm->neg)
+      return FALSE;
+    tm->year = val;
+    str++;
+    if (!parse_mysql_time_number(&str, end, 2, &val) || str == end || *str != '-')
+      return FALSE;
+    tm->month = val;
+    str++;
+    if (!parse_mysql_time_number(&str, end, 2, &val))
+      return FALSE;
+    tm->day = val;
+    tm->time_type = MYSQL_TIMESTAMP_DATE;
+    if (str == end)
+      return TRUE;
+    if (*str != ' ')
+      return FALSE;
+    str++;
+    if (!parse_mysql_time_number(&str, end, 2, &val))
+      return FALSE;
+    tm->hour = val;
+    tm->time_type = MYSQL_TIMESTAMP_DATETIME;
   }
-
-  while ((c= *ptr++))
+  else
   {
-    slen--;
-    if (c == ',' || !slen)
-    {
-      len= ptr - options;
-      if (c == ',')
-        len--;
-      options_list[ind] = savepvn(options, len);
-      ind++;
-      options= ptr;
-    }
+    tm->hour = val;
+    tm->time_type = MYSQL_TIMESTAMP_TIME;
   }
-  return options_list;
-}
 
-#if MYSQL_VERSION_ID < 50001
-/* MySQL client prior to version 5.0.1 does not implement mysql_real_escape_string() for SERVER_STATUS_NO_BACKSLASH_ESCAPES */
-static unsigned long string_escape_quotes(char *to, const char *from, unsigned long len)
-{
-  const char *to_start = to;
-  const char *end = from + len;
+  if (str == end || *str != ':')
+    return FALSE;
+  str++;
+  if (!parse_mysql_time_number(&str, end, 2, &val) || str == end || *str != ':')
+    return FALSE;
+  tm->minute = val;
+  str++;
+  if (!parse_mysql_time_number(&str, end, 2, &val))
+    return FALSE;
+  tm->second = val;
 
-  while (from < end)
+  if (str < end && *str == '.')
   {
-    if (*from == '\'')
-      *to++ = '\'';
-    *to++ = *from++;
+    str++;
+    start = str;
+    if (!parse_mysql_time_number(&str, end, 6, &val))
+      return FALSE;
+    for (len = str - start; len < 6; len++)
+      val *= 10;
+    tm->second_part = val;
   }
 
-  *to = '\0';
-  return to - to_start;
+  return str == end;
 }
-#endif
 
 /*
-  constructs an SQL statement previously prepared with
-  actual values replacing placeholders
+  Number of days from 1970-01-01 in proleptic Gregorian calendar
 */
-static char *parse_params(
-                          imp_xxh_t *imp_xxh,
-                          pTHX_ MYSQL *sock,
-                          char *statement,
-                          STRLEN *slen_ptr,
-                          imp_sth_ph_t* params,
-                          int num_params,
-                          bool bind_type_guessing,
-                          bool bind_comment_placeholders)
+static IV days_from_civil(IV year, unsigned int month, unsigned int day)
 {
-  bool comment_end = FALSE;
-  char *salloc, *statement_ptr;
-  char *statement_ptr_end, *ptr;
-  int i;
-  STRLEN alen;
-  STRLEN slen = *slen_ptr;
-  bool limit_flag = FALSE;
-  int comment_length=0;
-  imp_sth_ph_t *ph;
+  IV era;
+  unsigned int yoe, doy, doe;
+
+  year -= (month <= 2);
+  era = (year >= 0 ? year : year - 399) / 400;
+  yoe = (unsigned int)(year - era * 400);
+  doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (IV)doe - 719468;
+}
 
-  if (DBIc_DBISTATE(imp_xxh)->debug >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh), ">parse_params statement %.1000s%s\n", statement, slen > 1000 ? "..." : "");
+/*
+  Store DATE, TIME, DATETIME or TIMESTAMP value into Perl scalar in requested
+  representation, decimals is number of fractional digits of seconds in string.
+  Format is chosen by column type, time_type of binary value is not reliable:
+  client library leaves it as DATE for zero length or date only values which
+  server sends for zero values and midnight of DATETIME and TIMESTAMP
+*/
+static void mysql_time_to_sv(pTHX_ SV *sv, const MYSQL_TIME *tm, enum enum_field_types type, enum mariadb_temporal_mode mode, unsigned int decimals)
+{
+  char buf[64];
+  int len;
+  unsigned long hour;
+  unsigned long fraction;
+  unsigned int i;
+  NV epoch;
+  AV *av;
+  SV *rv;
+  enum enum_mysql_timestamp_type time_type;
 
-  if (num_params == 0)
-    return NULL;
-
-  while (isspace(*statement))
-  {
-    ++statement;
-    --slen;
+  switch (type) {
+  case MYSQL_TYPE_TIME:
+    time_type = MYSQL_TIMESTAMP_TIME;
+    break;
+  case MYSQL_TYPE_DATE:
+    time_type = MYSQL_TIMESTAMP_DATE;
+    break;
+  case MYSQL_TYPE_DATETIME:
+  case MYSQL_TYPE_TIMESTAMP:
+    time_type = MYSQL_TIMESTAMP_DATETIME;
+    break;
+  default:
+    time_type = tm->time_type;
+    break;
   }
 
-  /* Calculate the number of bytes being allocated for the statement */
-  alen= slen;
-  for (i= 0, ph= params; i < num_params; i++, ph++)
-  {
-    alen--; /* Erase '?' */
-    if (!ph->value)
-      alen += 4;  /* insert 'NULL' */
-    else
-      alen += 3 + 2*ph->len; /* 2 bytes for quotes, one for 'X' and in the worst case two bytes for each character */
-  }
+  hour = tm->hour;
+  if (time_type == MYSQL_TIMESTAMP_TIME)
+    hour += (unsigned long)tm->day * 24;
 
-  /* +1 for null term byte */
-  New(908, salloc, alen+1, char);
-  ptr= salloc;
+  switch (mode) {
+  case MARIADB_TEMPORAL_STRING:
+    switch (time_type) {
+    case MYSQL_TIMESTAMP_DATE:
+      len = sprintf(buf, "%04u-%02u-%02u", tm->year, tm->month, tm->day);
+      decimals = 0;
+      break;
+    case MYSQL_TIMESTAMP_TIME:
+      len = sprintf(buf, "%s%02lu:%02u:%02u", tm->neg ? "-" : "", hour, tm->minute, tm->second);
+      break;
+    case MYSQL_TIMESTAMP_DATETIME:
+      len = sprintf(buf, "%04u-%02u-%02u %02u:%02u:%02u", tm->year, tm->month, tm->day, tm->hour, tm->minute, tm->second);
+      break;
+    default:
+      (void) SvOK_off(sv);
+      return;
+    }
+    /* Same as client library, more than 6 decimals means not fixed number of decimals */
+    if (decimals > 0 && decimals <= 6)
+    {
+      fraction = tm->second_part;
+      for (i = decimals; i < 6; i++)
+        fraction /= 10;
+      len += sprintf(buf + len, ".%0*lu", (int)decimals, fraction);
+    }
+    SvUTF8_off(sv);
+    sv_setpvn(sv, buf, len);
+    break;
 
-  i= 0;
- /* Now create the statement string; compare count_params above */
-  statement_ptr_end= (statement_ptr= statement)+ slen;
+  case MARIADB_TEMPORAL_EPOCH:
+    if (time_type == MYSQL_TIMESTAMP_TIME)
+      epoch = (NV)hour * 3600 + tm->minute * 60 + tm->second;
+    else if ((time_type == MYSQL_TIMESTAMP_DATE || time_type == MYSQL_TIMESTAMP_DATETIME) && tm->month && tm->day)
+      epoch = (NV)days_from_civil(tm->year, tm->month, tm->day) * 86400 + tm->hour * 3600 + tm->minute * 60 + tm->second;
+    else
+    {
+      /* Zero or invalid date */
+      (void) SvOK_off(sv);
+      return;
+    }
+    if (tm->second_part)
+      epoch += tm->second_part / 1000000.0;
+    if (tm->neg)
+      epoch = -epoch;
+    if (!tm->second_part && epoch >= (NV)IV_MIN && epoch <= (NV)IV_MAX)
+      sv_setiv(sv, (IV)epoch);
+    else
+      sv_setnv(sv, epoch);
+    break;
 
-  while (statement_ptr < statement_ptr_end)
-  {
-    /* LIMIT should be the last part of the query, in most cases */
-    if (! limit_flag)
+  case MARIADB_TEMPORAL_ARRAY:
+    if (time_type != MYSQL_TIMESTAMP_DATE && time_type != MYSQL_TIMESTAMP_DATETIME && time_type != MYSQL_TIMESTAMP_TIME)
     {
-      if (statement_ptr+4 < statement_ptr_end)
-      {
-        char *s = statement_ptr;
-        if ((s[0] == 'l' || s[0] == 'L') &&
-            (s[1] == 'i' || s[1] == 'I') &&
-            (s[2] == 'm' || s[2] == 'M') &&
-            (s[3] == 'i' || s[3] == 'I') &&
-            (s[4] == 't' || s[4] == 'T'))
-        {
-          limit_flag = TRUE;
-        }
-      }
+      (void) SvOK_off(sv);
+      return;
     }
-    switch (*statement_ptr)
+    av = newAV();
+    av_extend(av, 6);
+    if (time_type == MYSQL_TIMESTAMP_TIME)
     {
-      /* comment detection. Anything goes in a comment */
-      case '-':
-      {
-          if (bind_comment_placeholders)
-          {
-              *ptr++= *statement_ptr++;
-              break;
-          }
-          else
-          {
-              comment_length= 1;
-              comment_end = FALSE;
-              *ptr++ = *statement_ptr++;
-              if  (*statement_ptr == '-')
-              {
-                  /* ignore everything until newline or end of string */
-                  while (*statement_ptr)
-                  {
-                      comment_length++;
-                      *ptr++ = *statement_ptr++;
-                      if (!*statement_ptr || *statement_ptr == '\n')
-                      {
-                          comment_end = TRUE;
-                          break;
-                      }
-                  }
-                  /* if not end of comment, go back to where we started, no end found */
-                  if (! comment_end)
-                  {
-                      statement_ptr -= comment_length;
-                      ptr -= comment_length;
-                  }
-              }
-              break;
-          }
-      }
-      /* c-type comments */
-      case '/':
-      {
-          if (bind_comment_placeholders)
-          {
-              *ptr++= *statement_ptr++;
-              break;
-          }
-          else
-          {
-              comment_length= 1;
-              comment_end = FALSE;
-              *ptr++ = *statement_ptr++;
-              if  (*statement_ptr == '*')
-              {
-                  /* use up characters everything until newline */
-                  while (*statement_ptr)
-                  {
-                      *ptr++ = *statement_ptr++;
-                      comment_length++;
-                      if (!strncmp(statement_ptr, "*/", 2))
-                      {
-                          comment_length += 2;
-                          comment_end = TRUE;
-                          break;
-                      }
-                  }
-                  /* Go back to where started if comment end not found */
-                  if (! comment_end)
-                  {
-                      statement_ptr -= comment_length;
-                      ptr -= comment_length;
-                  }
-              }
-              break;
-          }
-      }
-      case '`':
-      case '\'':
-      case '"':
-      /* Skip string */
-      {
-        char endToken = *statement_ptr++;
-        *ptr++ = endToken;
-        while (statement_ptr != statement_ptr_end &&
-               *statement_ptr != endToken)
-        {
-          if (*statement_ptr == '\\')
-          {
-            *ptr++ = *statement_ptr++;
-            if (statement_ptr == statement_ptr_end)
-	      break;
-	  }
-          *ptr++= *statement_ptr++;
-	}
-	if (statement_ptr != statement_ptr_end)
-          *ptr++= *statement_ptr++;
-      }
-      break;
+      /* TIME is interval, all components of negative value are negative */
+      av_push(av, newSViv(0));
+      av_push(av, newSViv(0));
+      av_push(av, newSViv(0));
+      av_push(av, newSViv(tm->neg ? -(IV)hour : (IV)hour));
+      av_push(av, newSViv(tm->neg ? -(IV)tm->minute : (IV)tm->minute));
+      av_push(av, newSViv(tm->neg ? -(IV)tm->second : (IV)tm->second));
+      av_push(av, newSViv(tm->neg ? -(IV)tm->second_part * 1000 : (IV)tm->second_part * 1000));
+    }
+    else
+    {
+      av_push(av, newSViv(tm->year));
+      av_push(av, newSViv(tm->month));
+      av_push(av, newSViv(tm->day));
+      av_push(av, newSViv(tm->hour));
+      av_push(av, newSViv(tm->minute));
+      av_push(av, newSViv(tm->second));
+      av_push(av, newSViv((IV)tm->second_part * 1000));
+    }
+    rv = newRV_noinc((SV *)av);
+    sv_setsv(sv, rv);
+    SvREFCNT_dec(rv);
+    break;
+  }
+}
 
-      case '?':
-        /* Insert parameter */
-        statement_ptr++;
-        if (i >= num_params)
-        {
-          break;
-        }
+/*
+  Parse value of mariadb_temporal_mode attribute
+*/
+static bool parse_temporal_mode(pTHX_ SV *h, SV *value, enum mariadb_temporal_mode *mode)
+{
+  STRLEN len;
+  const char *str = SvOK(value) ? SvPV_nomg(value, len) : (len = 0, "");
+
+  if (len == 0 || memEQs(str, len, "string"))
+    *mode = MARIADB_TEMPORAL_STRING;
+  else if (memEQs(str, len, "epoch"))
+    *mode = MARIADB_TEMPORAL_EPOCH;
+  else if (memEQs(str, len, "array"))
+    *mode = MARIADB_TEMPORAL_ARRAY;
+  else
+  {
+    mariadb_dr_do_error(h, CR_UNKNOWN_ERROR, "Valid values for mariadb_temporal_mode are 'string', 'epoch' and 'array'", "HY000");
+    return FALSE;
+  }
+  return TRUE;
+}
 
-        ph = params+ (i++);
-        if (!ph->value)
-        {
-          *ptr++ = 'N';
-          *ptr++ = 'U';
-          *ptr++ = 'L';
-          *ptr++ = 'L';
-        }
-        else
-        {
-          bool quote_value, is_value_num;
-
-          is_value_num = is_mysql_number(ph->value, ph->len);
-
-          if (limit_flag && is_value_num)
-            /* After a LIMIT clause must be unquoted numeric value */
-            quote_value = FALSE;
-          else if (bind_type_guessing && !ph->type)
-            /* If SQL type was not specified and bind_type_guessing is enabled, then quote only if needed */
-            quote_value = !is_value_num;
-          else if (sql_type_is_numeric(ph->type))
-            /* If SQL type is numeric then quote only in case value is not numeric */
-            quote_value = !is_value_num;
-          else
-            /* Otherwise always quote */
-            quote_value = TRUE;
+/*
+  Returns value of mariadb_temporal_mode attribute
+*/
+static SV *temporal_mode_sv(pTHX_ enum mariadb_temporal_mode mode)
+{
+  switch (mode) {
+  case MARIADB_TEMPORAL_EPOCH:
+    return sv_2mortal(newSVpvs("epoch"));
+  case MARIADB_TEMPORAL_ARRAY:
+    return sv_2mortal(newSVpvs("array"));
+  default:
+    return sv_2mortal(newSVpvs("string"));
+  }
+}
 
-          if (quote_value)
-          {
-#if MYSQL_VERSION_ID < 50001
-            if (sock->server_status & SERVER_STATUS_NO_BACKSLASH_ESCAPES)
-            {
-              *ptr++ = '\'';
-              ptr += string_escape_quotes(ptr, ph->value, ph->len);
-              *ptr++ = '\'';
-            }
-            else
-#endif
-            {
-            *ptr++ = '\'';
-#if !defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 50706 && MYSQL_VERSION_ID != 60000
-            ptr += mysql_real_escape_string_quote(sock, ptr, ph->value, ph->len, '\'');
-#else
-            ptr += mysql_real_escape_string(sock, ptr, ph->value, ph->len);
-#endif
-            *ptr++ = '\'';
-            }
-          }
-          else
-          {
-            memcpy(ptr, ph->value, ph->len);
-            ptr += ph->len;
-          }
-        }
-        break;
+/*
+  Store value of column bound by bind_col with numeric TYPE directly as IV or
+  NV, returns false when value is not a number and has to be stored as string
+*/
+static bool store_bound_number(pTHX_ SV *sv, const char *str, STRLEN len, IV sql_type)
+{
+  char buf[128];
+  UV uv_val;
+  bool negative;
 
-	/* in case this is a nested LIMIT */
-      case ')':
-        /* in case this is a column named "limit" */
-      case '=':
-        limit_flag = FALSE;
-	*ptr++ = *statement_ptr++;
-        break;
+  switch (sql_type) {
+  case SQL_BOOLEAN:
+  case SQL_TINYINT:
+  case SQL_SMALLINT:
+  case SQL_INTEGER:
+  case SQL_BIGINT:
+    if (!parse_mysql_integer(str, len, &uv_val, &negative))
+      return FALSE;
+    if (!negative && uv_val <= (UV)IV_MAX)
+      sv_setiv(sv, (IV)uv_val);
+    else if (!negative)
+      sv_setuv(sv, uv_val);
+    else if (uv_val <= (UV)IV_MAX+1)
+      sv_setiv(sv, -(IV)(uv_val-1)-1);
+    else
+      return FALSE;
+    return TRUE;
 
-      default:
-        *ptr++ = *statement_ptr++;
-        break;
+  case SQL_FLOAT:
+  case SQL_DOUBLE:
+  case SQL_REAL:
+    /* Value of server side prepared statement is not nul terminated */
+    if (len >= sizeof(buf))
+      return FALSE;
+    Copy(str, buf, len, char);
+    buf[len] = '\0';
+    if (!grok_number(buf, len, NULL))
+      return FALSE;
+    sv_setnv(sv, Atof(buf));
+    return TRUE;
 
-    }
+  /* SQL_NUMERIC and SQL_DECIMAL values would lose precision in NV, so they
+     are stored according to mariadb_decimal_mode like unbound columns */
+  default:
+    return FALSE;
   }
-
-  *slen_ptr = ptr - salloc;
-  *ptr++ = '\0';
-
-  return(salloc);
 }
 
-static void bind_param(imp_sth_ph_t *ph, SV *value, IV sql_type)
+/*
+  Parse DECIMAL value sent by server as string into integer scaled by 10^scale
+  Returns false if value is not a plain decimal number or does not fit into UV
+*/
+static bool parse_mysql_decimal_scaled(const char *str, STRLEN len, unsigned int scale, UV *value, bool *negative)
 {
-  dTHX;
-  char *buf;
+  const char *end = str + len;
+  UV val = 0;
+  unsigned int digit;
+  unsigned int frac_digits = 0;
+  bool fraction = FALSE;
 
-  if (ph->value)
+  *negative = FALSE;
+  if (str < end && *str == '-')
   {
-    Safefree(ph->value);
-    ph->value = NULL;
+    *negative = TRUE;
+    str++;
   }
 
-  ph->bound = TRUE;
+  if (str == end)
+    return FALSE;
 
-  if (sql_type)
-    ph->type = sql_type;
+  for (; str < end; str++)
+  {
+    if (*str == '.' && !fraction)
+    {
+      fraction = TRUE;
+      continue;
+    }
+    digit = (unsigned char)*str - '0';
+    if (digit > 9 || val > (UV_MAX - digit) / 10)
+      return FALSE;
+    val = val * 10 + digit;
+    if (fraction)
+      frac_digits++;
+  }
+
+  if (frac_digits > scale)
+    return FALSE;
 
-  if (SvOK(value))
+  for (; frac_digits < scale; frac_digits++)
   {
-    if (sql_type_is_binary(ph->type))
-      buf = SvPVbyte_nomg(value, ph->len); /* Ensure that buf is always byte orientated */
-    else
-      buf = SvPVutf8_nomg(value, ph->len); /* Ensure that buf is always UTF-8 encoded */
-    ph->value = savepvn(buf, ph->len);
+    if (val > UV_MAX / 10)
+      return FALSE;
+    val *= 10;
   }
+
+  *value = val;
+  return TRUE;
 }
 
-static const sql_type_info_t SQL_GET_TYPE_INFO_values[]= {
-  { "varchar",    SQL_VARCHAR,                    255, "'",  "'",  "max length",
-    1, 0, 3, 0, 0, 0, "variable length string",
-    0, 0, 0,
-    SQL_VARCHAR, 0, 0,
-    MYSQL_TYPE_STRING,  0,
-  },
-  { "decimal",   SQL_DECIMAL,                      15, NULL, NULL, "precision,scale",
-    1, 0, 3, 0, 0, 0, "double",
-    0, 6, 2,
-    SQL_DECIMAL, 0, 0,
+/*
+  Store DECIMAL value sent by server as string into Perl scalar in requested
+  representation, scale is number of digits after decimal point
+*/
+static void mysql_decimal_to_sv(pTHX_ SV *sv, const char *str, STRLEN len, enum mariadb_decimal_mode mode, unsigned int scale)
+{
+  char buf[128];
+  UV uv_val;
+  bool negative;
+
+  switch (mode) {
+  case MARIADB_DECIMAL_NV:
+    /* Value of server side prepared statement is not nul terminated */
+    if (len < sizeof(buf))
+    {
+      Copy(str, buf, len, char);
+      buf[len] = '\0';
+      sv_setnv(sv, Atof(buf));
+      return;
+    }
+    break;
+
+  case MARIADB_DECIMAL_IV_SCALED:
+    if (parse_mysql_decimal_scaled(str, len, scale, &uv_val, &negative))
+    {
+      if (!negative && uv_val <= (UV)IV_MAX)
+      {
+        sv_setiv(sv, (IV)uv_val);
+        return;
+      }
+      else if (negative && uv_val <= (UV)IV_MAX+1)
+      {
+        sv_setiv(sv, -(IV)(uv_val-1)-1);
+        return;
+      }
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  /* Value which cannot be converted is returned as string */
+  SvUTF8_off(sv);
+  sv_setpvn(sv, str, len);
+}
+
+/*
+  Parse value of mariadb_decimal_mode attribute
+*/
+static bool parse_decimal_mode(pTHX_ SV *h, SV *value, enum mariadb_decimal_mode *mode)
+{
+  STRLEN len;
+  const char *str = SvOK(value) ? SvPV_nomg(value, len) : (len = 0, "");
+
+  if (len == 0 || memEQs(str, len, "string"))
+    *mode = MARIADB_DECIMAL_STRING;
+  else if (memEQs(str, len, "nv"))
+    *mode = MARIADB_DECIMAL_NV;
+  else if (memEQs(str, len, "iv_scaled"))
+    *mode = MARIADB_DECIMAL_IV_SCALED;
+  else
+  {
+    mariadb_dr_do_error(h, CR_UNKNOWN_ERROR, "Valid values for mariadb_decimal_mode are 'string', 'nv' and 'iv_scaled'", "HY000");
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/*
+  Returns value of mariadb_decimal_mode attribute
+*/
+static SV *decimal_mode_sv(pTHX_ enum mariadb_decimal_mode mode)
+{
+  switch (mode) {
+  case MARIADB_DECIMAL_NV:
+    return sv_2mortal(newSVpvs("nv"));
+  case MARIADB_DECIMAL_IV_SCALED:
+    return sv_2mortal(newSVpvs("iv_scaled"));
+  default:
+    return sv_2mortal(newSVpvs("string"));
+  }
+}
+
+/* 
+  count embedded options
+*/
+static int count_embedded_options(char *st)
+{
+  int rc;
+  char c;
+  char *ptr;
+
+  ptr= st;
+  rc= 0;
+
+  if (st)
+  {
+    while ((c= *ptr++))
+    {
+      if (c == ',')
+        rc++;
+    }
+    rc++;
+  }
+
+  return rc;
+}
+
+/*
+  Free embedded options
+*/
+static int free_embedded_options(char ** options_list, int options_count)
+{
+  int i;
+
+  for (i= 0; i < options_count; i++)
+  {
+    if (options_list[i])
+      Safefree(options_list[i]);
+  }
+  Safefree(options_list);
+
+  return 1;
+}
+
+/*
+ Print out embedded option settings
+
+*/
+static int print_embedded_options(PerlIO *stream, char ** options_list, int options_count)
+{
+  int i;
+
+  for (i=0; i<options_count; i++)
+  {
+    if (options_list[i])
+        PerlIO_printf(stream,
+                      "Embedded server, parameter[%d]=%s\n",
+                      i, options_list[i]);
+  }
+  return 1;
+}
+
+/*
+
+*/
+static char **fill_out_embedded_options(char *options,
+                                 int options_type,
+                                 STRLEN slen, int cnt)
+{
+  int  ind, len;
+  char c;
+  char *ptr;
+  char **options_list= NULL;
+  dTHX;
+
+  Newz(908, options_list, cnt, char *);
+
+  ptr= options;
+  ind= 0;
+
+  if (options_type == 0)
+  {
+    /* server_groups list NULL terminated */
+    options_list[cnt]= (char *) NULL;
+  }
+
+  if (options_type == 1)
+  {
+    /* first item in server_options list is ignored. fill it with \0 */
+    Newz(908, options_list[0], 1, char);
+    ind++;
+  }
+
+  while ((c= *ptr++))
+  {
+    slen--;
+    if (c == ',' || !slen)
+    {
+      len= ptr - options;
+      if (c == ',')
+        len--;
+      options_list[ind] = savepvn(options, len);
+      ind++;
+      options= ptr;
+    }
+  }
+  return options_list;
+}
+
+#if MYSQL_VERSION_ID < 50001
+/* MySQL client prior to version 5.0.1 does not implement mysql_real_escape_string() for SERVER_STATUS_NO_BACKSLASH_ESCAPES */
+static unsigned long string_escape_quotes(char *to, const char *from, unsigned long len)
+{
+  const char *to_start = to;
+  const char *end = from + len;
+
+  while (from < end)
+  {
+    if (*from == '\'')
+      *to++ = '\'';
+    *to++ = *from++;
+  }
+
+  *to = '\0';
+  return to - to_start;
+}
+#endif
+
+/*
+  Returns true if characters escaped by escape_string() are always single
+  bytes in connection charset and never part of other multibyte character,
+  then escape_string() gives same result as mysql_real_escape_string()
+*/
+static bool mysql_charset_is_escape_safe(MYSQL *sock)
+{
+  const char *name = mysql_character_set_name(sock);
+  return (strEQ(name, "utf8mb4") || strEQ(name, "utf8") || strEQ(name, "utf8mb3") ||
+          strEQ(name, "binary") || strEQ(name, "latin1") || strEQ(name, "ascii"));
+}
+
+/*
+  Returns true if character has to be escaped in quoted string literal
+*/
+PERL_STATIC_INLINE bool char_needs_escape(char c, bool no_backslash_escapes)
+{
+  if (no_backslash_escapes)
+    return c == '\'';
+  return c == '\'' || c == '\\' || c == '"' || c == '\0' || c == '\n' || c == '\r' || c == '\032';
+}
+
+/*
+  Returns pointer to the first character between from and end which has to
+  be escaped, or end if there is no such character
+*/
+static const char *find_char_to_escape(const char *from, const char *end, bool no_backslash_escapes)
+{
+#ifdef __SSE2__
+  const __m128i quote = _mm_set1_epi8('\'');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i dquote = _mm_set1_epi8('"');
+  const __m128i nul = _mm_setzero_si128();
+  const __m128i lf = _mm_set1_epi8('\n');
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i ctrlz = _mm_set1_epi8('\032');
+  __m128i chunk, found;
+  int mask;
+
+  while (end - from >= 16)
+  {
+    chunk = _mm_loadu_si128((const __m128i *)from);
+    found = _mm_cmpeq_epi8(chunk, quote);
+    if (!no_backslash_escapes)
+    {
+      found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, backslash));
+      found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, dquote));
+      found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, nul));
+      found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, lf));
+      found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, cr));
+      found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, ctrlz));
+    }
+    mask = _mm_movemask_epi8(found);
+    if (mask)
+      return from + __builtin_ctz(mask);
+    from += 16;
+  }
+#endif
+
+  while (from < end && !char_needs_escape(*from, no_backslash_escapes))
+    from++;
+  return from;
+}
+
+/*
+  Returns number of characters in string which has to be escaped
+*/
+static STRLEN count_chars_to_escape(const char *from, STRLEN len, bool no_backslash_escapes)
+{
+  const char *end = from + len;
+  STRLEN count = 0;
+
+  while ((from = find_char_to_escape(from, end, no_backslash_escapes)) < end)
+  {
+    count++;
+    from++;
+  }
+
+  return count;
+}
+
+/*
+  Escapes string for quoted string literal in the same way as
+  mysql_real_escape_string() when mysql_charset_is_escape_safe() is true,
+  runs of characters without escaping are copied at once; returns number
+  of written bytes, which is len plus count_chars_to_escape()
+*/
+static STRLEN escape_string(char *to, const char *from, STRLEN len, bool no_backslash_escapes)
+{
+  const char *to_start = to;
+  const char *end = from + len;
+  const char *next;
+
+  while ((next = find_char_to_escape(from, end, no_backslash_escapes)) < end)
+  {
+    memcpy(to, from, next - from);
+    to += next - from;
+    if (no_backslash_escapes)
+    {
+      *to++ = '\'';
+      *to++ = '\'';
+    }
+    else
+    {
+      *to++ = '\\';
+      switch (*next) {
+      case '\0':   *to++ = '0'; break;
+      case '\n':   *to++ = 'n'; break;
+      case '\r':   *to++ = 'r'; break;
+      case '\032': *to++ = 'Z'; break;
+      default:     *to++ = *next; break;
+      }
+    }
+    from = next + 1;
+  }
+
+  memcpy(to, from, end - from);
+  to += end - from;
+  return to - to_start;
+}
+
+/*
+  finds positions of placeholders in SQL statement previously prepared with
+  client side prepare, leading whitespaces of statement are skipped; returns
+  number of placeholders stored into newly allocated *placeholders_ptr
+*/
+static int parse_placeholders(
+                              imp_xxh_t *imp_xxh,
+                              char *statement,
+                              STRLEN slen,
+                              bool bind_comment_placeholders,
+                              imp_sth_placeholder_t **placeholders_ptr)
+{
+  bool comment_end = FALSE;
+  char *statement_ptr, *statement_ptr_end;
+  bool limit_flag = FALSE;
+  int comment_length=0;
+  int num_placeholders = 0;
+  int max_placeholders = 0;
+  imp_sth_placeholder_t *placeholders = NULL;
+
+  if (DBIc_DBISTATE(imp_xxh)->debug >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), ">parse_placeholders statement %.1000s%s\n", statement, slen > 1000 ? "..." : "");
+
+  while (isspace(*statement))
+  {
+    ++statement;
+    --slen;
+  }
+
+  statement_ptr_end= (statement_ptr= statement)+ slen;
+
+  while (statement_ptr < statement_ptr_end)
+  {
+    /* LIMIT should be the last part of the query, in most cases */
+    if (! limit_flag)
+    {
+      if (statement_ptr+4 < statement_ptr_end)
+      {
+        char *s = statement_ptr;
+        if ((s[0] == 'l' || s[0] == 'L') &&
+            (s[1] == 'i' || s[1] == 'I') &&
+            (s[2] == 'm' || s[2] == 'M') &&
+            (s[3] == 'i' || s[3] == 'I') &&
+            (s[4] == 't' || s[4] == 'T'))
+        {
+          limit_flag = TRUE;
+        }
+      }
+    }
+    switch (*statement_ptr)
+    {
+      /* comment detection. Anything goes in a comment */
+      case '-':
+      {
+          if (bind_comment_placeholders)
+          {
+              statement_ptr++;
+              break;
+          }
+          else
+          {
+              comment_length= 1;
+              comment_end = FALSE;
+              statement_ptr++;
+              if  (*statement_ptr == '-')
+              {
+                  /* ignore everything until newline or end of string */
+                  while (*statement_ptr)
+                  {
+                      comment_length++;
+                      statement_ptr++;
+                      if (!*statement_ptr || *statement_ptr == '\n')
+                      {
+                          comment_end = TRUE;
+                          break;
+                      }
+                  }
+                  /* if not end of comment, go back to where we started, no end found */
+                  if (! comment_end)
+                      statement_ptr -= comment_length;
+              }
+              break;
+          }
+      }
+      /* c-type comments */
+      case '/':
+      {
+          if (bind_comment_placeholders)
+          {
+              statement_ptr++;
+              break;
+          }
+          else
+          {
+              comment_length= 1;
+              comment_end = FALSE;
+              statement_ptr++;
+              if  (*statement_ptr == '*')
+              {
+                  /* use up characters everything until newline */
+                  while (*statement_ptr)
+                  {
+                      statement_ptr++;
+                      comment_length++;
+                      if (!strncmp(statement_ptr, "*/", 2))
+                      {
+                          comment_length += 2;
+                          comment_end = TRUE;
+                          break;
+                      }
+                  }
+                  /* Go back to where started if comment end not found */
+                  if (! comment_end)
+                      statement_ptr -= comment_length;
+              }
+              break;
+          }
+      }
+      case '`':
+      case '\'':
+      case '"':
+      /* Skip string */
+      {
+        char endToken = *statement_ptr++;
+        while (statement_ptr != statement_ptr_end &&
+               *statement_ptr != endToken)
+        {
+          if (*statement_ptr == '\\')
+          {
+            statement_ptr++;
+            if (statement_ptr == statement_ptr_end)
+              break;
+          }
+          statement_ptr++;
+        }
+        if (statement_ptr != statement_ptr_end)
+          statement_ptr++;
+      }
+      break;
+
+      case '?':
+        /* Remember position of parameter */
+        if (num_placeholders >= max_placeholders)
+        {
+          max_placeholders = max_placeholders ? 2*max_placeholders : 8;
+          Renew(placeholders, max_placeholders, imp_sth_placeholder_t);
+        }
+        placeholders[num_placeholders].offset = statement_ptr - statement;
+        placeholders[num_placeholders].limit = limit_flag;
+        num_placeholders++;
+        statement_ptr++;
+        break;
+
+      /* in case this is a nested LIMIT */
+      case ')':
+        /* in case this is a column named "limit" */
+      case '=':
+        limit_flag = FALSE;
+        statement_ptr++;
+        break;
+
+      default:
+        statement_ptr++;
+        break;
+
+    }
+  }
+
+  *placeholders_ptr = placeholders;
+  return num_placeholders;
+}
+
+/*
+  constructs an SQL statement previously prepared with actual values
+  replacing placeholders found by parse_placeholders; placeholders after
+  the last parameter are removed. Statement is constructed in *buffer_ptr
+  of *buffer_size_ptr bytes which grows when needed, or in newly allocated
+  memory when buffer_ptr is NULL
+*/
+static char *substitute_params(
+                               pTHX_ MYSQL *sock,
+                               char *statement,
+                               STRLEN *slen_ptr,
+                               imp_sth_ph_t* params,
+                               int num_params,
+                               bool bind_type_guessing,
+                               const imp_sth_placeholder_t *placeholders,
+                               int num_placeholders,
+                               char **buffer_ptr,
+                               STRLEN *buffer_size_ptr)
+{
+  char *salloc, *statement_ptr;
+  char *ptr;
+  int i;
+  STRLEN alen;
+  STRLEN slen = *slen_ptr;
+  STRLEN len;
+  bool escape_safe, no_backslash_escapes;
+  imp_sth_ph_t *ph;
+
+  if (num_params == 0)
+    return NULL;
+
+  while (isspace(*statement))
+  {
+    ++statement;
+    --slen;
+  }
+
+  /* Escaping is done by driver itself when connection charset allows it */
+  escape_safe = mysql_charset_is_escape_safe(sock);
+  no_backslash_escapes = (sock->server_status & SERVER_STATUS_NO_BACKSLASH_ESCAPES) ? TRUE : FALSE;
+
+  /* Calculate the number of bytes being allocated for the statement */
+  alen= slen;
+  for (i= 0, ph= params; i < num_params; i++, ph++)
+  {
+    alen--; /* Erase '?' */
+    if (!ph->value)
+      alen += 4;  /* insert 'NULL' */
+    else if (ph->is_int)
+      alen += 2 + ph->len; /* 2 bytes for quotes, digits are never escaped */
+    else if (escape_safe)
+      alen += 2 + ph->len + count_chars_to_escape(ph->value, ph->len, no_backslash_escapes); /* 2 bytes for quotes and one more for each escaped character */
+    else
+      alen += 3 + 2*ph->len; /* 2 bytes for quotes, one for 'X' and in the worst case two bytes for each character */
+  }
+
+  /* +1 for null term byte */
+  if (!buffer_ptr)
+    New(908, salloc, alen+1, char);
+  else
+  {
+    if (*buffer_size_ptr < alen+1)
+    {
+      /* Previous statement is not needed, so it is not copied by Renew */
+      Safefree(*buffer_ptr);
+      New(908, *buffer_ptr, alen+1, char);
+      *buffer_size_ptr = alen+1;
+    }
+    salloc= *buffer_ptr;
+  }
+  ptr= salloc;
+
+  /* Now create the statement string from literal parts between placeholders */
+  statement_ptr= statement;
+
+  for (i= 0; i < num_placeholders; i++)
+  {
+    len= statement + placeholders[i].offset - statement_ptr;
+    memcpy(ptr, statement_ptr, len);
+    ptr += len;
+    statement_ptr += len + 1;
+
+    /* Insert parameter */
+    if (i >= num_params)
+      continue;
+
+    ph = params+i;
+    if (!ph->value)
+    {
+      *ptr++ = 'N';
+      *ptr++ = 'U';
+      *ptr++ = 'L';
+      *ptr++ = 'L';
+    }
+    else
+    {
+      bool quote_value, is_value_num;
+
+      is_value_num = ph->is_int || is_mysql_number(ph->value, ph->len);
+
+      if (placeholders[i].limit && is_value_num)
+        /* After a LIMIT clause must be unquoted numeric value */
+        quote_value = FALSE;
+      else if (bind_type_guessing && !ph->type)
+        /* If SQL type was not specified and bind_type_guessing is enabled, then quote only if needed */
+        quote_value = !is_value_num;
+      else if (sql_type_is_numeric(ph->type))
+        /* If SQL type is numeric then quote only in case value is not numeric */
+        quote_value = !is_value_num;
+      else
+        /* Otherwise always quote */
+        quote_value = TRUE;
+
+      if (quote_value && (escape_safe || ph->is_int))
+      {
+        *ptr++ = '\'';
+        ptr += escape_string(ptr, ph->value, ph->len, no_backslash_escapes);
+        *ptr++ = '\'';
+      }
+      else if (quote_value)
+      {
+#if MYSQL_VERSION_ID < 50001
+        if (no_backslash_escapes)
+        {
+          *ptr++ = '\'';
+          ptr += string_escape_quotes(ptr, ph->value, ph->len);
+          *ptr++ = '\'';
+        }
+        else
+#endif
+        {
+        *ptr++ = '\'';
+#if !defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 50706 && MYSQL_VERSION_ID != 60000
+        ptr += mysql_real_escape_string_quote(sock, ptr, ph->value, ph->len, '\'');
+#else
+        ptr += mysql_real_escape_string(sock, ptr, ph->value, ph->len);
+#endif
+        *ptr++ = '\'';
+        }
+      }
+      else
+      {
+        memcpy(ptr, ph->value, ph->len);
+        ptr += ph->len;
+      }
+    }
+  }
+
+  len= statement + slen - statement_ptr;
+  memcpy(ptr, statement_ptr, len);
+  ptr += len;
+
+  *slen_ptr = ptr - salloc;
+  *ptr++ = '\0';
+
+  return(salloc);
+}
+
+/*
+  constructs an SQL statement previously prepared with
+  actual values replacing placeholders
+*/
+static char *parse_params(
+                          imp_xxh_t *imp_xxh,
+                          pTHX_ MYSQL *sock,
+                          char *statement,
+                          STRLEN *slen_ptr,
+                          imp_sth_ph_t* params,
+                          int num_params,
+                          bool bind_type_guessing,
+                          bool bind_comment_placeholders)
+{
+  char *salloc;
+  int num_placeholders;
+  imp_sth_placeholder_t *placeholders;
+
+  if (num_params == 0)
+    return NULL;
+
+  num_placeholders = parse_placeholders(imp_xxh, statement, *slen_ptr, bind_comment_placeholders, &placeholders);
+  salloc = substitute_params(aTHX_ sock, statement, slen_ptr, params, num_params, bind_type_guessing, placeholders, num_placeholders, NULL, NULL);
+  Safefree(placeholders);
+
+  return salloc;
+}
+
+static bool is_ascii_buffer(const char *buf, STRLEN len)
+{
+  const char *end = buf + len;
+  while (buf < end)
+  {
+    if ((U8)*buf++ >= 0x80)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/*
+  Writes decimal representation of integer into nul terminated buffer of ph
+  and returns its length
+*/
+static STRLEN format_int_param(imp_sth_ph_t *ph)
+{
+  char digits[sizeof(ph->int_buf)];
+  char *ptr = digits + sizeof(digits);
+  bool negative = !ph->int_is_unsigned && ph->int_val < 0;
+  UV uv = ph->int_is_unsigned ? (UV)ph->int_val : negative ? (UV)0 - (UV)ph->int_val : (UV)ph->int_val;
+  STRLEN len;
+
+  do
+  {
+    *--ptr = '0' + (uv % 10);
+    uv /= 10;
+  } while (uv);
+
+  if (negative)
+    *--ptr = '-';
+
+  len = digits + sizeof(digits) - ptr;
+  memcpy(ph->int_buf, ptr, len);
+  ph->int_buf[len] = '\0';
+  return len;
+}
+
+static void bind_param(imp_sth_ph_t *ph, SV *value, IV sql_type)
+{
+  dTHX;
+  char *buf;
+
+  if (ph->sv)
+  {
+    SvREFCNT_dec(ph->sv);
+    ph->sv = NULL;
+  }
+  if (ph->stream)
+  {
+    SvREFCNT_dec(ph->stream);
+    ph->stream = NULL;
+  }
+  ph->value = NULL;
+  ph->len = 0;
+  ph->is_int = FALSE;
+
+  ph->bound = TRUE;
+
+  if (sql_type)
+    ph->type = sql_type;
+
+  if (SvIOK(value) && !SvPOK(value))
+  {
+    /*
+     * Integer without string representation is kept as number and its
+     * decimal representation is written into buffer of ph, which is same
+     * as stringified value; so no private SV and no encoding is needed.
+     */
+    ph->is_int = TRUE;
+    ph->int_is_unsigned = SvIsUV(value) ? TRUE : FALSE;
+    ph->int_val = SvIVX(value);
+    ph->len = format_int_param(ph);
+    ph->value = ph->int_buf;
+  }
+  else if (SvOK(value))
+  {
+    /*
+     * Keep private copy of value, so later changes of bound SV do not affect
+     * it. On perls with copy-on-write the copy shares string buffer with the
+     * bound SV, so large values are not copied. Encoding is done in the copy
+     * and is needed only for values which are not already encoded.
+     */
+    ph->sv = newSVsv_nomg(value);
+    if (sql_type_is_binary(ph->type))
+      buf = SvPVbyte(ph->sv, ph->len); /* Ensure that buf is always byte orientated */
+    else
+    {
+      buf = SvPV(ph->sv, ph->len);
+      /* ASCII string is already UTF-8 encoded, upgrade would unshare buffer */
+      if (!SvUTF8(ph->sv) && !is_ascii_buffer(buf, ph->len))
+        buf = SvPVutf8(ph->sv, ph->len); /* Ensure that buf is always UTF-8 encoded */
+    }
+    ph->value = buf;
+  }
+}
+
+static const sql_type_info_t SQL_GET_TYPE_INFO_values[]= {
+  { "varchar",    SQL_VARCHAR,                    255, "'",  "'",  "max length",
+    1, 0, 3, 0, 0, 0, "variable length string",
+    0, 0, 0,
+    SQL_VARCHAR, 0, 0,
+    MYSQL_TYPE_STRING,  0,
+  },
+  { "decimal",   SQL_DECIMAL,                      15, NULL, NULL, "precision,scale",
+    1, 0, 3, 0, 0, 0, "double",
+    0, 6, 2,
+    SQL_DECIMAL, 0, 0,
     MYSQL_TYPE_DECIMAL,     1
   },
   { "tinyint",   SQL_TINYINT,                       3, NULL, NULL, NULL,
@@ -1013,4634 +1955,6793 @@ static const sql_type_info_t SQL_GET_TYPE_INFO_values[]= {
     SQL_TIMESTAMP, 0, 0,
     MYSQL_TYPE_DATETIME,     0
   },
-  { "year", SQL_SMALLINT, 4, NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "year",
-    0, 0, 10,
-    SQL_SMALLINT, 0, 0,
-    MYSQL_TYPE_YEAR,     1
+  { "year", SQL_SMALLINT, 4, NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "year",
+    0, 0, 10,
+    SQL_SMALLINT, 0, 0,
+    MYSQL_TYPE_YEAR,     1
+  },
+  { "date", SQL_DATE, 10, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "date",
+    0, 0, 0,
+    SQL_DATE, 0, 0,
+    MYSQL_TYPE_NEWDATE,     0
+  },
+  { "enum",      SQL_VARCHAR,                     255, "'",  "'",  NULL,
+    1, 0, 1, 0, 0, 0, "enum(value1,value2,value3...)",
+    0, 0, 0,
+    0, 0, 0,
+    MYSQL_TYPE_ENUM,     0
+  },
+  { "set",       SQL_VARCHAR,                     255, "'",  "'",  NULL,
+    1, 0, 1, 0, 0, 0, "set(value1,value2,value3...)",
+    0, 0, 0,
+    0, 0, 0,
+    MYSQL_TYPE_SET,     0
+  },
+  { "blob",       SQL_LONGVARBINARY,              65535, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "binary large object (0-65535)",
+    0, 0, 0,
+    SQL_LONGVARBINARY, 0, 0,
+    MYSQL_TYPE_BLOB,     0
+  },
+  { "tinyblob",  SQL_VARBINARY,                 255, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "binary large object (0-255) ",
+    0, 0, 0,
+    SQL_VARBINARY, 0, 0,
+    MYSQL_TYPE_TINY_BLOB,        0
+  },
+  { "mediumblob", SQL_LONGVARBINARY,           16777215, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "binary large object",
+    0, 0, 0,
+    SQL_LONGVARBINARY, 0, 0,
+    MYSQL_TYPE_MEDIUM_BLOB, 0
+  },
+  { "longblob",   SQL_LONGVARBINARY,         2147483647, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "binary large object, use mediumblob instead",
+    0, 0, 0,
+    SQL_LONGVARBINARY, 0, 0,
+    MYSQL_TYPE_LONG_BLOB,   0
+  },
+  { "char",       SQL_CHAR,                       255, "'",  "'",  "max length",
+    1, 0, 3, 0, 0, 0, "string",
+    0, 0, 0,
+    SQL_CHAR, 0, 0,
+    MYSQL_TYPE_STRING,   0
+  },
+
+  { "decimal",            SQL_NUMERIC,            15,  NULL, NULL, "precision,scale",
+    1, 0, 3, 0, 0, 0, "double",
+    0, 6, 2,
+    SQL_NUMERIC, 0, 0,
+    MYSQL_TYPE_DECIMAL,   1 
+  },
+  { "tinyint unsigned",   SQL_TINYINT,              3, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "Tiny integer unsigned",
+    0, 0, 10,
+    SQL_TINYINT, 0, 0,
+    MYSQL_TYPE_TINY,        1
+  },
+  { "smallint unsigned",  SQL_SMALLINT,             5, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "Short integer unsigned",
+    0, 0, 10,
+    SQL_SMALLINT, 0, 0,
+    MYSQL_TYPE_SHORT,       1
+  },
+  { "mediumint unsigned", SQL_INTEGER,              8, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "Medium integer unsigned",
+    0, 0, 10,
+    SQL_INTEGER, 0, 0,
+    MYSQL_TYPE_INT24,       1
+  },
+  { "int unsigned",       SQL_INTEGER,             10, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "integer unsigned",
+    0, 0, 10,
+    SQL_INTEGER, 0, 0,
+    MYSQL_TYPE_LONG,        1
+  },
+  { "int",                SQL_INTEGER,             10, NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "integer",
+    0, 0, 10,
+    SQL_INTEGER, 0, 0,
+    MYSQL_TYPE_LONG,        1
+  },
+  { "integer unsigned",   SQL_INTEGER,             10, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "integer",
+    0, 0, 10,
+    SQL_INTEGER, 0, 0,
+    MYSQL_TYPE_LONG,        1
+  },
+  { "bigint unsigned",    SQL_BIGINT,              20, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "Longlong integer unsigned",
+    0, 0, 10,
+    SQL_BIGINT, 0, 0,
+    MYSQL_TYPE_LONGLONG,    1
+  },
+  { "text",               SQL_LONGVARCHAR,      65535, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "large text object (0-65535)",
+    0, 0, 0,
+    SQL_LONGVARCHAR, 0, 0,
+    MYSQL_TYPE_BLOB,        0
+  },
+  { "mediumtext",         SQL_LONGVARCHAR,   16777215, "'",  "'",  NULL,
+    1, 0, 3, 0, 0, 0, "large text object",
+    0, 0, 0,
+    SQL_LONGVARCHAR, 0, 0,
+    MYSQL_TYPE_MEDIUM_BLOB, 0
+  },
+  { "mediumint unsigned auto_increment", SQL_INTEGER, 8, NULL, NULL, NULL,
+    0, 0, 3, 1, 0, 1, "Medium integer unsigned auto_increment", 0, 0, 10,
+    SQL_INTEGER, 0, 0, MYSQL_TYPE_INT24, 1,
+  },
+  { "tinyint unsigned auto_increment", SQL_TINYINT, 3, NULL, NULL, NULL,
+    0, 0, 3, 1, 0, 1, "tinyint unsigned auto_increment", 0, 0, 10,
+    SQL_TINYINT, 0, 0, MYSQL_TYPE_TINY, 1
+  },
+
+  { "smallint auto_increment", SQL_SMALLINT, 5, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "smallint auto_increment", 0, 0, 10,
+    SQL_SMALLINT, 0, 0, MYSQL_TYPE_SHORT, 1
+  },
+
+  { "int unsigned auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
+    0, 0, 3, 1, 0, 1, "integer unsigned auto_increment", 0, 0, 10,
+    SQL_INTEGER, 0, 0, MYSQL_TYPE_LONG, 1
+  },
+
+  { "mediumint", SQL_INTEGER, 7, NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "Medium integer", 0, 0, 10,
+    SQL_INTEGER, 0, 0, MYSQL_TYPE_INT24, 1
+  },
+
+  { "bit", SQL_BIT, 1, NULL, NULL, NULL,
+    1, 0, 3, 0, 0, 0, "bit", 0, 0, 0,
+    SQL_BIT, 0, 0,
+#if MYSQL_VERSION_ID >= NEW_DATATYPE_VERSION
+    MYSQL_TYPE_BIT,
+#else
+    MYSQL_TYPE_TINY,
+#endif
+    0
+  },
+
+  { "numeric", SQL_NUMERIC, 19, NULL, NULL, "precision,scale",
+    1, 0, 3, 0, 0, 0, "numeric", 0, 19, 10,
+    SQL_NUMERIC, 0, 0, MYSQL_TYPE_DECIMAL, 1,
+  },
+
+  { "integer unsigned auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
+    0, 0, 3, 1, 0, 1, "integer unsigned auto_increment", 0, 0, 10,
+    SQL_INTEGER, 0, 0, MYSQL_TYPE_LONG, 1,
+  },
+
+  { "mediumint unsigned", SQL_INTEGER, 8, NULL, NULL, NULL,
+    1, 0, 3, 1, 0, 0, "Medium integer unsigned", 0, 0, 10,
+    SQL_INTEGER, 0, 0, MYSQL_TYPE_INT24, 1
+  },
+
+  { "smallint unsigned auto_increment", SQL_SMALLINT, 5, NULL, NULL, NULL,
+    0, 0, 3, 1, 0, 1, "smallint unsigned auto_increment", 0, 0, 10,
+    SQL_SMALLINT, 0, 0, MYSQL_TYPE_SHORT, 1
+  },
+
+  { "int auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "integer auto_increment", 0, 0, 10,
+    SQL_INTEGER, 0, 0, MYSQL_TYPE_LONG, 1
+  },
+
+  { "long varbinary", SQL_LONGVARBINARY, 16777215, "0x", NULL, NULL,
+    1, 0, 3, 0, 0, 0, "mediumblob", 0, 0, 0,
+    SQL_LONGVARBINARY, 0, 0, MYSQL_TYPE_LONG_BLOB, 0
+  },
+
+  { "double auto_increment", SQL_FLOAT, 15, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "double auto_increment", 0, 4, 2,
+    SQL_FLOAT, 0, 0, MYSQL_TYPE_DOUBLE, 1
   },
-  { "date", SQL_DATE, 10, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "date",
-    0, 0, 0,
-    SQL_DATE, 0, 0,
-    MYSQL_TYPE_NEWDATE,     0
+
+  { "double auto_increment", SQL_DOUBLE, 15, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "double auto_increment", 0, 4, 10,
+    SQL_DOUBLE, 0, 0, MYSQL_TYPE_DOUBLE, 1
   },
-  { "enum",      SQL_VARCHAR,                     255, "'",  "'",  NULL,
-    1, 0, 1, 0, 0, 0, "enum(value1,value2,value3...)",
-    0, 0, 0,
-    0, 0, 0,
-    MYSQL_TYPE_ENUM,     0
+
+  { "integer auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "integer auto_increment", 0, 0, 10,
+    SQL_INTEGER, 0, 0, MYSQL_TYPE_LONG, 1,
   },
-  { "set",       SQL_VARCHAR,                     255, "'",  "'",  NULL,
-    1, 0, 1, 0, 0, 0, "set(value1,value2,value3...)",
-    0, 0, 0,
-    0, 0, 0,
-    MYSQL_TYPE_SET,     0
+
+  { "bigint auto_increment", SQL_BIGINT, 19, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "bigint auto_increment", 0, 0, 10,
+    SQL_BIGINT, 0, 0, MYSQL_TYPE_LONGLONG,
+#if IVSIZE < 8
+    0
+#else
+    1
+#endif
   },
-  { "blob",       SQL_LONGVARBINARY,              65535, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "binary large object (0-65535)",
-    0, 0, 0,
-    SQL_LONGVARBINARY, 0, 0,
-    MYSQL_TYPE_BLOB,     0
+
+  { "bit auto_increment", SQL_BIT, 1, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "bit auto_increment", 0, 0, 0,
+    SQL_BIT, 0, 0,
+#if MYSQL_VERSION_ID >= NEW_DATATYPE_VERSION
+    MYSQL_TYPE_BIT,
+#else
+    MYSQL_TYPE_TINY,
+#endif
+    0
   },
-  { "tinyblob",  SQL_VARBINARY,                 255, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "binary large object (0-255) ",
-    0, 0, 0,
-    SQL_VARBINARY, 0, 0,
-    MYSQL_TYPE_TINY_BLOB,        0
+
+  { "mediumint auto_increment", SQL_INTEGER, 7, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "Medium integer auto_increment", 0, 0, 10,
+    SQL_INTEGER, 0, 0, MYSQL_TYPE_INT24, 1
   },
-  { "mediumblob", SQL_LONGVARBINARY,           16777215, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "binary large object",
-    0, 0, 0,
-    SQL_LONGVARBINARY, 0, 0,
-    MYSQL_TYPE_MEDIUM_BLOB, 0
+
+  { "float auto_increment", SQL_REAL, 7, NULL, NULL, NULL,
+    0, 0, 0, 0, 0, 1, "float auto_increment", 0, 2, 10,
+    SQL_FLOAT, 0, 0, MYSQL_TYPE_FLOAT, 1
   },
-  { "longblob",   SQL_LONGVARBINARY,         2147483647, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "binary large object, use mediumblob instead",
-    0, 0, 0,
-    SQL_LONGVARBINARY, 0, 0,
-    MYSQL_TYPE_LONG_BLOB,   0
+
+  { "long varchar", SQL_LONGVARCHAR, 16777215, "'", "'", NULL,
+    1, 0, 3, 0, 0, 0, "mediumtext", 0, 0, 0,
+    SQL_LONGVARCHAR, 0, 0, MYSQL_TYPE_MEDIUM_BLOB, 1
   },
-  { "char",       SQL_CHAR,                       255, "'",  "'",  "max length",
-    1, 0, 3, 0, 0, 0, "string",
-    0, 0, 0,
-    SQL_CHAR, 0, 0,
-    MYSQL_TYPE_STRING,   0
+
+  { "tinyint auto_increment", SQL_TINYINT, 3, NULL, NULL, NULL,
+    0, 0, 3, 0, 0, 1, "tinyint auto_increment", 0, 0, 10,
+    SQL_TINYINT, 0, 0, MYSQL_TYPE_TINY, 1
+  },
+
+  { "bigint unsigned auto_increment", SQL_BIGINT, 20, NULL, NULL, NULL,
+    0, 0, 3, 1, 0, 1, "bigint unsigned auto_increment", 0, 0, 10,
+    SQL_BIGINT, 0, 0, MYSQL_TYPE_LONGLONG,
+#if IVSIZE < 8
+    0
+#else
+    1
+#endif
   },
 
-  { "decimal",            SQL_NUMERIC,            15,  NULL, NULL, "precision,scale",
-    1, 0, 3, 0, 0, 0, "double",
-    0, 6, 2,
-    SQL_NUMERIC, 0, 0,
-    MYSQL_TYPE_DECIMAL,   1 
-  },
-  { "tinyint unsigned",   SQL_TINYINT,              3, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "Tiny integer unsigned",
-    0, 0, 10,
-    SQL_TINYINT, 0, 0,
-    MYSQL_TYPE_TINY,        1
-  },
-  { "smallint unsigned",  SQL_SMALLINT,             5, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "Short integer unsigned",
-    0, 0, 10,
-    SQL_SMALLINT, 0, 0,
-    MYSQL_TYPE_SHORT,       1
-  },
-  { "mediumint unsigned", SQL_INTEGER,              8, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "Medium integer unsigned",
-    0, 0, 10,
-    SQL_INTEGER, 0, 0,
-    MYSQL_TYPE_INT24,       1
-  },
-  { "int unsigned",       SQL_INTEGER,             10, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "integer unsigned",
-    0, 0, 10,
-    SQL_INTEGER, 0, 0,
-    MYSQL_TYPE_LONG,        1
-  },
-  { "int",                SQL_INTEGER,             10, NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "integer",
-    0, 0, 10,
-    SQL_INTEGER, 0, 0,
-    MYSQL_TYPE_LONG,        1
-  },
-  { "integer unsigned",   SQL_INTEGER,             10, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "integer",
-    0, 0, 10,
-    SQL_INTEGER, 0, 0,
-    MYSQL_TYPE_LONG,        1
-  },
-  { "bigint unsigned",    SQL_BIGINT,              20, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "Longlong integer unsigned",
-    0, 0, 10,
-    SQL_BIGINT, 0, 0,
-    MYSQL_TYPE_LONGLONG,    1
-  },
-  { "text",               SQL_LONGVARCHAR,      65535, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "large text object (0-65535)",
-    0, 0, 0,
-    SQL_LONGVARCHAR, 0, 0,
-    MYSQL_TYPE_BLOB,        0
-  },
-  { "mediumtext",         SQL_LONGVARCHAR,   16777215, "'",  "'",  NULL,
-    1, 0, 3, 0, 0, 0, "large text object",
-    0, 0, 0,
-    SQL_LONGVARCHAR, 0, 0,
-    MYSQL_TYPE_MEDIUM_BLOB, 0
-  },
-  { "mediumint unsigned auto_increment", SQL_INTEGER, 8, NULL, NULL, NULL,
-    0, 0, 3, 1, 0, 1, "Medium integer unsigned auto_increment", 0, 0, 10,
-    SQL_INTEGER, 0, 0, MYSQL_TYPE_INT24, 1,
-  },
-  { "tinyint unsigned auto_increment", SQL_TINYINT, 3, NULL, NULL, NULL,
-    0, 0, 3, 1, 0, 1, "tinyint unsigned auto_increment", 0, 0, 10,
-    SQL_TINYINT, 0, 0, MYSQL_TYPE_TINY, 1
-  },
+/* END MORE STUFF */
+};
+
+/* 
+  static const sql_type_info_t* native2sql (int t)
+*/
+static const sql_type_info_t *native2sql(int t)
+{
+  switch (t) {
+    case MYSQL_TYPE_VAR_STRING:  return &SQL_GET_TYPE_INFO_values[0];
+    case MYSQL_TYPE_DECIMAL:     return &SQL_GET_TYPE_INFO_values[1];
+    case MYSQL_TYPE_NEWDECIMAL:  return &SQL_GET_TYPE_INFO_values[1];
+    case MYSQL_TYPE_TINY:        return &SQL_GET_TYPE_INFO_values[2];
+    case MYSQL_TYPE_SHORT:       return &SQL_GET_TYPE_INFO_values[3];
+    case MYSQL_TYPE_LONG:        return &SQL_GET_TYPE_INFO_values[4];
+    case MYSQL_TYPE_FLOAT:       return &SQL_GET_TYPE_INFO_values[5];
+    case MYSQL_TYPE_NULL:        return &SQL_GET_TYPE_INFO_values[6];
+    case MYSQL_TYPE_DOUBLE:      return &SQL_GET_TYPE_INFO_values[7];
+    case MYSQL_TYPE_TIMESTAMP:   return &SQL_GET_TYPE_INFO_values[8];
+    case MYSQL_TYPE_LONGLONG:    return &SQL_GET_TYPE_INFO_values[9];
+    case MYSQL_TYPE_INT24:       return &SQL_GET_TYPE_INFO_values[10];
+    case MYSQL_TYPE_DATE:        return &SQL_GET_TYPE_INFO_values[11];
+    case MYSQL_TYPE_TIME:        return &SQL_GET_TYPE_INFO_values[12];
+    case MYSQL_TYPE_DATETIME:    return &SQL_GET_TYPE_INFO_values[13];
+    case MYSQL_TYPE_YEAR:        return &SQL_GET_TYPE_INFO_values[14];
+    case MYSQL_TYPE_NEWDATE:     return &SQL_GET_TYPE_INFO_values[15];
+    case MYSQL_TYPE_ENUM:        return &SQL_GET_TYPE_INFO_values[16];
+    case MYSQL_TYPE_SET:         return &SQL_GET_TYPE_INFO_values[17];
+    case MYSQL_TYPE_BLOB:        return &SQL_GET_TYPE_INFO_values[18];
+    case MYSQL_TYPE_TINY_BLOB:   return &SQL_GET_TYPE_INFO_values[19];
+    case MYSQL_TYPE_MEDIUM_BLOB: return &SQL_GET_TYPE_INFO_values[20];
+    case MYSQL_TYPE_LONG_BLOB:   return &SQL_GET_TYPE_INFO_values[21];
+    case MYSQL_TYPE_STRING:      return &SQL_GET_TYPE_INFO_values[22];
+    case MYSQL_TYPE_BIT:         return &SQL_GET_TYPE_INFO_values[38];
+    default:                     return &SQL_GET_TYPE_INFO_values[0];
+  }
+}
+
+
+#define SQL_GET_TYPE_INFO_num \
+	(sizeof(SQL_GET_TYPE_INFO_values)/sizeof(sql_type_info_t))
+
+
+/***************************************************************************
+ *
+ *  Name:    mariadb_dr_init
+ *
+ *  Purpose: Called when the driver is installed by DBI
+ *
+ *  Input:   dbistate - pointer to the DBI state variable, used for some
+ *               DBI internal things
+ *
+ *  Returns: Nothing
+ *
+ **************************************************************************/
+
+void mariadb_dr_init(dbistate_t* dbistate)
+{
+    dTHX;
+    DBISTATE_INIT;
+    PERL_UNUSED_ARG(dbistate);
+}
+
+
+/**************************************************************************
+ *
+ *  Name:    mariadb_dr_do_error
+ *
+ *  Purpose: Called to associate an error code and an error message
+ *           to some handle
+ *
+ *  Input:   h - the handle in error condition
+ *           rc - the error code
+ *           what - the error message
+ *
+ *  Returns: Nothing
+ *
+ **************************************************************************/
+
+void mariadb_dr_do_error(SV* h, unsigned int rc, const char *what, const char *sqlstate)
+{
+  dTHX;
+  D_imp_xxh(h);
+  SV *errstr;
+  SV *errstate;
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\t--> mariadb_dr_do_error\n");
+  errstr= DBIc_ERRSTR(imp_xxh);
+  sv_setuv(DBIc_ERR(imp_xxh), rc);	/* set err early	*/
+  SvUTF8_off(errstr);
+  sv_setpv(errstr, what);
+  sv_utf8_decode(errstr);
+
+  if (sqlstate)
+  {
+    errstate= DBIc_STATE(imp_xxh);
+    sv_setpv(errstate, sqlstate);
+  }
+
+  /* NO EFFECT DBIh_EVENT2(h, ERROR_event, DBIc_ERR(imp_xxh), errstr); */
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "error %u recorded: %" SVf "\n", rc, SVfARG(errstr));
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\t<-- mariadb_dr_do_error\n");
+}
+
+static void error_unknown_attribute(SV *h, const char *key)
+{
+  dTHX;
+  mariadb_dr_do_error(h, CR_UNKNOWN_ERROR, SvPVX(sv_2mortal(newSVpvf("Unknown attribute %s", key))), "HY000");
+}
+
+static void error_nul_character(SV *h, const char *key)
+{
+  dTHX;
+  mariadb_dr_do_error(h, CR_CONNECTION_ERROR, SvPVX(sv_2mortal(newSVpvf("Connection error: %s contains nul character", key))), "HY000");
+}
+
+static void error_no_connection(SV *h, const char *msg)
+{
+  dTHX;
+#ifdef HAVE_LAST_ERROR
+  /* Some versions of MySQL/MariaDB clients provides last error via NULL parameter, so use it instead of generic error */
+  unsigned int last_errno = mysql_errno(NULL);
+  const char *last_error = mysql_error(NULL);
+  if (last_errno && last_error && last_error[0])
+  {
+    mariadb_dr_do_error(h, last_errno, last_error, mysql_sqlstate(NULL));
+    return;
+  }
+#endif
+  mariadb_dr_do_error(h, CR_CONNECTION_ERROR, msg, "HY000");
+}
+
+static int mariadb_dr_socket_cloexec(my_socket sock_os)
+{
+#ifdef _WIN32
+  HANDLE handle = (HANDLE)sock_os;
+  DWORD flags;
+  int error;
+
+  /* Ignore connections without valid socket handle */
+  if (sock_os == 0)
+    return 0;
+
+  if (!GetHandleInformation(handle, &flags))
+  {
+    error = GetLastError();
+    return error != 0 ? -error : -EINVAL;
+  }
+
+  if (flags & HANDLE_FLAG_INHERIT)
+  {
+    /*
+      Clearing HANDLE_FLAG_INHERIT does not have to work for TCP sockets
+      when certain 3rd party Layered Service Providers are installed.
+      Note that perl's strerror() works also for error codes returned by
+      WinAPI GetLastError() function.
+     */
+    if (!SetHandleInformation(handle, HANDLE_FLAG_INHERIT, 0))
+    {
+      error = GetLastError();
+      return error != 0 ? -error : -EINVAL;
+    }
+  }
+#else
+  int fd = (int)sock_os;
+  int flags;
+
+  flags = fcntl(fd, F_GETFD);
+  if (flags == -1)
+    return errno != 0 ? -errno : -EINVAL;
+
+  if (!(flags & FD_CLOEXEC))
+  {
+    if (fcntl(fd, F_SETFD, flags | FD_CLOEXEC) == -1)
+      return errno != 0 ? -errno : -EINVAL;
+  }
+#endif
+
+  return 0;
+}
+
+/***************************************************************************
+ *
+ *  Name:    mariadb_dr_connect
+ *
+ *  Purpose: Replacement for mysql_connect
+ *
+ *  Input:   dbh - database handle being connected
+ *           imp_dbh_t *imp_dbh - Pointer to internal dbh structure
+ *           char* mysql_socket - Name of a UNIX socket being used
+ *             or NULL
+ *           char* host - Host name being used or NULL for localhost
+ *           unsigned int port - Port number being used or 0 for default
+ *           char* user - User name being used or NULL
+ *           char* password - Password being used or NULL
+ *           char* dbname - Database name being used or NULL
+ *
+ *  Returns: TRUE for success, FALSE otherwise; mariadb_dr_do_error will
+ *           be called in the latter case
+ *
+ **************************************************************************/
+
+static bool mariadb_dr_connect(
+                        SV* dbh,
+                        imp_dbh_t *imp_dbh,
+                        char* mysql_socket,
+                        char* host,
+                        unsigned int port,
+                        char* user,
+                        char* password,
+                        char* dbname)
+{
+  unsigned int client_flag;
+  bool client_supports_utf8mb4;
+  bool connected;
+  unsigned int read_timeout, write_timeout;
+  MYSQL *sock;
+  dTHX;
+  D_imp_xxh(dbh);
+  SV *sv = DBIc_IMP_DATA(imp_dbh);
+  D_imp_drh_from_dbh;
+
+#ifdef MARIADB_PACKAGE_VERSION
+  bool read_timeout_set = FALSE;
+  bool write_timeout_set = FALSE;
+#endif
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+		  "imp_dbh->mariadb_dr_connect: host = |%s|, port = %u,"
+		  " uid = %s, pwd = %s\n",
+		  host ? host : "NULL", port,
+		  user ? user : "NULL",
+		  !password ? "NULL" : !password[0] ? "" : "****");
+
+#if !defined(HAVE_EMBEDDED) && defined(HAVE_BROKEN_INIT)
+  if (imp_drh->non_embedded_finished)
+  {
+    mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: Method disconnect_all() was already called and library functions unloaded", "HY000");
+    return FALSE;
+  }
+#endif
+
+  /* host=localhost means to connect via unix socket, host=embedded means to use embedded server, so do not allow specifying port */
+  if (port && host && (strcmp(host, "localhost") == 0 || strcmp(host, "embedded") == 0))
+  {
+    mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: port cannot be specified when host is localhost or embedded", "HY000");
+    return FALSE;
+  }
+
+  /* when connecting via unix socket do not allow specifying port or host != localhost */
+  if (mysql_socket && (port || (host && strcmp(host, "localhost") != 0)))
+  {
+    mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: host or port cannot be specified together with mariadb_socket", "HY000");
+    return FALSE;
+  }
+
+  if (host && strcmp(host, "embedded") == 0)
+  {
+#ifndef HAVE_EMBEDDED
+    mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: Embedded server is not supported", "HY000");
+    return FALSE;
+#endif
+      if (sv  &&  SvROK(sv))
+      {
+        SV** svp;
+        SV *embedded_groups = NULL;
+        SV *embedded_args = NULL;
+        STRLEN options_len;
+        char * options;
+        int server_args_cnt= 0;
+        int server_groups_cnt= 0;
+        int rc= 0;
+
+        char ** server_args = NULL;
+        char ** server_groups = NULL;
+
+        HV* hv = (HV*) SvRV(sv);
+
+        if (SvTYPE(hv) != SVt_PVHV)
+          return FALSE;
+
+        if (imp_drh->instances == 0 && !imp_drh->non_embedded_started)
+        {
+          if ((svp = hv_fetchs(hv, "mariadb_embedded_groups", FALSE)) && *svp && SvTRUE(*svp))
+          {
+            embedded_groups = *svp;
+            options = SvPVutf8_nomg(embedded_groups, options_len);
+            if (strlen(options) != options_len)
+            {
+              error_nul_character(dbh, "mariadb_embedded_groups");
+              return FALSE;
+            }
+
+            if ((server_groups_cnt=count_embedded_options(options)))
+            {
+              /* number of server_groups always server_groups+1 */
+              server_groups = fill_out_embedded_options(options, 0, options_len, ++server_groups_cnt);
+              if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+              {
+                PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                              "Groups names passed to embedded server:\n");
+                print_embedded_options(DBIc_LOGPIO(imp_xxh), server_groups, server_groups_cnt);
+              }
+            }
+          }
+
+          if ((svp = hv_fetchs(hv, "mariadb_embedded_options", FALSE)) && *svp && SvTRUE(*svp))
+          {
+            embedded_args = *svp;
+            options = SvPVutf8_nomg(embedded_args, options_len);
+            if (strlen(options) != options_len)
+            {
+              if (server_groups_cnt)
+                free_embedded_options(server_groups, server_groups_cnt);
+              error_nul_character(dbh, "mariadb_embedded_options");
+              return FALSE;
+            }
+
+            if ((server_args_cnt=count_embedded_options(options)))
+            {
+              /* number of server_options always server_options+1 */
+              server_args = fill_out_embedded_options(options, 1, options_len, ++server_args_cnt);
+              if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+              {
+                PerlIO_printf(DBIc_LOGPIO(imp_xxh), "Server options passed to embedded server:\n");
+                print_embedded_options(DBIc_LOGPIO(imp_xxh), server_args, server_args_cnt);
+              }
+            }
+          }
+
+          /* Init embedded server */
+          rc = mysql_server_init(server_args_cnt, server_args, server_groups);
+
+          if (server_args_cnt)
+            free_embedded_options(server_args, server_args_cnt);
+          if (server_groups_cnt)
+            free_embedded_options(server_groups, server_groups_cnt);
+
+          if (rc)
+          {
+            error_no_connection(dbh, "Connection error: Cannot start embedded server");
+            return FALSE;
+          }
+
+          if (embedded_groups)
+            imp_drh->embedded_groups = newSVsv_nomg(embedded_groups);
+          if (embedded_args)
+            imp_drh->embedded_args = newSVsv_nomg(embedded_args);
+
+          imp_drh->embedded_started = TRUE;
+        }
+        else if (imp_drh->non_embedded_started)
+        {
+          mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: Non-embedded connection was already established", "HY000");
+          return FALSE;
+        }
+        else if (imp_drh->embedded_started)
+        {
+         /*
+          * Check if embedded parameters passed to connect() differ from
+          * first ones
+          */
+
+          if ( ((svp = hv_fetchs(hv, "mariadb_embedded_groups", FALSE)) && *svp && SvTRUE(*svp)))
+            rc += abs(sv_cmp_flags(*svp, imp_drh->embedded_groups, 0));
+
+          if ( ((svp = hv_fetchs(hv, "mariadb_embedded_options", FALSE)) && *svp && SvTRUE(*svp)) )
+            rc += abs(sv_cmp_flags(*svp, imp_drh->embedded_args, 0));
+
+          if (rc)
+          {
+            mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: Embedded server was already started, cannot pass different init parameters to embedded server", "HY000");
+            return FALSE;
+          }
+        }
+        else
+        {
+          mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: Unknown internal state (possible bug in driver)", "HY000");
+          return FALSE;
+        }
+      }
+  }
+  else
+  {
+    if (imp_drh->instances == 0 && !imp_drh->non_embedded_started)
+    {
+      /* negative value means to not start embedded server and just to initialize client library */
+      /* initializing client library is needed prior to any other mysql_* call from client library */
+      if (mysql_server_init(-1, NULL, NULL))
+      {
+        error_no_connection(dbh, "Connection error: Cannot initialize client library");
+        return FALSE;
+      }
+      imp_drh->non_embedded_started = TRUE;
+    }
+  }
+
+  sock = imp_dbh->pmysql = mysql_init(NULL);
+  if (!sock)
+  {
+    error_no_connection(dbh, "Connection error: Cannot initialize client structures");
+    mariadb_db_disconnect(dbh, imp_dbh);
+    return FALSE;
+  }
+#ifdef HAVE_ASYNC_STMT
+  imp_dbh->async_nonblock = FALSE;
+#endif
+  imp_drh->instances++;
+
+  client_flag = CLIENT_FOUND_ROWS | CLIENT_MULTI_RESULTS;
+
+      DBIc_set(imp_dbh, DBIcf_AutoCommit, TRUE);
+
+      if (sv  &&  SvROK(sv))
+      {
+        HV* hv = (HV*) SvRV(sv);
+        HV* processed = newHV();
+        HE* he;
+        SV** svp;
+        size_t i;
+
+        const char * const mariadb_ssl_attributes[] = {
+          "mariadb_ssl_optional",
+          "mariadb_ssl_verify_server_cert",
+          "mariadb_ssl_client_key",
+          "mariadb_ssl_client_cert",
+          "mariadb_ssl_ca_file",
+          "mariadb_ssl_ca_path",
+          "mariadb_ssl_cipher",
+        };
+
+        sv_2mortal(newRV_noinc((SV *)processed)); /* Automatically free HV processed */
+
+        /* These options are already handled and processed */
+        (void)hv_stores(processed, "host", &PL_sv_yes);
+        (void)hv_stores(processed, "port", &PL_sv_yes);
+        (void)hv_stores(processed, "user", &PL_sv_yes);
+        (void)hv_stores(processed, "password", &PL_sv_yes);
+        (void)hv_stores(processed, "database", &PL_sv_yes);
+        (void)hv_stores(processed, "mariadb_socket", &PL_sv_yes);
+
+#ifdef HAVE_EMBEDDED
+      if (host && strcmp(host, "embedded") == 0)
+      {
+        (void)hv_stores(processed, "mariadb_embedded_groups", &PL_sv_yes);
+        (void)hv_stores(processed, "mariadb_embedded_options", &PL_sv_yes);
+
+        mysql_options(sock, MYSQL_OPT_USE_EMBEDDED_CONNECTION, NULL);
+        imp_dbh->is_embedded = TRUE;
+        host = NULL;
+      }
+      else
+      {
+        mysql_options(sock, MYSQL_OPT_USE_REMOTE_CONNECTION, NULL);
+      }
+#endif
+
+        /* thanks to Peter John Edwards for mysql_init_command */ 
+        (void)hv_stores(processed, "mariadb_init_command", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_init_command", FALSE)) && *svp && SvTRUE(*svp))
+        {
+          STRLEN len;
+          char* df = SvPVutf8_nomg(*svp, len);
+          if (strlen(df) != len)
+          {
+            error_nul_character(dbh, "mariadb_init_command");
+            mariadb_db_disconnect(dbh, imp_dbh);
+            return FALSE;
+          }
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                           "imp_dbh->mariadb_dr_connect: Setting"
+                           " init command (%s).\n", df);
+          mysql_options(sock, MYSQL_INIT_COMMAND, df);
+        }
+
+        (void)hv_stores(processed, "mariadb_compression", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_compression", FALSE)) && *svp && SvTRUE(*svp))
+        {
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->mariadb_dr_connect: Enabling"
+                          " compression.\n");
+          mysql_options(sock, MYSQL_OPT_COMPRESS, NULL);
+        }
+
+        (void)hv_stores(processed, "mariadb_connect_timeout", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_connect_timeout", FALSE)) && *svp)
+        {
+          UV uv = SvUV(*svp);
+          unsigned int to = (uv <= UINT_MAX ? uv : UINT_MAX);
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->mariadb_dr_connect: Setting"
+                          " connect timeout (%u).\n", to);
+          mysql_options(sock, MYSQL_OPT_CONNECT_TIMEOUT,
+                        (const char *)&to);
+        }
+
+        (void)hv_stores(processed, "mariadb_write_timeout", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_write_timeout", FALSE)) && *svp)
+        {
+          UV uv = SvUV(*svp);
+          write_timeout = (uv <= UINT_MAX ? uv : UINT_MAX);
+#ifdef MARIADB_PACKAGE_VERSION
+          write_timeout_set = TRUE;
+#endif
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->mariadb_dr_connect: Setting"
+                          " write timeout (%u).\n", write_timeout);
+          mysql_options(sock, MYSQL_OPT_WRITE_TIMEOUT, (const char *)&write_timeout);
+        }
+
+        (void)hv_stores(processed, "mariadb_read_timeout", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_read_timeout", FALSE)) && *svp)
+        {
+          UV uv = SvUV(*svp);
+          read_timeout = (uv <= UINT_MAX ? uv : UINT_MAX);
+#ifdef MARIADB_PACKAGE_VERSION
+          read_timeout_set = TRUE;
+#endif
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->mariadb_dr_connect: Setting"
+                          " read timeout (%u).\n", read_timeout);
+          mysql_options(sock, MYSQL_OPT_READ_TIMEOUT, (const char *)&read_timeout);
+        }
+
+#ifdef MARIADB_PACKAGE_VERSION
+        {
+          /* Version is in format: "2.3.2" */
+          const char version[] = MARIADB_PACKAGE_VERSION;
+          bool broken_timeouts;
+
+          if (sizeof(version) != 6 || version[0] != '2' || version[1] != '.' || version[3] != '.' || version[5] != '\0')
+            broken_timeouts = FALSE;
+          else if (version[2] >= '0' && version[2] < '3' && version[4] >= '0' && version[4] <= '9')
+            broken_timeouts = TRUE;
+          else if (version[2] == '3' && version[4] >= '0' && version[4] < '3')
+            broken_timeouts = TRUE;
+          else
+            broken_timeouts = FALSE;
+
+          if (broken_timeouts)
+          {
+            /*
+              MariaDB Connector/C prior to version 2.3.3 has broken MYSQL_OPT_WRITE_TIMEOUT.
+              Write timeout is set by MYSQL_OPT_READ_TIMEOUT option.
+              See file libmariadb/libmariadb.c, line "vio_write_timeout(net->vio, mysql->options.read_timeout);".
+              Therefore specifying different read and write timeout is not possible.
+             */
+            if ((read_timeout_set || write_timeout_set) && (!read_timeout_set || !write_timeout_set || read_timeout != write_timeout))
+            {
+              mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: Specifying different mariadb_read_timeout and mariadb_write_timeout is broken by current version of MariaDB/MySQL client", "HY000");
+              mariadb_db_disconnect(dbh, imp_dbh);
+              return FALSE;
+            }
+
+            /*
+              MariaDB Connector/C prior to version 2.3.3 has broken zero write timeout.
+              See file libmariadb/violite.c, function vio_write(). Variable vio->write_timeout
+              is signed and on some places zero value is tested as "boolean" and on some as "> 0".
+              Therefore we need to force non-zero timeout, otherwise some operation fail.
+              Maximal possible value is INT_MAX/1000. So use it for simulation of infinite timeout.
+              Also set this timeout when no timeout was provided.
+             */
+            if ((!read_timeout_set || !write_timeout_set) || write_timeout == 0)
+            {
+              read_timeout = INT_MAX/1000;
+              write_timeout = INT_MAX/1000;
+              mysql_options(sock, MYSQL_OPT_READ_TIMEOUT, (const char *)&read_timeout);
+              mysql_options(sock, MYSQL_OPT_WRITE_TIMEOUT, (const char *)&write_timeout);
+            }
+          }
+        }
+#endif
+
+        (void)hv_stores(processed, "mariadb_max_allowed_packet", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_max_allowed_packet", FALSE)) && *svp && SvTRUE(*svp))
+        {
+          UV uv = SvUV_nomg(*svp);
+          unsigned long packet_size = (uv <= ULONG_MAX ? uv : ULONG_MAX);
+#if (!defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 50709 && MYSQL_VERSION_ID != 60000) || (defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 100206 && MYSQL_VERSION_ID != 100300)
+          /* MYSQL_OPT_MAX_ALLOWED_PACKET was added in mysql 5.7.9 */
+          /* MYSQL_OPT_MAX_ALLOWED_PACKET was added in MariaDB 10.2.6 and MariaDB 10.3.1 */
+          mysql_options(sock, MYSQL_OPT_MAX_ALLOWED_PACKET, &packet_size);
+#else
+          /* before MySQL 5.7.9 and MariaDB 10.2.6 and MariaDB 10.3.0 use max_allowed_packet macro */
+          max_allowed_packet = packet_size;
+#endif
+        }
+
+        (void)hv_stores(processed, "mariadb_skip_secure_auth", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_skip_secure_auth", FALSE)) && *svp && SvTRUE(*svp))
+        {
+          int error = 1;
+#ifdef HAVE_SECURE_AUTH
+          my_bool secauth = FALSE;
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->mariadb_dr_connect: Skipping"
+                          " secure auth\n");
+          error = mysql_options(sock, MYSQL_SECURE_AUTH, &secauth);
+#endif
+          if (error)
+          {
+            mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: mariadb_skip_secure_auth=1 is not supported", "HY000");
+            mariadb_db_disconnect(dbh, imp_dbh);
+            return FALSE;
+          }
+        }
+
+        (void)hv_stores(processed, "mariadb_auth_plugin", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_auth_plugin", FALSE)) && *svp)
+        {
+          int error = 1;
+          STRLEN len;
+          char *auth_plugin = SvPVutf8(*svp, len);
+          if (strlen(auth_plugin) != len)
+          {
+            error_nul_character(dbh, "mariadb_auth_plugin");
+            mariadb_db_disconnect(dbh, imp_dbh);
+            return FALSE;
+          }
+#if MYSQL_VERSION_ID >= 50507 && MYSQL_VERSION_ID != 60000
+          error = mysql_options(sock, MYSQL_DEFAULT_AUTH, auth_plugin);
+#endif
+          if (error)
+          {
+            mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: mariadb_auth_plugin is not supported", "HY000");
+            mariadb_db_disconnect(dbh, imp_dbh);
+            return FALSE;
+          }
+        }
+
+        (void)hv_stores(processed, "mariadb_read_default_file", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_read_default_file", FALSE)) && *svp && SvTRUE(*svp))
+        {
+          STRLEN len;
+          char* df = SvPVutf8_nomg(*svp, len);
+          if (strlen(df) != len)
+          {
+            error_nul_character(dbh, "mariadb_read_default_file");
+            mariadb_db_disconnect(dbh, imp_dbh);
+            return FALSE;
+          }
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->mariadb_dr_connect: Reading"
+                          " default file %s.\n", df);
+          mysql_options(sock, MYSQL_READ_DEFAULT_FILE, df);
+        }
+
+        (void)hv_stores(processed, "mariadb_read_default_group", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_read_default_group", FALSE)) && *svp && SvTRUE(*svp))
+        {
+          STRLEN len;
+          char* gr = SvPVutf8_nomg(*svp, len);
+          if (strlen(gr) != len)
+          {
+            error_nul_character(dbh, "mariadb_read_default_group");
+            mariadb_db_disconnect(dbh, imp_dbh);
+            return FALSE;
+          }
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                    "imp_dbh->mariadb_dr_connect: Using"
+                    " default group %s.\n", gr);
+
+          mysql_options(sock, MYSQL_READ_DEFAULT_GROUP, gr);
+        }
+
+        (void)hv_stores(processed, "mariadb_conn_attrs", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_conn_attrs", FALSE)) && *svp)
+        {
+        /* mysql_options4 with MYSQL_OPT_CONNECT_ATTR_ADD is supported by libraries:
+         * MariaDB 10.0.5+ and any MariaDB Connector/C; MySQL 5.6.6+ except MySQL Connector/C 6.0.0
+         */
+        #if (defined(MARIADB_BASE_VERSION) && (MYSQL_VERSION_ID >= 100005 || defined(MARIADB_PACKAGE_VERSION))) || (!defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 50606 && MYSQL_VERSION_ID != 60000)
+              HV* attrs = (HV*) SvRV(*svp);
+              HE* entry = NULL;
+              I32 num_entries = hv_iterinit(attrs);
+              while (num_entries && (entry = hv_iternext(attrs))) {
+                  I32 attr_name_len = 0;
+                  char *attr_name = hv_iterkey(entry, &attr_name_len);
+                  SV *sv_attr_val = hv_iterval(attrs, entry);
+                  STRLEN attr_val_len;
+                  char *attr_val  = SvPVutf8(sv_attr_val, attr_val_len);
+                  if (strlen(attr_name) != (STRLEN)attr_name_len || strlen(attr_val) != attr_val_len)
+                  {
+                    error_nul_character(dbh, "mariadb_conn_attrs");
+                    mariadb_db_disconnect(dbh, imp_dbh);
+                    return FALSE;
+                  }
+                  mysql_options4(sock, MYSQL_OPT_CONNECT_ATTR_ADD, attr_name, attr_val);
+              }
+        #else
+              mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: mariadb_conn_attrs is not supported", "HY000");
+              mariadb_db_disconnect(dbh, imp_dbh);
+              return FALSE;
+        #endif
+        }
+
+        (void)hv_stores(processed, "mariadb_client_found_rows", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_client_found_rows", FALSE)) && *svp && !SvTRUE(*svp))
+          client_flag &= ~CLIENT_FOUND_ROWS;
+
+        (void)hv_stores(processed, "mariadb_auto_reconnect", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_auto_reconnect", FALSE)) && *svp)
+        {
+          imp_dbh->auto_reconnect = SvTRUE(*svp);
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->auto_reconnect: %d\n",
+                          imp_dbh->auto_reconnect);
+        }
+
+        (void)hv_stores(processed, "mariadb_use_result", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_use_result", FALSE)) && *svp)
+        {
+          imp_dbh->use_mysql_use_result = SvTRUE(*svp);
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->use_mysql_use_result: %d\n",
+                          imp_dbh->use_mysql_use_result ? 1 : 0);
+        }
+
+        (void)hv_stores(processed, "mariadb_bind_type_guessing", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_bind_type_guessing", FALSE)) && *svp)
+        {
+          imp_dbh->bind_type_guessing= SvTRUE(*svp);
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->bind_type_guessing: %d\n",
+                          imp_dbh->bind_type_guessing);
+        }
+
+        (void)hv_stores(processed, "mariadb_bind_comment_placeholders", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_bind_comment_placeholders", FALSE)) && *svp)
+        {
+          imp_dbh->bind_comment_placeholders = SvTRUE(*svp);
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->bind_comment_placeholders: %d\n",
+                          imp_dbh->bind_comment_placeholders);
+        }
+
+        (void)hv_stores(processed, "mariadb_no_autocommit_cmd", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_no_autocommit_cmd", FALSE)) && *svp)
+        {
+          imp_dbh->no_autocommit_cmd= SvTRUE(*svp);
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->no_autocommit_cmd: %d\n",
+                          imp_dbh->no_autocommit_cmd);
+        }
+
+        (void)hv_stores(processed, "mariadb_use_fabric", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_use_fabric", FALSE)) && *svp && SvTRUE(*svp))
+        {
+#ifdef HAVE_FABRIC
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->use_fabric: Enabling use of"
+                          " MySQL Fabric.\n");
+          mysql_options(sock, MYSQL_OPT_USE_FABRIC, NULL);
+#else
+          mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: mariadb_use_fabric is not supported", "HY000");
+          mariadb_db_disconnect(dbh, imp_dbh);
+          return FALSE;
+#endif
+        }
+
+        (void)hv_stores(processed, "mariadb_multi_statements", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_multi_statements", FALSE)) && *svp && SvTRUE(*svp))
+        {
+          imp_dbh->use_multi_statements = TRUE;
+          client_flag |= CLIENT_MULTI_STATEMENTS;
+        }
+
+        (void)hv_stores(processed, "mariadb_server_prepare", &PL_sv_yes);
+	if ((svp = hv_fetchs(hv, "mariadb_server_prepare", FALSE)) && *svp)
+          imp_dbh->use_server_side_prepare = SvTRUE(*svp);
+        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+          PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                        "imp_dbh->use_server_side_prepare: %d\n",
+                        imp_dbh->use_server_side_prepare ? 1 : 0);
+
+        if (imp_dbh->bind_type_guessing && imp_dbh->use_server_side_prepare)
+        {
+          mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: mariadb_bind_type_guessing and mariadb_server_prepare cannot be enabled together", "HY000");
+          mariadb_db_disconnect(dbh, imp_dbh);
+          return FALSE;
+        }
+
+        (void)hv_stores(processed, "mariadb_server_prepare_disable_fallback", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_server_prepare_disable_fallback", FALSE)) && *svp)
+          imp_dbh->disable_fallback_for_server_prepare = SvTRUE(*svp);
+        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+          PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                        "imp_dbh->disable_fallback_for_server_prepare: %d\n",
+                        imp_dbh->disable_fallback_for_server_prepare ? 1 : 0);
+
+        (void)hv_stores(processed, "mariadb_stmt_cache_size", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_stmt_cache_size", FALSE)) && *svp && SvOK(*svp))
+        {
+          UV uv = SvUV(*svp);
+          imp_dbh->stmt_cache_size = (uv <= UINT_MAX) ? uv : UINT_MAX;
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->stmt_cache_size: %u\n",
+                          imp_dbh->stmt_cache_size);
+        }
+
+        (void)hv_stores(processed, "mariadb_cursor_prefetch", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_cursor_prefetch", FALSE)) && *svp && SvOK(*svp))
+        {
+          UV uv = SvUV(*svp);
+          imp_dbh->cursor_prefetch = (uv <= ULONG_MAX) ? uv : ULONG_MAX;
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->cursor_prefetch: %lu\n",
+                          imp_dbh->cursor_prefetch);
+        }
+
+        (void)hv_stores(processed, "mariadb_statement_buffer_max", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_statement_buffer_max", FALSE)) && *svp && SvOK(*svp))
+        {
+          UV uv = SvUV(*svp);
+          imp_dbh->statement_buffer_max = (uv <= (UV)SSize_t_MAX) ? uv : (UV)SSize_t_MAX;
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                          "imp_dbh->statement_buffer_max: %" UVuf "\n",
+                          (UV)imp_dbh->statement_buffer_max);
+        }
+
+        (void)hv_stores(processed, "mariadb_temporal_mode", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_temporal_mode", FALSE)) && *svp)
+        {
+          if (!parse_temporal_mode(aTHX_ dbh, *svp, &imp_dbh->temporal_mode))
+          {
+            mariadb_db_disconnect(dbh, imp_dbh);
+            return FALSE;
+          }
+        }
+
+        (void)hv_stores(processed, "mariadb_decimal_mode", &PL_sv_yes);
+        if ((svp = hv_fetchs(hv, "mariadb_decimal_mode", FALSE)) && *svp)
+        {
+          if (!parse_decimal_mode(aTHX_ dbh, *svp, &imp_dbh->decimal_mode))
+          {
+            mariadb_db_disconnect(dbh, imp_dbh);
+            return FALSE;
+          }
+        }
+
+        (void)hv_stores(processed, "mariadb_ssl", &PL_sv_yes);
+        for (i = 0; i < sizeof(mariadb_ssl_attributes)/sizeof(*mariadb_ssl_attributes); i++)
+          (void)hv_store(processed, mariadb_ssl_attributes[i], strlen(mariadb_ssl_attributes[i]), &PL_sv_yes, 0);
+	if ((svp = hv_fetchs(hv, "mariadb_ssl", FALSE)) && *svp && SvTRUE(*svp))
+          {
+	    char *client_key = NULL;
+	    char *client_cert = NULL;
+	    char *ca_file = NULL;
+	    char *ca_path = NULL;
+	    char *cipher = NULL;
+	    STRLEN len = 0;
+  #if defined(HAVE_SSL_MODE) || defined(HAVE_SSL_MODE_ONLY_REQUIRED)
+	    unsigned int ssl_mode;
+  #endif
+	    my_bool ssl_enforce = TRUE;
+	    my_bool ssl_verify = FALSE;
+  #ifndef HAVE_SSL_MODE
+	    my_bool ssl_verify_set = FALSE;
+  #endif
+
+	    if ((svp = hv_fetchs(hv, "mariadb_ssl_optional", FALSE)) && *svp)
+	      ssl_enforce = !SvTRUE(*svp);
+
+            /* Verify if the hostname we connect to matches the hostname in the certificate */
+	    if ((svp = hv_fetchs(hv, "mariadb_ssl_verify_server_cert", FALSE)) && *svp)
+	    {
+  #if defined(HAVE_SSL_VERIFY) || defined(HAVE_SSL_MODE)
+	      ssl_verify = SvTRUE(*svp);
+    #ifndef HAVE_SSL_MODE
+	      ssl_verify_set = TRUE;
+    #endif
+  #else
+	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: mariadb_ssl_verify_server_cert=1 is not supported", "HY000");
+	      mariadb_db_disconnect(dbh, imp_dbh);
+	      return FALSE;
+  #endif
+	    }
+
+	    if ((svp = hv_fetchs(hv, "mariadb_ssl_client_key", FALSE)) && *svp)
+	    {
+	      client_key = SvPVutf8(*svp, len);
+	      if (strlen(client_key) != len)
+	      {
+	        error_nul_character(dbh, "mariadb_ssl_client_key");
+	        mariadb_db_disconnect(dbh, imp_dbh);
+	        return FALSE;
+	      }
+	    }
+
+	    if ((svp = hv_fetchs(hv, "mariadb_ssl_client_cert", FALSE)) && *svp)
+	    {
+	      client_cert = SvPVutf8(*svp, len);
+	      if (strlen(client_cert) != len)
+	      {
+	        error_nul_character(dbh, "mariadb_ssl_client_cert");
+	        mariadb_db_disconnect(dbh, imp_dbh);
+	        return FALSE;
+	      }
+	    }
+
+	    if ((svp = hv_fetchs(hv, "mariadb_ssl_ca_file", FALSE)) && *svp)
+	    {
+	      ca_file = SvPVutf8(*svp, len);
+	      if (strlen(ca_file) != len)
+	      {
+	        error_nul_character(dbh, "mariadb_ssl_ca_file");
+	        mariadb_db_disconnect(dbh, imp_dbh);
+	        return FALSE;
+	      }
+	    }
+
+	    if ((svp = hv_fetchs(hv, "mariadb_ssl_ca_path", FALSE)) && *svp)
+	    {
+	      ca_path = SvPVutf8(*svp, len);
+	      if (strlen(ca_path) != len)
+	      {
+	        error_nul_character(dbh, "mariadb_ssl_ca_path");
+	        mariadb_db_disconnect(dbh, imp_dbh);
+	        return FALSE;
+	      }
+	    }
+
+	    if ((svp = hv_fetchs(hv, "mariadb_ssl_cipher", FALSE)) && *svp)
+	    {
+	      cipher = SvPVutf8(*svp, len);
+	      if (strlen(cipher) != len)
+	      {
+	        error_nul_character(dbh, "mariadb_ssl_cipher");
+	        mariadb_db_disconnect(dbh, imp_dbh);
+	        return FALSE;
+	      }
+	    }
+
+  #if !defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 80300
+	    if (mysql_options(sock, MYSQL_OPT_SSL_KEY, client_key) != 0 ||
+	        mysql_options(sock, MYSQL_OPT_SSL_CERT, client_cert) != 0 ||
+	        mysql_options(sock, MYSQL_OPT_SSL_CA, ca_file) != 0 ||
+	        mysql_options(sock, MYSQL_OPT_SSL_CAPATH, ca_path) != 0 ||
+	        mysql_options(sock, MYSQL_OPT_SSL_CIPHER, cipher) != 0) {
+	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Setting SSL options failed", "HY000");
+	      mariadb_db_disconnect(dbh, imp_dbh);
+	      return FALSE;
+	    }
+  #else
+	    mysql_ssl_set(sock, client_key, client_cert, ca_file,
+			  ca_path, cipher);
+  #endif
+
+	    if (ssl_verify && !(ca_file || ca_path)) {
+	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: mariadb_ssl_verify_server_cert=1 is not supported without mariadb_ssl_ca_file or mariadb_ssl_ca_path", "HY000");
+	      mariadb_db_disconnect(dbh, imp_dbh);
+	      return FALSE;
+	    }
+
+  #ifdef HAVE_SSL_MODE
+
+	    if (!ssl_enforce)
+	      ssl_mode = SSL_MODE_PREFERRED;
+	    else if (ssl_verify)
+	      ssl_mode = SSL_MODE_VERIFY_IDENTITY;
+	    else if (ca_file || ca_path)
+	      ssl_mode = SSL_MODE_VERIFY_CA;
+	    else
+	      ssl_mode = SSL_MODE_REQUIRED;
+	    if (mysql_options(sock, MYSQL_OPT_SSL_MODE, &ssl_mode) != 0) {
+	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Enforcing SSL encryption is not supported", "HY000");
+	      mariadb_db_disconnect(dbh, imp_dbh);
+	      return FALSE;
+	    }
+
+  #else
+
+	    if (ssl_enforce) {
+    #if defined(HAVE_SSL_MODE_ONLY_REQUIRED)
+	      ssl_mode = SSL_MODE_REQUIRED;
+	      if (mysql_options(sock, MYSQL_OPT_SSL_MODE, &ssl_mode) != 0) {
+	        mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Enforcing SSL encryption is not supported", "HY000");
+	        mariadb_db_disconnect(dbh, imp_dbh);
+	        return FALSE;
+	      }
+    #elif defined(HAVE_SSL_ENFORCE)
+	      if (mysql_options(sock, MYSQL_OPT_SSL_ENFORCE, &ssl_enforce) != 0) {
+	        mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Enforcing SSL encryption is not supported", "HY000");
+	        mariadb_db_disconnect(dbh, imp_dbh);
+	        return FALSE;
+	      }
+    #elif defined(HAVE_SSL_VERIFY)
+	      if (!ssl_verify_also_enforce_ssl()) {
+	        mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Enforcing SSL encryption is not supported", "HY000");
+	        mariadb_db_disconnect(dbh, imp_dbh);
+	        return FALSE;
+	      }
+	      if (ssl_verify_set && !ssl_verify) {
+	        mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Enforcing SSL encryption is not supported without mariadb_ssl_verify_server_cert=1", "HY000");
+	        mariadb_db_disconnect(dbh, imp_dbh);
+	        return FALSE;
+	      }
+	      ssl_verify = TRUE;
+    #else
+	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Enforcing SSL encryption is not supported", "HY000");
+	      mariadb_db_disconnect(dbh, imp_dbh);
+	      return FALSE;
+    #endif
+	    }
+
+    #ifdef HAVE_SSL_VERIFY
+	    if (!ssl_enforce && ssl_verify && ssl_verify_also_enforce_ssl()) {
+	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: mariadb_ssl_optional=1 with mariadb_ssl_verify_server_cert=1 is not supported", "HY000");
+	      mariadb_db_disconnect(dbh, imp_dbh);
+	      return FALSE;
+	    }
+    #endif
+
+	    if (ssl_verify) {
+	      if (!ssl_verify_usable() && ssl_enforce && ssl_verify_set) {
+	        mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: mariadb_ssl_verify_server_cert=1 is broken by current version of MariaDB/MySQL client", "HY000");
+	        mariadb_db_disconnect(dbh, imp_dbh);
+	        return FALSE;
+	      }
+    #ifdef HAVE_SSL_VERIFY
+	      if (mysql_options(sock, MYSQL_OPT_SSL_VERIFY_SERVER_CERT, &ssl_verify) != 0) {
+	        mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: mariadb_ssl_verify_server_cert=1 is not supported", "HY000");
+	        mariadb_db_disconnect(dbh, imp_dbh);
+	        return FALSE;
+	      }
+    #else
+	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: mariadb_ssl_verify_server_cert=1 is not supported", "HY000");
+	      mariadb_db_disconnect(dbh, imp_dbh);
+	      return FALSE;
+    #endif
+	    }
+
+  #endif
+	  }
+	else
+	  {
+	    for (i = 0; i < sizeof(mariadb_ssl_attributes)/sizeof(*mariadb_ssl_attributes); i++)
+	      {
+	        if ((svp = hv_fetch(hv, mariadb_ssl_attributes[i], strlen(mariadb_ssl_attributes[i]), FALSE)) && *svp)
+	          {
+	            mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, SvPVX(sv_2mortal(newSVpvf("SSL connection error: SSL attribute %s was specified but SSL encryption was not enabled via mariadb_ssl=1", mariadb_ssl_attributes[i]))), "HY000");
+	            mariadb_db_disconnect(dbh, imp_dbh);
+	            return FALSE;
+	          }
+	      }
+
+#ifdef HAVE_SSL_MODE
+	    unsigned int ssl_mode = SSL_MODE_DISABLED;
+	    mysql_options(sock, MYSQL_OPT_SSL_MODE, &ssl_mode);
+#endif
+	  }
+        (void)hv_stores(processed, "mariadb_local_infile", &PL_sv_yes);
+     if ((svp = hv_fetchs(hv, "mariadb_local_infile", FALSE)) && *svp)
+     {
+	  unsigned int flag = SvTRUE(*svp);
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+	    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+        "imp_dbh->mariadb_dr_connect: Using"
+        " local infile %u.\n", flag);
+	  mysql_options(sock, MYSQL_OPT_LOCAL_INFILE, (const char *) &flag);
+	}
+
+        hv_iterinit(hv);
+        while ((he = hv_iternext(hv)) != NULL)
+        {
+          I32 len;
+          const char *key;
+          key = hv_iterkey(he, &len);
+          if (skip_attribute(key) || hv_exists(processed, key, len))
+            continue;
+          error_unknown_attribute(dbh, key);
+          mariadb_db_disconnect(dbh, imp_dbh);
+          return FALSE;
+        }
+      }
+
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "imp_dbh->mariadb_dr_connect: client_flags = %d\n",
+		    client_flag);
+
+    /*
+      MySQL's "utf8mb4" charset is capable of handling 4-byte UTF-8 characters.
+      MySQL's "utf8" charset is capable of handling only up to 3-byte UTF-8 characters.
+      MySQL's "utf8mb4" charset was introduced in MySQL server version 5.5.3.
+      If MySQL's "utf8mb4" is not supported by server, fallback to MySQL's "utf8".
+      If MySQL's "utf8mb4" is not supported by client, connect with "utf8" and issue SET NAMES 'utf8mb4'.
+      MYSQL_SET_CHARSET_NAME option (prior to establishing connection) sets client's charset.
+      Some clients think that they were connected with MYSQL_SET_CHARSET_NAME, but reality can be different.
+      This problem was reported in MariaDB bug tracker https://jira.mariadb.org/browse/CONC-342
+      but problem is not going to be fixed. So always manually issue SET NAMES to prevent misbehave.
+      To enable UTF-8 storage on server it is needed to configure it via session variable character_set_server.
+      Some clients provides function get_charset_number() to check if charset is supported.
+      If MySQL client does not support specified charset it used to print error message to stdout or stderr.
+      DBD::MariaDB expects that whole communication with server is encoded in UTF-8.
+      By default broken utf8mb4_general_ci collation is used. So change it to utf8mb4_unicode_ci which is according to the Unicode 4.0.0.
+    */
+#ifdef HAVE_GET_CHARSET_NUMBER
+    client_supports_utf8mb4 = get_charset_number("utf8mb4", MY_CS_PRIMARY) ? TRUE : FALSE;
+#elif MYSQL_VERSION_ID < 50503
+    client_supports_utf8mb4 = FALSE;
+#else
+    client_supports_utf8mb4 = TRUE;
+#endif
+    connected = FALSE;
+    if (client_supports_utf8mb4)
+    {
+      mysql_options(sock, MYSQL_SET_CHARSET_NAME, "utf8mb4");
+      connected = mysql_real_connect(sock, host, user, password, dbname, port, mysql_socket, client_flag | CLIENT_REMEMBER_OPTIONS) ? TRUE : FALSE;
+      if (!connected && mysql_errno(sock) != CR_CANT_READ_CHARSET)
+      {
+        mariadb_dr_do_error(dbh, mysql_errno(sock), mysql_error(sock), mysql_sqlstate(sock));
+        mariadb_db_disconnect(dbh, imp_dbh);
+        return FALSE;
+      }
+      if (connected && mysql_get_server_version(sock) < 40100)
+      {
+        mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: MariaDB or MySQL server version is older than 4.1.0", "HY000");
+        mariadb_db_disconnect(dbh, imp_dbh);
+        return FALSE;
+      }
+    }
+    if (!connected)
+    {
+      mysql_options(sock, MYSQL_SET_CHARSET_NAME, "utf8");
+      connected = mysql_real_connect(sock, host, user, password, dbname, port, mysql_socket, client_flag) ? TRUE : FALSE;
+      if (!connected)
+      {
+        mariadb_dr_do_error(dbh, mysql_errno(sock), mysql_error(sock), mysql_sqlstate(sock));
+        mariadb_db_disconnect(dbh, imp_dbh);
+        return FALSE;
+      }
+      if (mysql_get_server_version(sock) < 40100)
+      {
+        mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: MariaDB or MySQL server version is older than 4.1.0", "HY000");
+        mariadb_db_disconnect(dbh, imp_dbh);
+        return FALSE;
+      }
+    }
+    if (mysql_query(sock, "SET NAMES 'utf8mb4'") != 0 ||
+        mysql_query(sock, "SET character_set_server = 'utf8mb4'") != 0)
+    {
+      if (mysql_errno(sock) != ER_UNKNOWN_CHARACTER_SET)
+      {
+        mariadb_dr_do_error(dbh, mysql_errno(sock), mysql_error(sock), mysql_sqlstate(sock));
+        mariadb_db_disconnect(dbh, imp_dbh);
+        return FALSE;
+      }
+      if (mysql_query(sock, "SET NAMES 'utf8'") != 0 ||
+          mysql_query(sock, "SET character_set_server = 'utf8'") != 0 ||
+          mysql_query(sock, "SET collation_connection = 'utf8_unicode_ci'") != 0 ||
+          mysql_query(sock, "SET collation_server = 'utf8_unicode_ci'") != 0)
+      {
+        mariadb_dr_do_error(dbh, mysql_errno(sock), mysql_error(sock), mysql_sqlstate(sock));
+        mariadb_db_disconnect(dbh, imp_dbh);
+        return FALSE;
+      }
+    }
+    else
+    {
+      if (mysql_query(sock, "SET collation_connection = 'utf8mb4_unicode_ci'") != 0 ||
+          mysql_query(sock, "SET collation_server = 'utf8mb4_unicode_ci'") != 0)
+      {
+        mariadb_dr_do_error(dbh, mysql_errno(sock), mysql_error(sock), mysql_sqlstate(sock));
+        mariadb_db_disconnect(dbh, imp_dbh);
+        return FALSE;
+      }
+    }
+
+    /*
+      we turn off Mysql's auto reconnect and handle re-connecting ourselves
+      so that we can keep track of when this happens.
+    */
+#if MYSQL_VERSION_ID >= 50013
+    /* Beginning with MySQL 8.0.34, the automatic reconnection feature is deprecated and disabled by default. */
+#if defined(MARIADB_BASE_VERSION) || MYSQL_VERSION_ID < 80034
+    {
+      my_bool reconnect = FALSE;
+      mysql_options(sock, MYSQL_OPT_RECONNECT, &reconnect);
+    }
+#endif
+#else
+      sock->reconnect = FALSE;
+#endif
+
+    /* Connection to Embedded server does not have socket */
+    if (imp_dbh->is_embedded)
+    {
+      imp_dbh->sock_fd = -1;
+    }
+    else
+    {
+      my_socket sock_os;
+      int retval;
+
+      /*
+        mysql_get_socket() is not available:
+        - in all MySQL clients
+        - MariaDB clients prior to 5.5.38 and 10.0.11
+        - MariaDB Connector/C clients prior to 2.2.1
+        NOTE: MARIADB_PACKAGE_VERSION_ID is set since MariaDB Connector/C 2.3.5+
+      */
+#if defined(MARIADB_BASE_VERSION) && ((MYSQL_VERSION_ID >= 50538 && MYSQL_VERSION_ID < 100000) || MYSQL_VERSION_ID >= 100011 || (defined(MARIADB_PACKAGE_VERSION_ID) && MARIADB_PACKAGE_VERSION_ID >= 20201))
+      sock_os = mysql_get_socket(sock);
+#else
+      sock_os = sock->net.fd;
+#endif
+      /*
+        Client library returns socket in my_socket type, which is C file
+        descriptor on Linux or Windows native socket type on Windows.
+        On Windows it can be zero in case connection type is not socket.
+        Perl requires sockets to always be in C file descriptor type,
+        so on Windows associate it with C file descriptor via Perl's
+        win32_open_osfhandle() function.
+      */
+#ifdef _WIN32
+      imp_dbh->sock_fd = sock_os != 0 ? win32_open_osfhandle(sock_os, O_RDWR|O_BINARY) : -1;
+#else
+      imp_dbh->sock_fd = sock_os;
+#endif
+
+#ifdef _WIN32
+      if (imp_dbh->sock_fd >= 0)
+      {
+        /*
+         * Winsock SO_UPDATE_CONNECT_CONTEXT option needs to be set on the socket,
+         * otherwise getpeername, getsockname, getsockopt, setsockopt, and shutdown
+         * functions would fail with WSAENOTCONN error.
+         */
+        DWORD value = 1;
+        setsockopt(imp_dbh->sock_fd, SOL_SOCKET, SO_UPDATE_CONNECT_CONTEXT, (const char *)&value, sizeof(value));
+      }
+#endif
+
+      /*
+        MySQL and MariaDB clients do not set FD_CLOEXEC flag on socket
+        https://bugs.mysql.com/bug.php?id=3779
+        https://jira.mariadb.org/browse/CONC-405
+      */
+      retval = mariadb_dr_socket_cloexec(sock_os);
+      if (retval != 0)
+      {
+        /* Throw DBI warning when setting FD_CLOEXEC flag failed */
+        SV *errstr = DBIc_ERRSTR(imp_xxh);
+        SvUTF8_off(errstr);
+        sv_setpvf(errstr, "Cannot set close-on-exec flag: %s", strerror(-retval));
+        sv_utf8_decode(errstr);
+        sv_setuv(DBIc_ERR(imp_xxh), 0); /* 0 indicates warning */
+        sv_setpv(DBIc_STATE(imp_xxh), "01000"); /* "01000" is generic warning */
+      }
+    }
+
+          imp_dbh->async_query_in_flight = NULL;
+
+    mariadb_list_add(imp_drh->active_imp_dbhs, imp_dbh->list_entry, imp_dbh);
+
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "imp_dbh->mariadb_dr_connect: <-\n");
+
+    return TRUE;
+}
+
+/*
+  safe_hv_fetch
+*/
+static char *safe_hv_fetch(pTHX_ SV *dbh, HV *hv, const char *name, int name_length)
+{
+  SV **svp;
+  char *str;
+  STRLEN len;
+
+  svp = hv_fetch(hv, name, name_length, FALSE);
+  if (!svp || !*svp)
+    return NULL;
+
+  SvGETMAGIC(*svp);
+  if (!SvOK(*svp))
+    return NULL;
+
+  str = SvPVutf8_nomg(*svp, len);
+  if (strlen(str) != len)
+  {
+    error_nul_character(dbh, name);
+    return (void *)-1;
+  }
+
+  return str;
+}
+#define safe_hv_fetchs(dbh, hv, name) safe_hv_fetch(aTHX_ (dbh), (hv), "" name "", sizeof((name))-1)
+
+/*
+ Frontend for mariadb_dr_connect
+*/
+static bool mariadb_db_my_login(pTHX_ SV* dbh, imp_dbh_t *imp_dbh)
+{
+  SV* sv;
+  HV* hv;
+  SV **svp;
+  UV port;
+  char* dbname;
+  char* host;
+  char* user;
+  char* password;
+  char* mysql_socket;
+  struct mariadb_list_entry *entry;
+  D_imp_xxh(dbh);
+  D_imp_drh_from_dbh;
+
+  if (DBIc_has(imp_dbh, DBIcf_IMPSET))
+  { /* eg from take_imp_data() */
+    if (DBIc_has(imp_dbh, DBIcf_ACTIVE))
+    {
+      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+        PerlIO_printf(DBIc_LOGPIO(imp_xxh), "mariadb_db_my_login skip connect\n");
+
+      /* tell our parent we've adopted an active child */
+      ++DBIc_ACTIVE_KIDS(DBIc_PARENT_COM(imp_dbh));
+
+      for (entry = imp_drh->taken_pmysqls; entry; entry = entry->next)
+      {
+        if ((MYSQL *)entry->data == imp_dbh->pmysql)
+        {
+          /* Remove MYSQL* entry from taken list */
+          mariadb_list_remove(imp_drh->taken_pmysqls, entry);
+
+          /* Add imp_dbh entry into active_imp_dbhs list */
+          mariadb_list_add(imp_drh->active_imp_dbhs, imp_dbh->list_entry, imp_dbh);
+
+          return TRUE;
+        }
+      }
+
+      /* This imp_dbh data belongs to different connection, so destructor should not touch it */
+      imp_dbh->list_entry = NULL;
+      imp_dbh->pmysql = NULL;
+      imp_dbh->sock_fd = -1;
+      mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: dbi_imp_data is not valid", "HY000");
+      return FALSE;
+    }
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                    "mariadb_db_my_login IMPSET but not ACTIVE so connect not skipped\n");
+  }
+
+  sv = DBIc_IMP_DATA(imp_dbh);
+
+  if (!sv  ||  !SvROK(sv))
+    return FALSE;
+
+  hv = (HV*) SvRV(sv);
+  if (SvTYPE(hv) != SVt_PVHV)
+    return FALSE;
+
+  host = safe_hv_fetchs(dbh, hv, "host");
+  if (host == (void *)-1)
+    return FALSE;
+
+  user = safe_hv_fetchs(dbh, hv, "user");
+  if (user == (void *)-1)
+    return FALSE;
+
+  password = safe_hv_fetchs(dbh, hv, "password");
+  if (password == (void *)-1)
+    return FALSE;
+
+  dbname = safe_hv_fetchs(dbh, hv, "database");
+  if (dbname == (void *)-1)
+    return FALSE;
+
+  mysql_socket = safe_hv_fetchs(dbh, hv, "mariadb_socket");
+  if (mysql_socket == (void *)-1)
+    return FALSE;
 
-  { "smallint auto_increment", SQL_SMALLINT, 5, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "smallint auto_increment", 0, 0, 10,
-    SQL_SMALLINT, 0, 0, MYSQL_TYPE_SHORT, 1
-  },
+  port = 0;
+  svp = hv_fetchs(hv, "port", FALSE);
+  if (svp && *svp)
+  {
+    SvGETMAGIC(*svp);
+    if (SvOK(*svp))
+    {
+      port = SvUV_nomg(*svp);
+      if (port == 0 || port > UINT_MAX)
+      {
+        mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: port is not valid number", "HY000");
+        return FALSE;
+      }
+    }
+  }
 
-  { "int unsigned auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
-    0, 0, 3, 1, 0, 1, "integer unsigned auto_increment", 0, 0, 10,
-    SQL_INTEGER, 0, 0, MYSQL_TYPE_LONG, 1
-  },
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+		  "imp_dbh->mariadb_db_my_login : dbname = %s, uid = %s, pwd = %s,"
+		  " host = %s, port = %u\n",
+		  dbname ? dbname : "NULL",
+		  user ? user : "NULL",
+		  !password ? "NULL" : !password[0] ? "" : "****",
+		  host ? host : "NULL",
+		  (unsigned int)port);
 
-  { "mediumint", SQL_INTEGER, 7, NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "Medium integer", 0, 0, 10,
-    SQL_INTEGER, 0, 0, MYSQL_TYPE_INT24, 1
-  },
+  return mariadb_dr_connect(dbh, imp_dbh, mysql_socket, host, port, user, password, dbname);
+}
 
-  { "bit", SQL_BIT, 1, NULL, NULL, NULL,
-    1, 0, 3, 0, 0, 0, "bit", 0, 0, 0,
-    SQL_BIT, 0, 0,
-#if MYSQL_VERSION_ID >= NEW_DATATYPE_VERSION
-    MYSQL_TYPE_BIT,
-#else
-    MYSQL_TYPE_TINY,
-#endif
-    0
-  },
 
-  { "numeric", SQL_NUMERIC, 19, NULL, NULL, "precision,scale",
-    1, 0, 3, 0, 0, 0, "numeric", 0, 19, 10,
-    SQL_NUMERIC, 0, 0, MYSQL_TYPE_DECIMAL, 1,
-  },
+/*
+  Cache of server side prepared statements, keyed by SQL statement.
+  Statement is removed from cache while it is used by some statement handle
+  and returned back when statement handle is destroyed. Least recently used
+  statements are at the end of imp_dbh->stmt_cache list.
+*/
+static void mariadb_db_stmt_cache_shrink(pTHX_ imp_dbh_t *imp_dbh, unsigned int size)
+{
+  struct mariadb_list_entry *entry;
+  struct mariadb_list_entry *prev;
+  struct mariadb_stmt_cache_entry *cache_entry;
 
-  { "integer unsigned auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
-    0, 0, 3, 1, 0, 1, "integer unsigned auto_increment", 0, 0, 10,
-    SQL_INTEGER, 0, 0, MYSQL_TYPE_LONG, 1,
-  },
+  if (imp_dbh->stmt_cache_count <= size)
+    return;
 
-  { "mediumint unsigned", SQL_INTEGER, 8, NULL, NULL, NULL,
-    1, 0, 3, 1, 0, 0, "Medium integer unsigned", 0, 0, 10,
-    SQL_INTEGER, 0, 0, MYSQL_TYPE_INT24, 1
-  },
+  for (entry = imp_dbh->stmt_cache; entry->next; entry = entry->next);
 
-  { "smallint unsigned auto_increment", SQL_SMALLINT, 5, NULL, NULL, NULL,
-    0, 0, 3, 1, 0, 1, "smallint unsigned auto_increment", 0, 0, 10,
-    SQL_SMALLINT, 0, 0, MYSQL_TYPE_SHORT, 1
-  },
+  while (imp_dbh->stmt_cache_count > size)
+  {
+    prev = entry->prev;
+    cache_entry = (struct mariadb_stmt_cache_entry *)entry->data;
+    if (DBIc_TRACE_LEVEL(imp_dbh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\tmariadb_db_stmt_cache_shrink: closing statement %p\n", cache_entry->stmt);
+    (void)hv_delete(imp_dbh->stmt_cache_hv, cache_entry->statement, cache_entry->statement_len, G_DISCARD);
+    mysql_stmt_close(cache_entry->stmt);
+    Safefree(cache_entry->statement);
+    Safefree(cache_entry);
+    mariadb_list_remove(imp_dbh->stmt_cache, entry);
+    imp_dbh->stmt_cache_count--;
+    entry = prev;
+  }
 
-  { "int auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "integer auto_increment", 0, 0, 10,
-    SQL_INTEGER, 0, 0, MYSQL_TYPE_LONG, 1
-  },
+  if (imp_dbh->stmt_cache_count == 0 && imp_dbh->stmt_cache_hv)
+  {
+    SvREFCNT_dec(imp_dbh->stmt_cache_hv);
+    imp_dbh->stmt_cache_hv = NULL;
+  }
+}
 
-  { "long varbinary", SQL_LONGVARBINARY, 16777215, "0x", NULL, NULL,
-    1, 0, 3, 0, 0, 0, "mediumblob", 0, 0, 0,
-    SQL_LONGVARBINARY, 0, 0, MYSQL_TYPE_LONG_BLOB, 0
-  },
+static MYSQL_STMT *mariadb_db_stmt_cache_get(pTHX_ imp_dbh_t *imp_dbh, const char *statement, STRLEN statement_len)
+{
+  SV *sv;
+  MYSQL_STMT *stmt;
+  struct mariadb_list_entry *entry;
+  struct mariadb_stmt_cache_entry *cache_entry;
 
-  { "double auto_increment", SQL_FLOAT, 15, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "double auto_increment", 0, 4, 2,
-    SQL_FLOAT, 0, 0, MYSQL_TYPE_DOUBLE, 1
-  },
+  if (!imp_dbh->stmt_cache_hv || statement_len > I32_MAX)
+    return NULL;
 
-  { "double auto_increment", SQL_DOUBLE, 15, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "double auto_increment", 0, 4, 10,
-    SQL_DOUBLE, 0, 0, MYSQL_TYPE_DOUBLE, 1
-  },
+  sv = hv_delete(imp_dbh->stmt_cache_hv, statement, statement_len, 0);
+  if (!sv)
+    return NULL;
 
-  { "integer auto_increment", SQL_INTEGER, 10, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "integer auto_increment", 0, 0, 10,
-    SQL_INTEGER, 0, 0, MYSQL_TYPE_LONG, 1,
-  },
+  entry = INT2PTR(struct mariadb_list_entry *, SvIV(sv));
+  cache_entry = (struct mariadb_stmt_cache_entry *)entry->data;
+  stmt = cache_entry->stmt;
+  Safefree(cache_entry->statement);
+  Safefree(cache_entry);
+  mariadb_list_remove(imp_dbh->stmt_cache, entry);
+  imp_dbh->stmt_cache_count--;
 
-  { "bigint auto_increment", SQL_BIGINT, 19, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "bigint auto_increment", 0, 0, 10,
-    SQL_BIGINT, 0, 0, MYSQL_TYPE_LONGLONG,
-#if IVSIZE < 8
-    0
-#else
-    1
-#endif
-  },
+  if (DBIc_TRACE_LEVEL(imp_dbh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\tmariadb_db_stmt_cache_get: reusing statement %p\n", stmt);
 
-  { "bit auto_increment", SQL_BIT, 1, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "bit auto_increment", 0, 0, 0,
-    SQL_BIT, 0, 0,
-#if MYSQL_VERSION_ID >= NEW_DATATYPE_VERSION
-    MYSQL_TYPE_BIT,
-#else
-    MYSQL_TYPE_TINY,
-#endif
-    0
-  },
+  return stmt;
+}
 
-  { "mediumint auto_increment", SQL_INTEGER, 7, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "Medium integer auto_increment", 0, 0, 10,
-    SQL_INTEGER, 0, 0, MYSQL_TYPE_INT24, 1
-  },
+/*
+  Returns false when statement was not stored into cache and caller has to close it
+*/
+static bool mariadb_db_stmt_cache_put(pTHX_ imp_dbh_t *imp_dbh, const char *statement, STRLEN statement_len, MYSQL_STMT *stmt)
+{
+  struct mariadb_list_entry *entry;
+  struct mariadb_stmt_cache_entry *cache_entry;
 
-  { "float auto_increment", SQL_REAL, 7, NULL, NULL, NULL,
-    0, 0, 0, 0, 0, 1, "float auto_increment", 0, 2, 10,
-    SQL_FLOAT, 0, 0, MYSQL_TYPE_FLOAT, 1
-  },
+  if (imp_dbh->stmt_cache_size == 0 || !imp_dbh->pmysql || stmt->mysql != imp_dbh->pmysql || statement_len > I32_MAX)
+    return FALSE;
 
-  { "long varchar", SQL_LONGVARCHAR, 16777215, "'", "'", NULL,
-    1, 0, 3, 0, 0, 0, "mediumtext", 0, 0, 0,
-    SQL_LONGVARCHAR, 0, 0, MYSQL_TYPE_MEDIUM_BLOB, 1
-  },
+  /* Same statement is already cached */
+  if (imp_dbh->stmt_cache_hv && hv_exists(imp_dbh->stmt_cache_hv, statement, statement_len))
+    return FALSE;
 
-  { "tinyint auto_increment", SQL_TINYINT, 3, NULL, NULL, NULL,
-    0, 0, 3, 0, 0, 1, "tinyint auto_increment", 0, 0, 10,
-    SQL_TINYINT, 0, 0, MYSQL_TYPE_TINY, 1
-  },
+  /* Release result set of the last execution */
+  if (mysql_stmt_free_result(stmt))
+    return FALSE;
 
-  { "bigint unsigned auto_increment", SQL_BIGINT, 20, NULL, NULL, NULL,
-    0, 0, 3, 1, 0, 1, "bigint unsigned auto_increment", 0, 0, 10,
-    SQL_BIGINT, 0, 0, MYSQL_TYPE_LONGLONG,
-#if IVSIZE < 8
-    0
-#else
-    1
-#endif
-  },
+  if (!imp_dbh->stmt_cache_hv)
+    imp_dbh->stmt_cache_hv = newHV();
 
-/* END MORE STUFF */
-};
+  Newz(0, cache_entry, 1, struct mariadb_stmt_cache_entry);
+  cache_entry->statement = savepvn(statement, statement_len);
+  cache_entry->statement_len = statement_len;
+  cache_entry->stmt = stmt;
+  mariadb_list_add(imp_dbh->stmt_cache, entry, cache_entry);
+  (void)hv_store(imp_dbh->stmt_cache_hv, statement, statement_len, newSViv(PTR2IV(entry)), 0);
+  imp_dbh->stmt_cache_count++;
 
-/* 
-  static const sql_type_info_t* native2sql (int t)
-*/
-static const sql_type_info_t *native2sql(int t)
+  if (DBIc_TRACE_LEVEL(imp_dbh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\tmariadb_db_stmt_cache_put: cached statement %p\n", stmt);
+
+  mariadb_db_stmt_cache_shrink(aTHX_ imp_dbh, imp_dbh->stmt_cache_size);
+  return TRUE;
+}
+
+SV *mariadb_db_take_imp_data(SV *dbh, imp_xxh_t *imp_xxh, void *foo)
 {
-  switch (t) {
-    case MYSQL_TYPE_VAR_STRING:  return &SQL_GET_TYPE_INFO_values[0];
-    case MYSQL_TYPE_DECIMAL:     return &SQL_GET_TYPE_INFO_values[1];
-    case MYSQL_TYPE_NEWDECIMAL:  return &SQL_GET_TYPE_INFO_values[1];
-    case MYSQL_TYPE_TINY:        return &SQL_GET_TYPE_INFO_values[2];
-    case MYSQL_TYPE_SHORT:       return &SQL_GET_TYPE_INFO_values[3];
-    case MYSQL_TYPE_LONG:        return &SQL_GET_TYPE_INFO_values[4];
-    case MYSQL_TYPE_FLOAT:       return &SQL_GET_TYPE_INFO_values[5];
-    case MYSQL_TYPE_NULL:        return &SQL_GET_TYPE_INFO_values[6];
-    case MYSQL_TYPE_DOUBLE:      return &SQL_GET_TYPE_INFO_values[7];
-    case MYSQL_TYPE_TIMESTAMP:   return &SQL_GET_TYPE_INFO_values[8];
-    case MYSQL_TYPE_LONGLONG:    return &SQL_GET_TYPE_INFO_values[9];
-    case MYSQL_TYPE_INT24:       return &SQL_GET_TYPE_INFO_values[10];
-    case MYSQL_TYPE_DATE:        return &SQL_GET_TYPE_INFO_values[11];
-    case MYSQL_TYPE_TIME:        return &SQL_GET_TYPE_INFO_values[12];
-    case MYSQL_TYPE_DATETIME:    return &SQL_GET_TYPE_INFO_values[13];
-    case MYSQL_TYPE_YEAR:        return &SQL_GET_TYPE_INFO_values[14];
-    case MYSQL_TYPE_NEWDATE:     return &SQL_GET_TYPE_INFO_values[15];
-    case MYSQL_TYPE_ENUM:        return &SQL_GET_TYPE_INFO_values[16];
-    case MYSQL_TYPE_SET:         return &SQL_GET_TYPE_INFO_values[17];
-    case MYSQL_TYPE_BLOB:        return &SQL_GET_TYPE_INFO_values[18];
-    case MYSQL_TYPE_TINY_BLOB:   return &SQL_GET_TYPE_INFO_values[19];
-    case MYSQL_TYPE_MEDIUM_BLOB: return &SQL_GET_TYPE_INFO_values[20];
-    case MYSQL_TYPE_LONG_BLOB:   return &SQL_GET_TYPE_INFO_values[21];
-    case MYSQL_TYPE_STRING:      return &SQL_GET_TYPE_INFO_values[22];
-    case MYSQL_TYPE_BIT:         return &SQL_GET_TYPE_INFO_values[38];
-    default:                     return &SQL_GET_TYPE_INFO_values[0];
-  }
+  dTHX;
+  D_imp_dbh(dbh);
+  D_imp_drh_from_dbh;
+  struct mariadb_list_entry *entry;
+  PERL_UNUSED_ARG(imp_xxh);
+  PERL_UNUSED_ARG(foo);
+
+  /* Cached statements cannot be used by new owner of MYSQL* */
+  mariadb_db_stmt_cache_shrink(aTHX_ imp_dbh, 0);
+
+  /* Add MYSQL* into taken list */
+  mariadb_list_add(imp_drh->taken_pmysqls, entry, imp_dbh->pmysql);
+
+  /* MYSQL* was taken from imp_dbh so remove it also from active_imp_dbhs list */
+  mariadb_list_remove(imp_drh->active_imp_dbhs, imp_dbh->list_entry);
+
+  return &PL_sv_no;
 }
 
 
-#define SQL_GET_TYPE_INFO_num \
-	(sizeof(SQL_GET_TYPE_INFO_values)/sizeof(sql_type_info_t))
+/**************************************************************************
+ *
+ *  Name:    mariadb_db_login6_sv
+ *
+ *  Purpose: Called for connecting to a database and logging in.
+ *
+ *  Input:   dbh - database handle being initialized
+ *           imp_dbh - drivers private database handle data
+ *           dsn - the database we want to log into; may be like
+ *               "dbname:host" or "dbname:host:port"
+ *           user - user name to connect as
+ *           password - password to connect with
+ *
+ *  Returns: 1 for success, 0 otherwise; mariadb_dr_do_error has already
+ *           been called in the latter case
+ *
+ **************************************************************************/
+
+int mariadb_db_login6_sv(SV *dbh, imp_dbh_t *imp_dbh, SV *dsn, SV *user, SV *password, SV *attribs)
+{
+  dTHX; 
+  D_imp_xxh(dbh);
+  PERL_UNUSED_ARG(attribs);
+
+  SvGETMAGIC(dsn);
+  SvGETMAGIC(user);
+  SvGETMAGIC(password);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+		  "imp_dbh->connect: dsn = %s, uid = %s, pwd = %s\n",
+                  SvOK(dsn) ? neatsvpv(dsn, 0) : "NULL",
+                  SvOK(user) ? neatsvpv(user, 0) : "NULL",
+                  !SvOK(password) ? "NULL" : !(SvPV_nomg_nolen(password))[0] ? "''" : "****");
+
+  imp_dbh->stats.auto_reconnects_ok= 0;
+  imp_dbh->stats.auto_reconnects_failed= 0;
+  imp_dbh->bind_type_guessing= FALSE;
+  imp_dbh->bind_comment_placeholders= FALSE;
+  imp_dbh->auto_reconnect = FALSE;
+  imp_dbh->connected = FALSE;       /* Will be switched to TRUE after DBI->connect finish */
+  imp_dbh->is_embedded = FALSE;
+  imp_dbh->statement_buffer_max = MARIADB_STATEMENT_BUFFER_MAX;
+
+  if (!mariadb_db_my_login(aTHX_ dbh, imp_dbh))
+    return 0;
 
+  /*
+   *  Tell DBI, that dbh->disconnect should be called for this handle
+   */
+  DBIc_ACTIVE_on(imp_dbh);
 
-/***************************************************************************
- *
- *  Name:    mariadb_dr_init
- *
- *  Purpose: Called when the driver is installed by DBI
- *
- *  Input:   dbistate - pointer to the DBI state variable, used for some
- *               DBI internal things
- *
- *  Returns: Nothing
- *
- **************************************************************************/
+  /* Tell DBI, that dbh->destroy should be called for this handle */
+  DBIc_on(imp_dbh, DBIcf_IMPSET);
 
-void mariadb_dr_init(dbistate_t* dbistate)
-{
-    dTHX;
-    DBISTATE_INIT;
-    PERL_UNUSED_ARG(dbistate);
+  return 1;
 }
 
 
+static my_ulonglong mariadb_st_internal_execute(SV *h, char *sbuf, STRLEN slen, int num_params, imp_sth_ph_t *params, MYSQL_RES **result, MYSQL **svsock, bool use_mysql_use_result);
+static my_ulonglong mariadb_st_internal_execute41(SV *h, char *sbuf, STRLEN slen, int num_params, imp_sth_ph_t *params, MYSQL_RES **result, MYSQL_STMT **stmt_ptr, MYSQL_BIND *bind, MYSQL **svsock, bool *has_been_bound, bool use_mysql_use_result, unsigned long cursor_prefetch);
+
 /**************************************************************************
  *
- *  Name:    mariadb_dr_do_error
+ *  Name:    mariadb_db_do6
  *
- *  Purpose: Called to associate an error code and an error message
- *           to some handle
+ *  Purpose: Function for preparing and executing simple statement.
  *
- *  Input:   h - the handle in error condition
- *           rc - the error code
- *           what - the error message
+ *  Input:   dbh - database handle being initialized
+ *           imp_dbh - drivers private database handle data
+ *           statement - query being executed
+ *           attribs - statement attributes
+ *           items - number of arguments passed to XSUB
+ *           ax - stack base offset used by ST() macro
  *
- *  Returns: Nothing
+ *  Returns: -2 for errors, -1 for unknown number of rows, otherwise number
+ *           of rows; mariadb_dr_do_error will be called for errors
  *
  **************************************************************************/
 
-void mariadb_dr_do_error(SV* h, unsigned int rc, const char *what, const char *sqlstate)
+IV mariadb_db_do6(SV *dbh, imp_dbh_t *imp_dbh, SV *statement_sv, SV *attribs, I32 items, I32 ax)
 {
   dTHX;
-  D_imp_xxh(h);
-  SV *errstr;
-  SV *errstate;
+  I32 i;
+  my_ulonglong retval;
+  char *statement;
+  STRLEN statement_len;
+  struct imp_sth_ph_st *params = NULL;
+  MYSQL_RES *result = NULL;
+  bool async = FALSE;
+  int next_result_rc;
+  bool failed = FALSE;
+  bool cached = FALSE;
+  bool has_been_bound = FALSE;
+  bool use_server_side_prepare = FALSE;
+  bool disable_fallback_for_server_prepare = FALSE;
+  MYSQL_STMT *stmt = NULL;
+  MYSQL_BIND *bind = NULL;
+  STRLEN blen;
+  unsigned long int num_params;
+  unsigned int error;
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\t--> mariadb_dr_do_error\n");
-  errstr= DBIc_ERRSTR(imp_xxh);
-  sv_setuv(DBIc_ERR(imp_xxh), rc);	/* set err early	*/
-  SvUTF8_off(errstr);
-  sv_setpv(errstr, what);
-  sv_utf8_decode(errstr);
+  ASYNC_CHECK_RETURN(dbh, -2);
 
-  if (sqlstate)
+  if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
   {
-    errstate= DBIc_STATE(imp_xxh);
-    sv_setpv(errstate, sqlstate);
+    mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+    return -2;
   }
 
-  /* NO EFFECT DBIh_EVENT2(h, ERROR_event, DBIc_ERR(imp_xxh), errstr); */
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "error %u recorded: %" SVf "\n", rc, SVfARG(errstr));
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\t<-- mariadb_dr_do_error\n");
-}
-
-static void error_unknown_attribute(SV *h, const char *key)
-{
-  dTHX;
-  mariadb_dr_do_error(h, CR_UNKNOWN_ERROR, SvPVX(sv_2mortal(newSVpvf("Unknown attribute %s", key))), "HY000");
-}
+  SvGETMAGIC(statement_sv);
 
-static void error_nul_character(SV *h, const char *key)
-{
-  dTHX;
-  mariadb_dr_do_error(h, CR_CONNECTION_ERROR, SvPVX(sv_2mortal(newSVpvf("Connection error: %s contains nul character", key))), "HY000");
-}
+  if (items < 0)
+    items = 0;
 
-static void error_no_connection(SV *h, const char *msg)
-{
-  dTHX;
-#ifdef HAVE_LAST_ERROR
-  /* Some versions of MySQL/MariaDB clients provides last error via NULL parameter, so use it instead of generic error */
-  unsigned int last_errno = mysql_errno(NULL);
-  const char *last_error = mysql_error(NULL);
-  if (last_errno && last_error && last_error[0])
+  for (i = 0; i < items; i++)
   {
-    mariadb_dr_do_error(h, last_errno, last_error, mysql_sqlstate(NULL));
-    return;
+    SV *param = ST(i);
+    SvGETMAGIC(param);
   }
-#endif
-  mariadb_dr_do_error(h, CR_CONNECTION_ERROR, msg, "HY000");
-}
 
-static int mariadb_dr_socket_cloexec(my_socket sock_os)
-{
-#ifdef _WIN32
-  HANDLE handle = (HANDLE)sock_os;
-  DWORD flags;
-  int error;
+  (void)hv_stores((HV *)SvRV(dbh), "Statement", SvREFCNT_inc(statement_sv));
+  statement = SvPVutf8_nomg(statement_sv, statement_len);
 
-  /* Ignore connections without valid socket handle */
-  if (sock_os == 0)
-    return 0;
+  if (DBIc_DBISTATE(imp_dbh)->debug >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\t-> do() SQL statement: %.1000s%s\n", statement, statement_len > 1000 ? "..." : "");
 
-  if (!GetHandleInformation(handle, &flags))
-  {
-    error = GetLastError();
-    return error != 0 ? -error : -EINVAL;
-  }
+  /*
+   * Globally enabled using of server side prepared statement
+   * for dbh->do() statements. It is possible to force driver
+   * to use server side prepared statement mechanism by adding
+   * 'mariadb_server_prepare' attribute to do() method localy:
+   * $dbh->do($stmt, {mariadb_server_prepare=>1});
+  */
+  use_server_side_prepare = imp_dbh->use_server_side_prepare;
 
-  if (flags & HANDLE_FLAG_INHERIT)
+  DBD_ATTRIBS_CHECK("do", dbh, attribs);
+  if (attribs)
   {
-    /*
-      Clearing HANDLE_FLAG_INHERIT does not have to work for TCP sockets
-      when certain 3rd party Layered Service Providers are installed.
-      Note that perl's strerror() works also for error codes returned by
-      WinAPI GetLastError() function.
-     */
-    if (!SetHandleInformation(handle, HANDLE_FLAG_INHERIT, 0))
-    {
-      error = GetLastError();
-      return error != 0 ? -error : -EINVAL;
-    }
-  }
-#else
-  int fd = (int)sock_os;
-  int flags;
+    HV *hv;
+    HE *he;
+    SV **svp;
+    HV *processed;
 
-  flags = fcntl(fd, F_GETFD);
-  if (flags == -1)
-    return errno != 0 ? -errno : -EINVAL;
+    processed = newHV();
+    sv_2mortal(newRV_noinc((SV *)processed)); /* Automatically free HV processed */
 
-  if (!(flags & FD_CLOEXEC))
-  {
-    if (fcntl(fd, F_SETFD, flags | FD_CLOEXEC) == -1)
-      return errno != 0 ? -errno : -EINVAL;
-  }
-#endif
+    (void)hv_stores(processed, "mariadb_server_prepare", &PL_sv_yes);
+    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_server_prepare");
+    use_server_side_prepare = svp ? SvTRUE(*svp) : imp_dbh->use_server_side_prepare;
 
-  return 0;
-}
+    (void)hv_stores(processed, "mariadb_server_prepare_disable_fallback", &PL_sv_yes);
+    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_server_prepare_disable_fallback");
+    disable_fallback_for_server_prepare = svp ? SvTRUE(*svp) : imp_dbh->disable_fallback_for_server_prepare;
 
-/***************************************************************************
- *
- *  Name:    mariadb_dr_connect
- *
- *  Purpose: Replacement for mysql_connect
- *
- *  Input:   dbh - database handle being connected
- *           imp_dbh_t *imp_dbh - Pointer to internal dbh structure
- *           char* mysql_socket - Name of a UNIX socket being used
- *             or NULL
- *           char* host - Host name being used or NULL for localhost
- *           unsigned int port - Port number being used or 0 for default
- *           char* user - User name being used or NULL
- *           char* password - Password being used or NULL
- *           char* dbname - Database name being used or NULL
- *
- *  Returns: TRUE for success, FALSE otherwise; mariadb_dr_do_error will
- *           be called in the latter case
- *
- **************************************************************************/
+    (void)hv_stores(processed, "mariadb_async", &PL_sv_yes);
+    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_async");
+    async = svp ? SvTRUE(*svp) : FALSE;
 
-static bool mariadb_dr_connect(
-                        SV* dbh,
-                        imp_dbh_t *imp_dbh,
-                        char* mysql_socket,
-                        char* host,
-                        unsigned int port,
-                        char* user,
-                        char* password,
-                        char* dbname)
-{
-  unsigned int client_flag;
-  bool client_supports_utf8mb4;
-  bool connected;
-  unsigned int read_timeout, write_timeout;
-  MYSQL *sock;
-  dTHX;
-  D_imp_xxh(dbh);
-  SV *sv = DBIc_IMP_DATA(imp_dbh);
-  D_imp_drh_from_dbh;
+    hv = (HV *)SvRV(attribs);
+    hv_iterinit(hv);
+    while ((he = hv_iternext(hv)) != NULL)
+    {
+      I32 len;
+      const char *key;
 
-#ifdef MARIADB_PACKAGE_VERSION
-  bool read_timeout_set = FALSE;
-  bool write_timeout_set = FALSE;
-#endif
+      key = hv_iterkey(he, &len);
+      if (hv_exists(processed, key, len))
+        continue;
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-		  "imp_dbh->mariadb_dr_connect: host = |%s|, port = %u,"
-		  " uid = %s, pwd = %s\n",
-		  host ? host : "NULL", port,
-		  user ? user : "NULL",
-		  !password ? "NULL" : !password[0] ? "" : "****");
+      error_unknown_attribute(dbh, key);
+      return -2;
+    }
+  }
 
-#if !defined(HAVE_EMBEDDED) && defined(HAVE_BROKEN_INIT)
-  if (imp_drh->non_embedded_finished)
+  if (DBIc_DBISTATE(imp_dbh)->debug >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\t\tuse_server_side_prepare %d\n", use_server_side_prepare ? 1 : 0);
+
+  if (DBIc_DBISTATE(imp_dbh)->debug >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\t\tasync %d\n", (async ? 1 : 0));
+
+  if (async)
   {
-    mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: Method disconnect_all() was already called and library functions unloaded", "HY000");
-    return FALSE;
+    if (imp_dbh->is_embedded)
+    {
+      mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Async option not supported for Embedded server", "HY000");
+      return -2;
+    }
+    if (disable_fallback_for_server_prepare)
+    {
+      mariadb_dr_do_error(dbh, ER_UNSUPPORTED_PS, "Async option not supported with server side prepare", "HY000");
+      return -2;
+    }
+    use_server_side_prepare = FALSE; /* for now */
+    imp_dbh->async_query_in_flight = imp_dbh;
   }
-#endif
 
-  /* host=localhost means to connect via unix socket, host=embedded means to use embedded server, so do not allow specifying port */
-  if (port && host && (strcmp(host, "localhost") == 0 || strcmp(host, "embedded") == 0))
+  while ((next_result_rc = mysql_next_result(imp_dbh->pmysql)) == 0)
   {
-    mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: port cannot be specified when host is localhost or embedded", "HY000");
-    return FALSE;
+    result = mysql_store_result(imp_dbh->pmysql);
+    if (!result)
+    {
+      if (mysql_errno(imp_dbh->pmysql))
+      {
+        mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
+        return -2;
+      }
+      imp_dbh->insertid = mysql_insert_id(imp_dbh->pmysql);
+    }
+    if (result)
+    {
+      mysql_free_result(result);
+      result = NULL;
+    }
   }
 
-  /* when connecting via unix socket do not allow specifying port or host != localhost */
-  if (mysql_socket && (port || (host && strcmp(host, "localhost") != 0)))
+  if (next_result_rc > 0)
   {
-    mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: host or port cannot be specified together with mariadb_socket", "HY000");
-    return FALSE;
+#if MYSQL_VERSION_ID < 50025
+    /* Cover a protocol design error: error packet does not contain the server status.
+     * Luckily, an error always aborts execution of a statement, so it is safe to turn off the flag. */
+    imp_dbh->pmysql->server_status &= ~SERVER_MORE_RESULTS_EXISTS;
+#endif
+    /* This is error for previous unfetched result ret. So do not report server errors to caller which is expecting new result set. */
+    error = mysql_errno(imp_dbh->pmysql);
+    if (error == CR_COMMANDS_OUT_OF_SYNC || error == CR_OUT_OF_MEMORY || error == CR_SERVER_GONE_ERROR || error == CR_SERVER_LOST || error == ER_CLIENT_INTERACTION_TIMEOUT || error == CR_UNKNOWN_ERROR)
+    {
+      mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
+      return -2;
+    }
   }
 
-  if (host && strcmp(host, "embedded") == 0)
+  if (use_server_side_prepare)
   {
-#ifndef HAVE_EMBEDDED
-    mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: Embedded server is not supported", "HY000");
-    return FALSE;
-#endif
-      if (sv  &&  SvROK(sv))
-      {
-        SV** svp;
-        SV *embedded_groups = NULL;
-        SV *embedded_args = NULL;
-        STRLEN options_len;
-        char * options;
-        int server_args_cnt= 0;
-        int server_groups_cnt= 0;
-        int rc= 0;
+    stmt = mariadb_db_stmt_cache_get(aTHX_ imp_dbh, statement, statement_len);
+    cached = stmt ? TRUE : FALSE;
+    if (!stmt)
+      stmt = mysql_stmt_init(imp_dbh->pmysql);
 
-        char ** server_args = NULL;
-        char ** server_groups = NULL;
+    if (stmt && !cached && mysql_stmt_prepare(stmt, statement, statement_len))
+    {
+      if (mariadb_db_reconnect(dbh, stmt))
+      {
+        mysql_stmt_close(stmt);
+        stmt = mysql_stmt_init(imp_dbh->pmysql);
+        if (stmt && mysql_stmt_prepare(stmt, statement, statement_len))
+          failed = TRUE;
+      }
+      else
+      {
+        failed = TRUE;
+      }
+    }
 
-        HV* hv = (HV*) SvRV(sv);
+    if (!stmt)
+    {
+      mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
+      retval = (my_ulonglong)-1;
+    }
+    else if (failed)
+    {
+      /* For commands that are not supported by server side prepared statement
+         mechanism lets try to pass them through regular API */
+      if (!disable_fallback_for_server_prepare &&
+          (mysql_stmt_errno(stmt) == ER_UNSUPPORTED_PS ||
+          /* And also fallback when placeholder is used in unsupported
+           * construction with old server versions (e.g. LIMIT ?) */
+          (mysql_stmt_errno(stmt) == ER_PARSE_ERROR &&
+           mysql_get_server_version(imp_dbh->pmysql) < 50007 &&
+           strstr(mysql_stmt_error(stmt), "'?"))))
+      {
+        use_server_side_prepare = FALSE;
+      }
+      else
+      {
+        mariadb_dr_do_error(dbh, mysql_stmt_errno(stmt), mysql_stmt_error(stmt), mysql_stmt_sqlstate(stmt));
+        retval = (my_ulonglong)-1;
+      }
+      mysql_stmt_close(stmt);
+      stmt = NULL;
+    }
+    else
+    {
+      num_params = mysql_stmt_param_count(stmt);
+      if (num_params > INT_MAX)
+      {
+        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Statement contains too many placeholders", "HY000");
+        mysql_stmt_close(stmt);
+        return -2;
+      }
+      else if ((int)num_params != items)
+      {
+        mariadb_dr_do_error(dbh, ER_WRONG_ARGUMENTS, "Wrong number of bind parameters", "HY000");
+        mysql_stmt_close(stmt);
+        return -2;
+      }
 
-        if (SvTYPE(hv) != SVt_PVHV)
-          return FALSE;
+      if (items > 0)
+      {
+        Newz(0, bind, items, MYSQL_BIND);
 
-        if (imp_drh->instances == 0 && !imp_drh->non_embedded_started)
+        for (i = 0; i < items; i++)
         {
-          if ((svp = hv_fetchs(hv, "mariadb_embedded_groups", FALSE)) && *svp && SvTRUE(*svp))
-          {
-            embedded_groups = *svp;
-            options = SvPVutf8_nomg(embedded_groups, options_len);
-            if (strlen(options) != options_len)
-            {
-              error_nul_character(dbh, "mariadb_embedded_groups");
-              return FALSE;
-            }
-
-            if ((server_groups_cnt=count_embedded_options(options)))
-            {
-              /* number of server_groups always server_groups+1 */
-              server_groups = fill_out_embedded_options(options, 0, options_len, ++server_groups_cnt);
-              if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-              {
-                PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                              "Groups names passed to embedded server:\n");
-                print_embedded_options(DBIc_LOGPIO(imp_xxh), server_groups, server_groups_cnt);
-              }
-            }
-          }
-
-          if ((svp = hv_fetchs(hv, "mariadb_embedded_options", FALSE)) && *svp && SvTRUE(*svp))
+          SV *param = ST(i);
+          if (SvOK(param))
           {
-            embedded_args = *svp;
-            options = SvPVutf8_nomg(embedded_args, options_len);
-            if (strlen(options) != options_len)
-            {
-              if (server_groups_cnt)
-                free_embedded_options(server_groups, server_groups_cnt);
-              error_nul_character(dbh, "mariadb_embedded_options");
-              return FALSE;
-            }
-
-            if ((server_args_cnt=count_embedded_options(options)))
-            {
-              /* number of server_options always server_options+1 */
-              server_args = fill_out_embedded_options(options, 1, options_len, ++server_args_cnt);
-              if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-              {
-                PerlIO_printf(DBIc_LOGPIO(imp_xxh), "Server options passed to embedded server:\n");
-                print_embedded_options(DBIc_LOGPIO(imp_xxh), server_args, server_args_cnt);
-              }
-            }
+            bind[i].buffer = SvPVutf8_nomg(param, blen);
+            bind[i].buffer_length = blen;
+            bind[i].buffer_type = MYSQL_TYPE_STRING;
           }
-
-          /* Init embedded server */
-          rc = mysql_server_init(server_args_cnt, server_args, server_groups);
-
-          if (server_args_cnt)
-            free_embedded_options(server_args, server_args_cnt);
-          if (server_groups_cnt)
-            free_embedded_options(server_groups, server_groups_cnt);
-
-          if (rc)
+          else
           {
-            error_no_connection(dbh, "Connection error: Cannot start embedded server");
-            return FALSE;
+            bind[i].buffer = NULL;
+            bind[i].buffer_length = 0;
+            bind[i].buffer_type = MYSQL_TYPE_NULL;
           }
-
-          if (embedded_groups)
-            imp_drh->embedded_groups = newSVsv_nomg(embedded_groups);
-          if (embedded_args)
-            imp_drh->embedded_args = newSVsv_nomg(embedded_args);
-
-          imp_drh->embedded_started = TRUE;
         }
-        else if (imp_drh->non_embedded_started)
-        {
-          mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: Non-embedded connection was already established", "HY000");
-          return FALSE;
-        }
-        else if (imp_drh->embedded_started)
-        {
-         /*
-          * Check if embedded parameters passed to connect() differ from
-          * first ones
-          */
+      }
 
-          if ( ((svp = hv_fetchs(hv, "mariadb_embedded_groups", FALSE)) && *svp && SvTRUE(*svp)))
-            rc += abs(sv_cmp_flags(*svp, imp_drh->embedded_groups, 0));
+      retval = mariadb_st_internal_execute41(dbh, statement, statement_len, !!(items > 0), NULL, &result, &stmt, bind, &imp_dbh->pmysql, &has_been_bound, FALSE, 0);
 
-          if ( ((svp = hv_fetchs(hv, "mariadb_embedded_options", FALSE)) && *svp && SvTRUE(*svp)) )
-            rc += abs(sv_cmp_flags(*svp, imp_drh->embedded_args, 0));
+      if (bind)
+        Safefree(bind);
 
-          if (rc)
-          {
-            mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: Embedded server was already started, cannot pass different init parameters to embedded server", "HY000");
-            return FALSE;
-          }
-        }
-        else
-        {
-          mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: Unknown internal state (possible bug in driver)", "HY000");
-          return FALSE;
-        }
-      }
-  }
-  else
-  {
-    if (imp_drh->instances == 0 && !imp_drh->non_embedded_started)
-    {
-      /* negative value means to not start embedded server and just to initialize client library */
-      /* initializing client library is needed prior to any other mysql_* call from client library */
-      if (mysql_server_init(-1, NULL, NULL))
+      if (retval == (my_ulonglong)-1 || !mariadb_db_stmt_cache_put(aTHX_ imp_dbh, statement, statement_len, stmt))
+        mysql_stmt_close(stmt);
+      stmt = NULL;
+
+      if (retval == (my_ulonglong)-1) /* -1 means error */
       {
-        error_no_connection(dbh, "Connection error: Cannot initialize client library");
-        return FALSE;
+        SV *err = DBIc_ERR(imp_dbh);
+        if (!disable_fallback_for_server_prepare && SvIV(err) == ER_UNSUPPORTED_PS)
+        {
+          use_server_side_prepare = FALSE;
+        }
       }
-      imp_drh->non_embedded_started = TRUE;
     }
   }
 
-  sock = imp_dbh->pmysql = mysql_init(NULL);
-  if (!sock)
+  if (!use_server_side_prepare)
   {
-    error_no_connection(dbh, "Connection error: Cannot initialize client structures");
-    mariadb_db_disconnect(dbh, imp_dbh);
-    return FALSE;
-  }
-  imp_drh->instances++;
-
-  client_flag = CLIENT_FOUND_ROWS | CLIENT_MULTI_RESULTS;
+    num_params = count_params(imp_dbh, aTHX_ statement, statement_len, imp_dbh->bind_comment_placeholders);
+    if (num_params > INT_MAX || num_params == ULONG_MAX)
+    {
+      mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Statement contains too many placeholders", "HY000");
+      return -2;
+    }
+    else if ((int)num_params != items)
+    {
+      mariadb_dr_do_error(dbh, ER_WRONG_ARGUMENTS, "Wrong number of bind parameters", "HY000");
+      return -2;
+    }
 
-      DBIc_set(imp_dbh, DBIcf_AutoCommit, TRUE);
+    if (items > 0)
+    {
+      Newz(0, params, items, struct imp_sth_ph_st);
 
-      if (sv  &&  SvROK(sv))
+      for (i = 0; i < items; i++)
       {
-        HV* hv = (HV*) SvRV(sv);
-        HV* processed = newHV();
-        HE* he;
-        SV** svp;
-        size_t i;
+        SV *param = ST(i);
+        if (SvOK(param))
+          params[i].value = SvPVutf8_nomg(param, params[i].len);
+        else
+          params[i].value = NULL;
+        params[i].type = SQL_VARCHAR;
+      }
+    }
 
-        const char * const mariadb_ssl_attributes[] = {
-          "mariadb_ssl_optional",
-          "mariadb_ssl_verify_server_cert",
-          "mariadb_ssl_client_key",
-          "mariadb_ssl_client_cert",
-          "mariadb_ssl_ca_file",
-          "mariadb_ssl_ca_path",
-          "mariadb_ssl_cipher",
-        };
+    retval = mariadb_st_internal_execute(dbh, statement, statement_len, items, params, &result, &imp_dbh->pmysql, FALSE);
+  }
 
-        sv_2mortal(newRV_noinc((SV *)processed)); /* Automatically free HV processed */
+  if (params)
+    Safefree(params);
 
-        /* These options are already handled and processed */
-        (void)hv_stores(processed, "host", &PL_sv_yes);
-        (void)hv_stores(processed, "port", &PL_sv_yes);
-        (void)hv_stores(processed, "user", &PL_sv_yes);
-        (void)hv_stores(processed, "password", &PL_sv_yes);
-        (void)hv_stores(processed, "database", &PL_sv_yes);
-        (void)hv_stores(processed, "mariadb_socket", &PL_sv_yes);
+  /* Some MySQL client versions return correct value from mysql_insert_id()
+   * function only after non-SELECT operation. So store insert id into dbh
+   * cache and later read it only from cache. */
+  if (retval != (my_ulonglong)-1 && !async && !result)
+    imp_dbh->insertid = mysql_insert_id(imp_dbh->pmysql);
 
-#ifdef HAVE_EMBEDDED
-      if (host && strcmp(host, "embedded") == 0)
-      {
-        (void)hv_stores(processed, "mariadb_embedded_groups", &PL_sv_yes);
-        (void)hv_stores(processed, "mariadb_embedded_options", &PL_sv_yes);
+  if (result)
+  {
+    mysql_free_result(result);
+    result = NULL;
+  }
 
-        mysql_options(sock, MYSQL_OPT_USE_EMBEDDED_CONNECTION, NULL);
-        imp_dbh->is_embedded = TRUE;
-        host = NULL;
-      }
-      else
+  if (retval != (my_ulonglong)-1 && !async) /* -1 means error */
+  {
+    /* more results? -1 = no, >0 = error, 0 = yes (keep looping) */
+    while ((next_result_rc = mysql_next_result(imp_dbh->pmysql)) == 0)
+    {
+      result = mysql_store_result(imp_dbh->pmysql);
+      if (mysql_errno(imp_dbh->pmysql))
       {
-        mysql_options(sock, MYSQL_OPT_USE_REMOTE_CONNECTION, NULL);
+        next_result_rc = 1;
+        break;
       }
-#endif
-
-        /* thanks to Peter John Edwards for mysql_init_command */ 
-        (void)hv_stores(processed, "mariadb_init_command", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_init_command", FALSE)) && *svp && SvTRUE(*svp))
-        {
-          STRLEN len;
-          char* df = SvPVutf8_nomg(*svp, len);
-          if (strlen(df) != len)
-          {
-            error_nul_character(dbh, "mariadb_init_command");
-            mariadb_db_disconnect(dbh, imp_dbh);
-            return FALSE;
-          }
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                           "imp_dbh->mariadb_dr_connect: Setting"
-                           " init command (%s).\n", df);
-          mysql_options(sock, MYSQL_INIT_COMMAND, df);
-        }
-
-        (void)hv_stores(processed, "mariadb_compression", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_compression", FALSE)) && *svp && SvTRUE(*svp))
-        {
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                          "imp_dbh->mariadb_dr_connect: Enabling"
-                          " compression.\n");
-          mysql_options(sock, MYSQL_OPT_COMPRESS, NULL);
-        }
-
-        (void)hv_stores(processed, "mariadb_connect_timeout", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_connect_timeout", FALSE)) && *svp)
-        {
-          UV uv = SvUV(*svp);
-          unsigned int to = (uv <= UINT_MAX ? uv : UINT_MAX);
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                          "imp_dbh->mariadb_dr_connect: Setting"
-                          " connect timeout (%u).\n", to);
-          mysql_options(sock, MYSQL_OPT_CONNECT_TIMEOUT,
-                        (const char *)&to);
-        }
-
-        (void)hv_stores(processed, "mariadb_write_timeout", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_write_timeout", FALSE)) && *svp)
-        {
-          UV uv = SvUV(*svp);
-          write_timeout = (uv <= UINT_MAX ? uv : UINT_MAX);
-#ifdef MARIADB_PACKAGE_VERSION
-          write_timeout_set = TRUE;
-#endif
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                          "imp_dbh->mariadb_dr_connect: Setting"
-                          " write timeout (%u).\n", write_timeout);
-          mysql_options(sock, MYSQL_OPT_WRITE_TIMEOUT, (const char *)&write_timeout);
-        }
+      if (!result) /* Next statement without result set, new insert id */
+        imp_dbh->insertid = mysql_insert_id(imp_dbh->pmysql);
+      if (result)
+        mysql_free_result(result);
+      result = NULL;
+    }
 
-        (void)hv_stores(processed, "mariadb_read_timeout", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_read_timeout", FALSE)) && *svp)
-        {
-          UV uv = SvUV(*svp);
-          read_timeout = (uv <= UINT_MAX ? uv : UINT_MAX);
-#ifdef MARIADB_PACKAGE_VERSION
-          read_timeout_set = TRUE;
+    if (next_result_rc > 0)
+    {
+#if MYSQL_VERSION_ID < 50025
+      /* Cover a protocol design error: error packet does not contain the server status.
+       * Luckily, an error always aborts execution of a statement, so it is safe to turn off the flag. */
+      imp_dbh->pmysql->server_status &= ~SERVER_MORE_RESULTS_EXISTS;
 #endif
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                          "imp_dbh->mariadb_dr_connect: Setting"
-                          " read timeout (%u).\n", read_timeout);
-          mysql_options(sock, MYSQL_OPT_READ_TIMEOUT, (const char *)&read_timeout);
-        }
 
-#ifdef MARIADB_PACKAGE_VERSION
-        {
-          /* Version is in format: "2.3.2" */
-          const char version[] = MARIADB_PACKAGE_VERSION;
-          bool broken_timeouts;
+      if (DBIc_DBISTATE(imp_dbh)->debug >= 2)
+        PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\t<- do() ERROR: %s\n", mysql_error(imp_dbh->pmysql));
 
-          if (sizeof(version) != 6 || version[0] != '2' || version[1] != '.' || version[3] != '.' || version[5] != '\0')
-            broken_timeouts = FALSE;
-          else if (version[2] >= '0' && version[2] < '3' && version[4] >= '0' && version[4] <= '9')
-            broken_timeouts = TRUE;
-          else if (version[2] == '3' && version[4] >= '0' && version[4] < '3')
-            broken_timeouts = TRUE;
-          else
-            broken_timeouts = FALSE;
+      mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
+      retval = (my_ulonglong)-1;
+    }
+  }
 
-          if (broken_timeouts)
-          {
-            /*
-              MariaDB Connector/C prior to version 2.3.3 has broken MYSQL_OPT_WRITE_TIMEOUT.
-              Write timeout is set by MYSQL_OPT_READ_TIMEOUT option.
-              See file libmariadb/libmariadb.c, line "vio_write_timeout(net->vio, mysql->options.read_timeout);".
-              Therefore specifying different read and write timeout is not possible.
-             */
-            if ((read_timeout_set || write_timeout_set) && (!read_timeout_set || !write_timeout_set || read_timeout != write_timeout))
-            {
-              mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: Specifying different mariadb_read_timeout and mariadb_write_timeout is broken by current version of MariaDB/MySQL client", "HY000");
-              mariadb_db_disconnect(dbh, imp_dbh);
-              return FALSE;
-            }
+  if (retval == (my_ulonglong)-1)
+    return -2;
+  else if (retval <= IV_MAX)
+    return retval;
+  else
+    return -1;
+}
 
-            /*
-              MariaDB Connector/C prior to version 2.3.3 has broken zero write timeout.
-              See file libmariadb/violite.c, function vio_write(). Variable vio->write_timeout
-              is signed and on some places zero value is tested as "boolean" and on some as "> 0".
-              Therefore we need to force non-zero timeout, otherwise some operation fail.
-              Maximal possible value is INT_MAX/1000. So use it for simulation of infinite timeout.
-              Also set this timeout when no timeout was provided.
-             */
-            if ((!read_timeout_set || !write_timeout_set) || write_timeout == 0)
-            {
-              read_timeout = INT_MAX/1000;
-              write_timeout = INT_MAX/1000;
-              mysql_options(sock, MYSQL_OPT_READ_TIMEOUT, (const char *)&read_timeout);
-              mysql_options(sock, MYSQL_OPT_WRITE_TIMEOUT, (const char *)&write_timeout);
-            }
-          }
-        }
-#endif
 
-        (void)hv_stores(processed, "mariadb_max_allowed_packet", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_max_allowed_packet", FALSE)) && *svp && SvTRUE(*svp))
-        {
-          UV uv = SvUV_nomg(*svp);
-          unsigned long packet_size = (uv <= ULONG_MAX ? uv : ULONG_MAX);
-#if (!defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 50709 && MYSQL_VERSION_ID != 60000) || (defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 100206 && MYSQL_VERSION_ID != 100300)
-          /* MYSQL_OPT_MAX_ALLOWED_PACKET was added in mysql 5.7.9 */
-          /* MYSQL_OPT_MAX_ALLOWED_PACKET was added in MariaDB 10.2.6 and MariaDB 10.3.1 */
-          mysql_options(sock, MYSQL_OPT_MAX_ALLOWED_PACKET, &packet_size);
-#else
-          /* before MySQL 5.7.9 and MariaDB 10.2.6 and MariaDB 10.3.0 use max_allowed_packet macro */
-          max_allowed_packet = packet_size;
-#endif
-        }
+/***************************************************************************
+ *
+ *  Name:    mariadb_db_commit
+ *           mariadb_db_rollback
+ *
+ *  Purpose: You guess what they should do. 
+ *
+ *  Input:   dbh - database handle being committed or rolled back
+ *           imp_dbh - drivers private database handle data
+ *
+ *  Returns: 1 for success, 0 otherwise; mariadb_dr_do_error has already
+ *           been called in the latter case
+ *
+ **************************************************************************/
 
-        (void)hv_stores(processed, "mariadb_skip_secure_auth", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_skip_secure_auth", FALSE)) && *svp && SvTRUE(*svp))
-        {
-          int error = 1;
-#ifdef HAVE_SECURE_AUTH
-          my_bool secauth = FALSE;
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                          "imp_dbh->mariadb_dr_connect: Skipping"
-                          " secure auth\n");
-          error = mysql_options(sock, MYSQL_SECURE_AUTH, &secauth);
-#endif
-          if (error)
-          {
-            mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: mariadb_skip_secure_auth=1 is not supported", "HY000");
-            mariadb_db_disconnect(dbh, imp_dbh);
-            return FALSE;
-          }
-        }
+int
+mariadb_db_commit(SV* dbh, imp_dbh_t* imp_dbh)
+{
+  if (DBIc_has(imp_dbh, DBIcf_AutoCommit))
+    return 0;
 
-        (void)hv_stores(processed, "mariadb_auth_plugin", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_auth_plugin", FALSE)) && *svp)
-        {
-          int error = 1;
-          STRLEN len;
-          char *auth_plugin = SvPVutf8(*svp, len);
-          if (strlen(auth_plugin) != len)
-          {
-            error_nul_character(dbh, "mariadb_auth_plugin");
-            mariadb_db_disconnect(dbh, imp_dbh);
-            return FALSE;
-          }
-#if MYSQL_VERSION_ID >= 50507 && MYSQL_VERSION_ID != 60000
-          error = mysql_options(sock, MYSQL_DEFAULT_AUTH, auth_plugin);
-#endif
-          if (error)
-          {
-            mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: mariadb_auth_plugin is not supported", "HY000");
-            mariadb_db_disconnect(dbh, imp_dbh);
-            return FALSE;
-          }
-        }
+  ASYNC_CHECK_RETURN(dbh, 0);
 
-        (void)hv_stores(processed, "mariadb_read_default_file", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_read_default_file", FALSE)) && *svp && SvTRUE(*svp))
-        {
-          STRLEN len;
-          char* df = SvPVutf8_nomg(*svp, len);
-          if (strlen(df) != len)
-          {
-            error_nul_character(dbh, "mariadb_read_default_file");
-            mariadb_db_disconnect(dbh, imp_dbh);
-            return FALSE;
-          }
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                          "imp_dbh->mariadb_dr_connect: Reading"
-                          " default file %s.\n", df);
-          mysql_options(sock, MYSQL_READ_DEFAULT_FILE, df);
-        }
+  if (!imp_dbh->pmysql)
+  {
+    mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "No connection to server", "HY000");
+    return 0;
+  }
 
-        (void)hv_stores(processed, "mariadb_read_default_group", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_read_default_group", FALSE)) && *svp && SvTRUE(*svp))
-        {
-          STRLEN len;
-          char* gr = SvPVutf8_nomg(*svp, len);
-          if (strlen(gr) != len)
-          {
-            error_nul_character(dbh, "mariadb_read_default_group");
-            mariadb_db_disconnect(dbh, imp_dbh);
-            return FALSE;
-          }
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                    "imp_dbh->mariadb_dr_connect: Using"
-                    " default group %s.\n", gr);
+    if (mysql_commit(imp_dbh->pmysql))
+    {
+      mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql)
+               ,mysql_sqlstate(imp_dbh->pmysql));
+      return 0;
+    }
 
-          mysql_options(sock, MYSQL_READ_DEFAULT_GROUP, gr);
-        }
+  return 1;
+}
 
-        (void)hv_stores(processed, "mariadb_conn_attrs", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_conn_attrs", FALSE)) && *svp)
-        {
-        /* mysql_options4 with MYSQL_OPT_CONNECT_ATTR_ADD is supported by libraries:
-         * MariaDB 10.0.5+ and any MariaDB Connector/C; MySQL 5.6.6+ except MySQL Connector/C 6.0.0
-         */
-        #if (defined(MARIADB_BASE_VERSION) && (MYSQL_VERSION_ID >= 100005 || defined(MARIADB_PACKAGE_VERSION))) || (!defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 50606 && MYSQL_VERSION_ID != 60000)
-              HV* attrs = (HV*) SvRV(*svp);
-              HE* entry = NULL;
-              I32 num_entries = hv_iterinit(attrs);
-              while (num_entries && (entry = hv_iternext(attrs))) {
-                  I32 attr_name_len = 0;
-                  char *attr_name = hv_iterkey(entry, &attr_name_len);
-                  SV *sv_attr_val = hv_iterval(attrs, entry);
-                  STRLEN attr_val_len;
-                  char *attr_val  = SvPVutf8(sv_attr_val, attr_val_len);
-                  if (strlen(attr_name) != (STRLEN)attr_name_len || strlen(attr_val) != attr_val_len)
-                  {
-                    error_nul_character(dbh, "mariadb_conn_attrs");
-                    mariadb_db_disconnect(dbh, imp_dbh);
-                    return FALSE;
-                  }
-                  mysql_options4(sock, MYSQL_OPT_CONNECT_ATTR_ADD, attr_name, attr_val);
-              }
-        #else
-              mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: mariadb_conn_attrs is not supported", "HY000");
-              mariadb_db_disconnect(dbh, imp_dbh);
-              return FALSE;
-        #endif
-        }
+/*
+ mariadb_db_rollback
+*/
+int
+mariadb_db_rollback(SV* dbh, imp_dbh_t* imp_dbh) {
+  /* report error, if not in AutoCommit mode */
+  if (DBIc_has(imp_dbh, DBIcf_AutoCommit))
+    return 0;
 
-        (void)hv_stores(processed, "mariadb_client_found_rows", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_client_found_rows", FALSE)) && *svp && !SvTRUE(*svp))
-          client_flag &= ~CLIENT_FOUND_ROWS;
+  ASYNC_CHECK_RETURN(dbh, 0);
 
-        (void)hv_stores(processed, "mariadb_auto_reconnect", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_auto_reconnect", FALSE)) && *svp)
-        {
-          imp_dbh->auto_reconnect = SvTRUE(*svp);
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                          "imp_dbh->auto_reconnect: %d\n",
-                          imp_dbh->auto_reconnect);
-        }
+  /* No connection to server, nothing to rollback */
+  if (!imp_dbh->pmysql)
+    return 1;
 
-        (void)hv_stores(processed, "mariadb_use_result", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_use_result", FALSE)) && *svp)
-        {
-          imp_dbh->use_mysql_use_result = SvTRUE(*svp);
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                          "imp_dbh->use_mysql_use_result: %d\n",
-                          imp_dbh->use_mysql_use_result ? 1 : 0);
-        }
+      if (mysql_rollback(imp_dbh->pmysql))
+      {
+        mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql),
+                 mysql_error(imp_dbh->pmysql) ,mysql_sqlstate(imp_dbh->pmysql));
+        return 0;
+      }
 
-        (void)hv_stores(processed, "mariadb_bind_type_guessing", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_bind_type_guessing", FALSE)) && *svp)
-        {
-          imp_dbh->bind_type_guessing= SvTRUE(*svp);
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                          "imp_dbh->bind_type_guessing: %d\n",
-                          imp_dbh->bind_type_guessing);
-        }
+  return 1;
+}
 
-        (void)hv_stores(processed, "mariadb_bind_comment_placeholders", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_bind_comment_placeholders", FALSE)) && *svp)
-        {
-          imp_dbh->bind_comment_placeholders = SvTRUE(*svp);
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                          "imp_dbh->bind_comment_placeholders: %d\n",
-                          imp_dbh->bind_comment_placeholders);
-        }
+static void mariadb_dr_close_mysql(pTHX_ imp_drh_t *imp_drh, MYSQL *pmysql)
+{
+  if (pmysql)
+  {
+    mysql_close(pmysql);
+    imp_drh->instances--;
+  }
+  if (imp_drh->instances == 0)
+  {
+    /*
+     * Some MariaDB and MySQL clients have a bug which cause:
+     * - inability to successfully initialize a new network connection, even after mysql_server_init()
+     * - infinite loop when calling mysql_server_end() more then once in case Embedded server was not started
+     * Therefore do not call mysql_server_end() when Embedded server was not in used.
+     * These bugs were fixed in MariaDB Connector/C 3.0.5, see: https://jira.mariadb.org/browse/CONC-336
+     * And fixed also in MySQL 8.0.20, see: https://bugs.mysql.com/bug.php?id=93276
+     * But remains in MariaDB Embedded server, see: https://jira.mariadb.org/browse/MDEV-16578
+     */
+#if !defined(HAVE_BROKEN_INIT) && (defined(HAVE_DEINITIALIZE_SSL) || !defined(HAVE_PROBLEM_WITH_OPENSSL))
+    if (imp_drh->non_embedded_started)
+    {
+      mysql_server_end();
+      imp_drh->non_embedded_started = FALSE;
+    }
+#endif
+    if (imp_drh->embedded_started)
+    {
+      mysql_server_end();
+      imp_drh->embedded_started = FALSE;
+#if !defined(HAVE_DEINITIALIZE_SSL) && defined(HAVE_PROBLEM_WITH_OPENSSL)
+      warn("DBD::MariaDB disconnect: Client library deinitialized OpenSSL library functions and module Net::SSLeay is now broken");
+#endif
+    }
+    if (imp_drh->embedded_args)
+    {
+      (void)SvREFCNT_dec(imp_drh->embedded_args);
+      imp_drh->embedded_args = NULL;
+    }
+    if (imp_drh->embedded_groups)
+    {
+      (void)SvREFCNT_dec(imp_drh->embedded_groups);
+      imp_drh->embedded_groups = NULL;
+    }
+  }
+}
 
-        (void)hv_stores(processed, "mariadb_no_autocommit_cmd", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_no_autocommit_cmd", FALSE)) && *svp)
-        {
-          imp_dbh->no_autocommit_cmd= SvTRUE(*svp);
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                          "imp_dbh->no_autocommit_cmd: %d\n",
-                          imp_dbh->no_autocommit_cmd);
-        }
+static void mariadb_db_close_mysql(pTHX_ imp_drh_t *imp_drh, imp_dbh_t *imp_dbh)
+{
+  AV *av;
+  I32 i;
+  MAGIC *mg;
+  SV **svp;
+  SV *sv;
+  SV *sth;
+  imp_sth_t *imp_sth;
+
+  if (DBIc_TRACE_LEVEL(imp_dbh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\tmariadb_db_close_mysql: imp_dbh=%p pmysql=%p\n", imp_dbh, imp_dbh->pmysql);
+
+  DBIc_ACTIVE_off(imp_dbh);
 
-        (void)hv_stores(processed, "mariadb_use_fabric", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_use_fabric", FALSE)) && *svp && SvTRUE(*svp))
-        {
-#ifdef HAVE_FABRIC
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                          "imp_dbh->use_fabric: Enabling use of"
-                          " MySQL Fabric.\n");
-          mysql_options(sock, MYSQL_OPT_USE_FABRIC, NULL);
+  if (imp_dbh->list_entry)
+    mariadb_list_remove(imp_drh->active_imp_dbhs, imp_dbh->list_entry);
+
+  if (imp_dbh->pmysql)
+  {
+    /* Cached statements are bound to this connection, which includes reconnect */
+    mariadb_db_stmt_cache_shrink(aTHX_ imp_dbh, 0);
+    mariadb_dr_close_mysql(aTHX_ imp_drh, imp_dbh->pmysql);
+    imp_dbh->pmysql = NULL;
+    imp_dbh->server_max_allowed_packet = 0;
+#ifdef _WIN32
+    /*
+      C file descriptor sock_fd on Windows was opened via win32_open_osfhandle()
+      function from the Windows native socket. Therefore sock_fd needs to be
+      closed via close() function. This function also closes original Windows
+      native socket from which was sock_fd opened. But Windows native socket
+      was already closed by mariadb_dr_close_mysql() function and therefore we
+      need to avoid closing it more times. So first disassociate Windows native
+      socket from C file descriptor sock_fd via _set_osfhnd() function and then
+      close sock_fd via close() function.
+    */
+    if (imp_dbh->sock_fd >= 0)
+    {
+#ifdef _UCRT
+    /*
+      Disassociation is not possible for UCRT builds as UCRT does not provide
+      access to native Windows handle. Skipping disassociation introduce race
+      condition, double close, possible closing of recycled handle and crashes.
+     */
+    #warning DBD::MariaDB compiled with UCRT runtime may crash
 #else
-          mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: mariadb_use_fabric is not supported", "HY000");
-          mariadb_db_disconnect(dbh, imp_dbh);
-          return FALSE;
+    _set_osfhnd(imp_dbh->sock_fd, INVALID_HANDLE_VALUE);
 #endif
-        }
-
-        (void)hv_stores(processed, "mariadb_multi_statements", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_multi_statements", FALSE)) && *svp && SvTRUE(*svp))
+    close(imp_dbh->sock_fd);
+    }
+#endif
+    imp_dbh->sock_fd = -1;
+    svp = hv_fetchs((HV*)DBIc_MY_H(imp_dbh), "ChildHandles", FALSE);
+    if (svp && *svp)
+    {
+      SvGETMAGIC(*svp);
+      if (SvROK(*svp) && SvTYPE(SvRV(*svp)) == SVt_PVAV)
+      {
+        av = (AV *)SvRV(*svp);
+        for (i = AvFILL(av); i >= 0; --i)
         {
-          imp_dbh->use_multi_statements = TRUE;
-          client_flag |= CLIENT_MULTI_STATEMENTS;
+          svp = av_fetch(av, i, FALSE);
+          if (!svp || !*svp || !sv_isobject(*svp) || SvTYPE(SvRV(*svp)) != SVt_PVHV)
+            continue;
+          sv = SvRV(*svp);
+          /* get inner DBI handle (sth) from outer DBI handle (sv) */
+          if (!SvMAGICAL(sv))
+            continue;
+          mg = mg_find(sv, 'P');
+          if (!mg)
+            continue;
+          sth = mg->mg_obj;
+          imp_sth = (imp_sth_t *)DBIh_COM(sth);
+          if (DBIc_TYPE(imp_sth) != DBIt_ST)
+            continue;
+          /* mysql_close() should properly invalidates MYSQL* pointers in
+           * MYSQL_STMT structures. But MariaDB and MySQL clients affected by
+           * CVE 2017-3302 do not do it. So do it manually to prevent crash. */
+          if (imp_sth->stmt && imp_sth->stmt->mysql)
+          {
+            if (DBIc_TRACE_LEVEL(imp_dbh) >= 2)
+              PerlIO_printf(DBIc_LOGPIO(imp_dbh), "Applying CVE 2017-3302 workaround for sth=%p\n", imp_sth);
+            imp_sth->stmt->mysql = NULL;
+          }
         }
+      }
+    }
+  }
+}
 
-        (void)hv_stores(processed, "mariadb_server_prepare", &PL_sv_yes);
-	if ((svp = hv_fetchs(hv, "mariadb_server_prepare", FALSE)) && *svp)
-          imp_dbh->use_server_side_prepare = SvTRUE(*svp);
-        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-          PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                        "imp_dbh->use_server_side_prepare: %d\n",
-                        imp_dbh->use_server_side_prepare ? 1 : 0);
-
-        if (imp_dbh->bind_type_guessing && imp_dbh->use_server_side_prepare)
-        {
-          mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: mariadb_bind_type_guessing and mariadb_server_prepare cannot be enabled together", "HY000");
-          mariadb_db_disconnect(dbh, imp_dbh);
-          return FALSE;
-        }
+/*
+ ***************************************************************************
+ *
+ *  Name:    mariadb_db_disconnect
+ *
+ *  Purpose: Disconnect a database handle from its database
+ *
+ *  Input:   dbh - database handle being disconnected
+ *           imp_dbh - drivers private database handle data
+ *
+ *  Returns: 1 for success (always)
+ *
+ **************************************************************************/
 
-        (void)hv_stores(processed, "mariadb_server_prepare_disable_fallback", &PL_sv_yes);
-        if ((svp = hv_fetchs(hv, "mariadb_server_prepare_disable_fallback", FALSE)) && *svp)
-          imp_dbh->disable_fallback_for_server_prepare = SvTRUE(*svp);
-        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-          PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                        "imp_dbh->disable_fallback_for_server_prepare: %d\n",
-                        imp_dbh->disable_fallback_for_server_prepare ? 1 : 0);
+int mariadb_db_disconnect(SV* dbh, imp_dbh_t* imp_dbh)
+{
+  dTHX;
+  D_imp_drh_from_dbh;
+  PERL_UNUSED_ARG(dbh);
 
-        (void)hv_stores(processed, "mariadb_ssl", &PL_sv_yes);
-        for (i = 0; i < sizeof(mariadb_ssl_attributes)/sizeof(*mariadb_ssl_attributes); i++)
-          (void)hv_store(processed, mariadb_ssl_attributes[i], strlen(mariadb_ssl_attributes[i]), &PL_sv_yes, 0);
-	if ((svp = hv_fetchs(hv, "mariadb_ssl", FALSE)) && *svp && SvTRUE(*svp))
-          {
-	    char *client_key = NULL;
-	    char *client_cert = NULL;
-	    char *ca_file = NULL;
-	    char *ca_path = NULL;
-	    char *cipher = NULL;
-	    STRLEN len = 0;
-  #if defined(HAVE_SSL_MODE) || defined(HAVE_SSL_MODE_ONLY_REQUIRED)
-	    unsigned int ssl_mode;
-  #endif
-	    my_bool ssl_enforce = TRUE;
-	    my_bool ssl_verify = FALSE;
-  #ifndef HAVE_SSL_MODE
-	    my_bool ssl_verify_set = FALSE;
-  #endif
+  /* We assume that disconnect will always work       */
+  /* since most errors imply already disconnected.    */
+  mariadb_db_close_mysql(aTHX_ imp_drh, imp_dbh);
 
-	    if ((svp = hv_fetchs(hv, "mariadb_ssl_optional", FALSE)) && *svp)
-	      ssl_enforce = !SvTRUE(*svp);
+  /* We don't free imp_dbh since a reference still exists    */
+  /* The DESTROY method is the only one to 'free' memory.    */
+  return 1;
+}
 
-            /* Verify if the hostname we connect to matches the hostname in the certificate */
-	    if ((svp = hv_fetchs(hv, "mariadb_ssl_verify_server_cert", FALSE)) && *svp)
-	    {
-  #if defined(HAVE_SSL_VERIFY) || defined(HAVE_SSL_MODE)
-	      ssl_verify = SvTRUE(*svp);
-    #ifndef HAVE_SSL_MODE
-	      ssl_verify_set = TRUE;
-    #endif
-  #else
-	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: mariadb_ssl_verify_server_cert=1 is not supported", "HY000");
-	      mariadb_db_disconnect(dbh, imp_dbh);
-	      return FALSE;
-  #endif
-	    }
 
-	    if ((svp = hv_fetchs(hv, "mariadb_ssl_client_key", FALSE)) && *svp)
-	    {
-	      client_key = SvPVutf8(*svp, len);
-	      if (strlen(client_key) != len)
-	      {
-	        error_nul_character(dbh, "mariadb_ssl_client_key");
-	        mariadb_db_disconnect(dbh, imp_dbh);
-	        return FALSE;
-	      }
-	    }
+/***************************************************************************
+ *
+ *  Name:    mariadb_dr_discon_all
+ *
+ *  Purpose: Disconnect all database handles at shutdown time
+ *
+ *  Input:   dbh - database handle being disconnected
+ *           imp_dbh - drivers private database handle data
+ *
+ *  Returns: 1 for success, 0 otherwise
+ *
+ **************************************************************************/
 
-	    if ((svp = hv_fetchs(hv, "mariadb_ssl_client_cert", FALSE)) && *svp)
-	    {
-	      client_cert = SvPVutf8(*svp, len);
-	      if (strlen(client_cert) != len)
-	      {
-	        error_nul_character(dbh, "mariadb_ssl_client_cert");
-	        mariadb_db_disconnect(dbh, imp_dbh);
-	        return FALSE;
-	      }
-	    }
+int mariadb_dr_discon_all (SV *drh, imp_drh_t *imp_drh) {
+  dTHX;
+  int ret;
+  struct mariadb_list_entry *entry;
+  PERL_UNUSED_ARG(drh);
 
-	    if ((svp = hv_fetchs(hv, "mariadb_ssl_ca_file", FALSE)) && *svp)
-	    {
-	      ca_file = SvPVutf8(*svp, len);
-	      if (strlen(ca_file) != len)
-	      {
-	        error_nul_character(dbh, "mariadb_ssl_ca_file");
-	        mariadb_db_disconnect(dbh, imp_dbh);
-	        return FALSE;
-	      }
-	    }
+  while ((entry = imp_drh->taken_pmysqls))
+  {
+    mariadb_dr_close_mysql(aTHX_ imp_drh, (MYSQL *)entry->data);
+    mariadb_list_remove(imp_drh->taken_pmysqls, entry);
+  }
 
-	    if ((svp = hv_fetchs(hv, "mariadb_ssl_ca_path", FALSE)) && *svp)
-	    {
-	      ca_path = SvPVutf8(*svp, len);
-	      if (strlen(ca_path) != len)
-	      {
-	        error_nul_character(dbh, "mariadb_ssl_ca_path");
-	        mariadb_db_disconnect(dbh, imp_dbh);
-	        return FALSE;
-	      }
-	    }
+  while (imp_drh->active_imp_dbhs)
+    mariadb_db_close_mysql(aTHX_ imp_drh, (imp_dbh_t *)imp_drh->active_imp_dbhs->data);
 
-	    if ((svp = hv_fetchs(hv, "mariadb_ssl_cipher", FALSE)) && *svp)
-	    {
-	      cipher = SvPVutf8(*svp, len);
-	      if (strlen(cipher) != len)
-	      {
-	        error_nul_character(dbh, "mariadb_ssl_cipher");
-	        mariadb_db_disconnect(dbh, imp_dbh);
-	        return FALSE;
-	      }
-	    }
+  ret = 1;
 
-  #if !defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 80300
-	    if (mysql_options(sock, MYSQL_OPT_SSL_KEY, client_key) != 0 ||
-	        mysql_options(sock, MYSQL_OPT_SSL_CERT, client_cert) != 0 ||
-	        mysql_options(sock, MYSQL_OPT_SSL_CA, ca_file) != 0 ||
-	        mysql_options(sock, MYSQL_OPT_SSL_CAPATH, ca_path) != 0 ||
-	        mysql_options(sock, MYSQL_OPT_SSL_CIPHER, cipher) != 0) {
-	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Setting SSL options failed", "HY000");
-	      mariadb_db_disconnect(dbh, imp_dbh);
-	      return FALSE;
-	    }
+  if (imp_drh->instances)
+  {
+    warn("DBD::MariaDB disconnect_all: %lu database handlers were not released (possible bug in driver)", imp_drh->instances);
+    ret = 0;
+  }
+
+  if (imp_drh->embedded_started)
+  {
+    warn("DBD::MariaDB disconnect_all: Embedded server was not properly stopped (possible bug in driver)");
+    ret = 0;
+  }
+
+  /* Some MariaDB and MySQL clients with Embedded server support have a bug which cause segfault
+   * when trying to call mysql_server_end() when Embedded server was not started. So do not call
+   * mysql_server_end() for normal connections when we have Embedded server support. */
+#ifndef HAVE_EMBEDDED
+  if (imp_drh->non_embedded_started)
+  {
+ #if defined(HAVE_DEINITIALIZE_SSL) || !defined(HAVE_PROBLEM_WITH_OPENSSL)
+  #ifndef HAVE_BROKEN_INIT
+    warn("DBD::MariaDB disconnect_all: Client library was not properly deinitialized (possible bug in driver)");
+    ret = 0;
   #else
-	    mysql_ssl_set(sock, client_key, client_cert, ca_file,
-			  ca_path, cipher);
+    mysql_server_end();
+    imp_drh->non_embedded_started = FALSE;
+    imp_drh->non_embedded_finished = TRUE;
   #endif
+ #endif
+  }
+#endif
 
-	    if (ssl_verify && !(ca_file || ca_path)) {
-	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: mariadb_ssl_verify_server_cert=1 is not supported without mariadb_ssl_ca_file or mariadb_ssl_ca_path", "HY000");
-	      mariadb_db_disconnect(dbh, imp_dbh);
-	      return FALSE;
-	    }
-
-  #ifdef HAVE_SSL_MODE
+  if (imp_drh->embedded_args)
+  {
+    warn("DBD::MariaDB disconnect_all: mariadb_embedded_options was not released (possible bug in driver)");
+    ret = 0;
+  }
 
-	    if (!ssl_enforce)
-	      ssl_mode = SSL_MODE_PREFERRED;
-	    else if (ssl_verify)
-	      ssl_mode = SSL_MODE_VERIFY_IDENTITY;
-	    else if (ca_file || ca_path)
-	      ssl_mode = SSL_MODE_VERIFY_CA;
-	    else
-	      ssl_mode = SSL_MODE_REQUIRED;
-	    if (mysql_options(sock, MYSQL_OPT_SSL_MODE, &ssl_mode) != 0) {
-	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Enforcing SSL encryption is not supported", "HY000");
-	      mariadb_db_disconnect(dbh, imp_dbh);
-	      return FALSE;
-	    }
+  if (imp_drh->embedded_groups)
+  {
+    warn("DBD::MariaDB disconnect_all: mariadb_embedded_groups was not released (possible bug in driver)");
+    ret = 0;
+  }
 
-  #else
+  return ret;
+}
 
-	    if (ssl_enforce) {
-    #if defined(HAVE_SSL_MODE_ONLY_REQUIRED)
-	      ssl_mode = SSL_MODE_REQUIRED;
-	      if (mysql_options(sock, MYSQL_OPT_SSL_MODE, &ssl_mode) != 0) {
-	        mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Enforcing SSL encryption is not supported", "HY000");
-	        mariadb_db_disconnect(dbh, imp_dbh);
-	        return FALSE;
-	      }
-    #elif defined(HAVE_SSL_ENFORCE)
-	      if (mysql_options(sock, MYSQL_OPT_SSL_ENFORCE, &ssl_enforce) != 0) {
-	        mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Enforcing SSL encryption is not supported", "HY000");
-	        mariadb_db_disconnect(dbh, imp_dbh);
-	        return FALSE;
-	      }
-    #elif defined(HAVE_SSL_VERIFY)
-	      if (!ssl_verify_also_enforce_ssl()) {
-	        mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Enforcing SSL encryption is not supported", "HY000");
-	        mariadb_db_disconnect(dbh, imp_dbh);
-	        return FALSE;
-	      }
-	      if (ssl_verify_set && !ssl_verify) {
-	        mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Enforcing SSL encryption is not supported without mariadb_ssl_verify_server_cert=1", "HY000");
-	        mariadb_db_disconnect(dbh, imp_dbh);
-	        return FALSE;
-	      }
-	      ssl_verify = TRUE;
-    #else
-	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: Enforcing SSL encryption is not supported", "HY000");
-	      mariadb_db_disconnect(dbh, imp_dbh);
-	      return FALSE;
-    #endif
-	    }
 
-    #ifdef HAVE_SSL_VERIFY
-	    if (!ssl_enforce && ssl_verify && ssl_verify_also_enforce_ssl()) {
-	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: mariadb_ssl_optional=1 with mariadb_ssl_verify_server_cert=1 is not supported", "HY000");
-	      mariadb_db_disconnect(dbh, imp_dbh);
-	      return FALSE;
-	    }
-    #endif
+/****************************************************************************
+ *
+ *  Name:    mariadb_db_destroy
+ *
+ *  Purpose: Our part of the dbh destructor
+ *
+ *  Input:   dbh - database handle being destroyed
+ *           imp_dbh - drivers private database handle data
+ *
+ *  Returns: Nothing
+ *
+ **************************************************************************/
 
-	    if (ssl_verify) {
-	      if (!ssl_verify_usable() && ssl_enforce && ssl_verify_set) {
-	        mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: mariadb_ssl_verify_server_cert=1 is broken by current version of MariaDB/MySQL client", "HY000");
-	        mariadb_db_disconnect(dbh, imp_dbh);
-	        return FALSE;
-	      }
-    #ifdef HAVE_SSL_VERIFY
-	      if (mysql_options(sock, MYSQL_OPT_SSL_VERIFY_SERVER_CERT, &ssl_verify) != 0) {
-	        mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: mariadb_ssl_verify_server_cert=1 is not supported", "HY000");
-	        mariadb_db_disconnect(dbh, imp_dbh);
-	        return FALSE;
-	      }
-    #else
-	      mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, "SSL connection error: mariadb_ssl_verify_server_cert=1 is not supported", "HY000");
-	      mariadb_db_disconnect(dbh, imp_dbh);
-	      return FALSE;
-    #endif
-	    }
+void mariadb_db_destroy(SV* dbh, imp_dbh_t* imp_dbh) {
 
-  #endif
-	  }
-	else
-	  {
-	    for (i = 0; i < sizeof(mariadb_ssl_attributes)/sizeof(*mariadb_ssl_attributes); i++)
-	      {
-	        if ((svp = hv_fetch(hv, mariadb_ssl_attributes[i], strlen(mariadb_ssl_attributes[i]), FALSE)) && *svp)
-	          {
-	            mariadb_dr_do_error(dbh, CR_SSL_CONNECTION_ERROR, SvPVX(sv_2mortal(newSVpvf("SSL connection error: SSL attribute %s was specified but SSL encryption was not enabled via mariadb_ssl=1", mariadb_ssl_attributes[i]))), "HY000");
-	            mariadb_db_disconnect(dbh, imp_dbh);
-	            return FALSE;
-	          }
-	      }
+    /*
+     *  Being on the safe side never hurts ...
+     */
+  if (DBIc_ACTIVE(imp_dbh))
+  {
+      if (!DBIc_has(imp_dbh, DBIcf_AutoCommit) && imp_dbh->pmysql)
+        if (mysql_rollback(imp_dbh->pmysql))
+          mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
+    mariadb_db_disconnect(dbh, imp_dbh);
+  }
 
-#ifdef HAVE_SSL_MODE
-	    unsigned int ssl_mode = SSL_MODE_DISABLED;
-	    mysql_options(sock, MYSQL_OPT_SSL_MODE, &ssl_mode);
-#endif
-	  }
-        (void)hv_stores(processed, "mariadb_local_infile", &PL_sv_yes);
-     if ((svp = hv_fetchs(hv, "mariadb_local_infile", FALSE)) && *svp)
-     {
-	  unsigned int flag = SvTRUE(*svp);
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-	    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-        "imp_dbh->mariadb_dr_connect: Using"
-        " local infile %u.\n", flag);
-	  mysql_options(sock, MYSQL_OPT_LOCAL_INFILE, (const char *) &flag);
-	}
+  /* Tell DBI, that dbh->destroy must no longer be called */
+  DBIc_off(imp_dbh, DBIcf_IMPSET);
+}
 
-        hv_iterinit(hv);
-        while ((he = hv_iternext(hv)) != NULL)
-        {
-          I32 len;
-          const char *key;
-          key = hv_iterkey(he, &len);
-          if (skip_attribute(key) || hv_exists(processed, key, len))
-            continue;
-          error_unknown_attribute(dbh, key);
-          mariadb_db_disconnect(dbh, imp_dbh);
-          return FALSE;
-        }
-      }
+/* 
+ ***************************************************************************
+ *
+ *  Name:    mariadb_db_STORE_attrib
+ *
+ *  Purpose: Function for storing dbh attributes; we currently support
+ *           just nothing. :-)
+ *
+ *  Input:   dbh - database handle being modified
+ *           imp_dbh - drivers private database handle data
+ *           keysv - the attribute name
+ *           valuesv - the attribute value
+ *
+ *  Returns: 1 for success, 0 otherwise
+ *
+ **************************************************************************/
+/* DBI expects that on AutoCommit failure driver croaks and does not return */
+#define croak_autocommit_failure() croak("Changing AutoCommit attribute failed: %" SVf, SVfARG(DBIc_ERRSTR(imp_dbh)))
+int
+mariadb_db_STORE_attrib(
+                    SV* dbh,
+                    imp_dbh_t* imp_dbh,
+                    SV* keysv,
+                    SV* valuesv
+                   )
+{
+  dTHX;
+  STRLEN kl;
+  char *key = SvPV(keysv, kl); /* needs to process get magic */
+  const bool bool_value = SvTRUE_nomg(valuesv);
 
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "imp_dbh->mariadb_dr_connect: client_flags = %d\n",
-		    client_flag);
+  if (memEQs(key, kl, "AutoCommit"))
+  {
+      bool oldval = DBIc_has(imp_dbh, DBIcf_AutoCommit) ? TRUE : FALSE;
 
-    /*
-      MySQL's "utf8mb4" charset is capable of handling 4-byte UTF-8 characters.
-      MySQL's "utf8" charset is capable of handling only up to 3-byte UTF-8 characters.
-      MySQL's "utf8mb4" charset was introduced in MySQL server version 5.5.3.
-      If MySQL's "utf8mb4" is not supported by server, fallback to MySQL's "utf8".
-      If MySQL's "utf8mb4" is not supported by client, connect with "utf8" and issue SET NAMES 'utf8mb4'.
-      MYSQL_SET_CHARSET_NAME option (prior to establishing connection) sets client's charset.
-      Some clients think that they were connected with MYSQL_SET_CHARSET_NAME, but reality can be different.
-      This problem was reported in MariaDB bug tracker https://jira.mariadb.org/browse/CONC-342
-      but problem is not going to be fixed. So always manually issue SET NAMES to prevent misbehave.
-      To enable UTF-8 storage on server it is needed to configure it via session variable character_set_server.
-      Some clients provides function get_charset_number() to check if charset is supported.
-      If MySQL client does not support specified charset it used to print error message to stdout or stderr.
-      DBD::MariaDB expects that whole communication with server is encoded in UTF-8.
-      By default broken utf8mb4_general_ci collation is used. So change it to utf8mb4_unicode_ci which is according to the Unicode 4.0.0.
-    */
-#ifdef HAVE_GET_CHARSET_NUMBER
-    client_supports_utf8mb4 = get_charset_number("utf8mb4", MY_CS_PRIMARY) ? TRUE : FALSE;
-#elif MYSQL_VERSION_ID < 50503
-    client_supports_utf8mb4 = FALSE;
-#else
-    client_supports_utf8mb4 = TRUE;
-#endif
-    connected = FALSE;
-    if (client_supports_utf8mb4)
-    {
-      mysql_options(sock, MYSQL_SET_CHARSET_NAME, "utf8mb4");
-      connected = mysql_real_connect(sock, host, user, password, dbname, port, mysql_socket, client_flag | CLIENT_REMEMBER_OPTIONS) ? TRUE : FALSE;
-      if (!connected && mysql_errno(sock) != CR_CANT_READ_CHARSET)
-      {
-        mariadb_dr_do_error(dbh, mysql_errno(sock), mysql_error(sock), mysql_sqlstate(sock));
-        mariadb_db_disconnect(dbh, imp_dbh);
-        return FALSE;
-      }
-      if (connected && mysql_get_server_version(sock) < 40100)
+      if (bool_value == oldval)
+        return 1;
+
+      /* if setting AutoCommit on ... */
+      if (!imp_dbh->no_autocommit_cmd)
       {
-        mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: MariaDB or MySQL server version is older than 4.1.0", "HY000");
-        mariadb_db_disconnect(dbh, imp_dbh);
-        return FALSE;
+        if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
+        {
+          mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+          croak_autocommit_failure(); /* does not return */
+        }
+        if (
+            mysql_autocommit(imp_dbh->pmysql, bool_value)
+           )
+        {
+          mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
+          croak_autocommit_failure(); /* does not return */
+        }
       }
-    }
-    if (!connected)
+      DBIc_set(imp_dbh, DBIcf_AutoCommit, bool_value);
+  }
+  else if (strBEGINs(key, "mariadb_"))
+  {
+    if (memEQs(key, kl, "mariadb_use_result"))
+      imp_dbh->use_mysql_use_result = bool_value;
+    else if (memEQs(key, kl, "mariadb_auto_reconnect"))
+      imp_dbh->auto_reconnect = bool_value;
+    else if (memEQs(key, kl, "mariadb_server_prepare"))
     {
-      mysql_options(sock, MYSQL_SET_CHARSET_NAME, "utf8");
-      connected = mysql_real_connect(sock, host, user, password, dbname, port, mysql_socket, client_flag) ? TRUE : FALSE;
-      if (!connected)
-      {
-        mariadb_dr_do_error(dbh, mysql_errno(sock), mysql_error(sock), mysql_sqlstate(sock));
-        mariadb_db_disconnect(dbh, imp_dbh);
-        return FALSE;
-      }
-      if (mysql_get_server_version(sock) < 40100)
+      if (bool_value && imp_dbh->bind_type_guessing)
       {
-        mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: MariaDB or MySQL server version is older than 4.1.0", "HY000");
-        mariadb_db_disconnect(dbh, imp_dbh);
-        return FALSE;
+        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "mariadb_bind_type_guessing and mariadb_server_prepare cannot be enabled together", "HY000");
+        return 0;
       }
+      imp_dbh->use_server_side_prepare = bool_value;
     }
-    if (mysql_query(sock, "SET NAMES 'utf8mb4'") != 0 ||
-        mysql_query(sock, "SET character_set_server = 'utf8mb4'") != 0)
+    else if (memEQs(key, kl, "mariadb_server_prepare_disable_fallback"))
+      imp_dbh->disable_fallback_for_server_prepare = bool_value;
+    else if (memEQs(key, kl, "mariadb_stmt_cache_size"))
     {
-      if (mysql_errno(sock) != ER_UNKNOWN_CHARACTER_SET)
-      {
-        mariadb_dr_do_error(dbh, mysql_errno(sock), mysql_error(sock), mysql_sqlstate(sock));
-        mariadb_db_disconnect(dbh, imp_dbh);
-        return FALSE;
-      }
-      if (mysql_query(sock, "SET NAMES 'utf8'") != 0 ||
-          mysql_query(sock, "SET character_set_server = 'utf8'") != 0 ||
-          mysql_query(sock, "SET collation_connection = 'utf8_unicode_ci'") != 0 ||
-          mysql_query(sock, "SET collation_server = 'utf8_unicode_ci'") != 0)
-      {
-        mariadb_dr_do_error(dbh, mysql_errno(sock), mysql_error(sock), mysql_sqlstate(sock));
-        mariadb_db_disconnect(dbh, imp_dbh);
-        return FALSE;
-      }
+      UV uv = SvOK(valuesv) ? SvUV_nomg(valuesv) : 0;
+      imp_dbh->stmt_cache_size = (uv <= UINT_MAX) ? uv : UINT_MAX;
+      mariadb_db_stmt_cache_shrink(aTHX_ imp_dbh, imp_dbh->stmt_cache_size);
     }
-    else
+    else if (memEQs(key, kl, "mariadb_cursor_prefetch"))
     {
-      if (mysql_query(sock, "SET collation_connection = 'utf8mb4_unicode_ci'") != 0 ||
-          mysql_query(sock, "SET collation_server = 'utf8mb4_unicode_ci'") != 0)
-      {
-        mariadb_dr_do_error(dbh, mysql_errno(sock), mysql_error(sock), mysql_sqlstate(sock));
-        mariadb_db_disconnect(dbh, imp_dbh);
-        return FALSE;
-      }
+      UV uv = SvOK(valuesv) ? SvUV_nomg(valuesv) : 0;
+      imp_dbh->cursor_prefetch = (uv <= ULONG_MAX) ? uv : ULONG_MAX;
     }
-
-      /*
-        we turn off Mysql's auto reconnect and handle re-connecting ourselves
-        so that we can keep track of when this happens.
-      */
-#if MYSQL_VERSION_ID >= 50013
-    /* Beginning with MySQL 8.0.34, the automatic reconnection feature is deprecated and disabled by default. */
-#if defined(MARIADB_BASE_VERSION) || MYSQL_VERSION_ID < 80034
+    else if (memEQs(key, kl, "mariadb_statement_buffer_max"))
     {
-      my_bool reconnect = FALSE;
-      mysql_options(sock, MYSQL_OPT_RECONNECT, &reconnect);
+      UV uv = SvOK(valuesv) ? SvUV_nomg(valuesv) : 0;
+      imp_dbh->statement_buffer_max = (uv <= (UV)SSize_t_MAX) ? uv : (UV)SSize_t_MAX;
     }
-#endif
-#else
-      sock->reconnect = FALSE;
-#endif
-
-    /* Connection to Embedded server does not have socket */
-    if (imp_dbh->is_embedded)
+    else if (memEQs(key, kl, "mariadb_temporal_mode"))
     {
-      imp_dbh->sock_fd = -1;
+      if (!parse_temporal_mode(aTHX_ dbh, valuesv, &imp_dbh->temporal_mode))
+        return 0;
     }
-    else
+    else if (memEQs(key, kl, "mariadb_decimal_mode"))
     {
-      my_socket sock_os;
-      int retval;
-
-      /*
-        mysql_get_socket() is not available:
-        - in all MySQL clients
-        - MariaDB clients prior to 5.5.38 and 10.0.11
-        - MariaDB Connector/C clients prior to 2.2.1
-        NOTE: MARIADB_PACKAGE_VERSION_ID is set since MariaDB Connector/C 2.3.5+
-      */
-#if defined(MARIADB_BASE_VERSION) && ((MYSQL_VERSION_ID >= 50538 && MYSQL_VERSION_ID < 100000) || MYSQL_VERSION_ID >= 100011 || (defined(MARIADB_PACKAGE_VERSION_ID) && MARIADB_PACKAGE_VERSION_ID >= 20201))
-      sock_os = mysql_get_socket(sock);
-#else
-      sock_os = sock->net.fd;
-#endif
-      /*
-        Client library returns socket in my_socket type, which is C file
-        descriptor on Linux or Windows native socket type on Windows.
-        On Windows it can be zero in case connection type is not socket.
-        Perl requires sockets to always be in C file descriptor type,
-        so on Windows associate it with C file descriptor via Perl's
-        win32_open_osfhandle() function.
-      */
-#ifdef _WIN32
-      imp_dbh->sock_fd = sock_os != 0 ? win32_open_osfhandle(sock_os, O_RDWR|O_BINARY) : -1;
-#else
-      imp_dbh->sock_fd = sock_os;
-#endif
-
-#ifdef _WIN32
-      if (imp_dbh->sock_fd >= 0)
+      if (!parse_decimal_mode(aTHX_ dbh, valuesv, &imp_dbh->decimal_mode))
+        return 0;
+    }
+    else if (memEQs(key, kl, "mariadb_no_autocommit_cmd"))
+      imp_dbh->no_autocommit_cmd = bool_value;
+    else if (memEQs(key, kl, "mariadb_bind_type_guessing"))
+    {
+      if (bool_value && imp_dbh->use_server_side_prepare)
       {
-        /*
-         * Winsock SO_UPDATE_CONNECT_CONTEXT option needs to be set on the socket,
-         * otherwise getpeername, getsockname, getsockopt, setsockopt, and shutdown
-         * functions would fail with WSAENOTCONN error.
-         */
-        DWORD value = 1;
-        setsockopt(imp_dbh->sock_fd, SOL_SOCKET, SO_UPDATE_CONNECT_CONTEXT, (const char *)&value, sizeof(value));
+        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "mariadb_bind_type_guessing and mariadb_server_prepare cannot be enabled together", "HY000");
+        return 0;
       }
-#endif
-
-      /*
-        MySQL and MariaDB clients do not set FD_CLOEXEC flag on socket
-        https://bugs.mysql.com/bug.php?id=3779
-        https://jira.mariadb.org/browse/CONC-405
-      */
-      retval = mariadb_dr_socket_cloexec(sock_os);
-      if (retval != 0)
+      imp_dbh->bind_type_guessing = bool_value;
+    }
+    else if (memEQs(key, kl, "mariadb_bind_comment_placeholders"))
+      imp_dbh->bind_comment_placeholders = bool_value;
+  #ifdef HAVE_FABRIC
+    else if (memEQs(key, kl, "mariadb_fabric_opt_group"))
+    {
+      STRLEN len;
+      char *str = SvPVutf8_nomg(valuesv, len);
+      if (strlen(str) != len)
       {
-        /* Throw DBI warning when setting FD_CLOEXEC flag failed */
-        SV *errstr = DBIc_ERRSTR(imp_xxh);
-        SvUTF8_off(errstr);
-        sv_setpvf(errstr, "Cannot set close-on-exec flag: %s", strerror(-retval));
-        sv_utf8_decode(errstr);
-        sv_setuv(DBIc_ERR(imp_xxh), 0); /* 0 indicates warning */
-        sv_setpv(DBIc_STATE(imp_xxh), "01000"); /* "01000" is generic warning */
+        error_nul_character(dbh, "mariadb_fabric_opt_group");
+        return 0;
+      }
+      if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
+      {
+        mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+        return 0;
       }
+      mysql_options(imp_dbh->pmysql, FABRIC_OPT_GROUP, str);
     }
-
-          imp_dbh->async_query_in_flight = NULL;
-
-    mariadb_list_add(imp_drh->active_imp_dbhs, imp_dbh->list_entry, imp_dbh);
-
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "imp_dbh->mariadb_dr_connect: <-\n");
-
-    return TRUE;
-}
-
-/*
-  safe_hv_fetch
-*/
-static char *safe_hv_fetch(pTHX_ SV *dbh, HV *hv, const char *name, int name_length)
-{
-  SV **svp;
-  char *str;
-  STRLEN len;
-
-  svp = hv_fetch(hv, name, name_length, FALSE);
-  if (!svp || !*svp)
-    return NULL;
-
-  SvGETMAGIC(*svp);
-  if (!SvOK(*svp))
-    return NULL;
-
-  str = SvPVutf8_nomg(*svp, len);
-  if (strlen(str) != len)
-  {
-    error_nul_character(dbh, name);
-    return (void *)-1;
-  }
-
-  return str;
-}
-#define safe_hv_fetchs(dbh, hv, name) safe_hv_fetch(aTHX_ (dbh), (hv), "" name "", sizeof((name))-1)
-
-/*
- Frontend for mariadb_dr_connect
-*/
-static bool mariadb_db_my_login(pTHX_ SV* dbh, imp_dbh_t *imp_dbh)
-{
-  SV* sv;
-  HV* hv;
-  SV **svp;
-  UV port;
-  char* dbname;
-  char* host;
-  char* user;
-  char* password;
-  char* mysql_socket;
-  struct mariadb_list_entry *entry;
-  D_imp_xxh(dbh);
-  D_imp_drh_from_dbh;
-
-  if (DBIc_has(imp_dbh, DBIcf_IMPSET))
-  { /* eg from take_imp_data() */
-    if (DBIc_has(imp_dbh, DBIcf_ACTIVE))
+    else if (memEQs(key, kl, "mariadb_fabric_opt_default_mode"))
+    {
+      if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
+      {
+        mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+        return 0;
+      }
+      if (SvOK(valuesv)) {
+        STRLEN len;
+        const char *str = SvPV_nomg(valuesv, len);
+        if (len == 0 || memEQs(str, len, "ro") || memEQs(str, len, "rw"))
+          mysql_options(imp_dbh->pmysql, FABRIC_OPT_DEFAULT_MODE, len == 0 ? NULL : str);
+        else
+        {
+          mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Valid settings for FABRIC_OPT_DEFAULT_MODE are 'ro', 'rw', or undef/empty string", "HY000");
+          return 0;
+        }
+      }
+      else {
+        mysql_options(imp_dbh->pmysql, FABRIC_OPT_DEFAULT_MODE, NULL);
+      }
+    }
+    else if (memEQs(key, kl, "mariadb_fabric_opt_mode"))
+    {
+      STRLEN len;
+      const char *str = SvPV_nomg(valuesv, len);
+      if (!memEQs(str, len, "ro") && !memEQs(str, len, "rw"))
+      {
+        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Valid settings for FABRIC_OPT_MODE are 'ro' or 'rw'", "HY000");
+        return 0;
+      }
+      if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
+      {
+        mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+        return 0;
+      }
+      mysql_options(imp_dbh->pmysql, FABRIC_OPT_MODE, str);
+    }
+    else if (memEQs(key, kl, "mariadb_fabric_opt_group_credentials"))
     {
-      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-        PerlIO_printf(DBIc_LOGPIO(imp_xxh), "mariadb_db_my_login skip connect\n");
-
-      /* tell our parent we've adopted an active child */
-      ++DBIc_ACTIVE_KIDS(DBIc_PARENT_COM(imp_dbh));
-
-      for (entry = imp_drh->taken_pmysqls; entry; entry = entry->next)
+      mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "'fabric_opt_group_credentials' is not supported", "HY000");
+      return 0;
+    }
+  #endif
+    else if (memEQs(key, kl, "mariadb_max_allowed_packet"))
+    {
+      if (imp_dbh->is_embedded)
       {
-        if ((MYSQL *)entry->data == imp_dbh->pmysql)
-        {
-          /* Remove MYSQL* entry from taken list */
-          mariadb_list_remove(imp_drh->taken_pmysqls, entry);
-
-          /* Add imp_dbh entry into active_imp_dbhs list */
-          mariadb_list_add(imp_drh->active_imp_dbhs, imp_dbh->list_entry, imp_dbh);
-
-          return TRUE;
-        }
+        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "mariadb_max_allowed_packet is not supported for Embedded server", "HY000");
+        return 0;
       }
-
-      /* This imp_dbh data belongs to different connection, so destructor should not touch it */
-      imp_dbh->list_entry = NULL;
-      imp_dbh->pmysql = NULL;
-      imp_dbh->sock_fd = -1;
-      mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: dbi_imp_data is not valid", "HY000");
-      return FALSE;
+#if (!defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 50709 && MYSQL_VERSION_ID != 60000) || (defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 100206 && MYSQL_VERSION_ID != 100300)
+      /* MYSQL_OPT_MAX_ALLOWED_PACKET was added in mysql 5.7.9 */
+      /* MYSQL_OPT_MAX_ALLOWED_PACKET was added in MariaDB 10.2.6 and MariaDB 10.3.1 */
+      UV uv = SvUV_nomg(valuesv);
+      unsigned long packet_size = (uv <= ULONG_MAX ? uv : ULONG_MAX);
+      if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
+      {
+        mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+        return 0;
+      }
+      mysql_options(imp_dbh->pmysql, MYSQL_OPT_MAX_ALLOWED_PACKET, &packet_size);
+#else
+      /* before MySQL 5.7.9 and MariaDB 10.2.6 and MariaDB 10.3.0 it is not possible to change max_allowed_packet after connection was established */
+      if (imp_dbh->connected)
+        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Changing mariadb_max_allowed_packet is not supported after connection was established", "HY000");
+      return 0;
+#endif
     }
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                    "mariadb_db_my_login IMPSET but not ACTIVE so connect not skipped\n");
-  }
-
-  sv = DBIc_IMP_DATA(imp_dbh);
-
-  if (!sv  ||  !SvROK(sv))
-    return FALSE;
-
-  hv = (HV*) SvRV(sv);
-  if (SvTYPE(hv) != SVt_PVHV)
-    return FALSE;
-
-  host = safe_hv_fetchs(dbh, hv, "host");
-  if (host == (void *)-1)
-    return FALSE;
-
-  user = safe_hv_fetchs(dbh, hv, "user");
-  if (user == (void *)-1)
-    return FALSE;
-
-  password = safe_hv_fetchs(dbh, hv, "password");
-  if (password == (void *)-1)
-    return FALSE;
-
-  dbname = safe_hv_fetchs(dbh, hv, "database");
-  if (dbname == (void *)-1)
-    return FALSE;
-
-  mysql_socket = safe_hv_fetchs(dbh, hv, "mariadb_socket");
-  if (mysql_socket == (void *)-1)
-    return FALSE;
-
-  port = 0;
-  svp = hv_fetchs(hv, "port", FALSE);
-  if (svp && *svp)
-  {
-    SvGETMAGIC(*svp);
-    if (SvOK(*svp))
+    else if (memEQs(key, kl, "mariadb_multi_statements"))
     {
-      port = SvUV_nomg(*svp);
-      if (port == 0 || port > UINT_MAX)
+      if (!imp_dbh->connected) /* When not connected, it is handled in mariadb_dr_connect() */
+        return 0;
+      if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
       {
-        mariadb_dr_do_error(dbh, CR_CONNECTION_ERROR, "Connection error: port is not valid number", "HY000");
-        return FALSE;
+        mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+        return 0;
+      }
+      if (mysql_set_server_option(imp_dbh->pmysql, bool_value ? MYSQL_OPTION_MULTI_STATEMENTS_ON : MYSQL_OPTION_MULTI_STATEMENTS_OFF) != 0)
+      {
+        mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
+        return 0;
       }
+      imp_dbh->use_multi_statements = bool_value;
+    }
+    else
+    {
+      if (imp_dbh->connected) /* Ignore unknown attributes passed by DBI->connect, they are handled in mariadb_dr_connect() */
+        error_unknown_attribute(dbh, key);
+      return 0;
     }
   }
+  else if (memEQs(key, kl, "LongReadLen"))
+  {
+    /* Value is stored by DBI, only remember that it was set */
+    imp_dbh->long_read_len_set = TRUE;
+    return 0;
+  }
+  else
+  {
+    if (!skip_attribute(key)) /* Not handled by this driver */
+      error_unknown_attribute(dbh, key);
+    return 0;
+  }
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-		  "imp_dbh->mariadb_db_my_login : dbname = %s, uid = %s, pwd = %s,"
-		  " host = %s, port = %u\n",
-		  dbname ? dbname : "NULL",
-		  user ? user : "NULL",
-		  !password ? "NULL" : !password[0] ? "" : "****",
-		  host ? host : "NULL",
-		  (unsigned int)port);
-
-  return mariadb_dr_connect(dbh, imp_dbh, mysql_socket, host, port, user, password, dbname);
+  return 1;
 }
 
-
-SV *mariadb_db_take_imp_data(SV *dbh, imp_xxh_t *imp_xxh, void *foo)
+#if IVSIZE < 8
+static char *
+my_ulonglong2str(my_ulonglong val, char *buf, STRLEN *len)
 {
-  dTHX;
-  D_imp_dbh(dbh);
-  D_imp_drh_from_dbh;
-  struct mariadb_list_entry *entry;
-  PERL_UNUSED_ARG(imp_xxh);
-  PERL_UNUSED_ARG(foo);
-
-  /* Add MYSQL* into taken list */
-  mariadb_list_add(imp_drh->taken_pmysqls, entry, imp_dbh->pmysql);
+  char *ptr = buf + *len - 1;
 
-  /* MYSQL* was taken from imp_dbh so remove it also from active_imp_dbhs list */
-  mariadb_list_remove(imp_drh->active_imp_dbhs, imp_dbh->list_entry);
+  if (*len < 2)
+  {
+    *len = 0;
+    return NULL;
+  }
 
-  return &PL_sv_no;
-}
+  if (val == 0)
+  {
+    buf[0] = '0';
+    buf[1] = '\0';
+    *len = 1;
+    return buf;
+  }
 
+  *ptr = '\0';
+  while (val > 0)
+  {
+    if (ptr == buf)
+    {
+      *len = 0;
+      return NULL;
+    }
+    *(--ptr) = ('0' + (val % 10));
+    val = val / 10;
+  }
 
-/**************************************************************************
- *
- *  Name:    mariadb_db_login6_sv
- *
- *  Purpose: Called for connecting to a database and logging in.
- *
- *  Input:   dbh - database handle being initialized
- *           imp_dbh - drivers private database handle data
- *           dsn - the database we want to log into; may be like
- *               "dbname:host" or "dbname:host:port"
- *           user - user name to connect as
- *           password - password to connect with
- *
- *  Returns: 1 for success, 0 otherwise; mariadb_dr_do_error has already
- *           been called in the latter case
- *
- **************************************************************************/
+  *len = (buf + *len - 1) - ptr;
+  return ptr;
+}
 
-int mariadb_db_login6_sv(SV *dbh, imp_dbh_t *imp_dbh, SV *dsn, SV *user, SV *password, SV *attribs)
+static char*
+signed_my_ulonglong2str(my_ulonglong val, char *buf, STRLEN *len)
 {
-  dTHX; 
-  D_imp_xxh(dbh);
-  PERL_UNUSED_ARG(attribs);
-
-  SvGETMAGIC(dsn);
-  SvGETMAGIC(user);
-  SvGETMAGIC(password);
-
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-		  "imp_dbh->connect: dsn = %s, uid = %s, pwd = %s\n",
-                  SvOK(dsn) ? neatsvpv(dsn, 0) : "NULL",
-                  SvOK(user) ? neatsvpv(user, 0) : "NULL",
-                  !SvOK(password) ? "NULL" : !(SvPV_nomg_nolen(password))[0] ? "''" : "****");
-
-  imp_dbh->stats.auto_reconnects_ok= 0;
-  imp_dbh->stats.auto_reconnects_failed= 0;
-  imp_dbh->bind_type_guessing= FALSE;
-  imp_dbh->bind_comment_placeholders= FALSE;
-  imp_dbh->auto_reconnect = FALSE;
-  imp_dbh->connected = FALSE;       /* Will be switched to TRUE after DBI->connect finish */
-  imp_dbh->is_embedded = FALSE;
-
-  if (!mariadb_db_my_login(aTHX_ dbh, imp_dbh))
-    return 0;
+  char *ptr;
 
-  /*
-   *  Tell DBI, that dbh->disconnect should be called for this handle
-   */
-  DBIc_ACTIVE_on(imp_dbh);
+  if (val <= (~(my_ulonglong)0 >> 1))
+    return my_ulonglong2str(val, buf, len);
 
-  /* Tell DBI, that dbh->destroy should be called for this handle */
-  DBIc_on(imp_dbh, DBIcf_IMPSET);
+  ptr = my_ulonglong2str(-val, buf, len);
+  if (!ptr || ptr == buf) {
+    *len = 0;
+    return NULL;
+  }
 
-  return 1;
+  *(--ptr) = '-';
+  *len += 1;
+  return ptr;
 }
+#endif
 
+SV*
+mariadb_dr_my_ulonglong2sv(pTHX_ my_ulonglong val)
+{
+#if IVSIZE >= 8
+  return newSVuv(val);
+#else
+  if (val <= UV_MAX)
+  {
+    return newSVuv(val);
+  }
+  else
+  {
+    char buf[64];
+    STRLEN len = sizeof(buf);
+    char *ptr = my_ulonglong2str(val, buf, &len);
+    return newSVpvn(ptr, len);
+  }
+#endif
+}
 
-static my_ulonglong mariadb_st_internal_execute(SV *h, char *sbuf, STRLEN slen, int num_params, imp_sth_ph_t *params, MYSQL_RES **result, MYSQL **svsock, bool use_mysql_use_result);
-static my_ulonglong mariadb_st_internal_execute41(SV *h, char *sbuf, STRLEN slen, int num_params, MYSQL_RES **result, MYSQL_STMT **stmt_ptr, MYSQL_BIND *bind, MYSQL **svsock, bool *has_been_bound);
-
-/**************************************************************************
+/***************************************************************************
  *
- *  Name:    mariadb_db_do6
+ *  Name:    mariadb_db_FETCH_attrib
  *
- *  Purpose: Function for preparing and executing simple statement.
+ *  Purpose: Function for fetching dbh attributes
  *
- *  Input:   dbh - database handle being initialized
+ *  Input:   dbh - database handle being queried
  *           imp_dbh - drivers private database handle data
- *           statement - query being executed
- *           attribs - statement attributes
- *           items - number of arguments passed to XSUB
- *           ax - stack base offset used by ST() macro
+ *           keysv - the attribute name
  *
- *  Returns: -2 for errors, -1 for unknown number of rows, otherwise number
- *           of rows; mariadb_dr_do_error will be called for errors
+ *  Returns: An SV*, if successful; NULL otherwise
+ *
+ *  Notes:   Do not forget to call sv_2mortal in the former case!
  *
  **************************************************************************/
 
-IV mariadb_db_do6(SV *dbh, imp_dbh_t *imp_dbh, SV *statement_sv, SV *attribs, I32 items, I32 ax)
+SV* mariadb_db_FETCH_attrib(SV *dbh, imp_dbh_t *imp_dbh, SV *keysv)
 {
   dTHX;
-  I32 i;
-  my_ulonglong retval;
-  char *statement;
-  STRLEN statement_len;
-  struct imp_sth_ph_st *params = NULL;
-  MYSQL_RES *result = NULL;
-  bool async = FALSE;
-  int next_result_rc;
-  bool failed = FALSE;
-  bool has_been_bound = FALSE;
-  bool use_server_side_prepare = FALSE;
-  bool disable_fallback_for_server_prepare = FALSE;
-  MYSQL_STMT *stmt = NULL;
-  MYSQL_BIND *bind = NULL;
-  STRLEN blen;
-  unsigned long int num_params;
-  unsigned int error;
-
-  ASYNC_CHECK_RETURN(dbh, -2);
+  STRLEN kl;
+  char *key = SvPV(keysv, kl); /* needs to process get magic */
+  SV* result = NULL;
+  PERL_UNUSED_ARG(dbh);
 
-  if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
-  {
-    mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
-    return -2;
+  switch (*key) {
+    case 'A':
+      if (memEQs(key, kl, "AutoCommit"))
+          return sv_2mortal(boolSV(DBIc_has(imp_dbh,DBIcf_AutoCommit)));
+      break;
   }
 
-  SvGETMAGIC(statement_sv);
-
-  if (items < 0)
-    items = 0;
-
-  for (i = 0; i < items; i++)
+  if (!strBEGINs(key, "mariadb_"))
   {
-    SV *param = ST(i);
-    SvGETMAGIC(param);
+    if (!skip_attribute(key)) /* Not handled by this driver */
+      error_unknown_attribute(dbh, key);
+    return Nullsv;
   }
-
-  (void)hv_stores((HV *)SvRV(dbh), "Statement", SvREFCNT_inc(statement_sv));
-  statement = SvPVutf8_nomg(statement_sv, statement_len);
-
-  if (DBIc_DBISTATE(imp_dbh)->debug >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\t-> do() SQL statement: %.1000s%s\n", statement, statement_len > 1000 ? "..." : "");
-
-  /*
-   * Globally enabled using of server side prepared statement
-   * for dbh->do() statements. It is possible to force driver
-   * to use server side prepared statement mechanism by adding
-   * 'mariadb_server_prepare' attribute to do() method localy:
-   * $dbh->do($stmt, {mariadb_server_prepare=>1});
-  */
-  use_server_side_prepare = imp_dbh->use_server_side_prepare;
-
-  DBD_ATTRIBS_CHECK("do", dbh, attribs);
-  if (attribs)
+  else
   {
-    HV *hv;
-    HE *he;
-    SV **svp;
-    HV *processed;
-
-    processed = newHV();
-    sv_2mortal(newRV_noinc((SV *)processed)); /* Automatically free HV processed */
-
-    (void)hv_stores(processed, "mariadb_server_prepare", &PL_sv_yes);
-    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_server_prepare");
-    use_server_side_prepare = svp ? SvTRUE(*svp) : imp_dbh->use_server_side_prepare;
-
-    (void)hv_stores(processed, "mariadb_server_prepare_disable_fallback", &PL_sv_yes);
-    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_server_prepare_disable_fallback");
-    disable_fallback_for_server_prepare = svp ? SvTRUE(*svp) : imp_dbh->disable_fallback_for_server_prepare;
-
-    (void)hv_stores(processed, "mariadb_async", &PL_sv_yes);
-    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_async");
-    async = svp ? SvTRUE(*svp) : FALSE;
-
-    hv = (HV *)SvRV(attribs);
-    hv_iterinit(hv);
-    while ((he = hv_iternext(hv)) != NULL)
+    if (memEQs(key, kl, "mariadb_auto_reconnect"))
+      result = boolSV(imp_dbh->auto_reconnect);
+    else if (memEQs(key, kl, "mariadb_bind_type_guessing"))
+      result = boolSV(imp_dbh->bind_type_guessing);
+    else if (memEQs(key, kl, "mariadb_bind_comment_placeholders"))
+      result = boolSV(imp_dbh->bind_comment_placeholders);
+    else if (memEQs(key, kl, "mariadb_clientinfo"))
     {
-      I32 len;
-      const char *key;
-
-      key = hv_iterkey(he, &len);
-      if (hv_exists(processed, key, len))
-        continue;
-
-      error_unknown_attribute(dbh, key);
-      return -2;
+      const char* clientinfo = mysql_get_client_info();
+      result = clientinfo ? sv_2mortal(newSVpv(clientinfo, 0)) : &PL_sv_undef;
+      sv_utf8_decode(result);
     }
-  }
-
-  if (DBIc_DBISTATE(imp_dbh)->debug >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\t\tuse_server_side_prepare %d\n", use_server_side_prepare ? 1 : 0);
-
-  if (DBIc_DBISTATE(imp_dbh)->debug >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\t\tasync %d\n", (async ? 1 : 0));
-
-  if (async)
-  {
-    if (imp_dbh->is_embedded)
+    else if (memEQs(key, kl, "mariadb_clientversion"))
+      result= sv_2mortal(newSVuv(mysql_get_client_version()));
+    else if (memEQs(key, kl, "mariadb_errno"))
+      result = imp_dbh->pmysql ? sv_2mortal(newSVuv(mysql_errno(imp_dbh->pmysql))) : &PL_sv_undef;
+    else if (memEQs(key, kl, "mariadb_error"))
     {
-      mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Async option not supported for Embedded server", "HY000");
-      return -2;
+      result = imp_dbh->pmysql ? sv_2mortal(newSVpv(mysql_error(imp_dbh->pmysql), 0)) : &PL_sv_undef;
+      sv_utf8_decode(result);
     }
-    if (disable_fallback_for_server_prepare)
+    else if (memEQs(key, kl, "mariadb_dbd_stats"))
     {
-      mariadb_dr_do_error(dbh, ER_UNSUPPORTED_PS, "Async option not supported with server side prepare", "HY000");
-      return -2;
+      HV* hv = newHV();
+      result = sv_2mortal((newRV_noinc((SV*)hv)));
+      (void)hv_stores(hv, "auto_reconnects_ok", newSViv(imp_dbh->stats.auto_reconnects_ok));
+      (void)hv_stores(hv, "auto_reconnects_failed", newSViv(imp_dbh->stats.auto_reconnects_failed));
     }
-    use_server_side_prepare = FALSE; /* for now */
-    imp_dbh->async_query_in_flight = imp_dbh;
-  }
-
-  while ((next_result_rc = mysql_next_result(imp_dbh->pmysql)) == 0)
-  {
-    result = mysql_store_result(imp_dbh->pmysql);
-    if (!result)
+    else if (memEQs(key, kl, "mariadb_hostinfo"))
     {
-      if (mysql_errno(imp_dbh->pmysql))
+      const char *hostinfo = imp_dbh->pmysql ? (imp_dbh->is_embedded ? "Embedded" : mysql_get_host_info(imp_dbh->pmysql)) : NULL;
+      result = hostinfo ? sv_2mortal(newSVpv(hostinfo, 0)) : &PL_sv_undef;
+      sv_utf8_decode(result);
+    }
+    else if (memEQs(key, kl, "mariadb_info"))
+    {
+      const char *info = imp_dbh->pmysql ? mysql_info(imp_dbh->pmysql) : NULL;
+      result = info ? sv_2mortal(newSVpv(info, 0)) : &PL_sv_undef;
+      sv_utf8_decode(result);
+    }
+    else if (memEQs(key, kl, "mariadb_insertid"))
+    {
+      /* We cannot return an IV, because the insertid is a long. */
+      result = sv_2mortal(my_ulonglong2sv(imp_dbh->insertid));
+    }
+    else if (memEQs(key, kl, "mariadb_max_allowed_packet"))
+    {
+      unsigned long packet_size;
+      if (imp_dbh->is_embedded)
       {
-        mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
-        return -2;
+        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "mariadb_max_allowed_packet is not supported for Embedded server", "HY000");
+        return Nullsv;
       }
-      imp_dbh->insertid = mysql_insert_id(imp_dbh->pmysql);
+#if (!defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 50709 && MYSQL_VERSION_ID != 60000) || (defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 100206 && MYSQL_VERSION_ID != 100300)
+      /* mysql_get_option() is not available in all versions */
+      /* if we do not have mysql_get_option() we cannot retrieve max_allowed_packet */
+      /* MYSQL_OPT_MAX_ALLOWED_PACKET was added in mysql 5.7.9 */
+      /* MYSQL_OPT_MAX_ALLOWED_PACKET was added in MariaDB 10.2.6 and MariaDB 10.3.1 */
+  #ifdef HAVE_GET_OPTION
+      mysql_get_option(imp_dbh->pmysql, MYSQL_OPT_MAX_ALLOWED_PACKET, &packet_size);
+  #else
+      mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Fetching mariadb_max_allowed_packet is not supported", "HY000");
+      return Nullsv;
+  #endif
+#else
+      /* before MySQL 5.7.9 and MariaDB 10.2.6 and MariaDB 10.3.0 use max_allowed_packet macro */
+      packet_size = max_allowed_packet;
+#endif
+      result = sv_2mortal(newSVuv(packet_size));
     }
-    if (result)
+    else if (memEQs(key, kl, "mariadb_no_autocommit_cmd"))
+      result = boolSV(imp_dbh->no_autocommit_cmd);
+    else if (memEQs(key, kl, "mariadb_protoinfo"))
+      result = imp_dbh->pmysql ? sv_2mortal(newSViv(mysql_get_proto_info(imp_dbh->pmysql))) : &PL_sv_undef;
+    else if (memEQs(key, kl, "mariadb_serverinfo"))
     {
-      mysql_free_result(result);
-      result = NULL;
-    }
-  }
-
-  if (next_result_rc > 0)
-  {
-#if MYSQL_VERSION_ID < 50025
-    /* Cover a protocol design error: error packet does not contain the server status.
-     * Luckily, an error always aborts execution of a statement, so it is safe to turn off the flag. */
-    imp_dbh->pmysql->server_status &= ~SERVER_MORE_RESULTS_EXISTS;
+      const char *serverinfo = imp_dbh->pmysql ? mysql_get_server_info(imp_dbh->pmysql) : NULL;
+#ifndef MARIADB_BASE_VERSION
+      /* serverinfo for MariaDB server from MySQL client is prefixed by string 5.5.5- */
+      if (serverinfo && strBEGINs(serverinfo, "5.5.5-"))
+          serverinfo += sizeof("5.5.5-")-1;
+#endif
+      result = serverinfo ? sv_2mortal(newSVpv(serverinfo, 0)) : &PL_sv_undef;
+      sv_utf8_decode(result);
+    } 
+    else if (memEQs(key, kl, "mariadb_ssl_cipher"))
+    {
+#if ((MYSQL_VERSION_ID >= 50023 && MYSQL_VERSION_ID < 50100) || MYSQL_VERSION_ID >= 50111)
+      const char *ssl_cipher = imp_dbh->pmysql ? mysql_get_ssl_cipher(imp_dbh->pmysql) : NULL;
+      result = ssl_cipher ? sv_2mortal(newSVpv(ssl_cipher, 0)) : &PL_sv_undef;
+      sv_utf8_decode(result);
+#else
+      mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Fetching mariadb_ssl_cipher is not supported", "HY000");
+      return Nullsv;
 #endif
-    /* This is error for previous unfetched result ret. So do not report server errors to caller which is expecting new result set. */
-    error = mysql_errno(imp_dbh->pmysql);
-    if (error == CR_COMMANDS_OUT_OF_SYNC || error == CR_OUT_OF_MEMORY || error == CR_SERVER_GONE_ERROR || error == CR_SERVER_LOST || error == ER_CLIENT_INTERACTION_TIMEOUT || error == CR_UNKNOWN_ERROR)
-    {
-      mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
-      return -2;
     }
-  }
-
-  if (use_server_side_prepare)
-  {
-    stmt = mysql_stmt_init(imp_dbh->pmysql);
-
-    if (stmt && mysql_stmt_prepare(stmt, statement, statement_len))
+    else if (memEQs(key, kl, "mariadb_serverversion"))
     {
-      if (mariadb_db_reconnect(dbh, stmt))
-      {
-        mysql_stmt_close(stmt);
-        stmt = mysql_stmt_init(imp_dbh->pmysql);
-        if (stmt && mysql_stmt_prepare(stmt, statement, statement_len))
-          failed = TRUE;
-      }
-      else
+#ifndef MARIADB_BASE_VERSION
+      unsigned int major, minor, patch;
+      const char *serverinfo = imp_dbh->pmysql ? mysql_get_server_info(imp_dbh->pmysql) : NULL;
+      /* serverinfo for MariaDB server from MySQL client is prefixed by string 5.5.5- */
+      if (serverinfo && strBEGINs(serverinfo, "5.5.5-"))
       {
-        failed = TRUE;
+        /* And in this case mysql_get_server_version() returns just 50505 and not correct
+         * MariaDB server version. So parse serverversion manually from serverinfo. */
+        serverinfo += sizeof("5.5.5-")-1;
+        if (sscanf(serverinfo, "%u.%u.%u", &major, &minor, &patch) == 3)
+          result = sv_2mortal(newSVuv(10000UL * major + 100UL * minor + patch));
       }
+#endif
+      if (!result)
+        result = imp_dbh->pmysql ? sv_2mortal(newSVuv(mysql_get_server_version(imp_dbh->pmysql))) : &PL_sv_undef;
     }
-
-    if (!stmt)
-    {
-      mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
-      retval = (my_ulonglong)-1;
-    }
-    else if (failed)
+    else if (memEQs(key, kl, "mariadb_sock"))
+      result = sv_2mortal(newSViv(PTR2IV(imp_dbh->pmysql)));
+    else if (memEQs(key, kl, "mariadb_sockfd"))
+      result = (imp_dbh->sock_fd >= 0) ? sv_2mortal(newSViv(imp_dbh->sock_fd)) : &PL_sv_undef;
+    else if (memEQs(key, kl, "mariadb_stat"))
     {
-      /* For commands that are not supported by server side prepared statement
-         mechanism lets try to pass them through regular API */
-      if (!disable_fallback_for_server_prepare &&
-          (mysql_stmt_errno(stmt) == ER_UNSUPPORTED_PS ||
-          /* And also fallback when placeholder is used in unsupported
-           * construction with old server versions (e.g. LIMIT ?) */
-          (mysql_stmt_errno(stmt) == ER_PARSE_ERROR &&
-           mysql_get_server_version(imp_dbh->pmysql) < 50007 &&
-           strstr(mysql_stmt_error(stmt), "'?"))))
-      {
-        use_server_side_prepare = FALSE;
-      }
-      else
-      {
-        mariadb_dr_do_error(dbh, mysql_stmt_errno(stmt), mysql_stmt_error(stmt), mysql_stmt_sqlstate(stmt));
-        retval = (my_ulonglong)-1;
-      }
-      mysql_stmt_close(stmt);
-      stmt = NULL;
+      const char *stats = imp_dbh->pmysql ? mysql_stat(imp_dbh->pmysql) : NULL;
+      result = stats ? sv_2mortal(newSVpv(stats, 0)) : &PL_sv_undef;
+      sv_utf8_decode(result);
     }
+    else if (memEQs(key, kl, "mariadb_server_prepare"))
+      result = boolSV(imp_dbh->use_server_side_prepare);
+    else if (memEQs(key, kl, "mariadb_server_prepare_disable_fallback"))
+      result = boolSV(imp_dbh->disable_fallback_for_server_prepare);
+    else if (memEQs(key, kl, "mariadb_stmt_cache_size"))
+      result = sv_2mortal(newSVuv(imp_dbh->stmt_cache_size));
+    else if (memEQs(key, kl, "mariadb_cursor_prefetch"))
+      result = sv_2mortal(newSVuv(imp_dbh->cursor_prefetch));
+    else if (memEQs(key, kl, "mariadb_statement_buffer_max"))
+      result = sv_2mortal(newSVuv(imp_dbh->statement_buffer_max));
+    else if (memEQs(key, kl, "mariadb_temporal_mode"))
+      result = temporal_mode_sv(aTHX_ imp_dbh->temporal_mode);
+    else if (memEQs(key, kl, "mariadb_decimal_mode"))
+      result = decimal_mode_sv(aTHX_ imp_dbh->decimal_mode);
+    else if (memEQs(key, kl, "mariadb_thread_id"))
+      result = imp_dbh->pmysql ? sv_2mortal(newSVuv(mysql_thread_id(imp_dbh->pmysql))) : &PL_sv_undef;
+    else if (memEQs(key, kl, "mariadb_warning_count"))
+      result = imp_dbh->pmysql ? sv_2mortal(newSVuv(mysql_warning_count(imp_dbh->pmysql))) : &PL_sv_undef;
+    else if (memEQs(key, kl, "mariadb_use_result"))
+      result = boolSV(imp_dbh->use_mysql_use_result);
+    else if (memEQs(key, kl, "mariadb_multi_statements"))
+      result = boolSV(imp_dbh->use_multi_statements);
     else
     {
-      num_params = mysql_stmt_param_count(stmt);
-      if (num_params > INT_MAX)
-      {
-        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Statement contains too many placeholders", "HY000");
-        mysql_stmt_close(stmt);
-        return -2;
-      }
-      else if ((int)num_params != items)
-      {
-        mariadb_dr_do_error(dbh, ER_WRONG_ARGUMENTS, "Wrong number of bind parameters", "HY000");
-        mysql_stmt_close(stmt);
-        return -2;
-      }
+      error_unknown_attribute(dbh, key);
+      return Nullsv;
+    }
+  }
 
-      if (items > 0)
-      {
-        Newz(0, bind, items, MYSQL_BIND);
+  return result;
+}
 
-        for (i = 0; i < items; i++)
-        {
-          SV *param = ST(i);
-          if (SvOK(param))
-          {
-            bind[i].buffer = SvPVutf8_nomg(param, blen);
-            bind[i].buffer_length = blen;
-            bind[i].buffer_type = MYSQL_TYPE_STRING;
-          }
-          else
-          {
-            bind[i].buffer = NULL;
-            bind[i].buffer_length = 0;
-            bind[i].buffer_type = MYSQL_TYPE_NULL;
-          }
-        }
-      }
+AV *mariadb_db_data_sources(SV *dbh, imp_dbh_t *imp_dbh, SV *attr)
+{
+  dTHX;
+  SV *sv;
+  AV *av;
+  SSize_t i;
+  MYSQL_RES *res;
+  MYSQL_ROW row;
+  MYSQL_FIELD* field;
+  my_ulonglong num_rows;
+  unsigned long *lengths;
+  const char *prefix = "DBI:MariaDB:";
+  const Size_t prefix_len = strlen(prefix);
+  PERL_UNUSED_ARG(attr);
 
-      retval = mariadb_st_internal_execute41(dbh, statement, statement_len, !!(items > 0), &result, &stmt, bind, &imp_dbh->pmysql, &has_been_bound);
+  ASYNC_CHECK_RETURN(dbh, NULL);
 
-      if (bind)
-        Safefree(bind);
+  if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
+  {
+    mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+    return NULL;
+  }
 
-      mysql_stmt_close(stmt);
-      stmt = NULL;
+  av = newAV();
+  sv_2mortal((SV *)av);
 
-      if (retval == (my_ulonglong)-1) /* -1 means error */
-      {
-        SV *err = DBIc_ERR(imp_dbh);
-        if (!disable_fallback_for_server_prepare && SvIV(err) == ER_UNSUPPORTED_PS)
-        {
-          use_server_side_prepare = FALSE;
-        }
-      }
-    }
+  res = mysql_list_dbs(imp_dbh->pmysql, NULL);
+  if (!res && mariadb_db_reconnect(dbh, NULL))
+    res = mysql_list_dbs(imp_dbh->pmysql, NULL);
+  if (!res)
+  {
+    mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql),
+                        mysql_error(imp_dbh->pmysql),
+                        mysql_sqlstate(imp_dbh->pmysql));
+    return NULL;
   }
 
-  if (!use_server_side_prepare)
+  field = mysql_fetch_field(res);
+  if (!field)
   {
-    num_params = count_params(imp_dbh, aTHX_ statement, statement_len, imp_dbh->bind_comment_placeholders);
-    if (num_params > INT_MAX || num_params == ULONG_MAX)
-    {
-      mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Statement contains too many placeholders", "HY000");
-      return -2;
-    }
-    else if ((int)num_params != items)
-    {
-      mariadb_dr_do_error(dbh, ER_WRONG_ARGUMENTS, "Wrong number of bind parameters", "HY000");
-      return -2;
-    }
-
-    if (items > 0)
-    {
-      Newz(0, params, items, struct imp_sth_ph_st);
+    mariadb_dr_do_error(dbh, CR_NO_RESULT_SET, "No result list of databases", "HY000");
+    return NULL;
+  }
 
-      for (i = 0; i < items; i++)
-      {
-        SV *param = ST(i);
-        if (SvOK(param))
-          params[i].value = SvPVutf8_nomg(param, params[i].len);
-        else
-          params[i].value = NULL;
-        params[i].type = SQL_VARCHAR;
-      }
-    }
+  num_rows = mysql_num_rows(res);
+  if (num_rows == 0)
+    return av;
 
-    retval = mariadb_st_internal_execute(dbh, statement, statement_len, items, params, &result, &imp_dbh->pmysql, FALSE);
-  }
+  /* av_extend() extends array to size: arg+1 */
+  --num_rows;
 
-  if (params)
-    Safefree(params);
+  /* Truncate list when is too big */
+  if (num_rows > SSize_t_MAX)
+    num_rows = SSize_t_MAX;
 
-  /* Some MySQL client versions return correct value from mysql_insert_id()
-   * function only after non-SELECT operation. So store insert id into dbh
-   * cache and later read it only from cache. */
-  if (retval != (my_ulonglong)-1 && !async && !result)
-    imp_dbh->insertid = mysql_insert_id(imp_dbh->pmysql);
+  av_extend(av, num_rows);
 
-  if (result)
+  i = 0;
+  while ((row = mysql_fetch_row(res)))
   {
-    mysql_free_result(result);
-    result = NULL;
-  }
+    if (!row[0])
+      continue;
 
-  if (retval != (my_ulonglong)-1 && !async) /* -1 means error */
-  {
-    /* more results? -1 = no, >0 = error, 0 = yes (keep looping) */
-    while ((next_result_rc = mysql_next_result(imp_dbh->pmysql)) == 0)
-    {
-      result = mysql_store_result(imp_dbh->pmysql);
-      if (mysql_errno(imp_dbh->pmysql))
-      {
-        next_result_rc = 1;
-        break;
-      }
-      if (!result) /* Next statement without result set, new insert id */
-        imp_dbh->insertid = mysql_insert_id(imp_dbh->pmysql);
-      if (result)
-        mysql_free_result(result);
-      result = NULL;
-    }
+    lengths = mysql_fetch_lengths(res);
 
-    if (next_result_rc > 0)
-    {
-#if MYSQL_VERSION_ID < 50025
-      /* Cover a protocol design error: error packet does not contain the server status.
-       * Luckily, an error always aborts execution of a statement, so it is safe to turn off the flag. */
-      imp_dbh->pmysql->server_status &= ~SERVER_MORE_RESULTS_EXISTS;
-#endif
+    /* newSV automatically adds extra byte for '\0' and does not set POK */
+    sv = newSV(prefix_len + lengths[0]);
+    av_store(av, i, sv);
+
+    memcpy(SvPVX(sv), prefix, prefix_len);
+    memcpy(SvPVX(sv)+prefix_len, row[0], lengths[0]);
+    *(SvPVX(sv)+prefix_len+lengths[0]) = '\0';
+
+    SvPOK_on(sv);
+    SvCUR_set(sv, prefix_len + lengths[0]);
 
-      if (DBIc_DBISTATE(imp_dbh)->debug >= 2)
-        PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\t<- do() ERROR: %s\n", mysql_error(imp_dbh->pmysql));
+    if (mysql_charsetnr_is_utf8(field->charsetnr))
+      sv_utf8_decode(sv);
 
-      mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
-      retval = (my_ulonglong)-1;
-    }
+    if ((my_ulonglong)i == num_rows+1)
+      break;
+
+    i++;
   }
 
-  if (retval == (my_ulonglong)-1)
-    return -2;
-  else if (retval <= IV_MAX)
-    return retval;
-  else
-    return -1;
+  mysql_free_result(res);
+  return av;
 }
 
+static bool mariadb_st_free_result_sets(SV *sth, imp_sth_t *imp_sth, bool free_last);
 
-/***************************************************************************
+/* 
+ **************************************************************************
  *
- *  Name:    mariadb_db_commit
- *           mariadb_db_rollback
+ *  Name:    mariadb_st_prepare_sv
  *
- *  Purpose: You guess what they should do. 
+ *  Purpose: Called for preparing an SQL statement; our part of the
+ *           statement handle constructor
  *
- *  Input:   dbh - database handle being committed or rolled back
- *           imp_dbh - drivers private database handle data
+ *  Input:   sth - statement handle being initialized
+ *           imp_sth - drivers private statement handle data
+ *           statement - pointer to string with SQL statement
+ *           attribs - statement attributes
  *
- *  Returns: 1 for success, 0 otherwise; mariadb_dr_do_error has already
- *           been called in the latter case
+ *  Returns: 1 for success, 0 otherwise; mariadb_dr_do_error will
+ *           be called in the latter case
  *
  **************************************************************************/
-
 int
-mariadb_db_commit(SV* dbh, imp_dbh_t* imp_dbh)
+mariadb_st_prepare_sv(
+  SV *sth,
+  imp_sth_t *imp_sth,
+  SV *statement_sv,
+  SV *attribs)
 {
-  if (DBIc_has(imp_dbh, DBIcf_AutoCommit))
-    return 0;
+  int i;
+  HV *hv;
+  HE *he;
+  SV **svp;
+  HV *processed;
+  char *statement;
+  STRLEN statement_len;
+  dTHX;
+  int prepare_retval;
+  MYSQL_BIND *bind, *bind_end;
+  imp_sth_phb_t *fbind;
+  unsigned long int num_params;
+  D_imp_xxh(sth);
+  D_imp_dbh_from_sth;
 
-  ASYNC_CHECK_RETURN(dbh, 0);
+  if (imp_sth->statement)
+  {
+    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "Statement is already prepared", "HY000");
+    return 0;
+  }
 
-  if (!imp_dbh->pmysql)
+  if (!imp_dbh->pmysql && !mariadb_db_reconnect(sth, NULL))
   {
-    mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "No connection to server", "HY000");
+    mariadb_dr_do_error(sth, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
     return 0;
   }
 
-    if (mysql_commit(imp_dbh->pmysql))
+  statement = SvPVutf8_nomg(statement_sv, statement_len);
+  imp_sth->statement = savepvn(statement, statement_len);
+  imp_sth->statement_len = statement_len;
+
+ /* Set default value of 'mariadb_server_prepare' attribute for sth from dbh */
+  imp_sth->use_mysql_use_result = imp_dbh->use_mysql_use_result;
+  imp_sth->cursor_prefetch = imp_dbh->cursor_prefetch;
+  imp_sth->statement_buffer_max = imp_dbh->statement_buffer_max;
+  imp_sth->temporal_mode = imp_dbh->temporal_mode;
+  imp_sth->decimal_mode = imp_dbh->decimal_mode;
+  imp_sth->long_read_len_set = imp_dbh->long_read_len_set;
+  imp_sth->use_server_side_prepare = imp_dbh->use_server_side_prepare;
+  imp_sth->disable_fallback_for_server_prepare = imp_dbh->disable_fallback_for_server_prepare;
+
+  imp_sth->done_desc = FALSE;
+  imp_sth->result = NULL;
+  imp_sth->current_row = NULL;
+  imp_sth->currow = 0;
+  imp_sth->row_num = (my_ulonglong)-1;
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                 "\t-> mariadb_st_prepare_sv MYSQL_VERSION_ID %d, SQL statement: %.1000s%s\n",
+                  MYSQL_VERSION_ID, statement, statement_len > 1000 ? "..." : "");
+
+  if (attribs)
+  {
+    processed = newHV();
+    sv_2mortal(newRV_noinc((SV *)processed)); /* Automatically free HV processed */
+
+    /* Automatically processed by DBI */
+    (void)hv_stores(processed, "Slice", &PL_sv_yes);
+    (void)hv_stores(processed, "Columns", &PL_sv_yes);
+    (void)hv_stores(processed, "MaxRows", &PL_sv_yes);
+
+    (void)hv_stores(processed, "mariadb_server_prepare", &PL_sv_yes);
+    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_server_prepare");
+    imp_sth->use_server_side_prepare = (svp) ?
+      SvTRUE(*svp) : imp_dbh->use_server_side_prepare;
+
+    (void)hv_stores(processed, "mariadb_server_prepare_disable_fallback", &PL_sv_yes);
+    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_server_prepare_disable_fallback");
+    imp_sth->disable_fallback_for_server_prepare = (svp) ?
+      SvTRUE(*svp) : imp_dbh->disable_fallback_for_server_prepare;
+
+    (void)hv_stores(processed, "mariadb_async", &PL_sv_yes);
+    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_async");
+    if(svp && SvTRUE(*svp)) {
+        if (imp_dbh->is_embedded)
+        {
+          mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "Async option not supported for Embedded server", "HY000");
+          return 0;
+        }
+        imp_sth->is_async = TRUE;
+#ifndef HAVE_ASYNC_STMT
+        if (imp_sth->disable_fallback_for_server_prepare)
+        {
+          mariadb_dr_do_error(sth, CR_NOT_IMPLEMENTED,
+                   "Async option not supported with server side prepare", "HY000");
+          return 0;
+        }
+        imp_sth->use_server_side_prepare = FALSE;
+#endif
+    }
+
+    /* Set default value of 'mariadb_use_result' attribute for sth from dbh */
+    (void)hv_stores(processed, "mariadb_use_result", &PL_sv_yes);
+    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_use_result");
+    imp_sth->use_mysql_use_result= svp ?
+      SvTRUE(*svp) : imp_dbh->use_mysql_use_result;
+
+    (void)hv_stores(processed, "mariadb_cursor_prefetch", &PL_sv_yes);
+    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_cursor_prefetch");
+    if (svp && SvOK(*svp))
     {
-      mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql)
-               ,mysql_sqlstate(imp_dbh->pmysql));
+      UV uv = SvUV(*svp);
+      imp_sth->cursor_prefetch = (uv <= ULONG_MAX) ? uv : ULONG_MAX;
+    }
+
+    (void)hv_stores(processed, "mariadb_statement_buffer_max", &PL_sv_yes);
+    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_statement_buffer_max");
+    if (svp && SvOK(*svp))
+    {
+      UV uv = SvUV(*svp);
+      imp_sth->statement_buffer_max = (uv <= (UV)SSize_t_MAX) ? uv : (UV)SSize_t_MAX;
+    }
+
+    (void)hv_stores(processed, "mariadb_temporal_mode", &PL_sv_yes);
+    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_temporal_mode");
+    if (svp && !parse_temporal_mode(aTHX_ sth, *svp, &imp_sth->temporal_mode))
+      return 0;
+
+    (void)hv_stores(processed, "mariadb_decimal_mode", &PL_sv_yes);
+    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_decimal_mode");
+    if (svp && !parse_decimal_mode(aTHX_ sth, *svp, &imp_sth->decimal_mode))
+      return 0;
+
+    hv = (HV*) SvRV(attribs);
+    hv_iterinit(hv);
+    while ((he = hv_iternext(hv)) != NULL)
+    {
+      I32 len;
+      const char *key;
+      key = hv_iterkey(he, &len);
+      if (hv_exists(processed, key, len))
+        continue;
+      error_unknown_attribute(sth, key);
       return 0;
     }
+  }
 
-  return 1;
-}
+  for (i= 0; i < AV_ATTRIB_LAST; i++)
+    imp_sth->av_attr[i]= Nullav;
+  imp_sth->hash_keys = NULL;
 
-/*
- mariadb_db_rollback
-*/
-int
-mariadb_db_rollback(SV* dbh, imp_dbh_t* imp_dbh) {
-  /* report error, if not in AutoCommit mode */
-  if (DBIc_has(imp_dbh, DBIcf_AutoCommit))
+  /*
+     Clean-up previous result set(s) for sth to prevent
+     'Commands out of sync' error 
+  */
+  if (!mariadb_st_free_result_sets(sth, imp_sth, TRUE))
     return 0;
 
-  ASYNC_CHECK_RETURN(dbh, 0);
+  if (imp_sth->use_server_side_prepare)
+  {
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                    "\t\tuse_server_side_prepare set\n");
 
-  /* No connection to server, nothing to rollback */
-  if (!imp_dbh->pmysql)
-    return 1;
+    imp_sth->stmt= mariadb_db_stmt_cache_get(aTHX_ imp_dbh, statement, statement_len);
 
-      if (mysql_rollback(imp_dbh->pmysql))
+    if (imp_sth->stmt)
+    {
+      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+        PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                      "\t\tusing cached server side prepared statement\n");
+      prepare_retval= 0;
+    }
+    else
+    {
+      imp_sth->stmt= mysql_stmt_init(imp_dbh->pmysql);
+
+      if (! imp_sth->stmt)
       {
-        mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql),
-                 mysql_error(imp_dbh->pmysql) ,mysql_sqlstate(imp_dbh->pmysql));
+        mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
         return 0;
       }
 
-  return 1;
-}
+      prepare_retval= mysql_stmt_prepare(imp_sth->stmt,
+                                         statement,
+                                         statement_len);
+    }
 
-static void mariadb_dr_close_mysql(pTHX_ imp_drh_t *imp_drh, MYSQL *pmysql)
-{
-  if (pmysql)
-  {
-    mysql_close(pmysql);
-    imp_drh->instances--;
-  }
-  if (imp_drh->instances == 0)
-  {
-    /*
-     * Some MariaDB and MySQL clients have a bug which cause:
-     * - inability to successfully initialize a new network connection, even after mysql_server_init()
-     * - infinite loop when calling mysql_server_end() more then once in case Embedded server was not started
-     * Therefore do not call mysql_server_end() when Embedded server was not in used.
-     * These bugs were fixed in MariaDB Connector/C 3.0.5, see: https://jira.mariadb.org/browse/CONC-336
-     * And fixed also in MySQL 8.0.20, see: https://bugs.mysql.com/bug.php?id=93276
-     * But remains in MariaDB Embedded server, see: https://jira.mariadb.org/browse/MDEV-16578
-     */
-#if !defined(HAVE_BROKEN_INIT) && (defined(HAVE_DEINITIALIZE_SSL) || !defined(HAVE_PROBLEM_WITH_OPENSSL))
-    if (imp_drh->non_embedded_started)
+    if (prepare_retval && mariadb_db_reconnect(sth, imp_sth->stmt))
     {
-      mysql_server_end();
-      imp_drh->non_embedded_started = FALSE;
+        mysql_stmt_close(imp_sth->stmt);
+        imp_sth->stmt = mysql_stmt_init(imp_dbh->pmysql);
+        if (!imp_sth->stmt)
+        {
+          mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
+          return 0;
+        }
+        prepare_retval= mysql_stmt_prepare(imp_sth->stmt,
+                                           statement,
+                                           statement_len);
     }
-#endif
-    if (imp_drh->embedded_started)
+
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+        PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                      "\t\tmysql_stmt_prepare returned %d\n",
+                      prepare_retval);
+
+    if (prepare_retval)
     {
-      mysql_server_end();
-      imp_drh->embedded_started = FALSE;
-#if !defined(HAVE_DEINITIALIZE_SSL) && defined(HAVE_PROBLEM_WITH_OPENSSL)
-      warn("DBD::MariaDB disconnect: Client library deinitialized OpenSSL library functions and module Net::SSLeay is now broken");
-#endif
+      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+        PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                      "\t\tmysql_stmt_prepare %d %s\n",
+                      mysql_stmt_errno(imp_sth->stmt),
+                      mysql_stmt_error(imp_sth->stmt));
+
+      /* For commands that are not supported by server side prepared statement
+         mechanism lets try to pass them through regular API */
+      if (!imp_sth->disable_fallback_for_server_prepare &&
+          (mysql_stmt_errno(imp_sth->stmt) == ER_UNSUPPORTED_PS ||
+          /* And also fallback when placeholder is used in unsupported
+           * construction with old server versions (e.g. LIMIT ?) */
+          (mysql_stmt_errno(imp_sth->stmt) == ER_PARSE_ERROR &&
+           mysql_get_server_version(imp_dbh->pmysql) < 50007 &&
+           strstr(mysql_stmt_error(imp_sth->stmt), "'?"))))
+      {
+        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+          PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                    "\t\tSETTING imp_sth->use_server_side_prepare to FALSE\n");
+        mysql_stmt_close(imp_sth->stmt);
+        imp_sth->stmt = NULL;
+        imp_sth->use_server_side_prepare = FALSE;
+      }
+      else
+      {
+        mariadb_dr_do_error(sth, mysql_stmt_errno(imp_sth->stmt),
+                 mysql_stmt_error(imp_sth->stmt),
+                mysql_sqlstate(imp_dbh->pmysql));
+        mysql_stmt_close(imp_sth->stmt);
+        imp_sth->stmt= NULL;
+        return 0;
+      }
     }
-    if (imp_drh->embedded_args)
+    else
     {
-      (void)SvREFCNT_dec(imp_drh->embedded_args);
-      imp_drh->embedded_args = NULL;
+      num_params = mysql_stmt_param_count(imp_sth->stmt);
+      if (num_params > INT_MAX)
+      {
+        mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "Prepared statement contains too many placeholders", "HY000");
+        mysql_stmt_close(imp_sth->stmt);
+        imp_sth->stmt = NULL;
+        return 0;
+      }
+      DBIc_NUM_PARAMS(imp_sth) = num_params;
+      if (DBIc_NUM_PARAMS(imp_sth) > 0)
+      {
+        /* Allocate memory for parameters and bind variables */
+        alloc_param(imp_sth, DBIc_NUM_PARAMS(imp_sth), TRUE);
+        imp_sth->has_been_bound = FALSE;
+
+        /* Initialize ph variables with  NULL values */
+        for (i= 0,
+             bind=      imp_sth->bind,
+             fbind=     imp_sth->fbind,
+             bind_end=  bind+DBIc_NUM_PARAMS(imp_sth);
+             bind < bind_end ;
+             bind++, fbind++, i++ )
+        {
+          bind->buffer_type=  MYSQL_TYPE_STRING;
+          bind->buffer=       NULL;
+          bind->length=       &(fbind->length);
+          bind->is_null=      &(fbind->is_null);
+          fbind->is_null=     TRUE;
+          fbind->length=      0;
+        }
+      }
     }
-    if (imp_drh->embedded_groups)
+  }
+
+  /* Count the number of parameters (driver, vs server-side) */
+  if (!imp_sth->use_server_side_prepare)
+  {
+    num_params = count_params(imp_dbh, aTHX_ statement, statement_len,
+                                            imp_dbh->bind_comment_placeholders);
+    if (num_params > INT_MAX || num_params == ULONG_MAX)
     {
-      (void)SvREFCNT_dec(imp_drh->embedded_groups);
-      imp_drh->embedded_groups = NULL;
+      mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "Prepared statement contains too many placeholders", "HY000");
+      mysql_stmt_close(imp_sth->stmt);
+      imp_sth->stmt = NULL;
+      return 0;
     }
+    DBIc_NUM_PARAMS(imp_sth) = num_params;
   }
+
+  /* Allocate memory for parameters */
+  if (DBIc_NUM_PARAMS(imp_sth) > 0 && !imp_sth->params)
+    alloc_param(imp_sth, DBIc_NUM_PARAMS(imp_sth), FALSE);
+  DBIc_IMPSET_on(imp_sth);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_prepare_sv\n");
+  return 1;
 }
 
-static void mariadb_db_close_mysql(pTHX_ imp_drh_t *imp_drh, imp_dbh_t *imp_dbh)
+/***************************************************************************
+ * Name: mariadb_st_free_result_sets
+ *
+ * Purpose: Clean-up single or multiple result sets (if any)
+ *
+ * Inputs: sth - Statement handle
+ *         imp_sth - driver's private statement handle
+ *         free_last - free also the last result set
+ *
+ * Returns: TRUE ok
+ *          FALSE error; mariadb_dr_do_error will be called
+ *************************************************************************/
+static bool mariadb_st_free_result_sets(SV *sth, imp_sth_t *imp_sth, bool free_last)
 {
-  AV *av;
-  I32 i;
-  MAGIC *mg;
-  SV **svp;
-  SV *sv;
-  SV *sth;
-  imp_sth_t *imp_sth;
+  dTHX;
+  D_imp_dbh_from_sth;
+  D_imp_xxh(sth);
+  int next_result_rc= -1;
+  unsigned int error;
 
-  if (DBIc_TRACE_LEVEL(imp_dbh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_dbh), "\tmariadb_db_close_mysql: imp_dbh=%p pmysql=%p\n", imp_dbh, imp_dbh->pmysql);
+  /* No connection, nothing to clean, no error */
+  if (!imp_dbh->pmysql)
+    return TRUE;
 
-  DBIc_ACTIVE_off(imp_dbh);
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t>- mariadb_st_free_result_sets\n");
 
-  if (imp_dbh->list_entry)
-    mariadb_list_remove(imp_drh->active_imp_dbhs, imp_dbh->list_entry);
+  /* Iterate over all remaining rows, required when mysql_use_result() was called */
+  if (imp_sth->result)
+    while (mysql_fetch_row(imp_sth->result));
 
-  if (imp_dbh->pmysql)
+  do
   {
-    mariadb_dr_close_mysql(aTHX_ imp_drh, imp_dbh->pmysql);
-    imp_dbh->pmysql = NULL;
-#ifdef _WIN32
-    /*
-      C file descriptor sock_fd on Windows was opened via win32_open_osfhandle()
-      function from the Windows native socket. Therefore sock_fd needs to be
-      closed via close() function. This function also closes original Windows
-      native socket from which was sock_fd opened. But Windows native socket
-      was already closed by mariadb_dr_close_mysql() function and therefore we
-      need to avoid closing it more times. So first disassociate Windows native
-      socket from C file descriptor sock_fd via _set_osfhnd() function and then
-      close sock_fd via close() function.
-    */
-    if (imp_dbh->sock_fd >= 0)
-    {
-#ifdef _UCRT
-    /*
-      Disassociation is not possible for UCRT builds as UCRT does not provide
-      access to native Windows handle. Skipping disassociation introduce race
-      condition, double close, possible closing of recycled handle and crashes.
-     */
-    #warning DBD::MariaDB compiled with UCRT runtime may crash
-#else
-    _set_osfhnd(imp_dbh->sock_fd, INVALID_HANDLE_VALUE);
-#endif
-    close(imp_dbh->sock_fd);
-    }
-#endif
-    imp_dbh->sock_fd = -1;
-    svp = hv_fetchs((HV*)DBIc_MY_H(imp_dbh), "ChildHandles", FALSE);
-    if (svp && *svp)
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_free_result_sets RC %d\n", next_result_rc);
+
+    if (next_result_rc == 0)
     {
-      SvGETMAGIC(*svp);
-      if (SvROK(*svp) && SvTYPE(SvRV(*svp)) == SVt_PVAV)
+      if (!(imp_sth->result = mysql_store_result(imp_dbh->pmysql)))
       {
-        av = (AV *)SvRV(*svp);
-        for (i = AvFILL(av); i >= 0; --i)
+        /* Check for possible error */
+        if (mysql_errno(imp_dbh->pmysql))
         {
-          svp = av_fetch(av, i, FALSE);
-          if (!svp || !*svp || !sv_isobject(*svp) || SvTYPE(SvRV(*svp)) != SVt_PVHV)
-            continue;
-          sv = SvRV(*svp);
-          /* get inner DBI handle (sth) from outer DBI handle (sv) */
-          if (!SvMAGICAL(sv))
-            continue;
-          mg = mg_find(sv, 'P');
-          if (!mg)
-            continue;
-          sth = mg->mg_obj;
-          imp_sth = (imp_sth_t *)DBIh_COM(sth);
-          if (DBIc_TYPE(imp_sth) != DBIt_ST)
-            continue;
-          /* mysql_close() should properly invalidates MYSQL* pointers in
-           * MYSQL_STMT structures. But MariaDB and MySQL clients affected by
-           * CVE 2017-3302 do not do it. So do it manually to prevent crash. */
-          if (imp_sth->stmt && imp_sth->stmt->mysql)
-          {
-            if (DBIc_TRACE_LEVEL(imp_dbh) >= 2)
-              PerlIO_printf(DBIc_LOGPIO(imp_dbh), "Applying CVE 2017-3302 workaround for sth=%p\n", imp_sth);
-            imp_sth->stmt->mysql = NULL;
-          }
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+          PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_free_result_sets ERROR: %s\n",
+                                  mysql_error(imp_dbh->pmysql));
+
+          mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql),
+                   mysql_sqlstate(imp_dbh->pmysql));
+          return FALSE;
         }
+        imp_dbh->insertid = imp_sth->insertid = mysql_insert_id(imp_dbh->pmysql);
       }
     }
-  }
-}
+    if (imp_sth->result && (mysql_more_results(imp_dbh->pmysql) || free_last))
+    {
+      mysql_free_result(imp_sth->result);
+      imp_sth->result=NULL;
+      imp_sth->current_row=NULL;
+    }
+  } while ((next_result_rc=mysql_next_result(imp_dbh->pmysql))==0);
 
-/*
- ***************************************************************************
- *
- *  Name:    mariadb_db_disconnect
- *
- *  Purpose: Disconnect a database handle from its database
- *
- *  Input:   dbh - database handle being disconnected
- *           imp_dbh - drivers private database handle data
- *
- *  Returns: 1 for success (always)
- *
- **************************************************************************/
+  if (next_result_rc > 0)
+  {
+#if MYSQL_VERSION_ID < 50025
+    /* Cover a protocol design error: error packet does not contain the server status.
+     * Luckily, an error always aborts execution of a statement, so it is safe to turn off the flag. */
+    imp_dbh->pmysql->server_status &= ~SERVER_MORE_RESULTS_EXISTS;
+#endif
 
-int mariadb_db_disconnect(SV* dbh, imp_dbh_t* imp_dbh)
-{
-  dTHX;
-  D_imp_drh_from_dbh;
-  PERL_UNUSED_ARG(dbh);
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_free_result_sets: Error while processing multi-result set: %s\n",
+                    mysql_error(imp_dbh->pmysql));
 
-  /* We assume that disconnect will always work       */
-  /* since most errors imply already disconnected.    */
-  mariadb_db_close_mysql(aTHX_ imp_drh, imp_dbh);
+    /* This is error for previous unfetched result ret. So do not report server errors to caller which is expecting new result set. */
+    error = mysql_errno(imp_dbh->pmysql);
+    if (error == CR_COMMANDS_OUT_OF_SYNC || error == CR_OUT_OF_MEMORY || error == CR_SERVER_GONE_ERROR || error == CR_SERVER_LOST || error == ER_CLIENT_INTERACTION_TIMEOUT || error == CR_UNKNOWN_ERROR)
+    {
+      mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
+      return FALSE;
+    }
+  }
 
-  /* We don't free imp_dbh since a reference still exists    */
-  /* The DESTROY method is the only one to 'free' memory.    */
-  return 1;
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_free_result_sets\n");
+
+  return TRUE;
 }
 
 
 /***************************************************************************
+ * Name: mariadb_st_more_results
  *
- *  Name:    mariadb_dr_discon_all
- *
- *  Purpose: Disconnect all database handles at shutdown time
- *
- *  Input:   dbh - database handle being disconnected
- *           imp_dbh - drivers private database handle data
+ * Purpose: Move onto the next result set (if any)
  *
- *  Returns: 1 for success, 0 otherwise
+ * Inputs: sth - Statement handle
+ *         imp_sth - driver's private statement handle
  *
- **************************************************************************/
-
-int mariadb_dr_discon_all (SV *drh, imp_drh_t *imp_drh) {
+ * Returns: TRUE if there are more results sets
+ *          FALSE if there are not
+ *************************************************************************/
+bool mariadb_st_more_results(SV* sth, imp_sth_t* imp_sth)
+{
   dTHX;
-  int ret;
-  struct mariadb_list_entry *entry;
-  PERL_UNUSED_ARG(drh);
-
-  while ((entry = imp_drh->taken_pmysqls))
-  {
-    mariadb_dr_close_mysql(aTHX_ imp_drh, (MYSQL *)entry->data);
-    mariadb_list_remove(imp_drh->taken_pmysqls, entry);
-  }
+  D_imp_dbh_from_sth;
+  D_imp_xxh(sth);
 
-  while (imp_drh->active_imp_dbhs)
-    mariadb_db_close_mysql(aTHX_ imp_drh, (imp_dbh_t *)imp_drh->active_imp_dbhs->data);
+  bool use_mysql_use_result = imp_sth->use_mysql_use_result;
+  int next_result_return_code, i;
 
-  ret = 1;
+  if (!SvROK(sth) || SvTYPE(SvRV(sth)) != SVt_PVHV)
+    croak("Expected hash array");
 
-  if (imp_drh->instances)
+  if (imp_sth->use_server_side_prepare)
   {
-    warn("DBD::MariaDB disconnect_all: %lu database handlers were not released (possible bug in driver)", imp_drh->instances);
-    ret = 0;
+    mariadb_dr_do_error(sth, CR_NOT_IMPLEMENTED, "Processing of multiple result set is not possible with server side prepare", "HY000");
+    return FALSE;
   }
 
-  if (imp_drh->embedded_started)
+  if (imp_dbh->async_query_in_flight && !imp_sth->async_result)
   {
-    warn("DBD::MariaDB disconnect_all: Embedded server was not properly stopped (possible bug in driver)");
-    ret = 0;
+    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "more_results() without mariadb_async_result()", "HY000");
+    return FALSE;
   }
 
-  /* Some MariaDB and MySQL clients with Embedded server support have a bug which cause segfault
-   * when trying to call mysql_server_end() when Embedded server was not started. So do not call
-   * mysql_server_end() for normal connections when we have Embedded server support. */
-#ifndef HAVE_EMBEDDED
-  if (imp_drh->non_embedded_started)
+  if (imp_dbh->async_query_in_flight && imp_dbh->async_query_in_flight != imp_sth)
   {
- #if defined(HAVE_DEINITIALIZE_SSL) || !defined(HAVE_PROBLEM_WITH_OPENSSL)
-  #ifndef HAVE_BROKEN_INIT
-    warn("DBD::MariaDB disconnect_all: Client library was not properly deinitialized (possible bug in driver)");
-    ret = 0;
-  #else
-    mysql_server_end();
-    imp_drh->non_embedded_started = FALSE;
-    imp_drh->non_embedded_finished = TRUE;
-  #endif
- #endif
+    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "Gathering async_query_in_flight results for the wrong handle", "HY000");
+    return FALSE;
   }
-#endif
+  imp_dbh->async_query_in_flight = NULL;
 
-  if (imp_drh->embedded_args)
-  {
-    warn("DBD::MariaDB disconnect_all: mariadb_embedded_options was not released (possible bug in driver)");
-    ret = 0;
-  }
+  DBIc_ACTIVE_off(imp_sth);
 
-  if (imp_drh->embedded_groups)
+  if (!imp_dbh->pmysql && !mariadb_db_reconnect(sth, NULL))
   {
-    warn("DBD::MariaDB disconnect_all: mariadb_embedded_groups was not released (possible bug in driver)");
-    ret = 0;
+    mariadb_dr_do_error(sth, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+    return FALSE;
   }
 
-  return ret;
-}
-
-
-/****************************************************************************
- *
- *  Name:    mariadb_db_destroy
- *
- *  Purpose: Our part of the dbh destructor
- *
- *  Input:   dbh - database handle being destroyed
- *           imp_dbh - drivers private database handle data
- *
- *  Returns: Nothing
- *
- **************************************************************************/
-
-void mariadb_db_destroy(SV* dbh, imp_dbh_t* imp_dbh) {
-
-    /*
-     *  Being on the safe side never hurts ...
-     */
-  if (DBIc_ACTIVE(imp_dbh))
+  if (!mysql_more_results(imp_dbh->pmysql))
   {
-      if (!DBIc_has(imp_dbh, DBIcf_AutoCommit) && imp_dbh->pmysql)
-        if (mysql_rollback(imp_dbh->pmysql))
-          mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
-    mariadb_db_disconnect(dbh, imp_dbh);
+    /* No more pending result set(s)*/
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+		    "\n      <- mariadb_st_more_results no more results\n");
+    return FALSE;
   }
 
-  /* Tell DBI, that dbh->destroy must no longer be called */
-  DBIc_off(imp_dbh, DBIcf_IMPSET);
-}
-
-/* 
- ***************************************************************************
- *
- *  Name:    mariadb_db_STORE_attrib
- *
- *  Purpose: Function for storing dbh attributes; we currently support
- *           just nothing. :-)
- *
- *  Input:   dbh - database handle being modified
- *           imp_dbh - drivers private database handle data
- *           keysv - the attribute name
- *           valuesv - the attribute value
- *
- *  Returns: 1 for success, 0 otherwise
- *
- **************************************************************************/
-/* DBI expects that on AutoCommit failure driver croaks and does not return */
-#define croak_autocommit_failure() croak("Changing AutoCommit attribute failed: %" SVf, SVfARG(DBIc_ERRSTR(imp_dbh)))
-int
-mariadb_db_STORE_attrib(
-                    SV* dbh,
-                    imp_dbh_t* imp_dbh,
-                    SV* keysv,
-                    SV* valuesv
-                   )
-{
-  dTHX;
-  STRLEN kl;
-  char *key = SvPV(keysv, kl); /* needs to process get magic */
-  const bool bool_value = SvTRUE_nomg(valuesv);
-
-  if (memEQs(key, kl, "AutoCommit"))
+  /*
+   *  Free cached array attributes
+   */
+  for (i= 0; i < AV_ATTRIB_LAST;  i++)
   {
-      bool oldval = DBIc_has(imp_dbh, DBIcf_AutoCommit) ? TRUE : FALSE;
-
-      if (bool_value == oldval)
-        return 1;
+    if (imp_sth->av_attr[i])
+      SvREFCNT_dec(imp_sth->av_attr[i]);
 
-      /* if setting AutoCommit on ... */
-      if (!imp_dbh->no_autocommit_cmd)
-      {
-        if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
-        {
-          mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
-          croak_autocommit_failure(); /* does not return */
-        }
-        if (
-            mysql_autocommit(imp_dbh->pmysql, bool_value)
-           )
-        {
-          mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
-          croak_autocommit_failure(); /* does not return */
-        }
-      }
-      DBIc_set(imp_dbh, DBIcf_AutoCommit, bool_value);
+    imp_sth->av_attr[i]= Nullav;
   }
-  else if (strBEGINs(key, "mariadb_"))
-  {
-    if (memEQs(key, kl, "mariadb_use_result"))
-      imp_dbh->use_mysql_use_result = bool_value;
-    else if (memEQs(key, kl, "mariadb_auto_reconnect"))
-      imp_dbh->auto_reconnect = bool_value;
-    else if (memEQs(key, kl, "mariadb_server_prepare"))
-    {
-      if (bool_value && imp_dbh->bind_type_guessing)
-      {
-        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "mariadb_bind_type_guessing and mariadb_server_prepare cannot be enabled together", "HY000");
-        return 0;
-      }
-      imp_dbh->use_server_side_prepare = bool_value;
-    }
-    else if (memEQs(key, kl, "mariadb_server_prepare_disable_fallback"))
-      imp_dbh->disable_fallback_for_server_prepare = bool_value;
-    else if (memEQs(key, kl, "mariadb_no_autocommit_cmd"))
-      imp_dbh->no_autocommit_cmd = bool_value;
-    else if (memEQs(key, kl, "mariadb_bind_type_guessing"))
-    {
-      if (bool_value && imp_dbh->use_server_side_prepare)
-      {
-        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "mariadb_bind_type_guessing and mariadb_server_prepare cannot be enabled together", "HY000");
-        return 0;
-      }
-      imp_dbh->bind_type_guessing = bool_value;
-    }
-    else if (memEQs(key, kl, "mariadb_bind_comment_placeholders"))
-      imp_dbh->bind_comment_placeholders = bool_value;
-  #ifdef HAVE_FABRIC
-    else if (memEQs(key, kl, "mariadb_fabric_opt_group"))
-    {
-      STRLEN len;
-      char *str = SvPVutf8_nomg(valuesv, len);
-      if (strlen(str) != len)
-      {
-        error_nul_character(dbh, "mariadb_fabric_opt_group");
-        return 0;
-      }
-      if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
-      {
-        mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
-        return 0;
-      }
-      mysql_options(imp_dbh->pmysql, FABRIC_OPT_GROUP, str);
-    }
-    else if (memEQs(key, kl, "mariadb_fabric_opt_default_mode"))
-    {
-      if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
-      {
-        mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
-        return 0;
-      }
-      if (SvOK(valuesv)) {
-        STRLEN len;
-        const char *str = SvPV_nomg(valuesv, len);
-        if (len == 0 || memEQs(str, len, "ro") || memEQs(str, len, "rw"))
-          mysql_options(imp_dbh->pmysql, FABRIC_OPT_DEFAULT_MODE, len == 0 ? NULL : str);
-        else
-        {
-          mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Valid settings for FABRIC_OPT_DEFAULT_MODE are 'ro', 'rw', or undef/empty string", "HY000");
-          return 0;
-        }
-      }
-      else {
-        mysql_options(imp_dbh->pmysql, FABRIC_OPT_DEFAULT_MODE, NULL);
-      }
-    }
-    else if (memEQs(key, kl, "mariadb_fabric_opt_mode"))
-    {
-      STRLEN len;
-      const char *str = SvPV_nomg(valuesv, len);
-      if (!memEQs(str, len, "ro") && !memEQs(str, len, "rw"))
-      {
-        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Valid settings for FABRIC_OPT_MODE are 'ro' or 'rw'", "HY000");
-        return 0;
-      }
-      if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
-      {
-        mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
-        return 0;
-      }
-      mysql_options(imp_dbh->pmysql, FABRIC_OPT_MODE, str);
-    }
-    else if (memEQs(key, kl, "mariadb_fabric_opt_group_credentials"))
+  free_hash_keys(aTHX_ imp_sth);
+
+  /* Release previous MySQL result*/
+  if (imp_sth->result)
+  {
+    mysql_free_result(imp_sth->result);
+    imp_sth->result= NULL;
+  }
+
+  imp_sth->done_desc = FALSE;
+  imp_sth->current_row = NULL;
+  imp_sth->currow = 0;
+  imp_sth->row_num = (my_ulonglong)-1;
+
+  /* clear NUM_OF_FIELDS attribute */
+  DBIc_DBISTATE(imp_sth)->set_attr_k(sth, sv_2mortal(newSVpvs("NUM_OF_FIELDS")), 0, sv_2mortal(newSViv(0)));
+
+  /* delete cached handle attributes */
+  /* XXX should be driven by a list to ease maintenance */
+  (void)hv_deletes((HV*)SvRV(sth), "NAME", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "NULLABLE", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "NUM_OF_FIELDS", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "PRECISION", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "SCALE", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "TYPE", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "mariadb_insertid", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "mariadb_is_auto_increment", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "mariadb_is_blob", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "mariadb_is_key", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "mariadb_is_num", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "mariadb_is_pri_key", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "mariadb_length", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "mariadb_max_length", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "mariadb_table", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "mariadb_type", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "mariadb_type_name", G_DISCARD);
+  (void)hv_deletes((HV*)SvRV(sth), "mariadb_warning_count", G_DISCARD);
+
+  next_result_return_code= mysql_next_result(imp_dbh->pmysql);
+
+  imp_sth->warning_count = mysql_warning_count(imp_dbh->pmysql);
+
+  /*
+    mysql_next_result returns
+      0 if there are more results
+     -1 if there are no more results
+     >0 if there was an error
+   */
+  if (next_result_return_code > 0)
+  {
+#if MYSQL_VERSION_ID < 50025
+    /* Cover a protocol design error: error packet does not contain the server status.
+     * Luckily, an error always aborts execution of a statement, so it is safe to turn off the flag. */
+    imp_dbh->pmysql->server_status &= ~SERVER_MORE_RESULTS_EXISTS;
+#endif
+    mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql),
+             mysql_sqlstate(imp_dbh->pmysql));
+
+    return FALSE;
+  }
+  else if(next_result_return_code == -1)                                                                                                                  
+  {                                                                                                                                                       
+    return FALSE;
+  }  
+  else
+  {
+    /* Store the result from the Query */
+    imp_sth->result = use_mysql_use_result ?
+     mysql_use_result(imp_dbh->pmysql) : mysql_store_result(imp_dbh->pmysql);
+
+    if (mysql_errno(imp_dbh->pmysql))
     {
-      mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "'fabric_opt_group_credentials' is not supported", "HY000");
-      return 0;
+      mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), 
+               mysql_sqlstate(imp_dbh->pmysql));
+      return FALSE;
     }
-  #endif
-    else if (memEQs(key, kl, "mariadb_max_allowed_packet"))
+
+    if (imp_sth->result == NULL)
     {
-      if (imp_dbh->is_embedded)
-      {
-        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "mariadb_max_allowed_packet is not supported for Embedded server", "HY000");
-        return 0;
-      }
-#if (!defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 50709 && MYSQL_VERSION_ID != 60000) || (defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 100206 && MYSQL_VERSION_ID != 100300)
-      /* MYSQL_OPT_MAX_ALLOWED_PACKET was added in mysql 5.7.9 */
-      /* MYSQL_OPT_MAX_ALLOWED_PACKET was added in MariaDB 10.2.6 and MariaDB 10.3.1 */
-      UV uv = SvUV_nomg(valuesv);
-      unsigned long packet_size = (uv <= ULONG_MAX ? uv : ULONG_MAX);
-      if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
-      {
-        mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
-        return 0;
-      }
-      mysql_options(imp_dbh->pmysql, MYSQL_OPT_MAX_ALLOWED_PACKET, &packet_size);
-#else
-      /* before MySQL 5.7.9 and MariaDB 10.2.6 and MariaDB 10.3.0 it is not possible to change max_allowed_packet after connection was established */
-      if (imp_dbh->connected)
-        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Changing mariadb_max_allowed_packet is not supported after connection was established", "HY000");
-      return 0;
-#endif
+      imp_sth->row_num = mysql_affected_rows(imp_dbh->pmysql);
+
+      imp_dbh->insertid = imp_sth->insertid = mysql_insert_id(imp_dbh->pmysql);
+
+      if (mysql_more_results(imp_dbh->pmysql))
+        DBIc_ACTIVE_on(imp_sth);
     }
-    else if (memEQs(key, kl, "mariadb_multi_statements"))
+    else
     {
-      if (!imp_dbh->connected) /* When not connected, it is handled in mariadb_dr_connect() */
-        return 0;
-      if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
-      {
-        mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
-        return 0;
-      }
-      if (mysql_set_server_option(imp_dbh->pmysql, bool_value ? MYSQL_OPTION_MULTI_STATEMENTS_ON : MYSQL_OPTION_MULTI_STATEMENTS_OFF) != 0)
-      {
-        mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
-        return 0;
-      }
-      imp_dbh->use_multi_statements = bool_value;
+      /* We have a new rowset */
+      imp_sth->row_num = use_mysql_use_result ? (my_ulonglong)-2 : mysql_num_rows(imp_sth->result);
+
+      /* Adjust NUM_OF_FIELDS - which also adjusts the row buffer size */
+      DBIc_DBISTATE(imp_sth)->set_attr_k(sth, sv_2mortal(newSVpvs("NUM_OF_FIELDS")), 0,
+          sv_2mortal(newSVuv(mysql_num_fields(imp_sth->result)))
+      );
+
+      if (imp_sth->row_num)
+        DBIc_ACTIVE_on(imp_sth);
     }
-    else
+
+    if (imp_sth->is_async && mysql_more_results(imp_dbh->pmysql))
+      imp_dbh->async_query_in_flight = imp_sth;
+
+    imp_dbh->pmysql->net.last_errno= 0;
+    return TRUE;
+  }
+}
+
+/**************************************************************************
+ *
+ *  Name:    mariadb_st_internal_execute
+ *
+ *  Purpose: Internal version for executing a statement, called both from
+ *           within the "do" and the "execute" method.
+ *
+ *  Inputs:  h - object handle, for storing error messages
+ *           statement - query being executed
+ *           attribs - statement attributes, currently ignored
+ *           num_params - number of parameters being bound
+ *           params - parameter array
+ *           result - where to store results, if any
+ *           svsock - socket connected to the database
+ *
+ **************************************************************************/
+
+
+static my_ulonglong mariadb_st_internal_execute(
+                                       SV *h, /* could be sth or dbh */
+                                       char *sbuf,
+                                       STRLEN slen,
+                                       int num_params,
+                                       imp_sth_ph_t *params,
+                                       MYSQL_RES **result,
+                                       MYSQL **svsock,
+                                       bool use_mysql_use_result
+                                      )
+{
+  dTHX;
+  bool bind_type_guessing= FALSE;
+  bool bind_comment_placeholders= TRUE;
+  char *salloc;
+  imp_sth_t *cache_sth= NULL;
+  int htype;
+  bool async = FALSE;
+  my_ulonglong rows= 0;
+  /* thank you DBI.c for this info! */
+  D_imp_xxh(h);
+
+  htype= DBIc_TYPE(imp_xxh);
+  /*
+    It is important to import imp_dbh properly according to the htype
+    that it is! Also, one might ask why bind_type_guessing is assigned
+    in each block. Well, it's because D_imp_ macros called in these
+    blocks make it so imp_dbh is not "visible" or defined outside of the
+    if/else (when compiled, it fails for imp_dbh not being defined).
+  */
+  /* h is a dbh */
+  if (htype == DBIt_DB)
+  {
+    D_imp_dbh(h);
+    /* if imp_dbh is not available, it causes segfault (proper) on OpenBSD */
+    if (imp_dbh)
     {
-      if (imp_dbh->connected) /* Ignore unknown attributes passed by DBI->connect, they are handled in mariadb_dr_connect() */
-        error_unknown_attribute(dbh, key);
-      return 0;
+      bind_type_guessing= imp_dbh->bind_type_guessing;
+      bind_comment_placeholders= imp_dbh->bind_comment_placeholders;
     }
+    async = imp_dbh->async_query_in_flight ? TRUE : FALSE;
   }
+  /* h is a sth */
   else
   {
-    if (!skip_attribute(key)) /* Not handled by this driver */
-      error_unknown_attribute(dbh, key);
-    return 0;
+    D_imp_sth(h);
+    D_imp_dbh_from_sth;
+    /* if imp_dbh is not available, it causes segfault (proper) on OpenBSD */
+    if (imp_dbh)
+    {
+      bind_type_guessing= imp_dbh->bind_type_guessing;
+      bind_comment_placeholders= imp_dbh->bind_comment_placeholders;
+    }
+    async = imp_sth->is_async;
+    imp_dbh->async_query_in_flight = async ? imp_sth : NULL;
+    cache_sth = imp_sth;
   }
 
-  return 1;
-}
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "mariadb_st_internal_execute MYSQL_VERSION_ID %d\n",
+                  MYSQL_VERSION_ID );
 
-#if IVSIZE < 8
-static char *
-my_ulonglong2str(my_ulonglong val, char *buf, STRLEN *len)
-{
-  char *ptr = buf + *len - 1;
+  if (!*svsock && !mariadb_db_reconnect(h, NULL))
+  {
+    mariadb_dr_do_error(h, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+    return -1;
+  }
 
-  if (*len < 2)
+  /* Statement of sth is parsed only on the first execute and constructed in reused buffer */
+  if (cache_sth && num_params > 0)
   {
-    *len = 0;
-    return NULL;
+    if (!cache_sth->placeholders_parsed ||
+        cache_sth->placeholders_comments != bind_comment_placeholders)
+    {
+      Safefree(cache_sth->placeholders);
+      cache_sth->num_placeholders= parse_placeholders(imp_xxh,
+                                                             sbuf,
+                                                             slen,
+                                                             bind_comment_placeholders,
+                                                             &cache_sth->placeholders);
+      cache_sth->placeholders_comments= bind_comment_placeholders;
+      cache_sth->placeholders_parsed= TRUE;
+    }
+    salloc= substitute_params(aTHX_ *svsock,
+                              sbuf,
+                              &slen,
+                              params,
+                              num_params,
+                              bind_type_guessing,
+                              cache_sth->placeholders,
+                              cache_sth->num_placeholders,
+                              &cache_sth->statement_buffer,
+                              &cache_sth->statement_buffer_size);
+  }
+  else
+    salloc= parse_params(imp_xxh,
+                                aTHX_ *svsock,
+                                sbuf,
+                                &slen,
+                                params,
+                                num_params,
+                                bind_type_guessing,
+                                bind_comment_placeholders);
+
+  if (salloc)
+  {
+    sbuf= salloc;
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "Binding parameters: %.1000s%s\n", sbuf, slen > 1000 ? "..." : "");
   }
 
-  if (val == 0)
-  {
-    buf[0] = '0';
-    buf[1] = '\0';
-    *len = 1;
-    return buf;
+  if(async) {
+    if((mysql_send_query(*svsock, sbuf, slen)) &&
+       (!mariadb_db_reconnect(h, NULL) ||
+        (mysql_send_query(*svsock, sbuf, slen))))
+    {
+        rows = -1;
+    } else {
+        rows = 0;
+    }
+  } else {
+      if ((mysql_real_query(*svsock, sbuf, slen))  &&
+          (!mariadb_db_reconnect(h, NULL) ||
+           (mysql_real_query(*svsock, sbuf, slen))))
+      {
+#if MYSQL_VERSION_ID < 50025
+        /* Cover a protocol design error: error packet does not contain the server status.
+         * Luckily, an error always aborts execution of a statement, so it is safe to turn off the flag. */
+        (*svsock)->server_status &= ~SERVER_MORE_RESULTS_EXISTS;
+#endif
+        rows = -1;
+      } else {
+          /** Store the result from the Query */
+          *result= use_mysql_use_result ?
+            mysql_use_result(*svsock) : mysql_store_result(*svsock);
+
+          if (mysql_errno(*svsock))
+            rows = -1;
+          else if (use_mysql_use_result)
+            rows = (my_ulonglong)-2;
+          else if (*result)
+            rows = mysql_num_rows(*result);
+          else {
+            rows = mysql_affected_rows(*svsock);
+          }
+      }
   }
 
-  *ptr = '\0';
-  while (val > 0)
+  if (cache_sth)
   {
-    if (ptr == buf)
+    /* Do not keep too large buffer between executes */
+    if (cache_sth->statement_buffer_size > cache_sth->statement_buffer_max)
     {
-      *len = 0;
-      return NULL;
+      Safefree(cache_sth->statement_buffer);
+      cache_sth->statement_buffer= NULL;
+      cache_sth->statement_buffer_size= 0;
     }
-    *(--ptr) = ('0' + (val % 10));
-    val = val / 10;
   }
+  else if (salloc)
+    Safefree(salloc);
 
-  *len = (buf + *len - 1) - ptr;
-  return ptr;
-}
-
-static char*
-signed_my_ulonglong2str(my_ulonglong val, char *buf, STRLEN *len)
-{
-  char *ptr;
-
-  if (val <= (~(my_ulonglong)0 >> 1))
-    return my_ulonglong2str(val, buf, len);
-
-  ptr = my_ulonglong2str(-val, buf, len);
-  if (!ptr || ptr == buf) {
-    *len = 0;
-    return NULL;
-  }
+  if (rows == (my_ulonglong)-1)
+    mariadb_dr_do_error(h, mysql_errno(*svsock), mysql_error(*svsock), 
+             mysql_sqlstate(*svsock));
 
-  *(--ptr) = '-';
-  *len += 1;
-  return ptr;
+  return(rows);
 }
-#endif
 
-SV*
-mariadb_dr_my_ulonglong2sv(pTHX_ my_ulonglong val)
+static bool mariadb_st_has_stream(imp_sth_ph_t *params, int num_params)
 {
-#if IVSIZE >= 8
-  return newSVuv(val);
-#else
-  if (val <= UV_MAX)
-  {
-    return newSVuv(val);
-  }
-  else
+  int i;
+  for (i = 0; i < num_params; ++i)
   {
-    char buf[64];
-    STRLEN len = sizeof(buf);
-    char *ptr = my_ulonglong2str(val, buf, &len);
-    return newSVpvn(ptr, len);
+    if (params[i].stream)
+      return TRUE;
   }
-#endif
+  return FALSE;
 }
 
-/***************************************************************************
- *
- *  Name:    mariadb_db_FETCH_attrib
- *
- *  Purpose: Function for fetching dbh attributes
- *
- *  Input:   dbh - database handle being queried
- *           imp_dbh - drivers private database handle data
- *           keysv - the attribute name
- *
- *  Returns: An SV*, if successful; NULL otherwise
- *
- *  Notes:   Do not forget to call sv_2mortal in the former case!
- *
- **************************************************************************/
-
-SV* mariadb_db_FETCH_attrib(SV *dbh, imp_dbh_t *imp_dbh, SV *keysv)
+/*
+  Send values of parameters bound with mariadb_stream attribute in chunks via
+  mysql_stmt_send_long_data(). Filehandles are read as bytes, strings returned
+  by code references are encoded like other bound values. Parameters must be
+  already bound by mysql_stmt_bind_param().
+*/
+static bool mariadb_st_send_long_data(pTHX_ SV *h, MYSQL_STMT *stmt, int num_params, imp_sth_ph_t *params)
 {
-  dTHX;
-  STRLEN kl;
-  char *key = SvPV(keysv, kl); /* needs to process get magic */
-  SV* result = NULL;
-  PERL_UNUSED_ARG(dbh);
+  const STRLEN chunk_size = 65536;
+  D_imp_xxh(h);
+  int i;
 
-  switch (*key) {
-    case 'A':
-      if (memEQs(key, kl, "AutoCommit"))
-          return sv_2mortal(boolSV(DBIc_has(imp_dbh,DBIcf_AutoCommit)));
-      break;
-  }
+  if (!mariadb_st_has_stream(params, num_params))
+    return TRUE;
 
-  if (!strBEGINs(key, "mariadb_"))
+  /* Discard data of previously interrupted sending */
+  if (mysql_stmt_reset(stmt))
   {
-    if (!skip_attribute(key)) /* Not handled by this driver */
-      error_unknown_attribute(dbh, key);
-    return Nullsv;
+    mariadb_dr_do_error(h, mysql_stmt_errno(stmt), mysql_stmt_error(stmt), mysql_stmt_sqlstate(stmt));
+    return FALSE;
   }
-  else
+
+  for (i = 0; i < num_params; ++i)
   {
-    if (memEQs(key, kl, "mariadb_auto_reconnect"))
-      result = boolSV(imp_dbh->auto_reconnect);
-    else if (memEQs(key, kl, "mariadb_bind_type_guessing"))
-      result = boolSV(imp_dbh->bind_type_guessing);
-    else if (memEQs(key, kl, "mariadb_bind_comment_placeholders"))
-      result = boolSV(imp_dbh->bind_comment_placeholders);
-    else if (memEQs(key, kl, "mariadb_clientinfo"))
-    {
-      const char* clientinfo = mysql_get_client_info();
-      result = clientinfo ? sv_2mortal(newSVpv(clientinfo, 0)) : &PL_sv_undef;
-      sv_utf8_decode(result);
-    }
-    else if (memEQs(key, kl, "mariadb_clientversion"))
-      result= sv_2mortal(newSVuv(mysql_get_client_version()));
-    else if (memEQs(key, kl, "mariadb_errno"))
-      result = imp_dbh->pmysql ? sv_2mortal(newSVuv(mysql_errno(imp_dbh->pmysql))) : &PL_sv_undef;
-    else if (memEQs(key, kl, "mariadb_error"))
-    {
-      result = imp_dbh->pmysql ? sv_2mortal(newSVpv(mysql_error(imp_dbh->pmysql), 0)) : &PL_sv_undef;
-      sv_utf8_decode(result);
-    }
-    else if (memEQs(key, kl, "mariadb_dbd_stats"))
-    {
-      HV* hv = newHV();
-      result = sv_2mortal((newRV_noinc((SV*)hv)));
-      (void)hv_stores(hv, "auto_reconnects_ok", newSViv(imp_dbh->stats.auto_reconnects_ok));
-      (void)hv_stores(hv, "auto_reconnects_failed", newSViv(imp_dbh->stats.auto_reconnects_failed));
-    }
-    else if (memEQs(key, kl, "mariadb_hostinfo"))
-    {
-      const char *hostinfo = imp_dbh->pmysql ? (imp_dbh->is_embedded ? "Embedded" : mysql_get_host_info(imp_dbh->pmysql)) : NULL;
-      result = hostinfo ? sv_2mortal(newSVpv(hostinfo, 0)) : &PL_sv_undef;
-      sv_utf8_decode(result);
-    }
-    else if (memEQs(key, kl, "mariadb_info"))
-    {
-      const char *info = imp_dbh->pmysql ? mysql_info(imp_dbh->pmysql) : NULL;
-      result = info ? sv_2mortal(newSVpv(info, 0)) : &PL_sv_undef;
-      sv_utf8_decode(result);
-    }
-    else if (memEQs(key, kl, "mariadb_insertid"))
-    {
-      /* We cannot return an IV, because the insertid is a long. */
-      result = sv_2mortal(my_ulonglong2sv(imp_dbh->insertid));
-    }
-    else if (memEQs(key, kl, "mariadb_max_allowed_packet"))
+    imp_sth_ph_t *ph = &params[i];
+    STRLEN total = 0;
+
+    if (!ph->stream)
+      continue;
+
+    if (SvROK(ph->stream) && SvTYPE(SvRV(ph->stream)) == SVt_PVCV)
     {
-      unsigned long packet_size;
-      if (imp_dbh->is_embedded)
+      bool done = FALSE;
+      while (!done)
       {
-        mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "mariadb_max_allowed_packet is not supported for Embedded server", "HY000");
-        return Nullsv;
+        SV *chunk;
+        const char *buf;
+        STRLEN len = 0;
+        int count;
+        bool failed = FALSE;
+        dSP;
+
+        ENTER;
+        SAVETMPS;
+        PUSHMARK(SP);
+        PUTBACK;
+        count = call_sv(ph->stream, G_SCALAR);
+        SPAGAIN;
+        chunk = (count > 0) ? POPs : &PL_sv_undef;
+        PUTBACK;
+
+        if (SvOK(chunk))
+        {
+          if (sql_type_is_binary(ph->type))
+            buf = SvPVbyte(chunk, len);
+          else
+            buf = SvPVutf8(chunk, len);
+          if (len > 0 && mysql_stmt_send_long_data(stmt, i, buf, len))
+            failed = TRUE;
+          total += len;
+        }
+        if (len == 0)
+          done = TRUE;
+
+        FREETMPS;
+        LEAVE;
+
+        if (failed)
+        {
+          mariadb_dr_do_error(h, mysql_stmt_errno(stmt), mysql_stmt_error(stmt), mysql_stmt_sqlstate(stmt));
+          return FALSE;
+        }
       }
-#if (!defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 50709 && MYSQL_VERSION_ID != 60000) || (defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 100206 && MYSQL_VERSION_ID != 100300)
-      /* mysql_get_option() is not available in all versions */
-      /* if we do not have mysql_get_option() we cannot retrieve max_allowed_packet */
-      /* MYSQL_OPT_MAX_ALLOWED_PACKET was added in mysql 5.7.9 */
-      /* MYSQL_OPT_MAX_ALLOWED_PACKET was added in MariaDB 10.2.6 and MariaDB 10.3.1 */
-  #ifdef HAVE_GET_OPTION
-      mysql_get_option(imp_dbh->pmysql, MYSQL_OPT_MAX_ALLOWED_PACKET, &packet_size);
-  #else
-      mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Fetching mariadb_max_allowed_packet is not supported", "HY000");
-      return Nullsv;
-  #endif
-#else
-      /* before MySQL 5.7.9 and MariaDB 10.2.6 and MariaDB 10.3.0 use max_allowed_packet macro */
-      packet_size = max_allowed_packet;
-#endif
-      result = sv_2mortal(newSVuv(packet_size));
-    }
-    else if (memEQs(key, kl, "mariadb_no_autocommit_cmd"))
-      result = boolSV(imp_dbh->no_autocommit_cmd);
-    else if (memEQs(key, kl, "mariadb_protoinfo"))
-      result = imp_dbh->pmysql ? sv_2mortal(newSViv(mysql_get_proto_info(imp_dbh->pmysql))) : &PL_sv_undef;
-    else if (memEQs(key, kl, "mariadb_serverinfo"))
-    {
-      const char *serverinfo = imp_dbh->pmysql ? mysql_get_server_info(imp_dbh->pmysql) : NULL;
-#ifndef MARIADB_BASE_VERSION
-      /* serverinfo for MariaDB server from MySQL client is prefixed by string 5.5.5- */
-      if (serverinfo && strBEGINs(serverinfo, "5.5.5-"))
-          serverinfo += sizeof("5.5.5-")-1;
-#endif
-      result = serverinfo ? sv_2mortal(newSVpv(serverinfo, 0)) : &PL_sv_undef;
-      sv_utf8_decode(result);
-    } 
-    else if (memEQs(key, kl, "mariadb_ssl_cipher"))
-    {
-#if ((MYSQL_VERSION_ID >= 50023 && MYSQL_VERSION_ID < 50100) || MYSQL_VERSION_ID >= 50111)
-      const char *ssl_cipher = imp_dbh->pmysql ? mysql_get_ssl_cipher(imp_dbh->pmysql) : NULL;
-      result = ssl_cipher ? sv_2mortal(newSVpv(ssl_cipher, 0)) : &PL_sv_undef;
-      sv_utf8_decode(result);
-#else
-      mariadb_dr_do_error(dbh, CR_UNKNOWN_ERROR, "Fetching mariadb_ssl_cipher is not supported", "HY000");
-      return Nullsv;
-#endif
     }
-    else if (memEQs(key, kl, "mariadb_serverversion"))
+    else
     {
-#ifndef MARIADB_BASE_VERSION
-      unsigned int major, minor, patch;
-      const char *serverinfo = imp_dbh->pmysql ? mysql_get_server_info(imp_dbh->pmysql) : NULL;
-      /* serverinfo for MariaDB server from MySQL client is prefixed by string 5.5.5- */
-      if (serverinfo && strBEGINs(serverinfo, "5.5.5-"))
+      IO *io = sv_2io(ph->stream);
+      PerlIO *fp = io ? IoIFP(io) : NULL;
+      SSize_t len;
+      char *buf;
+
+      if (!fp)
       {
-        /* And in this case mysql_get_server_version() returns just 50505 and not correct
-         * MariaDB server version. So parse serverversion manually from serverinfo. */
-        serverinfo += sizeof("5.5.5-")-1;
-        if (sscanf(serverinfo, "%u.%u.%u", &major, &minor, &patch) == 3)
-          result = sv_2mortal(newSVuv(10000UL * major + 100UL * minor + patch));
+        mariadb_dr_do_error(h, CR_INVALID_PARAMETER_NO, "Filehandle bound with mariadb_stream is not opened", "HY000");
+        return FALSE;
+      }
+
+      Newx(buf, chunk_size, char);
+      while ((len = PerlIO_read(fp, buf, chunk_size)) > 0)
+      {
+        if (mysql_stmt_send_long_data(stmt, i, buf, len))
+        {
+          Safefree(buf);
+          mariadb_dr_do_error(h, mysql_stmt_errno(stmt), mysql_stmt_error(stmt), mysql_stmt_sqlstate(stmt));
+          return FALSE;
+        }
+        total += len;
+      }
+      Safefree(buf);
+
+      if (len < 0 || PerlIO_error(fp))
+      {
+        mariadb_dr_do_error(h, CR_UNKNOWN_ERROR, "Reading from filehandle bound with mariadb_stream failed", "HY000");
+        return FALSE;
       }
-#endif
-      if (!result)
-        result = imp_dbh->pmysql ? sv_2mortal(newSVuv(mysql_get_server_version(imp_dbh->pmysql))) : &PL_sv_undef;
     }
-    else if (memEQs(key, kl, "mariadb_sock"))
-      result = sv_2mortal(newSViv(PTR2IV(imp_dbh->pmysql)));
-    else if (memEQs(key, kl, "mariadb_sockfd"))
-      result = (imp_dbh->sock_fd >= 0) ? sv_2mortal(newSViv(imp_dbh->sock_fd)) : &PL_sv_undef;
-    else if (memEQs(key, kl, "mariadb_stat"))
+
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tsent %lu bytes of streamed parameter %d\n", (unsigned long)total, i+1);
+  }
+
+  return TRUE;
+}
+
+ /*
+  Opens read only server side cursor on next execution of statement which
+  sends prefetch rows at once, or disables it when prefetch is 0
+*/
+static bool mariadb_stmt_set_cursor(MYSQL_STMT *stmt, unsigned long prefetch)
+{
+  unsigned long cursor_type = prefetch ? (unsigned long)CURSOR_TYPE_READ_ONLY : (unsigned long)CURSOR_TYPE_NO_CURSOR;
+
+  if (mysql_stmt_attr_set(stmt, STMT_ATTR_CURSOR_TYPE, &cursor_type))
+    return FALSE;
+  if (prefetch && mysql_stmt_attr_set(stmt, STMT_ATTR_PREFETCH_ROWS, &prefetch))
+    return FALSE;
+  return TRUE;
+}
+
+/*
+  Reads result of executed server side prepared statement into result and
+  returns number of rows, -2 when number of rows is not known yet or -1 on
+  error; mariadb_dr_do_error is called in the latter case. When result_stored
+  is true, result set was already stored by mysql_stmt_store_result_start()
+*/
+static my_ulonglong mariadb_st_internal_result41(SV *h, MYSQL_STMT *stmt, MYSQL_RES **result, bool use_mysql_use_result, unsigned long cursor_prefetch, bool result_stored)
+{
+  dTHX;
+  my_ulonglong rows;
+  D_imp_xxh(h);
+
+  /*
+   This statement does not return a result set (INSERT, UPDATE...)
+  */
+  if (!(*result= mysql_stmt_result_metadata(stmt)))
+  {
+    if (mysql_stmt_errno(stmt))
+      goto error;
+
+    rows= mysql_stmt_affected_rows(stmt);
+
+    /* mysql_stmt_affected_rows(): -1 indicates that the query returned an error */
+    if (rows == (my_ulonglong)-1)
+      goto error;
+  }
+  /*
+    This statement returns a result set (SELECT...)
+  */
+  else
+  {
+    if (cursor_prefetch || use_mysql_use_result)
     {
-      const char *stats = imp_dbh->pmysql ? mysql_stat(imp_dbh->pmysql) : NULL;
-      result = stats ? sv_2mortal(newSVpv(stats, 0)) : &PL_sv_undef;
-      sv_utf8_decode(result);
+      /* Rows are fetched from server side cursor or read directly from the
+         connection, number of rows is unknown */
+      rows = (my_ulonglong)-2;
     }
-    else if (memEQs(key, kl, "mariadb_server_prepare"))
-      result = boolSV(imp_dbh->use_server_side_prepare);
-    else if (memEQs(key, kl, "mariadb_server_prepare_disable_fallback"))
-      result = boolSV(imp_dbh->disable_fallback_for_server_prepare);
-    else if (memEQs(key, kl, "mariadb_thread_id"))
-      result = imp_dbh->pmysql ? sv_2mortal(newSVuv(mysql_thread_id(imp_dbh->pmysql))) : &PL_sv_undef;
-    else if (memEQs(key, kl, "mariadb_warning_count"))
-      result = imp_dbh->pmysql ? sv_2mortal(newSVuv(mysql_warning_count(imp_dbh->pmysql))) : &PL_sv_undef;
-    else if (memEQs(key, kl, "mariadb_use_result"))
-      result = boolSV(imp_dbh->use_mysql_use_result);
-    else if (memEQs(key, kl, "mariadb_multi_statements"))
-      result = boolSV(imp_dbh->use_multi_statements);
     else
     {
-      error_unknown_attribute(dbh, key);
-      return Nullsv;
+      if (!result_stored && mysql_stmt_store_result(stmt))
+        goto error;
+      /* Get the total rows affected and return */
+      rows = mysql_stmt_num_rows(stmt);
     }
   }
+  return rows;
 
-  return result;
+error:
+  if (*result)
+  {
+    mysql_free_result(*result);
+    *result = NULL;
+  }
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                  "     errno %d err message %s\n",
+                  mysql_stmt_errno(stmt),
+                  mysql_stmt_error(stmt));
+  mariadb_dr_do_error(h, mysql_stmt_errno(stmt), mysql_stmt_error(stmt),
+           mysql_stmt_sqlstate(stmt));
+  mysql_stmt_reset(stmt);
+  return -1;
 }
 
-AV *mariadb_db_data_sources(SV *dbh, imp_dbh_t *imp_dbh, SV *attr)
+/**************************************************************************
+ *
+ *  Name:    mariadb_st_internal_execute41
+ *
+ *  Purpose: Internal version for executing a prepared statement, called both
+ *           from within the "do" and the "execute" method.
+ *           MYSQL 4.1 API
+ *
+ *
+ *  Inputs:  h - object handle, for storing error messages
+ *           statement - query being executed
+ *           attribs - statement attributes, currently ignored
+ *           num_params - number of parameters being bound
+ *           params - parameter array, values of streamed parameters are
+ *               sent before execute (or NULL)
+ *           result - where to store results, if any
+ *           svsock - socket connected to the database
+ *           use_mysql_use_result - if true, rows are read by mysql_stmt_fetch
+ *               directly from the connection instead of mysql_stmt_store_result
+ *           cursor_prefetch - number of rows fetched at once by read only
+ *               server side cursor, 0 for storing the whole result set
+ *
+ **************************************************************************/
+
+static my_ulonglong mariadb_st_internal_execute41(
+                                         SV *h,
+                                         char *sbuf,
+                                         STRLEN slen,
+                                         int num_params,
+                                         imp_sth_ph_t *params,
+                                         MYSQL_RES **result,
+                                         MYSQL_STMT **stmt_ptr,
+                                         MYSQL_BIND *bind,
+                                         MYSQL **svsock,
+                                         bool *has_been_bound,
+                                         bool use_mysql_use_result,
+                                         unsigned long cursor_prefetch
+                                        )
 {
   dTHX;
-  SV *sv;
-  AV *av;
-  SSize_t i;
-  MYSQL_RES *res;
-  MYSQL_ROW row;
-  MYSQL_FIELD* field;
-  my_ulonglong num_rows;
-  unsigned long *lengths;
-  const char *prefix = "DBI:MariaDB:";
-  const Size_t prefix_len = strlen(prefix);
-  PERL_UNUSED_ARG(attr);
+  int execute_retval;
+  MYSQL_STMT *stmt = *stmt_ptr;
+  my_ulonglong rows=0;
+  bool reconnected = FALSE;
+  D_imp_xxh(h);
 
-  ASYNC_CHECK_RETURN(dbh, NULL);
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                  "\t-> mariadb_st_internal_execute41\n");
 
-  if (!imp_dbh->pmysql && !mariadb_db_reconnect(dbh, NULL))
+  /* free result if exists */
+  if (*result)
   {
-    mariadb_dr_do_error(dbh, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
-    return NULL;
+    mysql_free_result(*result);
+    *result = NULL;
   }
 
-  av = newAV();
-  sv_2mortal((SV *)av);
+  if (!*svsock)
+  {
+    if (!mariadb_db_reconnect(h, NULL))
+    {
+      mariadb_dr_do_error(h, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+      return -1;
+    }
+    reconnected = TRUE;
+  }
 
-  res = mysql_list_dbs(imp_dbh->pmysql, NULL);
-  if (!res && mariadb_db_reconnect(dbh, NULL))
-    res = mysql_list_dbs(imp_dbh->pmysql, NULL);
-  if (!res)
+  /*
+    If were performed any changes with ph variables
+    we have to rebind them
+  */
+
+  if (!reconnected && num_params > 0 && !(*has_been_bound))
   {
-    mariadb_dr_do_error(dbh, mysql_errno(imp_dbh->pmysql),
-                        mysql_error(imp_dbh->pmysql),
-                        mysql_sqlstate(imp_dbh->pmysql));
-    return NULL;
+#if !defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 80300
+    if (mysql_stmt_bind_named_param(stmt, bind, num_params, NULL) == 0)
+#else
+    if (mysql_stmt_bind_param(stmt,bind) == 0)
+#endif
+    {
+      *has_been_bound = TRUE;
+    }
+    else
+    {
+      if (!mariadb_db_reconnect(h, stmt))
+        goto error;
+      reconnected = TRUE;
+    }
   }
 
-  field = mysql_fetch_field(res);
-  if (!field)
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                  "\t\tmariadb_st_internal_execute41 calling mysql_execute with %d num_params\n",
+                  num_params);
+
+  if (!reconnected)
   {
-    mariadb_dr_do_error(dbh, CR_NO_RESULT_SET, "No result list of databases", "HY000");
-    return NULL;
+    if (params && !mariadb_st_send_long_data(aTHX_ h, stmt, num_params, params))
+      return -1;
+    if (!mariadb_stmt_set_cursor(stmt, cursor_prefetch))
+      goto error;
+    execute_retval = mysql_stmt_execute(stmt);
+    if (execute_retval && mariadb_db_reconnect(h, stmt))
+      reconnected = TRUE;
+  }
+  if (reconnected)
+  {
+    *has_been_bound = FALSE;
+    stmt = mysql_stmt_init(*svsock);
+    if (!stmt)
+    {
+      mariadb_dr_do_error(h, mysql_errno(*svsock), mysql_error(*svsock), mysql_sqlstate(*svsock));
+      return -1;
+    }
+    if (mysql_stmt_prepare(stmt, sbuf, slen))
+    {
+      mariadb_dr_do_error(h, mysql_stmt_errno(stmt), mysql_stmt_error(stmt), mysql_stmt_sqlstate(stmt));
+      mysql_stmt_close(stmt);
+      return -1;
+    }
+    mysql_stmt_close(*stmt_ptr);
+    *stmt_ptr = stmt;
+    if (num_params > 0)
+    {
+#if !defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 80300
+      if (mysql_stmt_bind_named_param(stmt, bind, num_params, NULL) == 0)
+#else
+      if (mysql_stmt_bind_param(stmt,bind))
+#endif
+        goto error;
+      *has_been_bound = TRUE;
+    }
+    if (params && mariadb_st_has_stream(params, num_params))
+    {
+      /* Streams were already read, they cannot be sent again */
+      mariadb_dr_do_error(h, CR_SERVER_LOST, "Connection was lost and streamed parameters cannot be sent again", "HY000");
+      return -1;
+    }
+    if (!mariadb_stmt_set_cursor(stmt, cursor_prefetch))
+      goto error;
+    execute_retval= mysql_stmt_execute(stmt);
   }
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                  "\t\tmysql_stmt_execute returned %d\n",
+                  execute_retval);
+  if (execute_retval)
+    goto error;
 
-  num_rows = mysql_num_rows(res);
-  if (num_rows == 0)
-    return av;
+  rows= mariadb_st_internal_result41(h, stmt, result, use_mysql_use_result, cursor_prefetch, FALSE);
+  if (rows == (my_ulonglong)-1)
+    return -1;
 
-  /* av_extend() extends array to size: arg+1 */
-  --num_rows;
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                  "\t<- mysql_internal_execute_41 returning %" SVf " rows\n",
+                  SVfARG(sv_2mortal(my_ulonglong2sv(rows))));
+  return(rows);
 
-  /* Truncate list when is too big */
-  if (num_rows > SSize_t_MAX)
-    num_rows = SSize_t_MAX;
+error:
+  if (*result)
+  {
+    mysql_free_result(*result);
+    *result = NULL;
+  }
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                  "     errno %d err message %s\n",
+                  mysql_stmt_errno(stmt),
+                  mysql_stmt_error(stmt));
+  mariadb_dr_do_error(h, mysql_stmt_errno(stmt), mysql_stmt_error(stmt),
+           mysql_stmt_sqlstate(stmt));
+  mysql_stmt_reset(stmt);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                  "\t<- mariadb_st_internal_execute41\n");
+  return -1;
 
-  av_extend(av, num_rows);
+}
 
-  i = 0;
-  while ((row = mysql_fetch_row(res)))
-  {
-    if (!row[0])
-      continue;
+#ifdef HAVE_ASYNC_STMT
+/*
+  Starts execution of server side prepared statement via non-blocking API,
+  its result is read later by mariadb_db_async_result()
+*/
+static bool mariadb_st_async_execute41(SV *sth, imp_sth_t *imp_sth)
+{
+  dTHX;
+  D_imp_dbh_from_sth;
+  D_imp_xxh(sth);
+  MYSQL_STMT *stmt = imp_sth->stmt;
+  int num_params = DBIc_NUM_PARAMS(imp_sth);
 
-    lengths = mysql_fetch_lengths(res);
+  if (imp_sth->result)
+  {
+    mysql_free_result(imp_sth->result);
+    imp_sth->result = NULL;
+  }
 
-    /* newSV automatically adds extra byte for '\0' and does not set POK */
-    sv = newSV(prefix_len + lengths[0]);
-    av_store(av, i, sv);
+  if (!imp_dbh->pmysql)
+  {
+    mariadb_dr_do_error(sth, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+    return FALSE;
+  }
 
-    memcpy(SvPVX(sv), prefix, prefix_len);
-    memcpy(SvPVX(sv)+prefix_len, row[0], lengths[0]);
-    *(SvPVX(sv)+prefix_len+lengths[0]) = '\0';
+  /* Non-blocking mode is enabled only when it is needed as it allocates stack for the client library */
+  if (!imp_dbh->async_nonblock)
+  {
+    if (mysql_options(imp_dbh->pmysql, MYSQL_OPT_NONBLOCK, 0) != 0)
+    {
+      mariadb_dr_do_error(sth, CR_OUT_OF_MEMORY, "Cannot enable non-blocking mode", "HY000");
+      return FALSE;
+    }
+    imp_dbh->async_nonblock = TRUE;
+  }
 
-    SvPOK_on(sv);
-    SvCUR_set(sv, prefix_len + lengths[0]);
+  if (num_params > 0 && !imp_sth->has_been_bound)
+  {
+    if (mysql_stmt_bind_param(stmt, imp_sth->bind))
+      goto error;
+    imp_sth->has_been_bound = TRUE;
+  }
 
-    if (mysql_charsetnr_is_utf8(field->charsetnr))
-      sv_utf8_decode(sv);
+  if (imp_sth->params && !mariadb_st_send_long_data(aTHX_ sth, stmt, num_params, imp_sth->params))
+    return FALSE;
+  if (!mariadb_stmt_set_cursor(stmt, imp_sth->cursor_prefetch))
+    goto error;
 
-    if ((my_ulonglong)i == num_rows+1)
-      break;
+  imp_sth->async_stmt_step = MARIADB_ASYNC_STMT_EXECUTE;
+  imp_sth->async_stmt_status = mysql_stmt_execute_start(&imp_sth->async_stmt_retval, stmt);
+  imp_dbh->async_query_in_flight = imp_sth;
 
-    i++;
-  }
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                  "\t\tmysql_stmt_execute_start returned status %d\n",
+                  imp_sth->async_stmt_status);
+  return TRUE;
 
-  mysql_free_result(res);
-  return av;
+error:
+  mariadb_dr_do_error(sth, mysql_stmt_errno(stmt), mysql_stmt_error(stmt),
+           mysql_stmt_sqlstate(stmt));
+  mysql_stmt_reset(stmt);
+  return FALSE;
 }
+#endif
 
-static bool mariadb_st_free_result_sets(SV *sth, imp_sth_t *imp_sth, bool free_last);
-
-/* 
- **************************************************************************
+/***************************************************************************
  *
- *  Name:    mariadb_st_prepare_sv
+ *  Name:    mariadb_st_execute_iv
  *
  *  Purpose: Called for preparing an SQL statement; our part of the
  *           statement handle constructor
  *
  *  Input:   sth - statement handle being initialized
  *           imp_sth - drivers private statement handle data
- *           statement - pointer to string with SQL statement
- *           attribs - statement attributes
  *
- *  Returns: 1 for success, 0 otherwise; mariadb_dr_do_error will
- *           be called in the latter case
+ *  Returns: -2 for errors, -1 for unknown number of rows, otherwise number
+ *           of rows; mariadb_dr_do_error will be called for errors
  *
  **************************************************************************/
-int
-mariadb_st_prepare_sv(
-  SV *sth,
-  imp_sth_t *imp_sth,
-  SV *statement_sv,
-  SV *attribs)
+
+IV mariadb_st_execute_iv(SV* sth, imp_sth_t* imp_sth)
 {
-  int i;
-  HV *hv;
-  HE *he;
-  SV **svp;
-  HV *processed;
-  char *statement;
-  STRLEN statement_len;
   dTHX;
-  int prepare_retval;
-  MYSQL_BIND *bind, *bind_end;
-  imp_sth_phb_t *fbind;
-  unsigned long int num_params;
-  D_imp_xxh(sth);
+  int i;
+  unsigned int num_fields;
   D_imp_dbh_from_sth;
+  D_imp_xxh(sth);
+  MYSQL_STMT *stmt = imp_sth->stmt;
+  bool use_server_side_prepare = imp_sth->use_server_side_prepare;
+  bool disable_fallback_for_server_prepare = imp_sth->disable_fallback_for_server_prepare;
 
-  if (imp_sth->statement)
+  ASYNC_CHECK_RETURN(sth, -2);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+      " -> mariadb_st_execute_iv for %p\n", sth);
+
+  if (!SvROK(sth)  ||  SvTYPE(SvRV(sth)) != SVt_PVHV)
+    croak("Expected hash array");
+
+  for (i = 0; i < DBIc_NUM_PARAMS(imp_sth); ++i)
   {
-    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "Statement is already prepared", "HY000");
-    return 0;
+    if (!imp_sth->params[i].bound)
+    {
+      mariadb_dr_do_error(sth, ER_WRONG_ARGUMENTS, "Wrong number of bind parameters", "HY000");
+      return -2;
+    }
   }
 
-  if (!imp_dbh->pmysql && !mariadb_db_reconnect(sth, NULL))
+  /* Free cached array attributes */
+  for (i= 0;  i < AV_ATTRIB_LAST;  i++)
   {
-    mariadb_dr_do_error(sth, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
-    return 0;
-  }
+    if (imp_sth->av_attr[i])
+      SvREFCNT_dec(imp_sth->av_attr[i]);
 
-  statement = SvPVutf8_nomg(statement_sv, statement_len);
-  imp_sth->statement = savepvn(statement, statement_len);
-  imp_sth->statement_len = statement_len;
+    imp_sth->av_attr[i]= Nullav;
+  }
+  free_hash_keys(aTHX_ imp_sth);
 
- /* Set default value of 'mariadb_server_prepare' attribute for sth from dbh */
-  imp_sth->use_mysql_use_result = imp_dbh->use_mysql_use_result;
-  imp_sth->use_server_side_prepare = imp_dbh->use_server_side_prepare;
-  imp_sth->disable_fallback_for_server_prepare = imp_dbh->disable_fallback_for_server_prepare;
+  /* 
+     Clean-up previous result set(s) for sth to prevent
+     'Commands out of sync' error 
+  */
+  if (!mariadb_st_free_result_sets(sth, imp_sth, TRUE))
+    return -2;
 
-  imp_sth->done_desc = FALSE;
-  imp_sth->result = NULL;
+  imp_sth->current_row = NULL;
   imp_sth->currow = 0;
-  imp_sth->row_num = (my_ulonglong)-1;
-
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                 "\t-> mariadb_st_prepare_sv MYSQL_VERSION_ID %d, SQL statement: %.1000s%s\n",
-                  MYSQL_VERSION_ID, statement, statement_len > 1000 ? "..." : "");
 
-  if (attribs)
+  if (use_server_side_prepare)
   {
-    processed = newHV();
-    sv_2mortal(newRV_noinc((SV *)processed)); /* Automatically free HV processed */
-
-    /* Automatically processed by DBI */
-    (void)hv_stores(processed, "Slice", &PL_sv_yes);
-    (void)hv_stores(processed, "Columns", &PL_sv_yes);
-    (void)hv_stores(processed, "MaxRows", &PL_sv_yes);
-
-    (void)hv_stores(processed, "mariadb_server_prepare", &PL_sv_yes);
-    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_server_prepare");
-    imp_sth->use_server_side_prepare = (svp) ?
-      SvTRUE(*svp) : imp_dbh->use_server_side_prepare;
-
-    (void)hv_stores(processed, "mariadb_server_prepare_disable_fallback", &PL_sv_yes);
-    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_server_prepare_disable_fallback");
-    imp_sth->disable_fallback_for_server_prepare = (svp) ?
-      SvTRUE(*svp) : imp_dbh->disable_fallback_for_server_prepare;
-
-    (void)hv_stores(processed, "mariadb_async", &PL_sv_yes);
-    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_async");
-    if(svp && SvTRUE(*svp)) {
-        if (imp_dbh->is_embedded)
-        {
-          mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "Async option not supported for Embedded server", "HY000");
-          return 0;
-        }
-        imp_sth->is_async = TRUE;
-        if (imp_sth->disable_fallback_for_server_prepare)
-        {
-          mariadb_dr_do_error(sth, CR_NOT_IMPLEMENTED,
-                   "Async option not supported with server side prepare", "HY000");
-          return 0;
-        }
-        imp_sth->use_server_side_prepare = FALSE;
+#ifdef HAVE_ASYNC_STMT
+    if (imp_sth->is_async)
+    {
+      if (!mariadb_st_async_execute41(sth, imp_sth))
+        return -2;
+      imp_sth->row_num = 0;
+      DBIc_ACTIVE_on(imp_sth);
+      imp_sth->async_result = FALSE;
+      return 0;
+    }
+#endif
+    imp_sth->row_num= mariadb_st_internal_execute41(
+                                                  sth,
+                                                  imp_sth->statement,
+                                                  imp_sth->statement_len,
+                                                  DBIc_NUM_PARAMS(imp_sth),
+                                                  imp_sth->params,
+                                                  &imp_sth->result,
+                                                  &imp_sth->stmt,
+                                                  imp_sth->bind,
+                                                  &imp_dbh->pmysql,
+                                                  &imp_sth->has_been_bound,
+                                                  imp_sth->use_mysql_use_result,
+                                                  imp_sth->cursor_prefetch
+                                                 );
+    if (imp_sth->row_num == (my_ulonglong)-1) /* -1 means error */
+    {
+      SV *err = DBIc_ERR(imp_xxh);
+      if (!disable_fallback_for_server_prepare && SvIV(err) == ER_UNSUPPORTED_PS)
+      {
+        use_server_side_prepare = FALSE;
+      }
     }
+  }
 
-    /* Set default value of 'mariadb_use_result' attribute for sth from dbh */
-    (void)hv_stores(processed, "mariadb_use_result", &PL_sv_yes);
-    svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_use_result");
-    imp_sth->use_mysql_use_result= svp ?
-      SvTRUE(*svp) : imp_dbh->use_mysql_use_result;
+  if (!use_server_side_prepare)
+  {
+    imp_sth->row_num= mariadb_st_internal_execute(
+                                                sth,
+                                                imp_sth->statement,
+                                                imp_sth->statement_len,
+                                                DBIc_NUM_PARAMS(imp_sth),
+                                                imp_sth->params,
+                                                &imp_sth->result,
+                                                &imp_dbh->pmysql,
+                                                imp_sth->use_mysql_use_result
+                                               );
+    if(imp_dbh->async_query_in_flight) {
+        DBIc_ACTIVE_on(imp_sth);
+        imp_sth->async_result = FALSE;
+        return 0;
+    }
+  }
 
-    hv = (HV*) SvRV(attribs);
-    hv_iterinit(hv);
-    while ((he = hv_iternext(hv)) != NULL)
+  if (imp_sth->row_num != (my_ulonglong)-1)
+  {
+    if (!imp_sth->result)
     {
-      I32 len;
-      const char *key;
-      key = hv_iterkey(he, &len);
-      if (hv_exists(processed, key, len))
-        continue;
-      error_unknown_attribute(sth, key);
-      return 0;
+      /* Some MySQL client versions return correct value from mysql_insert_id()
+       * function only after non-SELECT operation. So store insert id into dbh
+       * cache and later read it only from cache. */
+      imp_dbh->insertid = imp_sth->insertid = mysql_insert_id(imp_dbh->pmysql);
+      if (mysql_more_results(imp_dbh->pmysql))
+        DBIc_ACTIVE_on(imp_sth);
+    }
+    else
+    {
+      /** Store the result in the current statement handle */
+      num_fields = mysql_num_fields(imp_sth->result);
+      DBIc_NUM_FIELDS(imp_sth) = (num_fields <= INT_MAX) ? num_fields : INT_MAX;
+      if (imp_sth->row_num)
+        DBIc_ACTIVE_on(imp_sth);
+      /* Buffers of server side prepared statement stay bound for the next
+       * execute unless statement was prepared again after reconnect or
+       * server sent different metadata, e.g. after ALTER TABLE */
+      if (!use_server_side_prepare || imp_sth->stmt != stmt ||
+          !fbuffer_matches_fields(imp_sth, mysql_fetch_fields(imp_sth->result), DBIc_NUM_FIELDS(imp_sth)))
+        imp_sth->done_desc = FALSE;
     }
   }
 
-  for (i= 0; i < AV_ATTRIB_LAST; i++)
-    imp_sth->av_attr[i]= Nullav;
+  imp_sth->warning_count = mysql_warning_count(imp_dbh->pmysql);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+  {
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                  " <- mariadb_st_execute_iv returning imp_sth->row_num %" SVf "\n",
+                  SVfARG(sv_2mortal(my_ulonglong2sv(imp_sth->row_num))));
+  }
+
+  if (imp_sth->row_num == (my_ulonglong)-1)
+    return -2; /* -2 is error */
+  else if (imp_sth->row_num <= IV_MAX)
+    return imp_sth->row_num;
+  else         /* overflow */
+    return -1; /* -1 is unknown number of rows */
+}
+
+/*
+ * Returns max_allowed_packet limit for statements sent to the server in
+ * *size. Server value is queried once per connection, but only when the
+ * connection is idle, otherwise the query would interfere with a pending
+ * result. When connection is not idle, *size is set to 0. Returns FALSE
+ * and sets error when the query fails.
+ */
+static bool mariadb_db_max_statement_size(SV *h, imp_dbh_t *imp_dbh, unsigned long *size)
+{
+  unsigned long packet_size;
+  MYSQL_RES *res;
+  MYSQL_ROW row;
 
-  /*
-     Clean-up previous result set(s) for sth to prevent
-     'Commands out of sync' error 
-  */
-  if (!mariadb_st_free_result_sets(sth, imp_sth, TRUE))
-    return 0;
+  *size = 0;
 
-  if (imp_sth->use_server_side_prepare)
+  if (!imp_dbh->server_max_allowed_packet)
   {
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                    "\t\tuse_server_side_prepare set\n");
-
-    imp_sth->stmt= mysql_stmt_init(imp_dbh->pmysql);
+    if (imp_dbh->async_query_in_flight || imp_dbh->pmysql->status != MYSQL_STATUS_READY || mysql_more_results(imp_dbh->pmysql))
+      return TRUE;
 
-    if (! imp_sth->stmt)
+    if (mysql_real_query(imp_dbh->pmysql, "SELECT @@max_allowed_packet", sizeof("SELECT @@max_allowed_packet")-1) != 0 ||
+        !(res = mysql_store_result(imp_dbh->pmysql)))
     {
-      mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
-      return 0;
+      mariadb_dr_do_error(h, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
+      return FALSE;
     }
 
-    prepare_retval= mysql_stmt_prepare(imp_sth->stmt,
-                                       statement,
-                                       statement_len);
+    row = mysql_fetch_row(res);
+    if (row && row[0])
+      imp_dbh->server_max_allowed_packet = strtoul(row[0], NULL, 10);
+    mysql_free_result(res);
 
-    if (prepare_retval && mariadb_db_reconnect(sth, imp_sth->stmt))
+    if (!imp_dbh->server_max_allowed_packet)
     {
-        mysql_stmt_close(imp_sth->stmt);
-        imp_sth->stmt = mysql_stmt_init(imp_dbh->pmysql);
-        if (!imp_sth->stmt)
-        {
-          mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
-          return 0;
-        }
-        prepare_retval= mysql_stmt_prepare(imp_sth->stmt,
-                                           statement,
-                                           statement_len);
+      mariadb_dr_do_error(h, CR_UNKNOWN_ERROR, "Cannot determine max_allowed_packet of server", "HY000");
+      return FALSE;
     }
+  }
 
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-        PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                      "\t\tmysql_stmt_prepare returned %d\n",
-                      prepare_retval);
+  packet_size = imp_dbh->server_max_allowed_packet;
 
-    if (prepare_retval)
-    {
-      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-        PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                      "\t\tmysql_stmt_prepare %d %s\n",
-                      mysql_stmt_errno(imp_sth->stmt),
-                      mysql_stmt_error(imp_sth->stmt));
+  /* Client library may have its own lower limit, see mariadb_max_allowed_packet attribute */
+#if (!defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 50709 && MYSQL_VERSION_ID != 60000) || (defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 100206 && MYSQL_VERSION_ID != 100300)
+  #ifdef HAVE_GET_OPTION
+  if (!imp_dbh->is_embedded)
+  {
+    unsigned long client_packet_size = 0;
+    if (mysql_get_option(imp_dbh->pmysql, MYSQL_OPT_MAX_ALLOWED_PACKET, &client_packet_size) == 0 && client_packet_size && client_packet_size < packet_size)
+      packet_size = client_packet_size;
+  }
+  #endif
+#else
+  if (!imp_dbh->is_embedded && max_allowed_packet < packet_size)
+    packet_size = max_allowed_packet;
+#endif
 
-      /* For commands that are not supported by server side prepared statement
-         mechanism lets try to pass them through regular API */
-      if (!imp_sth->disable_fallback_for_server_prepare &&
-          (mysql_stmt_errno(imp_sth->stmt) == ER_UNSUPPORTED_PS ||
-          /* And also fallback when placeholder is used in unsupported
-           * construction with old server versions (e.g. LIMIT ?) */
-          (mysql_stmt_errno(imp_sth->stmt) == ER_PARSE_ERROR &&
-           mysql_get_server_version(imp_dbh->pmysql) < 50007 &&
-           strstr(mysql_stmt_error(imp_sth->stmt), "'?"))))
+  *size = packet_size;
+  return TRUE;
+}
+
+/* Checks if case insensitive keyword is at ptr and is followed by non word character */
+static bool sql_keyword_at(const char *ptr, const char *end, const char *keyword)
+{
+  while (*keyword)
+  {
+    if (ptr >= end || toUPPER(*ptr) != *keyword)
+      return FALSE;
+    ++ptr;
+    ++keyword;
+  }
+  return (ptr < end && !isALNUM(*ptr));
+}
+
+/*
+ * Checks if statement is INSERT or REPLACE with exactly one VALUES group which
+ * contains all placeholders. On success fills offset and length of the group
+ * including parenthesis, so statement can be rewritten to multi-row INSERT.
+ */
+static bool insert_values_group(const char *statement, STRLEN statement_len, bool bind_comment_placeholders, STRLEN *group_offset, STRLEN *group_len)
+{
+  const char *ptr = statement;
+  const char *end = statement + statement_len;
+  const char *group = NULL;
+  const char *group_end = NULL;
+  int depth = 0;
+  char c;
+
+  while (ptr < end && isSPACE(*ptr))
+    ++ptr;
+
+  if (!sql_keyword_at(ptr, end, "INSERT") && !sql_keyword_at(ptr, end, "REPLACE"))
+    return FALSE;
+
+  while (ptr < end)
+  {
+    c = *ptr;
+    switch (c) {
+    case '`':
+    case '"':
+    case '\'':
+      /* Skip string */
+      ++ptr;
+      while (ptr < end && *ptr != c)
       {
-        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-          PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                    "\t\tSETTING imp_sth->use_server_side_prepare to FALSE\n");
-        mysql_stmt_close(imp_sth->stmt);
-        imp_sth->stmt = NULL;
-        imp_sth->use_server_side_prepare = FALSE;
+        if (*ptr == '\\' && ptr+1 < end)
+          ++ptr;
+        ++ptr;
       }
-      else
+      if (ptr >= end)
+        return FALSE;
+      ++ptr;
+      continue;
+
+    case '-':
+      if (!bind_comment_placeholders && ptr+1 < end && ptr[1] == '-')
       {
-        mariadb_dr_do_error(sth, mysql_stmt_errno(imp_sth->stmt),
-                 mysql_stmt_error(imp_sth->stmt),
-                mysql_sqlstate(imp_dbh->pmysql));
-        mysql_stmt_close(imp_sth->stmt);
-        imp_sth->stmt= NULL;
-        return 0;
+        while (ptr < end && *ptr != '\n')
+          ++ptr;
+        continue;
       }
-    }
-    else
-    {
-      num_params = mysql_stmt_param_count(imp_sth->stmt);
-      if (num_params > INT_MAX)
+      break;
+
+    case '/':
+      if (!bind_comment_placeholders && ptr+1 < end && ptr[1] == '*')
       {
-        mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "Prepared statement contains too many placeholders", "HY000");
-        mysql_stmt_close(imp_sth->stmt);
-        imp_sth->stmt = NULL;
-        return 0;
+        for (ptr += 2; ptr+1 < end && !(ptr[0] == '*' && ptr[1] == '/'); ++ptr);
+        if (ptr+1 >= end)
+          return FALSE;
+        ptr += 2;
+        continue;
       }
-      DBIc_NUM_PARAMS(imp_sth) = num_params;
-      if (DBIc_NUM_PARAMS(imp_sth) > 0)
+      break;
+
+    case ';':
+      /* Multiple statements */
+      return FALSE;
+
+    case '?':
+      /* Placeholder outside of VALUES group */
+      if (!group || group_end)
+        return FALSE;
+      break;
+
+    case '(':
+      if (group && !group_end)
+        ++depth;
+      break;
+
+    case ')':
+      if (group && !group_end && --depth == 0)
       {
-        /* Allocate memory for bind variables */
-        imp_sth->bind=            alloc_bind(DBIc_NUM_PARAMS(imp_sth));
-        imp_sth->fbind=           alloc_fbind(DBIc_NUM_PARAMS(imp_sth));
-        imp_sth->has_been_bound = FALSE;
+        group_end = ptr+1;
+        /* Statement already inserts more rows */
+        for (ptr = group_end; ptr < end && isSPACE(*ptr); ++ptr);
+        if (ptr < end && *ptr == ',')
+          return FALSE;
+        continue;
+      }
+      break;
 
-        /* Initialize ph variables with  NULL values */
-        for (i= 0,
-             bind=      imp_sth->bind,
-             fbind=     imp_sth->fbind,
-             bind_end=  bind+DBIc_NUM_PARAMS(imp_sth);
-             bind < bind_end ;
-             bind++, fbind++, i++ )
+    default:
+      if (!group && (c == 'v' || c == 'V') && (ptr == statement || !isALNUM(ptr[-1])))
+      {
+        const char *next = NULL;
+        if (sql_keyword_at(ptr, end, "VALUES"))
+          next = ptr + 6;
+        else if (sql_keyword_at(ptr, end, "VALUE"))
+          next = ptr + 5;
+        if (next)
         {
-          bind->buffer_type=  MYSQL_TYPE_STRING;
-          bind->buffer=       NULL;
-          bind->length=       &(fbind->length);
-          bind->is_null=      &(fbind->is_null);
-          fbind->is_null=     TRUE;
-          fbind->length=      0;
+          for (ptr = next; ptr < end && isSPACE(*ptr); ++ptr);
+          if (ptr < end && *ptr == '(')
+          {
+            group = ptr++;
+            depth = 1;
+          }
+          continue;
         }
       }
+      break;
     }
+    ++ptr;
   }
 
-  /* Count the number of parameters (driver, vs server-side) */
-  if (!imp_sth->use_server_side_prepare)
+  if (!group_end)
+    return FALSE;
+
+  *group_offset = group - statement;
+  *group_len = group_end - group;
+  return TRUE;
+}
+
+/* Tuples collected by mariadb_st_execute_for_fetch() for one batch */
+struct mariadb_batch {
+  SV *sth;
+  imp_sth_t *imp_sth;
+  AV *status_av;
+  IV *rc_total;
+  IV *err_count;
+  unsigned int rows;
+  STRLEN packet_size;
+  STRLEN header_size;
+  /* Bulk execution, values of tuples in row-major arrays */
+  SV *data;
+  SV *offsets;
+  SV *lengths;
+  SV *indicators;
+  unsigned int capacity;
+  /* Multi-row INSERT, statement prefix and VALUES groups of tuples */
+  SV *statement;
+  SV *group;
+  STRLEN prefix_len;
+  const char *suffix;
+  STRLEN suffix_len;
+  imp_sth_ph_t *params;
+};
+
+static void mariadb_batch_status(pTHX_ struct mariadb_batch *batch, unsigned int rows, SV *status)
+{
+  unsigned int i;
+
+  if (batch->status_av)
   {
-    num_params = count_params(imp_dbh, aTHX_ statement, statement_len,
-                                            imp_dbh->bind_comment_placeholders);
-    if (num_params > INT_MAX || num_params == ULONG_MAX)
-    {
-      mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "Prepared statement contains too many placeholders", "HY000");
-      mysql_stmt_close(imp_sth->stmt);
-      imp_sth->stmt = NULL;
-      return 0;
-    }
-    DBIc_NUM_PARAMS(imp_sth) = num_params;
+    for (i = 0; i < rows; ++i)
+      av_push(batch->status_av, i == 0 ? status : newSVsv(status));
   }
+  else
+    SvREFCNT_dec(status);
+}
 
-  /* Allocate memory for parameters */
-  if (DBIc_NUM_PARAMS(imp_sth) > 0)
-    imp_sth->params = alloc_param(DBIc_NUM_PARAMS(imp_sth));
-  DBIc_IMPSET_on(imp_sth);
+static SV *mariadb_batch_error_status(pTHX_ imp_sth_t *imp_sth)
+{
+  AV *av = newAV();
+  av_push(av, newSVsv(DBIc_ERR(imp_sth)));
+  av_push(av, newSVsv(DBIc_ERRSTR(imp_sth)));
+  av_push(av, newSVsv(DBIc_STATE(imp_sth)));
+  return newRV_noinc((SV *)av);
+}
+
+static void mariadb_batch_done(pTHX_ struct mariadb_batch *batch, my_ulonglong affected_rows)
+{
+  if (affected_rows == (my_ulonglong)-1)
+  {
+    mariadb_batch_status(aTHX_ batch, batch->rows, mariadb_batch_error_status(aTHX_ batch->imp_sth));
+    *batch->err_count += batch->rows;
+  }
+  else
+  {
+    /* Number of affected rows is known only for the whole batch */
+    mariadb_batch_status(aTHX_ batch, batch->rows, newSViv(-1));
+    if (*batch->rc_total >= 0)
+      *batch->rc_total = (affected_rows <= (my_ulonglong)(IV_MAX - *batch->rc_total)) ? *batch->rc_total + (IV)affected_rows : -1;
+  }
+  batch->rows = 0;
+  batch->packet_size = batch->header_size;
+}
+
+/*
+ * Execute batch as one multi-row INSERT statement built from client side
+ * rendered VALUES groups of tuples.
+ */
+static void mariadb_batch_execute_statement(pTHX_ struct mariadb_batch *batch)
+{
+  SV *sth = batch->sth;
+  imp_sth_t *imp_sth = batch->imp_sth;
+  D_imp_xxh(sth);
+  D_imp_dbh_from_sth;
+  my_ulonglong rows;
 
   if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_prepare_sv\n");
-  return 1;
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tmariadb_batch_execute_statement with %u rows\n", batch->rows);
+
+  sv_catpvn(batch->statement, batch->suffix, batch->suffix_len);
+  rows = mariadb_st_internal_execute(sth, SvPVX(batch->statement), SvCUR(batch->statement), 0, NULL, &imp_sth->result, &imp_dbh->pmysql, FALSE);
+  SvCUR_set(batch->statement, batch->prefix_len);
+
+  if (rows != (my_ulonglong)-1)
+  {
+    if (imp_sth->result)
+    {
+      mysql_free_result(imp_sth->result);
+      imp_sth->result = NULL;
+      imp_sth->current_row = NULL;
+    }
+    imp_dbh->insertid = imp_sth->insertid = mysql_insert_id(imp_dbh->pmysql);
+  }
+
+  mariadb_batch_done(aTHX_ batch, rows);
 }
 
-/***************************************************************************
- * Name: mariadb_st_free_result_sets
- *
- * Purpose: Clean-up single or multiple result sets (if any)
- *
- * Inputs: sth - Statement handle
- *         imp_sth - driver's private statement handle
- *         free_last - free also the last result set
- *
- * Returns: TRUE ok
- *          FALSE error; mariadb_dr_do_error will be called
- *************************************************************************/
-static bool mariadb_st_free_result_sets(SV *sth, imp_sth_t *imp_sth, bool free_last)
+/*
+ * Render VALUES group for tuple and append it to the statement, pending
+ * tuples are executed first when statement would not fit into the packet.
+ */
+static void mariadb_batch_add_statement(pTHX_ struct mariadb_batch *batch, AV *av, unsigned long max_packet_size)
 {
-  dTHX;
+  imp_sth_t *imp_sth = batch->imp_sth;
   D_imp_dbh_from_sth;
-  D_imp_xxh(sth);
-  int next_result_rc= -1;
-  unsigned int error;
+  unsigned int i, num_params = DBIc_NUM_PARAMS(imp_sth);
+  imp_sth_ph_t *ph;
+  STRLEN len = SvCUR(batch->group);
+  char *values;
+  SV **svp;
 
-  /* No connection, nothing to clean, no error */
-  if (!imp_dbh->pmysql)
-    return TRUE;
+  /* Values are escaped according to the connection */
+  if (!imp_dbh->pmysql && !mariadb_db_reconnect(batch->sth, NULL))
+  {
+    mariadb_dr_do_error(batch->sth, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+    mariadb_batch_status(aTHX_ batch, 1, mariadb_batch_error_status(aTHX_ imp_sth));
+    ++*batch->err_count;
+    return;
+  }
+
+  for (i = 0, ph = batch->params; i < num_params; ++i, ++ph)
+  {
+    svp = av_fetch(av, i, FALSE);
+    ph->type = imp_sth->params[i].type;
+    if (!svp || !SvOK(*svp))
+    {
+      ph->value = NULL;
+      ph->len = 0;
+    }
+    else if (sql_type_is_binary(ph->type))
+      ph->value = SvPVbyte(*svp, ph->len); /* Ensure that value is always byte orientated */
+    else
+      ph->value = SvPVutf8(*svp, ph->len); /* Ensure that value is always UTF-8 encoded */
+  }
+
+  values = parse_params((imp_xxh_t *)imp_sth, aTHX_ imp_dbh->pmysql, SvPVX(batch->group), &len, batch->params, num_params, imp_dbh->bind_type_guessing, imp_dbh->bind_comment_placeholders);
+
+  if (batch->rows > 0 && batch->packet_size + len + 1 > max_packet_size)
+    mariadb_batch_execute_statement(aTHX_ batch);
+
+  if (batch->rows > 0)
+    sv_catpvs(batch->statement, ",");
+  sv_catpvn(batch->statement, values, len);
+  Safefree(values);
+
+  batch->packet_size += len + 1;
+  ++batch->rows;
+}
+
+#ifdef HAVE_BULK_EXECUTE
+
+/*
+ * Execute batch with one COM_STMT_BULK_EXECUTE command via column-wise array
+ * binding. All values are sent as strings.
+ */
+static void mariadb_batch_execute_bulk(pTHX_ struct mariadb_batch *batch)
+{
+  SV *sth = batch->sth;
+  imp_sth_t *imp_sth = batch->imp_sth;
+  D_imp_xxh(sth);
+  D_imp_dbh_from_sth;
+  MYSQL_STMT *stmt = imp_sth->stmt;
+  unsigned int num_params = DBIc_NUM_PARAMS(imp_sth);
+  unsigned int rows = batch->rows;
+  unsigned int array_size = rows;
+  unsigned int i, row;
+  my_ulonglong affected_rows = (my_ulonglong)-1;
+  char *data = SvPVX(batch->data);
+  STRLEN *offsets = (STRLEN *)SvPVX(batch->offsets);
+  unsigned long *lengths = (unsigned long *)SvPVX(batch->lengths);
+  char *indicators = SvPVX(batch->indicators);
+  MYSQL_BIND *bind;
+  char **col_values;
+  unsigned long *col_lengths;
+  char *col_indicators;
 
   if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t>- mariadb_st_free_result_sets\n");
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tmariadb_batch_execute_bulk with %u rows\n", rows);
 
-  /* Iterate over all remaining rows, required when mysql_use_result() was called */
-  if (imp_sth->result)
-    while (mysql_fetch_row(imp_sth->result));
+  Newxz(bind, num_params, MYSQL_BIND);
+  Newx(col_values, (size_t)num_params * rows, char *);
+  Newx(col_lengths, (size_t)num_params * rows, unsigned long);
+  Newx(col_indicators, (size_t)num_params * rows, char);
 
-  do
+  for (i = 0; i < num_params; ++i)
   {
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_free_result_sets RC %d\n", next_result_rc);
-
-    if (next_result_rc == 0)
+    for (row = 0; row < rows; ++row)
     {
-      if (!(imp_sth->result = mysql_store_result(imp_dbh->pmysql)))
-      {
-        /* Check for possible error */
-        if (mysql_errno(imp_dbh->pmysql))
-        {
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-          PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_free_result_sets ERROR: %s\n",
-                                  mysql_error(imp_dbh->pmysql));
+      size_t src = (size_t)row * num_params + i;
+      size_t dst = (size_t)i * rows + row;
+      col_values[dst] = data + offsets[src];
+      col_lengths[dst] = lengths[src];
+      col_indicators[dst] = indicators[src];
+    }
+    bind[i].buffer_type = sql_type_is_binary(imp_sth->params[i].type) ? MYSQL_TYPE_BLOB : MYSQL_TYPE_STRING;
+    bind[i].buffer = col_values + (size_t)i * rows;
+    bind[i].length = col_lengths + (size_t)i * rows;
+    bind[i].u.indicator = col_indicators + (size_t)i * rows;
+  }
 
-          mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql),
-                   mysql_sqlstate(imp_dbh->pmysql));
-          return FALSE;
-        }
-        imp_dbh->insertid = imp_sth->insertid = mysql_insert_id(imp_dbh->pmysql);
-      }
+  /* Parameters of statement handle have to be bound again for next execute */
+  imp_sth->has_been_bound = FALSE;
+
+  if (mysql_stmt_attr_set(stmt, STMT_ATTR_ARRAY_SIZE, &array_size) ||
+      mysql_stmt_bind_param(stmt, bind) ||
+      mysql_stmt_execute(stmt) ||
+      (affected_rows = mysql_stmt_affected_rows(stmt)) == (my_ulonglong)-1)
+  {
+    affected_rows = (my_ulonglong)-1;
+    mariadb_dr_do_error(sth, mysql_stmt_errno(stmt), mysql_stmt_error(stmt), mysql_stmt_sqlstate(stmt));
+    mysql_stmt_reset(stmt);
+  }
+  else
+    imp_dbh->insertid = imp_sth->insertid = mysql_stmt_insert_id(stmt);
+
+  array_size = 0;
+  mysql_stmt_attr_set(stmt, STMT_ATTR_ARRAY_SIZE, &array_size);
+
+  Safefree(col_indicators);
+  Safefree(col_lengths);
+  Safefree(col_values);
+  Safefree(bind);
+
+  SvCUR_set(batch->data, 0);
+  mariadb_batch_done(aTHX_ batch, affected_rows);
+}
+
+/*
+ * Append values of tuple to row-major arrays, pending tuples are executed
+ * first when tuple would not fit into the packet.
+ */
+static void mariadb_batch_add_bulk(pTHX_ struct mariadb_batch *batch, AV *av, unsigned long max_packet_size)
+{
+  imp_sth_t *imp_sth = batch->imp_sth;
+  unsigned int i, num_params = DBIc_NUM_PARAMS(imp_sth);
+  STRLEN row_data_start = SvCUR(batch->data);
+  STRLEN tuple_size = 0;
+  STRLEN *offsets;
+  unsigned long *lengths;
+  char *indicators;
+  SV **svp;
+
+  if (batch->rows == batch->capacity)
+  {
+    batch->capacity *= 2;
+    SvGROW(batch->offsets, batch->capacity * num_params * sizeof(STRLEN));
+    SvGROW(batch->lengths, batch->capacity * num_params * sizeof(unsigned long));
+    SvGROW(batch->indicators, batch->capacity * num_params);
+  }
+  offsets = (STRLEN *)SvPVX(batch->offsets) + (size_t)batch->rows * num_params;
+  lengths = (unsigned long *)SvPVX(batch->lengths) + (size_t)batch->rows * num_params;
+  indicators = SvPVX(batch->indicators) + (size_t)batch->rows * num_params;
+
+  for (i = 0; i < num_params; ++i)
+  {
+    svp = av_fetch(av, i, FALSE);
+    offsets[i] = SvCUR(batch->data);
+    if (!svp || !SvOK(*svp))
+    {
+      lengths[i] = 0;
+      indicators[i] = STMT_INDICATOR_NULL;
+      tuple_size += 1;
     }
-    if (imp_sth->result && (mysql_more_results(imp_dbh->pmysql) || free_last))
+    else
     {
-      mysql_free_result(imp_sth->result);
-      imp_sth->result=NULL;
+      STRLEN len;
+      const char *buf;
+      if (sql_type_is_binary(imp_sth->params[i].type))
+        buf = SvPVbyte(*svp, len); /* Ensure that buf is always byte orientated */
+      else
+        buf = SvPVutf8(*svp, len); /* Ensure that buf is always UTF-8 encoded */
+      sv_catpvn(batch->data, buf, len);
+      lengths[i] = len;
+      indicators[i] = STMT_INDICATOR_NONE;
+      /* indicator and length encoded length */
+      tuple_size += len + 10;
     }
-  } while ((next_result_rc=mysql_next_result(imp_dbh->pmysql))==0);
+  }
 
-  if (next_result_rc > 0)
+  /* Execute pending tuples and move this one to start of batch */
+  if (batch->rows > 0 && batch->packet_size + tuple_size > max_packet_size)
   {
-#if MYSQL_VERSION_ID < 50025
-    /* Cover a protocol design error: error packet does not contain the server status.
-     * Luckily, an error always aborts execution of a statement, so it is safe to turn off the flag. */
-    imp_dbh->pmysql->server_status &= ~SERVER_MORE_RESULTS_EXISTS;
-#endif
+    STRLEN *first_offsets;
+    unsigned long *first_lengths;
+    char *first_indicators;
+    STRLEN data_len = SvCUR(batch->data);
 
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_free_result_sets: Error while processing multi-result set: %s\n",
-                    mysql_error(imp_dbh->pmysql));
+    SvCUR_set(batch->data, row_data_start);
+    mariadb_batch_execute_bulk(aTHX_ batch);
 
-    /* This is error for previous unfetched result ret. So do not report server errors to caller which is expecting new result set. */
-    error = mysql_errno(imp_dbh->pmysql);
-    if (error == CR_COMMANDS_OUT_OF_SYNC || error == CR_OUT_OF_MEMORY || error == CR_SERVER_GONE_ERROR || error == CR_SERVER_LOST || error == ER_CLIENT_INTERACTION_TIMEOUT || error == CR_UNKNOWN_ERROR)
+    first_offsets = (STRLEN *)SvPVX(batch->offsets);
+    first_lengths = (unsigned long *)SvPVX(batch->lengths);
+    first_indicators = SvPVX(batch->indicators);
+    Move(SvPVX(batch->data) + row_data_start, SvPVX(batch->data), data_len - row_data_start, char);
+    SvCUR_set(batch->data, data_len - row_data_start);
+    for (i = 0; i < num_params; ++i)
     {
-      mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), mysql_sqlstate(imp_dbh->pmysql));
-      return FALSE;
+      first_offsets[i] = offsets[i] - row_data_start;
+      first_lengths[i] = lengths[i];
+      first_indicators[i] = indicators[i];
     }
   }
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_free_result_sets\n");
-
-  return TRUE;
+  batch->packet_size += tuple_size;
+  ++batch->rows;
 }
 
+#endif
+
+static void mariadb_batch_execute(pTHX_ struct mariadb_batch *batch)
+{
+  if (batch->rows == 0)
+    return;
+#ifdef HAVE_BULK_EXECUTE
+  if (!batch->statement)
+  {
+    mariadb_batch_execute_bulk(aTHX_ batch);
+    return;
+  }
+#endif
+  mariadb_batch_execute_statement(aTHX_ batch);
+}
 
 /***************************************************************************
- * Name: mariadb_st_more_results
  *
- * Purpose: Move onto the next result set (if any)
+ *  Name:    mariadb_st_execute_for_fetch
  *
- * Inputs: sth - Statement handle
- *         imp_sth - driver's private statement handle
+ *  Purpose: Execute statement for all tuples returned by fetch_tuple_sub
+ *           in batches limited by max_allowed_packet, each batch in one
+ *           round trip. Server side prepared statements use MariaDB bulk
+ *           execution with array binding, INSERT statements with client
+ *           side placeholders are rewritten to multi-row INSERT.
  *
- * Returns: TRUE if there are more results sets
- *          FALSE if there are not
- *************************************************************************/
-bool mariadb_st_more_results(SV* sth, imp_sth_t* imp_sth)
+ *  Input:   sth - statement handle
+ *           imp_sth - drivers private statement handle data
+ *           fetch_tuple_sub - code reference returning tuples
+ *           tuple_status - array reference for tuple status or undef
+ *           tuples - where to store number of tuples
+ *           rc_total - where to store total number of affected rows
+ *           err_count - where to store number of failed tuples
+ *
+ *  Returns: 0 when batches are not supported for statement,
+ *           fetch_tuple_sub was not called and caller should execute
+ *           tuples one by one; -1 on error before any tuple was fetched,
+ *           mariadb_dr_do_error will be called; 1 otherwise
+ *
+ **************************************************************************/
+
+int mariadb_st_execute_for_fetch(SV *sth, imp_sth_t *imp_sth, SV *fetch_tuple_sub, SV *tuple_status, IV *tuples, IV *rc_total, IV *err_count)
 {
   dTHX;
-  D_imp_dbh_from_sth;
   D_imp_xxh(sth);
+  D_imp_dbh_from_sth;
+  unsigned int i, num_params = DBIc_NUM_PARAMS(imp_sth);
+  struct mariadb_batch batch;
+  unsigned long max_packet_size;
+  STRLEN group_offset, group_len;
+  bool done = FALSE;
 
-  bool use_mysql_use_result = imp_sth->use_mysql_use_result;
-  int next_result_return_code, i;
+  if (imp_sth->use_mysql_use_result || imp_sth->is_async || !imp_dbh->pmysql || num_params == 0)
+    return 0;
 
-  if (!SvROK(sth) || SvTYPE(SvRV(sth)) != SVt_PVHV)
-    croak("Expected hash array");
+  Zero(&batch, 1, struct mariadb_batch);
 
   if (imp_sth->use_server_side_prepare)
   {
-    mariadb_dr_do_error(sth, CR_NOT_IMPLEMENTED, "Processing of multiple result set is not possible with server side prepare", "HY000");
-    return FALSE;
-  }
-
-  if (imp_dbh->async_query_in_flight && !imp_sth->async_result)
-  {
-    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "more_results() without mariadb_async_result()", "HY000");
-    return FALSE;
-  }
-
-  if (imp_dbh->async_query_in_flight && imp_dbh->async_query_in_flight != imp_sth)
-  {
-    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "Gathering async_query_in_flight results for the wrong handle", "HY000");
-    return FALSE;
-  }
-  imp_dbh->async_query_in_flight = NULL;
-
-  DBIc_ACTIVE_off(imp_sth);
+#ifdef HAVE_BULK_EXECUTE
+    size_t extended_capabilities = 0;
 
-  if (!imp_dbh->pmysql && !mariadb_db_reconnect(sth, NULL))
-  {
-    mariadb_dr_do_error(sth, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
-    return FALSE;
-  }
+    if (!imp_sth->stmt || imp_sth->stmt->mysql != imp_dbh->pmysql || mysql_stmt_field_count(imp_sth->stmt) != 0)
+      return 0;
 
-  if (!mysql_more_results(imp_dbh->pmysql))
-  {
-    /* No more pending result set(s)*/
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-		    "\n      <- mariadb_st_more_results no more results\n");
-    return FALSE;
+    if (mariadb_get_infov(imp_dbh->pmysql, MARIADB_CONNECTION_EXTENDED_SERVER_CAPABILITIES, &extended_capabilities) != 0 ||
+        !(extended_capabilities & (MARIADB_CLIENT_STMT_BULK_OPERATIONS >> 32)))
+      return 0;
+#else
+    return 0;
+#endif
   }
-
-  /*
-   *  Free cached array attributes
-   */
-  for (i= 0; i < AV_ATTRIB_LAST;  i++)
+  else
   {
-    if (imp_sth->av_attr[i])
-      SvREFCNT_dec(imp_sth->av_attr[i]);
-
-    imp_sth->av_attr[i]= Nullav;
+    /*
+      When multi-row INSERT fails, rows before the failed one may be already
+      stored (e.g. non-transactional table) and status of tuples would not be
+      known. Inside transaction application can roll back, so use it only there.
+    */
+    if (DBIc_has(imp_dbh, DBIcf_AutoCommit))
+      return 0;
+    if (!insert_values_group(imp_sth->statement, imp_sth->statement_len, imp_dbh->bind_comment_placeholders, &group_offset, &group_len))
+      return 0;
   }
 
-  /* Release previous MySQL result*/
-  if (imp_sth->result)
+  if (SvOK(tuple_status))
   {
-    mysql_free_result(imp_sth->result);
-    imp_sth->result= NULL;
+    if (!SvROK(tuple_status) || SvTYPE(SvRV(tuple_status)) != SVt_PVAV)
+      return 0;
+    batch.status_av = (AV *)SvRV(tuple_status);
+    av_clear(batch.status_av);
   }
 
-  imp_sth->done_desc = FALSE;
-  imp_sth->currow = 0;
-  imp_sth->row_num = (my_ulonglong)-1;
+  if (!mariadb_st_free_result_sets(sth, imp_sth, TRUE))
+    return -1;
 
-  /* clear NUM_OF_FIELDS attribute */
-  DBIc_DBISTATE(imp_sth)->set_attr_k(sth, sv_2mortal(newSVpvs("NUM_OF_FIELDS")), 0, sv_2mortal(newSViv(0)));
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), " -> mariadb_st_execute_for_fetch for %p\n", sth);
 
-  /* delete cached handle attributes */
-  /* XXX should be driven by a list to ease maintenance */
-  (void)hv_deletes((HV*)SvRV(sth), "NAME", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "NULLABLE", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "NUM_OF_FIELDS", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "PRECISION", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "SCALE", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "TYPE", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "mariadb_insertid", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "mariadb_is_auto_increment", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "mariadb_is_blob", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "mariadb_is_key", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "mariadb_is_num", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "mariadb_is_pri_key", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "mariadb_length", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "mariadb_max_length", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "mariadb_table", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "mariadb_type", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "mariadb_type_name", G_DISCARD);
-  (void)hv_deletes((HV*)SvRV(sth), "mariadb_warning_count", G_DISCARD);
+  if (!mariadb_db_max_statement_size(sth, imp_dbh, &max_packet_size))
+    return -1;
 
-  next_result_return_code= mysql_next_result(imp_dbh->pmysql);
+  /* Connection is busy with another statement, execute tuples one by one */
+  if (!max_packet_size)
+    return 0;
 
-  imp_sth->warning_count = mysql_warning_count(imp_dbh->pmysql);
+  batch.sth = sth;
+  batch.imp_sth = imp_sth;
+  batch.rc_total = rc_total;
+  batch.err_count = err_count;
 
-  /*
-    mysql_next_result returns
-      0 if there are more results
-     -1 if there are no more results
-     >0 if there was an error
-   */
-  if (next_result_return_code > 0)
+  if (imp_sth->use_server_side_prepare)
   {
-#if MYSQL_VERSION_ID < 50025
-    /* Cover a protocol design error: error packet does not contain the server status.
-     * Luckily, an error always aborts execution of a statement, so it is safe to turn off the flag. */
-    imp_dbh->pmysql->server_status &= ~SERVER_MORE_RESULTS_EXISTS;
-#endif
-    mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql),
-             mysql_sqlstate(imp_dbh->pmysql));
-
-    return FALSE;
+    /* packet header, command, statement id, flags and parameter types */
+    batch.header_size = 4 + 1 + 4 + 2 + 2 * (STRLEN)num_params;
+    batch.capacity = 64;
+    batch.data = sv_2mortal(newSVpvs(""));
+    batch.offsets = sv_2mortal(newSV(batch.capacity * num_params * sizeof(STRLEN)));
+    batch.lengths = sv_2mortal(newSV(batch.capacity * num_params * sizeof(unsigned long)));
+    batch.indicators = sv_2mortal(newSV(batch.capacity * num_params));
   }
-  else if(next_result_return_code == -1)                                                                                                                  
-  {                                                                                                                                                       
-    return FALSE;
-  }  
   else
   {
-    /* Store the result from the Query */
-    imp_sth->result = use_mysql_use_result ?
-     mysql_use_result(imp_dbh->pmysql) : mysql_store_result(imp_dbh->pmysql);
-
-    if (mysql_errno(imp_dbh->pmysql))
-    {
-      mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql), mysql_error(imp_dbh->pmysql), 
-               mysql_sqlstate(imp_dbh->pmysql));
-      return FALSE;
-    }
-
-    if (imp_sth->result == NULL)
-    {
-      imp_sth->row_num = mysql_affected_rows(imp_dbh->pmysql);
+    batch.prefix_len = group_offset;
+    batch.suffix = imp_sth->statement + group_offset + group_len;
+    batch.suffix_len = imp_sth->statement_len - group_offset - group_len;
+    batch.statement = sv_2mortal(newSVpvn(imp_sth->statement, group_offset));
+    batch.group = sv_2mortal(newSVpvn(imp_sth->statement + group_offset, group_len));
+    batch.params = (imp_sth_ph_t *)SvPVX(sv_2mortal(newSV(num_params * sizeof(imp_sth_ph_t))));
+    Zero(batch.params, num_params, imp_sth_ph_t);
+    /* command and statement without VALUES group */
+    batch.header_size = 1 + imp_sth->statement_len - group_len;
+  }
+  batch.packet_size = batch.header_size;
 
-      imp_dbh->insertid = imp_sth->insertid = mysql_insert_id(imp_dbh->pmysql);
+  *tuples = 0;
+  *rc_total = 0;
+  *err_count = 0;
 
-      if (mysql_more_results(imp_dbh->pmysql))
-        DBIc_ACTIVE_on(imp_sth);
-    }
+  while (!done)
+  {
+    SV *tuple;
+    AV *av = NULL;
+    SV **svp;
+    SV *errmsg = NULL;
+    unsigned int errcode = 0;
+    int count;
+    dSP;
+
+    ENTER;
+    SAVETMPS;
+    PUSHMARK(SP);
+    PUTBACK;
+    count = call_sv(fetch_tuple_sub, G_SCALAR);
+    SPAGAIN;
+    tuple = (count > 0) ? POPs : &PL_sv_undef;
+    PUTBACK;
+
+    if (!SvTRUE(tuple))
+      done = TRUE;
+    else if (!SvROK(tuple) || SvTYPE(SvRV(tuple)) != SVt_PVAV)
+      croak("fetch_tuple_sub did not return an array reference");
     else
+      av = (AV *)SvRV(tuple);
+
+    if (av)
     {
-      /* We have a new rowset */
-      imp_sth->row_num = use_mysql_use_result ? (my_ulonglong)-2 : mysql_num_rows(imp_sth->result);
+      ++*tuples;
 
-      /* Adjust NUM_OF_FIELDS - which also adjusts the row buffer size */
-      DBIc_DBISTATE(imp_sth)->set_attr_k(sth, sv_2mortal(newSVpvs("NUM_OF_FIELDS")), 0,
-          sv_2mortal(newSVuv(mysql_num_fields(imp_sth->result)))
-      );
+      /* Check tuple before it is added to batch, like execute() does for bind values */
+      if (av_len(av)+1 != num_params)
+      {
+        errcode = ER_WRONG_ARGUMENTS;
+        errmsg = sv_2mortal(newSVpvf("called with %d bind variables when %u are needed", (int)(av_len(av)+1), num_params));
+      }
+      else
+      {
+        for (i = 0; i < num_params; ++i)
+        {
+          svp = av_fetch(av, i, FALSE);
+          if (svp && SvOK(*svp) && sql_type_is_numeric(imp_sth->params[i].type) && !looks_like_number(*svp))
+          {
+            errcode = CR_INVALID_PARAMETER_NO;
+            errmsg = sv_2mortal(newSVpvf("Binding non-numeric field %u, value %s as a numeric!", i+1, neatsvpv(*svp, 0)));
+            break;
+          }
+        }
+      }
 
-      if (imp_sth->row_num)
-        DBIc_ACTIVE_on(imp_sth);
+      if (errmsg)
+      {
+        /* Keep order of tuple status, first execute pending tuples */
+        mariadb_batch_execute(aTHX_ &batch);
+        mariadb_dr_do_error(sth, errcode, SvPVX(errmsg), "HY000");
+        mariadb_batch_status(aTHX_ &batch, 1, mariadb_batch_error_status(aTHX_ imp_sth));
+        ++*err_count;
+      }
+#ifdef HAVE_BULK_EXECUTE
+      else if (!batch.statement)
+        mariadb_batch_add_bulk(aTHX_ &batch, av, max_packet_size);
+#endif
+      else
+        mariadb_batch_add_statement(aTHX_ &batch, av, max_packet_size);
     }
 
-    if (imp_sth->is_async && mysql_more_results(imp_dbh->pmysql))
-      imp_dbh->async_query_in_flight = imp_sth;
-
-    imp_dbh->pmysql->net.last_errno= 0;
-    return TRUE;
+    FREETMPS;
+    LEAVE;
   }
+
+  mariadb_batch_execute(aTHX_ &batch);
+
+  imp_sth->row_num = (*rc_total >= 0) ? (my_ulonglong)*rc_total : (my_ulonglong)-1;
+  if (imp_dbh->pmysql)
+    imp_sth->warning_count = mysql_warning_count(imp_dbh->pmysql);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                  " <- mariadb_st_execute_for_fetch executed %" IVdf " tuples with %" IVdf " errors\n",
+                  *tuples, *err_count);
+
+  return 1;
 }
 
-/**************************************************************************
+ /**************************************************************************
  *
- *  Name:    mariadb_st_internal_execute
+ *  Name:    mariadb_st_describe
  *
- *  Purpose: Internal version for executing a statement, called both from
- *           within the "do" and the "execute" method.
+ *  Purpose: Called from within the fetch method to describe the result
  *
- *  Inputs:  h - object handle, for storing error messages
- *           statement - query being executed
- *           attribs - statement attributes, currently ignored
- *           num_params - number of parameters being bound
- *           params - parameter array
- *           result - where to store results, if any
- *           svsock - socket connected to the database
+ *  Input:   sth - statement handle being initialized
+ *           imp_sth - our part of the statement handle, there's no
+ *               need for supplying both; Tim just doesn't remove it
+ *
+ *  Returns: 1 for success, 0 otherwise; mariadb_dr_do_error will
+ *           be called in the latter case
  *
  **************************************************************************/
 
-
-static my_ulonglong mariadb_st_internal_execute(
-                                       SV *h, /* could be sth or dbh */
-                                       char *sbuf,
-                                       STRLEN slen,
-                                       int num_params,
-                                       imp_sth_ph_t *params,
-                                       MYSQL_RES **result,
-                                       MYSQL **svsock,
-                                       bool use_mysql_use_result
-                                      )
+static int mariadb_st_describe(SV* sth, imp_sth_t* imp_sth)
 {
   dTHX;
-  bool bind_type_guessing= FALSE;
-  bool bind_comment_placeholders= TRUE;
-  char *salloc;
-  int htype;
-  bool async = FALSE;
-  my_ulonglong rows= 0;
-  /* thank you DBI.c for this info! */
-  D_imp_xxh(h);
+  D_imp_xxh(sth);
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t--> mariadb_st_describe\n");
 
-  htype= DBIc_TYPE(imp_xxh);
-  /*
-    It is important to import imp_dbh properly according to the htype
-    that it is! Also, one might ask why bind_type_guessing is assigned
-    in each block. Well, it's because D_imp_ macros called in these
-    blocks make it so imp_dbh is not "visible" or defined outside of the
-    if/else (when compiled, it fails for imp_dbh not being defined).
-  */
-  /* h is a dbh */
-  if (htype == DBIt_DB)
+  if (imp_sth->done_desc)
+    return 1;
+
+  if (imp_sth->use_server_side_prepare)
   {
-    D_imp_dbh(h);
-    /* if imp_dbh is not available, it causes segfault (proper) on OpenBSD */
-    if (imp_dbh)
+    int i;
+    int num_fields= DBIc_NUM_FIELDS(imp_sth);
+    imp_sth_fbh_t *fbh;
+    MYSQL_BIND *buffer;
+    MYSQL_FIELD *fields;
+    STRLEN data_size= 0;
+    char *data;
+
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tmariadb_st_describe() num_fields %d\n",
+                    num_fields);
+
+    if (num_fields <= 0 || !imp_sth->result)
     {
-      bind_type_guessing= imp_dbh->bind_type_guessing;
-      bind_comment_placeholders= imp_dbh->bind_comment_placeholders;
+      /* no metadata */
+      mariadb_dr_do_error(sth, CR_NO_STMT_METADATA, "Prepared statement contains no metadata", "HY000");
+      return 0;
     }
-    async = imp_dbh->async_query_in_flight ? TRUE : FALSE;
-  }
-  /* h is a sth */
-  else
-  {
-    D_imp_sth(h);
-    D_imp_dbh_from_sth;
-    /* if imp_dbh is not available, it causes segfault (proper) on OpenBSD */
-    if (imp_dbh)
+
+    fields= mysql_fetch_fields(imp_sth->result);
+
+    /* allocate fields buffers together with initial buffers of all columns */
+    for (i= 0; i < num_fields; i++)
     {
-      bind_type_guessing= imp_dbh->bind_type_guessing;
-      bind_comment_placeholders= imp_dbh->bind_comment_placeholders;
+      if (mysql_field_needs_allocated_buffer(&fields[i]))
+        data_size+= mysql_field_buffer_length(&fields[i]);
     }
-    async = imp_sth->is_async;
-    imp_dbh->async_query_in_flight = async ? imp_sth : NULL;
-  }
+    free_fbuffer(imp_sth);
+    data= alloc_fbuffer(imp_sth, num_fields, data_size);
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "mariadb_st_internal_execute MYSQL_VERSION_ID %d\n",
-                  MYSQL_VERSION_ID );
+    for (
+         fbh= imp_sth->fbh, buffer= (MYSQL_BIND*)imp_sth->buffer, i= 0;
+         i < num_fields;
+         i++, fbh++, buffer++
+        )
+    {
+      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      {
+        PerlIO_printf(DBIc_LOGPIO(imp_xxh),"\t\ti %d fbh->length %lu\n",
+                      i, fbh->length);
+        PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                      "\t\tfields[i].length %lu fields[i].max_length %lu fields[i].type %d fields[i].flags %d fields[i].charsetnr %d\n",
+                      fields[i].length, fields[i].max_length, fields[i].type, fields[i].flags, fields[i].charsetnr);
+      }
 
-  if (!*svsock && !mariadb_db_reconnect(h, NULL))
-  {
-    mariadb_dr_do_error(h, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
-    return -1;
-  }
+      fbh->is_utf8 = mysql_charsetnr_is_utf8(fields[i].charsetnr);
+      fbh->decimals = fields[i].decimals;
+      fbh->is_decimal = mysql_type_is_decimal(fields[i].type);
 
-  salloc= parse_params(imp_xxh,
-                              aTHX_ *svsock,
-                              sbuf,
-                              &slen,
-                              params,
-                              num_params,
-                              bind_type_guessing,
-                              bind_comment_placeholders);
+      buffer->buffer_type= mysql_field_buffer_type(&fields[i]);
+      buffer->is_unsigned= (fields[i].flags & UNSIGNED_FLAG) ? TRUE : FALSE;
+      buffer->length= &(fbh->length);
+      buffer->is_null= &(fbh->is_null);
+#if MYSQL_VERSION_ID >= NEW_DATATYPE_VERSION
+      buffer->error= &(fbh->error);
+#endif
 
-  if (salloc)
-  {
-    sbuf= salloc;
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "Binding parameters: %.1000s%s\n", sbuf, slen > 1000 ? "..." : "");
-  }
+      switch (buffer->buffer_type) {
+      case MYSQL_TYPE_NULL:
+        buffer->buffer_length= 0;
+        buffer->buffer= NULL;
+        break;
 
-  if(async) {
-    if((mysql_send_query(*svsock, sbuf, slen)) &&
-       (!mariadb_db_reconnect(h, NULL) ||
-        (mysql_send_query(*svsock, sbuf, slen))))
+      case MYSQL_TYPE_TINY:
+        buffer->buffer_length= sizeof(fbh->numeric_val.tval);
+        buffer->buffer= (char*) &fbh->numeric_val.tval;
+        break;
+
+      case MYSQL_TYPE_SHORT:
+        buffer->buffer_length= sizeof(fbh->numeric_val.sval);
+        buffer->buffer= (char*) &fbh->numeric_val.sval;
+        break;
+
+      case MYSQL_TYPE_LONG:
+        buffer->buffer_length= sizeof(fbh->numeric_val.lval);
+        buffer->buffer= (char*) &fbh->numeric_val.lval;
+        break;
+
+      case MYSQL_TYPE_LONGLONG:
+        buffer->buffer_length= sizeof(fbh->numeric_val.llval);
+        buffer->buffer= (char*) &fbh->numeric_val.llval;
+        break;
+
+      case MYSQL_TYPE_FLOAT:
+        buffer->buffer_length= sizeof(fbh->numeric_val.fval);
+        buffer->buffer= (char*) &fbh->numeric_val.fval;
+        break;
+
+      case MYSQL_TYPE_DOUBLE:
+        buffer->buffer_length= sizeof(fbh->numeric_val.dval);
+        buffer->buffer= (char*) &fbh->numeric_val.dval;
+        break;
+
+      case MYSQL_TYPE_TIME:
+      case MYSQL_TYPE_DATE:
+      case MYSQL_TYPE_DATETIME:
+      case MYSQL_TYPE_TIMESTAMP:
+        buffer->buffer_length= sizeof(fbh->numeric_val.time);
+        buffer->buffer= (char*) &fbh->numeric_val.time;
+        break;
+
+      default:
+        buffer->buffer_length= mysql_field_buffer_length(&fields[i]);
+        fbh->data= data;
+        buffer->buffer= data;
+        data+= buffer->buffer_length;
+        break;
+      }
+    }
+
+    if (mysql_stmt_bind_result(imp_sth->stmt, imp_sth->buffer))
     {
-        rows = -1;
-    } else {
-        rows = 0;
+      mariadb_dr_do_error(sth, mysql_stmt_errno(imp_sth->stmt),
+               mysql_stmt_error(imp_sth->stmt),
+               mysql_stmt_sqlstate(imp_sth->stmt));
+      return 0;
     }
-  } else {
-      if ((mysql_real_query(*svsock, sbuf, slen))  &&
-          (!mariadb_db_reconnect(h, NULL) ||
-           (mysql_real_query(*svsock, sbuf, slen))))
-      {
-#if MYSQL_VERSION_ID < 50025
-        /* Cover a protocol design error: error packet does not contain the server status.
-         * Luckily, an error always aborts execution of a statement, so it is safe to turn off the flag. */
-        (*svsock)->server_status &= ~SERVER_MORE_RESULTS_EXISTS;
-#endif
-        rows = -1;
-      } else {
-          /** Store the result from the Query */
-          *result= use_mysql_use_result ?
-            mysql_use_result(*svsock) : mysql_store_result(*svsock);
+  }
+  else if (imp_sth->result)
+  {
+    /* Text protocol returns all values as strings, so compute conversion
+     * of every column only once for whole result set */
+    unsigned int i;
+    unsigned int num_fields= mysql_num_fields(imp_sth->result);
+    MYSQL_FIELD *fields= mysql_fetch_fields(imp_sth->result);
 
-          if (mysql_errno(*svsock))
-            rows = -1;
-          else if (use_mysql_use_result)
-            rows = (my_ulonglong)-2;
-          else if (*result)
-            rows = mysql_num_rows(*result);
-          else {
-            rows = mysql_affected_rows(*svsock);
-          }
-      }
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tmariadb_st_describe() text protocol num_fields %u\n",
+                    num_fields);
+
+    Renew(imp_sth->conv, num_fields, enum mariadb_conv);
+    for (i= 0; i < num_fields; ++i)
+      imp_sth->conv[i]= mysql_field_conv(&fields[i]);
   }
 
-  if (salloc)
-    Safefree(salloc);
+  imp_sth->done_desc = TRUE;
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_describe\n");
+  return 1;
+}
 
-  if (rows == (my_ulonglong)-1)
-    mariadb_dr_do_error(h, mysql_errno(*svsock), mysql_error(*svsock), 
-             mysql_sqlstate(*svsock));
+/*
+  Returns maximal number of bytes of BLOB/TEXT column value stored into the
+  fetched row. Longer values are truncated only when LongTruncOk is enabled
+  and LongReadLen was set explicitly (DBI default 80 is ignored), whole value
+  is then available via blob_read.
+ */
+static unsigned long mariadb_st_long_read_len(imp_sth_t *imp_sth)
+{
+  if (!DBIc_is(imp_sth, DBIcf_LongTruncOk) || !imp_sth->long_read_len_set || (IV)DBIc_LongReadLen(imp_sth) < 0)
+    return ULONG_MAX;
+  return DBIc_LongReadLen(imp_sth);
+}
 
-  return(rows);
+/*
+  Returns length of UTF-8 string truncated to len bytes without incomplete
+  multibyte character at the end, only first len bytes of str are read
+ */
+static STRLEN utf8_truncate_len(const char *str, STRLEN len)
+{
+  STRLEN start;
+  STRLEN need;
+  unsigned char c;
+
+  start = len;
+  while (start > 0 && len - start < 4 && ((unsigned char)str[start-1] & 0xC0) == 0x80)
+    start--;
+  if (start == 0)
+    return len;
+
+  c = (unsigned char)str[--start];
+  need = (c >= 0xF0) ? 4 : (c >= 0xE0) ? 3 : (c >= 0xC0) ? 2 : 1;
+  return (len - start < need) ? start : len;
 }
 
- /**************************************************************************
- *
- *  Name:    mariadb_st_internal_execute41
+/**************************************************************************
  *
- *  Purpose: Internal version for executing a prepared statement, called both
- *           from within the "do" and the "execute" method.
- *           MYSQL 4.1 API
+ *  Name:    mariadb_st_fetch_next
  *
+ *  Purpose: Advance to the next row of the current result set
  *
- *  Inputs:  h - object handle, for storing error messages
- *           statement - query being executed
- *           attribs - statement attributes, currently ignored
- *           num_params - number of parameters being bound
- *           params - parameter array
- *           result - where to store results, if any
- *           svsock - socket connected to the database
+ *  Input:   sth - statement handle being fetched
+ *           imp_sth - drivers private statement handle data
+ *           num_fields - pointer for storing number of columns in row
+ *
+ *  Returns: 1 if row is available, 0 if there are no more rows and
+ *           -1 on error; mariadb_dr_do_error() will be called in the
+ *           latter case
  *
  **************************************************************************/
 
-static my_ulonglong mariadb_st_internal_execute41(
-                                         SV *h,
-                                         char *sbuf,
-                                         STRLEN slen,
-                                         int num_params,
-                                         MYSQL_RES **result,
-                                         MYSQL_STMT **stmt_ptr,
-                                         MYSQL_BIND *bind,
-                                         MYSQL **svsock,
-                                         bool *has_been_bound
-                                        )
+static int
+mariadb_st_fetch_next(SV *sth, imp_sth_t* imp_sth, unsigned int *num_fields)
 {
   dTHX;
-  int store_retval;
-  int execute_retval;
-  unsigned int i, num_fields;
-  MYSQL_STMT *stmt = *stmt_ptr;
-  my_ulonglong rows=0;
-  bool reconnected = FALSE;
-  D_imp_xxh(h);
-
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                  "\t-> mariadb_st_internal_execute41\n");
+  int rc;
+  unsigned int i;
+  MYSQL_ROW cols;
+  D_imp_dbh_from_sth;
+  imp_sth_fbh_t *fbh;
+  D_imp_xxh(sth);
+  MYSQL_BIND *buffer;
+  bool rebind_result;
+  unsigned long length;
+  unsigned long prefix;
+  unsigned long size;
+  MYSQL_BIND tail;
 
-  /* free result if exists */
-  if (*result)
+  if (!imp_dbh->pmysql)
   {
-    mysql_free_result(*result);
-    *result = NULL;
+    mariadb_dr_do_error(sth, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+    return -1;
   }
 
-  if (!*svsock)
+  if (imp_dbh->async_query_in_flight)
   {
-    if (!mariadb_db_reconnect(h, NULL))
-    {
-      mariadb_dr_do_error(h, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
+    if (!DBIc_ACTIVE(imp_sth))
+      return 0;
+    if (mariadb_db_async_result(sth, &imp_sth->result) == (my_ulonglong)-1)
       return -1;
-    }
-    reconnected = TRUE;
   }
-
-  /*
-    If were performed any changes with ph variables
-    we have to rebind them
-  */
-
-  if (!reconnected && num_params > 0 && !(*has_been_bound))
+  else
   {
-#if !defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 80300
-    if (mysql_stmt_bind_named_param(stmt, bind, num_params, NULL) == 0)
-#else
-    if (mysql_stmt_bind_param(stmt,bind) == 0)
-#endif
-    {
-      *has_been_bound = TRUE;
-    }
-    else
+    if (!imp_sth->result)
     {
-      if (!mariadb_db_reconnect(h, stmt))
-        goto error;
-      reconnected = TRUE;
+      mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "fetch() without execute()", "HY000");
+      return -1;
     }
+    if (!DBIc_ACTIVE(imp_sth))
+      return 0;
   }
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                  "\t\tmariadb_st_internal_execute41 calling mysql_execute with %d num_params\n",
-                  num_params);
+  /* fix from 2.9008 */
+  imp_dbh->pmysql->net.last_errno = 0;
 
-  if (!reconnected)
-  {
-    execute_retval = mysql_stmt_execute(stmt);
-    if (execute_retval && mariadb_db_reconnect(h, stmt))
-      reconnected = TRUE;
-  }
-  if (reconnected)
+  if (imp_sth->use_server_side_prepare)
   {
-    *has_been_bound = FALSE;
-    stmt = mysql_stmt_init(*svsock);
-    if (!stmt)
-    {
-      mariadb_dr_do_error(h, mysql_errno(*svsock), mysql_error(*svsock), mysql_sqlstate(*svsock));
+    if (!mariadb_st_describe(sth, imp_sth))
       return -1;
+
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tmariadb_st_fetch calling mysql_stmt_fetch\n");
+
+    if ((rc= mysql_stmt_fetch(imp_sth->stmt)))
+    {
+#if MYSQL_VERSION_ID >= 50003
+      if (rc == MYSQL_DATA_TRUNCATED) {
+        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+          PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tmariadb_st_fetch data truncated\n");
+        goto process;
+      }
+#endif
+
+      if (rc == MYSQL_NO_DATA)
+      {
+        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+          PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tmariadb_st_fetch no data\n");
+        rc = 0;
+        if (imp_sth->row_num == (my_ulonglong)-2)
+          imp_sth->row_num = imp_sth->currow;
+      }
+      else if (rc == 1)
+      {
+        mariadb_dr_do_error(sth, mysql_stmt_errno(imp_sth->stmt),
+                 mysql_stmt_error(imp_sth->stmt),
+                 mysql_stmt_sqlstate(imp_sth->stmt));
+        rc = -1;
+      }
+      else
+        rc = 0;
+
+      DBIc_ACTIVE_off(imp_sth);
+
+      return rc;
     }
-    if (mysql_stmt_prepare(stmt, sbuf, slen))
+
+process:
+    imp_sth->currow++;
+
+    if (imp_sth->currow >= imp_sth->row_num)
+      DBIc_ACTIVE_off(imp_sth);
+
+    *num_fields=mysql_stmt_field_count(imp_sth->stmt);
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                    "\t\tmariadb_st_fetch called mysql_fetch, rc %d num_fields %u\n",
+                    rc, *num_fields);
+
+    rebind_result = FALSE;
+    for (
+         buffer= imp_sth->buffer,
+         fbh= imp_sth->fbh,
+         i= 0;
+         i < *num_fields;
+         i++,
+         fbh++,
+         buffer++
+        )
     {
-      mariadb_dr_do_error(h, mysql_stmt_errno(stmt), mysql_stmt_error(stmt), mysql_stmt_sqlstate(stmt));
-      mysql_stmt_close(stmt);
-      return -1;
+        /* In case of BLOB/TEXT fields we allocate only few bytes
+           in mariadb_st_describe() for data. Here we know real size of field
+           so we should increase buffer size and fetch remaining part of column
+           value. Buffer grows at least twice, so following rows with similar
+           sizes fit into it and rebinding of result is rarely needed.
+        */
+        if (!fbh->is_null && mysql_type_needs_allocated_buffer(buffer->buffer_type) && (fbh->length > buffer->buffer_length || fbh->error))
+        {
+          /* With LongTruncOk only LongReadLen bytes are needed,
+             remaining part can be read by blob_read */
+          length= fbh->length;
+          if (mysql_type_is_long(buffer->buffer_type) && length > mariadb_st_long_read_len(imp_sth))
+          {
+            length= mariadb_st_long_read_len(imp_sth);
+            if (length <= buffer->buffer_length)
+              continue;
+          }
+
+          /* Already received prefix of value is kept in buffer */
+          prefix= (fbh->length < buffer->buffer_length) ? fbh->length : buffer->buffer_length;
+          if (prefix >= length)
+            prefix= 0;
+
+          size= (buffer->buffer_length <= ULONG_MAX/2) ? 2*buffer->buffer_length : length;
+          if (size < length || (mysql_type_is_long(buffer->buffer_type) && size > mariadb_st_long_read_len(imp_sth)))
+            size= length;
+
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+              "\t\tRefetch BLOB/TEXT column: %d, length: %lu, offset: %lu, buffer: %lu, error: %d\n",
+              i, length, prefix, size, fbh->error ? 1 : 0);
+
+          if (fbh->data_allocated)
+            Renew(fbh->data, size, char);
+          else
+          {
+            /* Initial buffer is part of imp_sth->fbh allocation */
+            char *data;
+            Newx(data, size, char);
+            Copy(fbh->data, data, prefix, char);
+            fbh->data= data;
+            fbh->data_allocated= TRUE;
+          }
+          buffer->buffer_length= size;
+          buffer->buffer= (char *) fbh->data;
+
+          /* We invalidated fbh->data, therefore we must call mysql_stmt_bind_result()
+           * prior exiting this function. But we cannot call mysql_stmt_bind_result()
+           * before all remaining mysql_stmt_fetch_column() calls because we would get
+           * again truncated data. */
+          rebind_result = TRUE;
+
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2) {
+            char *ptr = (char*)buffer->buffer;
+            unsigned long int j, m;
+            m = buffer->buffer_length;
+            if (m > *buffer->length)
+              m = *buffer->length;
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),"\t\tbefore buffer->buffer: ");
+            for (j = 0; j < m; j++) {
+              PerlIO_printf(DBIc_LOGPIO(imp_xxh), "%c", *ptr++);
+            }
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),"\n");
+          }
+
+          tail= *buffer;
+          tail.buffer= (char *) fbh->data + prefix;
+          tail.buffer_length= length - prefix;
+          if (mysql_stmt_fetch_column(imp_sth->stmt, &tail, i, prefix))
+          {
+            mariadb_dr_do_error(sth, mysql_stmt_errno(imp_sth->stmt),
+                     mysql_stmt_error(imp_sth->stmt),
+                     mysql_stmt_sqlstate(imp_sth->stmt));
+            mysql_stmt_bind_result(imp_sth->stmt, imp_sth->buffer);
+            return -1;
+          }
+
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2) {
+            char *ptr = (char*)buffer->buffer;
+            unsigned long int j, m;
+            m = buffer->buffer_length;
+            if (m > *buffer->length)
+              m = *buffer->length;
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),"\t\tafter buffer->buffer: ");
+            for (j = 0; j < m; j++) {
+              PerlIO_printf(DBIc_LOGPIO(imp_xxh), "%c", *ptr++);
+            }
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh),"\n");
+          }
+        }
     }
-    mysql_stmt_close(*stmt_ptr);
-    *stmt_ptr = stmt;
-    if (num_params > 0)
+
+    if (rebind_result)
     {
-#if !defined(MARIADB_BASE_VERSION) && MYSQL_VERSION_ID >= 80300
-      if (mysql_stmt_bind_named_param(stmt, bind, num_params, NULL) == 0)
-#else
-      if (mysql_stmt_bind_param(stmt,bind))
-#endif
-        goto error;
-      *has_been_bound = TRUE;
+      if (mysql_stmt_bind_result(imp_sth->stmt, imp_sth->buffer))
+      {
+        mariadb_dr_do_error(sth, mysql_stmt_errno(imp_sth->stmt), mysql_stmt_error(imp_sth->stmt), mysql_stmt_sqlstate(imp_sth->stmt));
+        return -1;
+      }
     }
-    execute_retval= mysql_stmt_execute(stmt);
-  }
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                  "\t\tmysql_stmt_execute returned %d\n",
-                  execute_retval);
-  if (execute_retval)
-    goto error;
 
-  /*
-   This statement does not return a result set (INSERT, UPDATE...)
-  */
-  if (!(*result= mysql_stmt_result_metadata(stmt)))
+    return 1;
+  }
+  else
   {
-    if (mysql_stmt_errno(stmt))
-      goto error;
+    imp_sth->currow++;
 
-    rows= mysql_stmt_affected_rows(stmt);
+    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    {
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tmariadb_st_fetch result set details\n");
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\timp_sth->result=%p\n", imp_sth->result);
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tmysql_num_fields=%u\n",
+                    mysql_num_fields(imp_sth->result));
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tmysql_num_rows=%" SVf "\n",
+                    SVfARG(sv_2mortal(my_ulonglong2sv(mysql_num_rows(imp_sth->result)))));
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tmysql_affected_rows=%" SVf "\n",
+                    SVfARG(sv_2mortal(my_ulonglong2sv(mysql_affected_rows(imp_dbh->pmysql)))));
+      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tmariadb_st_fetch for %p, currow=%" SVf "\n",
+                    sth, SVfARG(sv_2mortal(my_ulonglong2sv(imp_sth->currow))));
+    }
 
-    /* mysql_stmt_affected_rows(): -1 indicates that the query returned an error */
-    if (rows == (my_ulonglong)-1)
-      goto error;
-  }
-  /*
-    This statement returns a result set (SELECT...)
-  */
-  else
-  {
-    num_fields = mysql_stmt_field_count(stmt);
-    for (i = 0; i < num_fields; ++i)
+    if (!(cols= mysql_fetch_row(imp_sth->result)))
     {
-      MYSQL_FIELD *field = mysql_fetch_field_direct(*result, i);
-      if (field && mysql_field_needs_allocated_buffer(field))
+      imp_sth->current_row = NULL;
+      rc = 0;
+      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
       {
-        /* mysql_stmt_store_result to update MYSQL_FIELD->max_length */
-        my_bool on = TRUE;
-        mysql_stmt_attr_set(stmt, STMT_ATTR_UPDATE_MAX_LENGTH, &on);
-        break;
+        PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tmariadb_st_fetch, no more rows to fetch\n");
+      }
+      if (mysql_errno(imp_dbh->pmysql))
+      {
+        mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql),
+                 mysql_error(imp_dbh->pmysql),
+                 mysql_sqlstate(imp_dbh->pmysql));
+        rc = -1;
       }
+      else if (imp_sth->row_num == (my_ulonglong)-2)
+        imp_sth->row_num = mysql_num_rows(imp_sth->result);
+      if (!mysql_more_results(imp_dbh->pmysql))
+        DBIc_ACTIVE_off(imp_sth);
+      return rc;
     }
-    store_retval = mysql_stmt_store_result(stmt);
-    if (store_retval)
-      goto error;
-    /* Get the total rows affected and return */
-    rows = mysql_stmt_num_rows(stmt);
-  }
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                  "\t<- mysql_internal_execute_41 returning %" SVf " rows\n",
-                  SVfARG(sv_2mortal(my_ulonglong2sv(rows))));
-  return(rows);
 
-error:
-  if (*result)
-  {
-    mysql_free_result(*result);
-    *result = NULL;
-  }
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                  "     errno %d err message %s\n",
-                  mysql_stmt_errno(stmt),
-                  mysql_stmt_error(stmt));
-  mariadb_dr_do_error(h, mysql_stmt_errno(stmt), mysql_stmt_error(stmt),
-           mysql_stmt_sqlstate(stmt));
-  mysql_stmt_reset(stmt);
+    if (imp_sth->currow >= imp_sth->row_num && !mysql_more_results(imp_dbh->pmysql))
+      DBIc_ACTIVE_off(imp_sth);
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                  "\t<- mariadb_st_internal_execute41\n");
-  return -1;
+    if (!mariadb_st_describe(sth, imp_sth))
+      return -1;
 
+    imp_sth->current_row = cols;
+    *num_fields= mysql_num_fields(imp_sth->result);
+    return 1;
+  }
 }
 
-/***************************************************************************
+/**************************************************************************
  *
- *  Name:    mariadb_st_execute_iv
+ *  Name:    mariadb_st_store_row
  *
- *  Purpose: Called for preparing an SQL statement; our part of the
- *           statement handle constructor
+ *  Purpose: Store values of the current row into Perl scalars
  *
- *  Input:   sth - statement handle being initialized
+ *  Input:   sth - statement handle being fetched
  *           imp_sth - drivers private statement handle data
+ *           row - array of num_fields scalars which receive the values
+ *           num_fields - number of columns in row
  *
- *  Returns: -2 for errors, -1 for unknown number of rows, otherwise number
- *           of rows; mariadb_dr_do_error will be called for errors
+ *  Returns: Nothing
  *
  **************************************************************************/
 
-IV mariadb_st_execute_iv(SV* sth, imp_sth_t* imp_sth)
+static void
+mariadb_st_store_row(SV *sth, imp_sth_t* imp_sth, SV **row, unsigned int num_fields)
 {
   dTHX;
-  int i;
-  unsigned int num_fields;
-  D_imp_dbh_from_sth;
+  bool ChopBlanks;
+  unsigned int i;
+  unsigned long *lengths;
+  MYSQL_ROW cols;
+  imp_sth_fbh_t *fbh;
   D_imp_xxh(sth);
-  bool use_server_side_prepare = imp_sth->use_server_side_prepare;
-  bool disable_fallback_for_server_prepare = imp_sth->disable_fallback_for_server_prepare;
+  MYSQL_BIND *buffer;
+  IV int_val;
+  const char *int_type;
+  enum mariadb_conv *conv;
+  MYSQL_FIELD *fields;
+  unsigned long long_read_len;
+  MYSQL_TIME tm;
+
+  ChopBlanks = DBIc_is(imp_sth, DBIcf_ChopBlanks) ? TRUE : FALSE;
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                  "\t\tmariadb_st_fetch for %p, chopblanks %d\n",
+                  sth, ChopBlanks ? 1 : 0);
+
+  long_read_len = mariadb_st_long_read_len(imp_sth);
+
+  if (imp_sth->use_server_side_prepare)
+  {
+    for (
+         buffer= imp_sth->buffer,
+         fbh= imp_sth->fbh,
+         i= 0;
+         i < num_fields;
+         i++,
+         fbh++,
+         buffer++
+        )
+    {
+      SV *sv= row[i]; /* Note: we (re)use the SV in the AV	*/
+      STRLEN len;
+      if (fbh->is_null)
+        (void) SvOK_off(sv);  /*  Field is NULL, return undef  */
+      else
+      {
+        switch (buffer->buffer_type) {
+        case MYSQL_TYPE_TINY:
+        case MYSQL_TYPE_SHORT:
+        case MYSQL_TYPE_LONG:
+#if IVSIZE >= 8
+        case MYSQL_TYPE_LONGLONG:
+#endif
+          switch (buffer->buffer_type) {
+          case MYSQL_TYPE_TINY:
+            if (buffer->is_unsigned)
+              int_val= (unsigned char)fbh->numeric_val.tval;
+            else
+              int_val= (signed char)fbh->numeric_val.tval;
+            int_type= "TINY INT";
+            break;
+
+          case MYSQL_TYPE_SHORT:
+            if (buffer->is_unsigned)
+              int_val= (unsigned short)fbh->numeric_val.sval;
+            else
+              int_val= (signed short)fbh->numeric_val.sval;
+            int_type= "SHORT INT";
+            break;
+
+          case MYSQL_TYPE_LONG:
+            if (buffer->is_unsigned)
+              int_val= (uint32_t)fbh->numeric_val.lval;
+            else
+              int_val= (int32_t)fbh->numeric_val.lval;
+            int_type= "LONG INT";
+            break;
+
+#if IVSIZE >= 8
+          case MYSQL_TYPE_LONGLONG:
+            if (buffer->is_unsigned)
+              int_val= fbh->numeric_val.llval;
+            else
+              int_val= fbh->numeric_val.llval;
+            int_type= "LONGLONG INT";
+            break;
+#endif
+          default:
+            NOT_REACHED;
+            int_val = 0;
+            int_type = "";
+            break;
+          }
+
+          if (buffer->is_unsigned)
+            sv_setuv(sv, (UV)int_val);
+          else
+            sv_setiv(sv, (IV)int_val);
+
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+          {
+            if (buffer->is_unsigned)
+              PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tst_fetch AN UNSIGNED %s NUMBER %"UVuf"\n",
+                            int_type, (UV)int_val);
+            else
+              PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tst_fetch A SIGNED %s NUMBER %"IVdf"\n",
+                            int_type, (IV)int_val);
+          }
+          break;
+
+#if IVSIZE < 8
+        case MYSQL_TYPE_LONGLONG:
+          {
+            char buf[64];
+            STRLEN len = sizeof(buf);
+            char *ptr;
+
+            if (buffer->is_unsigned)
+              ptr = my_ulonglong2str(fbh->numeric_val.llval, buf, &len);
+            else
+              ptr = signed_my_ulonglong2str(fbh->numeric_val.llval, buf, &len);
+
+            SvUTF8_off(sv);
+            sv_setpvn(sv, ptr, len);
+
+            if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+              PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tst_fetch %s LONGLONG INT NUMBER %s\n",
+                            (buffer->is_unsigned ? "AN UNSIGNED" : "A SIGNED"), ptr);
+          }
+          break;
+#endif
+
+        case MYSQL_TYPE_FLOAT:
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tst_fetch A FLOAT NUMBER %f\n", fbh->numeric_val.fval);
+          sv_setnv(sv, fbh->numeric_val.fval);
+          break;
+
+        case MYSQL_TYPE_DOUBLE:
+          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+            PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tst_fetch A DOUBLE NUMBER %f\n", fbh->numeric_val.dval);
+          sv_setnv(sv, fbh->numeric_val.dval);
+          break;
+
+        case MYSQL_TYPE_TIME:
+        case MYSQL_TYPE_DATE:
+        case MYSQL_TYPE_DATETIME:
+        case MYSQL_TYPE_TIMESTAMP:
+          mysql_time_to_sv(aTHX_ sv, &fbh->numeric_val.time, fields[i].type, imp_sth->temporal_mode, fbh->decimals);
+          break;
+
+        case MYSQL_TYPE_NULL:
+          (void) SvOK_off(sv);  /*  Field is NULL, return undef  */
+          break;
+
+        default:
+          if (i < imp_sth->bind_col_count && imp_sth->bind_col_type[i] &&
+              store_bound_number(aTHX_ sv, fbh->data, fbh->length, imp_sth->bind_col_type[i]))
+            break;
+
+          if (fbh->is_decimal && imp_sth->decimal_mode != MARIADB_DECIMAL_STRING)
+          {
+            mysql_decimal_to_sv(aTHX_ sv, fbh->data, fbh->length, imp_sth->decimal_mode, fbh->decimals);
+            break;
+          }
+
+          /* TEXT columns can be returned as MYSQL_TYPE_BLOB, so always check for charset */
+          len= fbh->length;
+          if (mysql_type_is_long(buffer->buffer_type) && len > long_read_len)
+            len= fbh->is_utf8 ? utf8_truncate_len(fbh->data, long_read_len) : long_read_len;
+	  /* ChopBlanks server-side prepared statement */
+          if (ChopBlanks)
+          {
+            if (fbh->is_utf8)
+              while (len && fbh->data[len-1] == ' ') { --len; }
+          }
+	  /* END OF ChopBlanks */
+
+          SvUTF8_off(sv);
+          sv_setpvn(sv, fbh->data, len);
+          if (fbh->is_utf8)
+            sv_utf8_decode(sv);
+          break;
+        }
+      }
+    }
+  }
+  else
+  {
+    cols= imp_sth->current_row;
+    lengths= mysql_fetch_lengths(imp_sth->result);
+    conv= imp_sth->conv;
+    fields= mysql_fetch_fields(imp_sth->result);
+
+    for (i= 0;  i < num_fields; ++i)
+    {
+      char *col= cols[i];
+      SV *sv= row[i]; /* Note: we (re)use the SV in the AV	*/
+      STRLEN len;
+      UV uv_val;
+      bool negative;
+
+      if (!col)
+      {
+        (void) SvOK_off(sv);  /*  Field is NULL, return undef  */
+        continue;
+      }
+
+      len= lengths[i];
+
+      if (i < imp_sth->bind_col_count && imp_sth->bind_col_type[i] &&
+          store_bound_number(aTHX_ sv, col, len, imp_sth->bind_col_type[i]))
+        continue;
 
-  ASYNC_CHECK_RETURN(sth, -2);
+      if (len > long_read_len && mysql_type_is_long(fields[i].type))
+        len= (conv[i] == MARIADB_CONV_UTF8) ? utf8_truncate_len(col, long_read_len) : long_read_len;
 
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-      " -> mariadb_st_execute_iv for %p\n", sth);
+      switch (conv[i]) {
+      case MARIADB_CONV_NULL:
+        /* Field is NULL, return undef */
+        (void) SvOK_off(sv);
+        break;
 
-  if (!SvROK(sth)  ||  SvTYPE(SvRV(sth)) != SVt_PVHV)
-    croak("Expected hash array");
+      case MARIADB_CONV_INTEGER:
+        if (parse_mysql_integer(col, len, &uv_val, &negative))
+        {
+          if (!negative && uv_val <= (UV)IV_MAX)
+          {
+            sv_setiv(sv, (IV)uv_val);
+            break;
+          }
+          else if (negative && uv_val <= (UV)IV_MAX+1)
+          {
+            sv_setiv(sv, -(IV)(uv_val-1)-1);
+            break;
+          }
+        }
+        /* Coerce to integer and set scalar as IV */
+        SvUTF8_off(sv);
+        sv_setpvn(sv, col, len);
+        sv_setiv(sv, SvIV_nomg(sv));
+        break;
 
-  for (i = 0; i < DBIc_NUM_PARAMS(imp_sth); ++i)
-  {
-    if (!imp_sth->params[i].bound)
-    {
-      mariadb_dr_do_error(sth, ER_WRONG_ARGUMENTS, "Wrong number of bind parameters", "HY000");
-      return -2;
-    }
-  }
+      case MARIADB_CONV_UNSIGNED:
+        if (parse_mysql_integer(col, len, &uv_val, &negative) && !negative)
+        {
+          sv_setuv(sv, uv_val);
+          break;
+        }
+        /* Coerce to integer and set scalar as UV */
+        SvUTF8_off(sv);
+        sv_setpvn(sv, col, len);
+        sv_setuv(sv, SvUV_nomg(sv));
+        break;
 
-  /* Free cached array attributes */
-  for (i= 0;  i < AV_ATTRIB_LAST;  i++)
-  {
-    if (imp_sth->av_attr[i])
-      SvREFCNT_dec(imp_sth->av_attr[i]);
+      case MARIADB_CONV_DOUBLE:
+        /* Values in rows returned by mysql_fetch_row() are always nul terminated */
+        sv_setnv(sv, Atof(col));
+        break;
 
-    imp_sth->av_attr[i]= Nullav;
-  }
+      case MARIADB_CONV_UTF8:
+        if (ChopBlanks)
+        {
+          while (len && col[len-1] == ' ')
+          {	--len; }
+        }
+        SvUTF8_off(sv);
+        sv_setpvn(sv, col, len);
+        sv_utf8_decode(sv);
+        break;
 
-  /* 
-     Clean-up previous result set(s) for sth to prevent
-     'Commands out of sync' error 
-  */
-  if (!mariadb_st_free_result_sets(sth, imp_sth, TRUE))
-    return -2;
+      case MARIADB_CONV_BINARY:
+        SvUTF8_off(sv);
+        sv_setpvn(sv, col, len);
+        break;
 
-  imp_sth->currow = 0;
+      case MARIADB_CONV_DECIMAL:
+        mysql_decimal_to_sv(aTHX_ sv, col, len, imp_sth->decimal_mode, fields[i].decimals);
+        break;
 
-  if (use_server_side_prepare)
-  {
-    if (imp_sth->use_mysql_use_result)
-    {
-      if (disable_fallback_for_server_prepare)
-      {
-        mariadb_dr_do_error(sth, CR_NOT_IMPLEMENTED,
-                 "\"mariadb_use_result\" not supported with server side prepare",
-                 "HY000");
-        return -2;
-      }
-      use_server_side_prepare = FALSE;
-    }
-
-    if (use_server_side_prepare)
-    {
-      imp_sth->row_num= mariadb_st_internal_execute41(
-                                                    sth,
-                                                    imp_sth->statement,
-                                                    imp_sth->statement_len,
-                                                    DBIc_NUM_PARAMS(imp_sth),
-                                                    &imp_sth->result,
-                                                    &imp_sth->stmt,
-                                                    imp_sth->bind,
-                                                    &imp_dbh->pmysql,
-                                                    &imp_sth->has_been_bound
-                                                   );
-      if (imp_sth->row_num == (my_ulonglong)-1) /* -1 means error */
-      {
-        SV *err = DBIc_ERR(imp_xxh);
-        if (!disable_fallback_for_server_prepare && SvIV(err) == ER_UNSUPPORTED_PS)
+      case MARIADB_CONV_TEMPORAL:
+        if (imp_sth->temporal_mode != MARIADB_TEMPORAL_STRING && parse_mysql_time(col, len, &tm))
         {
-          use_server_side_prepare = FALSE;
+          mysql_time_to_sv(aTHX_ sv, &tm, fields[i].type, imp_sth->temporal_mode, 0);
+          break;
         }
+        SvUTF8_off(sv);
+        sv_setpvn(sv, col, len);
+        break;
       }
     }
   }
-
-  if (!use_server_side_prepare)
-  {
-    imp_sth->row_num= mariadb_st_internal_execute(
-                                                sth,
-                                                imp_sth->statement,
-                                                imp_sth->statement_len,
-                                                DBIc_NUM_PARAMS(imp_sth),
-                                                imp_sth->params,
-                                                &imp_sth->result,
-                                                &imp_dbh->pmysql,
-                                                imp_sth->use_mysql_use_result
-                                               );
-    if(imp_dbh->async_query_in_flight) {
-        DBIc_ACTIVE_on(imp_sth);
-        imp_sth->async_result = FALSE;
-        return 0;
-    }
-  }
-
-  if (imp_sth->row_num != (my_ulonglong)-1)
-  {
-    if (!imp_sth->result)
-    {
-      /* Some MySQL client versions return correct value from mysql_insert_id()
-       * function only after non-SELECT operation. So store insert id into dbh
-       * cache and later read it only from cache. */
-      imp_dbh->insertid = imp_sth->insertid = mysql_insert_id(imp_dbh->pmysql);
-      if (mysql_more_results(imp_dbh->pmysql))
-        DBIc_ACTIVE_on(imp_sth);
-    }
-    else
-    {
-      /** Store the result in the current statement handle */
-      num_fields = mysql_num_fields(imp_sth->result);
-      DBIc_NUM_FIELDS(imp_sth) = (num_fields <= INT_MAX) ? num_fields : INT_MAX;
-      if (imp_sth->row_num)
-        DBIc_ACTIVE_on(imp_sth);
-      if (!use_server_side_prepare)
-        imp_sth->done_desc = FALSE;
-    }
-  }
-
-  imp_sth->warning_count = mysql_warning_count(imp_dbh->pmysql);
-
-  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-  {
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                  " <- mariadb_st_execute_iv returning imp_sth->row_num %" SVf "\n",
-                  SVfARG(sv_2mortal(my_ulonglong2sv(imp_sth->row_num))));
-  }
-
-  if (imp_sth->row_num == (my_ulonglong)-1)
-    return -2; /* -2 is error */
-  else if (imp_sth->row_num <= IV_MAX)
-    return imp_sth->row_num;
-  else         /* overflow */
-    return -1; /* -1 is unknown number of rows */
 }
 
- /**************************************************************************
+/**************************************************************************
  *
- *  Name:    mariadb_st_describe
+ *  Name:    mariadb_st_fetch
  *
- *  Purpose: Called from within the fetch method to describe the result
+ *  Purpose: Called for fetching a result row
  *
  *  Input:   sth - statement handle being initialized
- *           imp_sth - our part of the statement handle, there's no
- *               need for supplying both; Tim just doesn't remove it
+ *           imp_sth - drivers private statement handle data
  *
- *  Returns: 1 for success, 0 otherwise; mariadb_dr_do_error will
- *           be called in the latter case
+ *  Returns: array of columns; the array is allocated by DBI via
+ *           DBIc_DBISTATE(imp_sth)->get_fbav(imp_sth), even the values
+ *           of the array are prepared, we just need to modify them
+ *           appropriately
  *
  **************************************************************************/
 
-static int mariadb_st_describe(SV* sth, imp_sth_t* imp_sth)
+AV*
+mariadb_st_fetch(SV *sth, imp_sth_t* imp_sth)
 {
   dTHX;
+  unsigned int num_fields;
+  AV *av;
+  unsigned int av_length;
+  bool av_readonly;
   D_imp_xxh(sth);
+
   if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t--> mariadb_st_describe\n");
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t-> mariadb_st_fetch\n");
 
-  if (imp_sth->done_desc)
-    return 1;
+  if (mariadb_st_fetch_next(sth, imp_sth, &num_fields) <= 0)
+    return Nullav;
 
-  if (imp_sth->use_server_side_prepare)
+  if (!imp_sth->use_server_side_prepare && (av= DBIc_FIELDS_AV(imp_sth)) != Nullav)
   {
-    int i;
-    int num_fields= DBIc_NUM_FIELDS(imp_sth);
-    imp_sth_fbh_t *fbh;
-    MYSQL_BIND *buffer;
-    MYSQL_FIELD *fields;
-
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tmariadb_st_describe() num_fields %d\n",
-                    num_fields);
-
-    if (num_fields <= 0 || !imp_sth->result)
-    {
-      /* no metadata */
-      mariadb_dr_do_error(sth, CR_NO_STMT_METADATA, "Prepared statement contains no metadata", "HY000");
-      return 0;
-    }
-
-    /* allocate fields buffers  */
-    if (  !(imp_sth->fbh= alloc_fbuffer(num_fields))
-          || !(imp_sth->buffer= alloc_bind(num_fields)) )
-    {
-      /* Out of memory */
-      mariadb_dr_do_error(sth, CR_OUT_OF_MEMORY, "Out of memory in mariadb_st_describe()", "HY000");
-      return 0;
-    }
-
-    fields= mysql_fetch_fields(imp_sth->result);
+    av_length= av_len(av)+1;
 
-    for (
-         fbh= imp_sth->fbh, buffer= (MYSQL_BIND*)imp_sth->buffer, i= 0;
-         i < num_fields;
-         i++, fbh++, buffer++
-        )
+    if (av_length != num_fields)              /* Resize array if necessary */
     {
       if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      {
-        PerlIO_printf(DBIc_LOGPIO(imp_xxh),"\t\ti %d fbh->length %lu\n",
-                      i, fbh->length);
-        PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                      "\t\tfields[i].length %lu fields[i].max_length %lu fields[i].type %d fields[i].flags %d fields[i].charsetnr %d\n",
-                      fields[i].length, fields[i].max_length, fields[i].type, fields[i].flags, fields[i].charsetnr);
-      }
+        PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_fetch, size of results array(%u) != num_fields(%u)\n",
+                                 av_length, num_fields);
 
-      fbh->is_utf8 = mysql_charsetnr_is_utf8(fields[i].charsetnr);
-
-      buffer->buffer_type= fields[i].type;
-      buffer->is_unsigned= (fields[i].flags & UNSIGNED_FLAG) ? TRUE : FALSE;
-      buffer->length= &(fbh->length);
-      buffer->is_null= &(fbh->is_null);
-#if MYSQL_VERSION_ID >= NEW_DATATYPE_VERSION
-      buffer->error= &(fbh->error);
-#endif
-
-      if (mysql_field_needs_string_type(&fields[i]))
-        buffer->buffer_type = MYSQL_TYPE_STRING;
-
-      switch (buffer->buffer_type) {
-      case MYSQL_TYPE_NULL:
-        buffer->buffer_length= 0;
-        buffer->buffer= NULL;
-        break;
-
-      case MYSQL_TYPE_TINY:
-        buffer->buffer_length= sizeof(fbh->numeric_val.tval);
-        buffer->buffer= (char*) &fbh->numeric_val.tval;
-        break;
-
-      case MYSQL_TYPE_SHORT:
-        buffer->buffer_length= sizeof(fbh->numeric_val.sval);
-        buffer->buffer= (char*) &fbh->numeric_val.sval;
-        break;
-
-      case MYSQL_TYPE_LONG:
-        buffer->buffer_length= sizeof(fbh->numeric_val.lval);
-        buffer->buffer= (char*) &fbh->numeric_val.lval;
-        break;
-
-      case MYSQL_TYPE_LONGLONG:
-        buffer->buffer_length= sizeof(fbh->numeric_val.llval);
-        buffer->buffer= (char*) &fbh->numeric_val.llval;
-        break;
-
-      case MYSQL_TYPE_FLOAT:
-        buffer->buffer_length= sizeof(fbh->numeric_val.fval);
-        buffer->buffer= (char*) &fbh->numeric_val.fval;
-        break;
+      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+        PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_fetch, result fields(%d)\n",
+                                 DBIc_NUM_FIELDS(imp_sth));
 
-      case MYSQL_TYPE_DOUBLE:
-        buffer->buffer_length= sizeof(fbh->numeric_val.dval);
-        buffer->buffer= (char*) &fbh->numeric_val.dval;
-        break;
+      av_readonly = SvREADONLY(av) ? TRUE : FALSE;
 
-      /* TODO: datetime structures */
-#if 0
-      case MYSQL_TYPE_TIME:
-      case MYSQL_TYPE_DATE:
-      case MYSQL_TYPE_DATETIME:
-      case MYSQL_TYPE_TIMESTAMP:
-        break;
-#endif
+      if (av_readonly)
+        SvREADONLY_off( av );              /* DBI sets this readonly */
 
-      default:
-        if (buffer->buffer_type != MYSQL_TYPE_BLOB)
-          buffer->buffer_type= MYSQL_TYPE_STRING;
-        buffer->buffer_length= fields[i].max_length ? fields[i].max_length : 1;
-        Newz(908, fbh->data, buffer->buffer_length, char);
-        buffer->buffer= (char *) fbh->data;
-        break;
+      while (av_length < num_fields)
+      {
+        av_store(av, av_length++, newSV(0));
       }
-    }
 
-    if (mysql_stmt_bind_result(imp_sth->stmt, imp_sth->buffer))
-    {
-      mariadb_dr_do_error(sth, mysql_stmt_errno(imp_sth->stmt),
-               mysql_stmt_error(imp_sth->stmt),
-               mysql_stmt_sqlstate(imp_sth->stmt));
-      return 0;
+      while (av_length > num_fields)
+      {
+        SvREFCNT_dec(av_pop(av));
+        av_length--;
+      }
+      if (av_readonly)
+        SvREADONLY_on(av);
     }
   }
 
-  imp_sth->done_desc = TRUE;
+  av= DBIc_DBISTATE(imp_sth)->get_fbav(imp_sth);
+
+  mariadb_st_store_row(sth, imp_sth, AvARRAY(av), num_fields);
+
   if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_describe\n");
-  return 1;
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_fetch, %u cols\n", num_fields);
+
+  return av;
 }
 
 /**************************************************************************
  *
- *  Name:    mariadb_st_fetch
+ *  Name:    mariadb_st_fetch_chunk
  *
- *  Purpose: Called for fetching a result row
+ *  Purpose: Fetch up to max_rows rows in one call; each row is stored
+ *           directly into a newly created array, so no per row method
+ *           dispatch nor copying of DBI's row buffer is needed
  *
- *  Input:   sth - statement handle being initialized
+ *  Input:   sth - statement handle being fetched
  *           imp_sth - drivers private statement handle data
+ *           max_rows - maximal number of rows, negative for all rows
  *
- *  Returns: array of columns; the array is allocated by DBI via
- *           DBIc_DBISTATE(imp_sth)->get_fbav(imp_sth), even the values
- *           of the array are prepared, we just need to modify them
- *           appropriately
+ *  Returns: mortal reference to array of row array references; undef
+ *           when max_rows is positive and statement is not active
  *
  **************************************************************************/
 
-AV*
-mariadb_st_fetch(SV *sth, imp_sth_t* imp_sth)
+SV *
+mariadb_st_fetch_chunk(SV *sth, imp_sth_t* imp_sth, IV max_rows)
 {
   dTHX;
-  bool ChopBlanks;
-  int rc;
   unsigned int i, num_fields;
-  unsigned long *lengths;
-  AV *av;
-  unsigned int av_length;
-  bool av_readonly;
-  MYSQL_ROW cols;
-  D_imp_dbh_from_sth;
-  imp_sth_fbh_t *fbh;
+  AV *rows_av;
+  AV *row_av;
   D_imp_xxh(sth);
-  MYSQL_BIND *buffer;
-  IV int_val;
-  const char *int_type;
-  MYSQL_FIELD *fields;
-  bool rebind_result;
 
   if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t-> mariadb_st_fetch\n");
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t-> mariadb_st_fetch_chunk, max_rows %" IVdf "\n", max_rows);
 
-  if (!imp_dbh->pmysql)
-  {
-    mariadb_dr_do_error(sth, CR_SERVER_GONE_ERROR, "MySQL server has gone away", "HY000");
-    return Nullav;
-  }
+  /* Same as DBI's fetchall_arrayref: with batch size return undef without error when all rows were fetched */
+  if (!DBIc_ACTIVE(imp_sth) && max_rows > 0)
+    return &PL_sv_undef;
 
-  if (imp_dbh->async_query_in_flight)
-  {
-    if (!DBIc_ACTIVE(imp_sth))
-      return Nullav;
-    if (mariadb_db_async_result(sth, &imp_sth->result) == (my_ulonglong)-1)
-      return Nullav;
-  }
-  else
+  rows_av = newAV();
+  av_extend(rows_av, (max_rows > 0 && max_rows < 1024) ? max_rows-1 : 31);
+
+  while (max_rows < 0 || max_rows-- > 0)
   {
-    if (!imp_sth->result)
+    if (mariadb_st_fetch_next(sth, imp_sth, &num_fields) <= 0)
+      break;
+
+    row_av = newAV();
+    if (num_fields > 0)
     {
-      mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "fetch() without execute()", "HY000");
-      return Nullav;
+      av_extend(row_av, num_fields-1);
+      for (i = 0; i < num_fields; ++i)
+        AvARRAY(row_av)[i] = newSV(0);
+      AvFILLp(row_av) = num_fields-1;
     }
-    if (!DBIc_ACTIVE(imp_sth))
-      return Nullav;
-  }
 
-  ChopBlanks = DBIc_is(imp_sth, DBIcf_ChopBlanks) ? TRUE : FALSE;
+    mariadb_st_store_row(sth, imp_sth, AvARRAY(row_av), num_fields);
+    av_push(rows_av, newRV_noinc((SV *)row_av));
+  }
 
   if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                  "\t\tmariadb_st_fetch for %p, chopblanks %d\n",
-                  sth, ChopBlanks ? 1 : 0);
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_fetch_chunk, %ld rows\n", (long)(av_len(rows_av)+1));
 
-  /* fix from 2.9008 */
-  imp_dbh->pmysql->net.last_errno = 0;
+  return sv_2mortal(newRV_noinc((SV *)rows_av));
+}
 
-  if (imp_sth->use_server_side_prepare)
+/*
+  Append value of fetched scalar to column packed by mariadb_st_fetch_columns
+  Returns false if value cannot be packed
+*/
+static bool packed_column_append(pTHX_ SV *column, char kind, SV *sv)
+{
+  IV iv_val;
+  double nv_val;
+  UV uv_val;
+  bool negative;
+  const char *ptr;
+  STRLEN size;
+
+  if (kind == 'j')
+  {
+    if (SvIOK(sv) && (!SvIsUV(sv) || SvUVX(sv) <= (UV)IV_MAX))
+      iv_val = SvIVX(sv);
+    else if (SvPOK(sv) && parse_mysql_integer(SvPVX(sv), SvCUR(sv), &uv_val, &negative) && uv_val <= (UV)IV_MAX)
+      iv_val = negative ? -(IV)uv_val : (IV)uv_val;
+    else
+      return FALSE;
+    ptr = (const char *)&iv_val;
+    size = sizeof(iv_val);
+  }
+  else
   {
-    if (!mariadb_st_describe(sth, imp_sth))
-      return Nullav;
+    if (SvNOK(sv))
+      nv_val = SvNVX(sv);
+    else if (SvIOK(sv))
+      nv_val = SvIsUV(sv) ? (double)SvUVX(sv) : (double)SvIVX(sv);
+    else if (SvPOK(sv) && looks_like_number(sv))
+      nv_val = SvNV_nomg(sv);
+    else
+      return FALSE;
+    ptr = (const char *)&nv_val;
+    size = sizeof(nv_val);
+  }
 
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tmariadb_st_fetch calling mysql_stmt_fetch\n");
+  /* Grow geometrically, older perls extend string buffer only by needed size */
+  if (SvCUR(column) + size + 1 > SvLEN(column))
+    SvGROW(column, 2 * SvLEN(column) + size + 1);
+  sv_catpvn(column, ptr, size);
+  return TRUE;
+}
 
-    if ((rc= mysql_stmt_fetch(imp_sth->stmt)))
-    {
-#if MYSQL_VERSION_ID >= 50003
-      if (rc == MYSQL_DATA_TRUNCATED) {
-        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-          PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tmariadb_st_fetch data truncated\n");
-        goto process;
-      }
-#endif
+/*
+  Convert packed column to array of scalars
+*/
+static AV *packed_column_to_av(pTHX_ SV *column, char kind)
+{
+  AV *av;
+  STRLEN len;
+  STRLEN i;
+  const char *str;
+  IV iv_val;
+  double nv_val;
 
-      if (rc == MYSQL_NO_DATA)
-      {
-        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-          PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tmariadb_st_fetch no data\n");
-      }
-      else if (rc == 1)
-      {
-        mariadb_dr_do_error(sth, mysql_stmt_errno(imp_sth->stmt),
-                 mysql_stmt_error(imp_sth->stmt),
-                 mysql_stmt_sqlstate(imp_sth->stmt));
-      }
+  str = SvPV(column, len);
+  av = newAV();
+  if (kind == 'j')
+  {
+    av_extend(av, len / sizeof(iv_val));
+    for (i = 0; i + sizeof(iv_val) <= len; i += sizeof(iv_val))
+    {
+      Copy(str + i, &iv_val, 1, IV);
+      av_push(av, newSViv(iv_val));
+    }
+  }
+  else
+  {
+    av_extend(av, len / sizeof(nv_val));
+    for (i = 0; i + sizeof(nv_val) <= len; i += sizeof(nv_val))
+    {
+      Copy(str + i, &nv_val, 1, double);
+      av_push(av, newSVnv(nv_val));
+    }
+  }
+  return av;
+}
 
-      DBIc_ACTIVE_off(imp_sth);
+/*
+  Find columns of integer and floating point types which are packed by
+  mariadb_st_fetch_columns and replace their arrays by empty strings
+*/
+static bool packed_columns_init(pTHX_ imp_sth_t *imp_sth, AV *columns_av, unsigned int num_fields, char *kind, SV **scratch)
+{
+  unsigned int i;
+  MYSQL_FIELD *fields;
 
-      return Nullav;
+  fields = mysql_fetch_fields(imp_sth->result);
+  for (i = 0; i < num_fields && i < mysql_num_fields(imp_sth->result); ++i)
+  {
+    switch (mysql_field_conv(&fields[i])) {
+    case MARIADB_CONV_INTEGER:
+    case MARIADB_CONV_UNSIGNED:
+      kind[i] = 'j';
+      break;
+    case MARIADB_CONV_DOUBLE:
+      kind[i] = 'd';
+      break;
+    default:
+      continue;
     }
+    scratch[i] = newSV(0);
+    av_store(columns_av, i, newSVpvs(""));
+  }
+  return TRUE;
+}
 
-process:
-    imp_sth->currow++;
+/**************************************************************************
+ *
+ *  Name:    mariadb_st_fetch_columns
+ *
+ *  Purpose: Fetch up to max_rows rows in one call and store values
+ *           directly into arrays of columns, so no per row array is
+ *           created; integer and floating point columns can be packed
+ *           into one string per column
+ *
+ *  Input:   sth - statement handle being fetched
+ *           imp_sth - drivers private statement handle data
+ *           max_rows - maximal number of rows, negative for all rows
+ *           pack - pack integer columns as IVs and floating point
+ *               columns as doubles
+ *
+ *  Returns: mortal reference to array of column array references or
+ *           packed strings; undef when max_rows is positive and
+ *           statement is not active
+ *
+ **************************************************************************/
 
-    if (imp_sth->currow >= imp_sth->row_num)
-      DBIc_ACTIVE_off(imp_sth);
+SV *
+mariadb_st_fetch_columns(SV *sth, imp_sth_t* imp_sth, IV max_rows, bool pack)
+{
+  dTHX;
+  unsigned int i, num_fields, row_fields;
+  AV *columns_av;
+  SV **columns;
+  SV **row;
+  SV **scratch;
+  char *kind;
+  bool kind_known;
+  AV *av;
+  IV rows;
+  D_imp_xxh(sth);
 
-    av= DBIc_DBISTATE(imp_sth)->get_fbav(imp_sth);
-    num_fields=mysql_stmt_field_count(imp_sth->stmt);
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-                    "\t\tmariadb_st_fetch called mysql_fetch, rc %d num_fields %u\n",
-                    rc, num_fields);
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t-> mariadb_st_fetch_columns, max_rows %" IVdf ", pack %d\n", max_rows, pack ? 1 : 0);
 
-    rebind_result = FALSE;
-    for (
-         buffer= imp_sth->buffer,
-         fbh= imp_sth->fbh,
-         i= 0;
-         i < num_fields;
-         i++,
-         fbh++,
-         buffer++
-        )
-    {
-        /* In case of BLOB/TEXT fields we allocate only few bytes
-           in mariadb_st_describe() for data. Here we know real size of field
-           so we should increase buffer size and refetch column value
-        */
-        if (!fbh->is_null && mysql_type_needs_allocated_buffer(buffer->buffer_type) && (fbh->length > buffer->buffer_length || fbh->error))
-        {
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),
-              "\t\tRefetch BLOB/TEXT column: %d, length: %lu, error: %d\n",
-              i, fbh->length, fbh->error ? 1 : 0);
+  /* Same as mariadb_st_fetch_chunk */
+  if (!DBIc_ACTIVE(imp_sth) && max_rows > 0)
+    return &PL_sv_undef;
 
-          Renew(fbh->data, fbh->length, char);
-          buffer->buffer_length= fbh->length;
-          buffer->buffer= (char *) fbh->data;
+  num_fields = DBIc_NUM_FIELDS(imp_sth) > 0 ? DBIc_NUM_FIELDS(imp_sth) : 0;
 
-          /* We invalidated fbh->data, therefore we must call mysql_stmt_bind_result()
-           * prior exiting this function. But we cannot call mysql_stmt_bind_result()
-           * before all remaining mysql_stmt_fetch_column() calls because we would get
-           * again truncated data. */
-          rebind_result = TRUE;
+  columns_av = newAV();
+  sv_2mortal((SV *)columns_av);
+  if (num_fields > 0)
+    av_extend(columns_av, num_fields-1);
+  for (i = 0; i < num_fields; ++i)
+    av_push(columns_av, newRV_noinc((SV *)newAV()));
 
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2) {
-            char *ptr = (char*)buffer->buffer;
-            unsigned long int j, m;
-            m = buffer->buffer_length;
-            if (m > *buffer->length)
-              m = *buffer->length;
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),"\t\tbefore buffer->buffer: ");
-            for (j = 0; j < m; j++) {
-              PerlIO_printf(DBIc_LOGPIO(imp_xxh), "%c", *ptr++);
-            }
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),"\n");
-          }
+  Newx(row, num_fields ? num_fields : 1, SV *);
+  Newxz(kind, num_fields ? num_fields : 1, char);
+  Newxz(scratch, num_fields ? num_fields : 1, SV *);
+  columns = AvARRAY(columns_av);
+  kind_known = !pack;
+  rows = 0;
 
-          /*TODO: Use offset instead of 0 to fetch only remain part of data*/
-          if (mysql_stmt_fetch_column(imp_sth->stmt, buffer , i, 0))
-          {
-            mariadb_dr_do_error(sth, mysql_stmt_errno(imp_sth->stmt),
-                     mysql_stmt_error(imp_sth->stmt),
-                     mysql_stmt_sqlstate(imp_sth->stmt));
-            mysql_stmt_bind_result(imp_sth->stmt, imp_sth->buffer);
-            return Nullav;
-          }
+  /* Column types are known from result metadata, for async query after first fetch */
+  if (!kind_known && imp_sth->result)
+    kind_known = packed_columns_init(aTHX_ imp_sth, columns_av, num_fields, kind, scratch);
 
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2) {
-            char *ptr = (char*)buffer->buffer;
-            unsigned long int j, m;
-            m = buffer->buffer_length;
-            if (m > *buffer->length)
-              m = *buffer->length;
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),"\t\tafter buffer->buffer: ");
-            for (j = 0; j < m; j++) {
-              PerlIO_printf(DBIc_LOGPIO(imp_xxh), "%c", *ptr++);
-            }
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh),"\n");
-          }
-        }
+  while (max_rows < 0 || max_rows-- > 0)
+  {
+    if (mariadb_st_fetch_next(sth, imp_sth, &row_fields) <= 0)
+      break;
+
+    if (row_fields != num_fields)
+    {
+      mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "Number of columns in row does not match NUM_OF_FIELDS", "HY000");
+      break;
     }
 
-    if (rebind_result)
+    if (!kind_known)
+      kind_known = packed_columns_init(aTHX_ imp_sth, columns_av, num_fields, kind, scratch);
+
+    for (i = 0; i < num_fields; ++i)
+      row[i] = kind[i] ? scratch[i] : newSV(0);
+
+    mariadb_st_store_row(sth, imp_sth, row, num_fields);
+
+    for (i = 0; i < num_fields; ++i)
     {
-      if (mysql_stmt_bind_result(imp_sth->stmt, imp_sth->buffer))
+      if (!kind[i])
       {
-        mariadb_dr_do_error(sth, mysql_stmt_errno(imp_sth->stmt), mysql_stmt_error(imp_sth->stmt), mysql_stmt_sqlstate(imp_sth->stmt));
-        return Nullav;
+        av_push((AV *)SvRV(columns[i]), row[i]);
+        continue;
       }
+
+      if (packed_column_append(aTHX_ columns[i], kind[i], row[i]))
+        continue;
+
+      /* Value cannot be packed (e.g. NULL), return column as array */
+      av = packed_column_to_av(aTHX_ columns[i], kind[i]);
+      av_push(av, newSVsv(row[i]));
+      av_store(columns_av, i, newRV_noinc((SV *)av));
+      SvREFCNT_dec(scratch[i]);
+      scratch[i] = NULL;
+      kind[i] = 0;
     }
 
-    for (
-         buffer= imp_sth->buffer,
-         fbh= imp_sth->fbh,
-         i= 0;
-         i < num_fields;
-         i++,
-         fbh++,
-         buffer++
-        )
-    {
-      SV *sv= AvARRAY(av)[i]; /* Note: we (re)use the SV in the AV	*/
-      STRLEN len;
+    rows++;
+  }
 
-      if (fbh->is_null)
-        (void) SvOK_off(sv);  /*  Field is NULL, return undef  */
-      else
-      {
-        switch (buffer->buffer_type) {
-        case MYSQL_TYPE_TINY:
-        case MYSQL_TYPE_SHORT:
-        case MYSQL_TYPE_LONG:
-#if IVSIZE >= 8
-        case MYSQL_TYPE_LONGLONG:
-#endif
-          switch (buffer->buffer_type) {
-          case MYSQL_TYPE_TINY:
-            if (buffer->is_unsigned)
-              int_val= (unsigned char)fbh->numeric_val.tval;
-            else
-              int_val= (signed char)fbh->numeric_val.tval;
-            int_type= "TINY INT";
-            break;
+  for (i = 0; i < num_fields; ++i)
+  {
+    if (scratch[i])
+      SvREFCNT_dec(scratch[i]);
+  }
+  Safefree(scratch);
+  Safefree(kind);
+  Safefree(row);
 
-          case MYSQL_TYPE_SHORT:
-            if (buffer->is_unsigned)
-              int_val= (unsigned short)fbh->numeric_val.sval;
-            else
-              int_val= (signed short)fbh->numeric_val.sval;
-            int_type= "SHORT INT";
-            break;
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_fetch_columns, %" IVdf " rows\n", rows);
 
-          case MYSQL_TYPE_LONG:
-            if (buffer->is_unsigned)
-              int_val= (uint32_t)fbh->numeric_val.lval;
-            else
-              int_val= (int32_t)fbh->numeric_val.lval;
-            int_type= "LONG INT";
-            break;
+  return sv_2mortal(newRV_inc((SV *)columns_av));
+}
 
-#if IVSIZE >= 8
-          case MYSQL_TYPE_LONGLONG:
-            if (buffer->is_unsigned)
-              int_val= fbh->numeric_val.llval;
-            else
-              int_val= fbh->numeric_val.llval;
-            int_type= "LONGLONG INT";
-            break;
-#endif
-          default:
-            NOT_REACHED;
-            int_val = 0;
-            int_type = "";
-            break;
-          }
+/*
+  Returns value of statement attribute in the same way as DBI's FETCH,
+  without creating the attribute in the handle hash
+*/
+static SV *fetch_sth_attrib(pTHX_ SV *sth, imp_sth_t *imp_sth, const char *key, STRLEN len)
+{
+  SV *keysv = sv_2mortal(newSVpvn(key, len));
+  SV *valuesv = mariadb_st_FETCH_attrib(sth, imp_sth, keysv);
+  if (!valuesv)
+    valuesv = DBIc_DBISTATE(imp_sth)->get_attr_k(sth, keysv, 0);
+  return valuesv;
+}
 
-          if (buffer->is_unsigned)
-            sv_setuv(sv, (UV)int_val);
-          else
-            sv_setiv(sv, (IV)int_val);
+/*
+  Returns name of attribute with column names used as hash keys, keyattrib
+  when it is set, otherwise value of FetchHashKeyName
+*/
+static const char *hash_key_attrib(pTHX_ SV *sth, imp_sth_t *imp_sth, const char *keyattrib)
+{
+  SV *sv;
 
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-          {
-            if (buffer->is_unsigned)
-              PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tst_fetch AN UNSIGNED %s NUMBER %"UVuf"\n",
-                            int_type, (UV)int_val);
-            else
-              PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tst_fetch A SIGNED %s NUMBER %"IVdf"\n",
-                            int_type, (IV)int_val);
-          }
-          break;
+  if (keyattrib && *keyattrib)
+    return keyattrib;
 
-#if IVSIZE < 8
-        case MYSQL_TYPE_LONGLONG:
-          {
-            char buf[64];
-            STRLEN len = sizeof(buf);
-            char *ptr;
+  sv = fetch_sth_attrib(aTHX_ sth, imp_sth, STR_WITH_LEN("FetchHashKeyName"));
+  return (sv && SvOK(sv)) ? SvPV_nolen(sv) : "NAME";
+}
 
-            if (buffer->is_unsigned)
-              ptr = my_ulonglong2str(fbh->numeric_val.llval, buf, &len);
-            else
-              ptr = signed_my_ulonglong2str(fbh->numeric_val.llval, buf, &len);
+/*
+  Returns column names of attribute keyattrib with precomputed hashes,
+  cached for the current result set
+*/
+static mariadb_hash_keys_t *get_hash_keys(pTHX_ SV *sth, imp_sth_t *imp_sth, const char *keyattrib, unsigned int num_fields)
+{
+  mariadb_hash_keys_t *keys;
+  SV **svp;
+  SV *sv;
+  AV *names;
+  char *pv;
+  STRLEN len;
+  unsigned int i;
 
-            SvUTF8_off(sv);
-            sv_setpvn(sv, ptr, len);
+  keys = imp_sth->hash_keys;
+  if (keys && strEQ(keys->attrib, keyattrib) && keys->count == num_fields)
+    return keys;
 
-            if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-              PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tst_fetch %s LONGLONG INT NUMBER %s\n",
-                            (buffer->is_unsigned ? "AN UNSIGNED" : "A SIGNED"), ptr);
-          }
-          break;
-#endif
+  free_hash_keys(aTHX_ imp_sth);
 
-        case MYSQL_TYPE_FLOAT:
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tst_fetch A FLOAT NUMBER %f\n", fbh->numeric_val.fval);
-          sv_setnv(sv, fbh->numeric_val.fval);
-          break;
+  sv = fetch_sth_attrib(aTHX_ sth, imp_sth, keyattrib, strlen(keyattrib));
+  if (!sv || !SvROK(sv) || SvTYPE(SvRV(sv)) != SVt_PVAV)
+  {
+    sv = sv_2mortal(newSVpvf("Attribute %s is not an array of column names", keyattrib));
+    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, SvPVX(sv), "HY000");
+    return NULL;
+  }
 
-        case MYSQL_TYPE_DOUBLE:
-          if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-            PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tst_fetch A DOUBLE NUMBER %f\n", fbh->numeric_val.dval);
-          sv_setnv(sv, fbh->numeric_val.dval);
-          break;
+  names = (AV *)SvRV(sv);
+  if ((unsigned int)(av_len(names)+1) != num_fields)
+  {
+    sv = sv_2mortal(newSVpvf("Number of names in attribute %s does not match number of columns", keyattrib));
+    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, SvPVX(sv), "HY000");
+    return NULL;
+  }
 
-        /* TODO: datetime structures */
-  #if 0
-        case MYSQL_TYPE_TIME:
-        case MYSQL_TYPE_DATE:
-        case MYSQL_TYPE_DATETIME:
-        case MYSQL_TYPE_TIMESTAMP:
-          break;
-  #endif
+  Newxz(keys, 1, mariadb_hash_keys_t);
+  keys->attrib = savepv(keyattrib);
+  keys->names = newAV();
+  keys->count = num_fields;
+  Newx(keys->key, num_fields ? num_fields : 1, const char *);
+  Newx(keys->klen, num_fields ? num_fields : 1, I32);
+  Newx(keys->hash, num_fields ? num_fields : 1, U32);
+  Newx(keys->row, num_fields ? num_fields : 1, SV *);
+  imp_sth->hash_keys = keys;
 
-        case MYSQL_TYPE_NULL:
-          (void) SvOK_off(sv);  /*  Field is NULL, return undef  */
-          break;
+  for (i = 0; i < num_fields; ++i)
+  {
+    svp = av_fetch(names, i, FALSE);
+    sv = newSVsv(svp ? *svp : &PL_sv_undef);
+    av_push(keys->names, sv);
 
-        default:
-          /* TEXT columns can be returned as MYSQL_TYPE_BLOB, so always check for charset */
-          len= fbh->length;
-	  /* ChopBlanks server-side prepared statement */
-          if (ChopBlanks)
-          {
-            if (fbh->is_utf8)
-              while (len && fbh->data[len-1] == ' ') { --len; }
-          }
-	  /* END OF ChopBlanks */
+    /* Hash of UTF-8 key is valid only for its canonical form */
+    if (SvUTF8(sv))
+      sv_utf8_downgrade(sv, TRUE);
 
-          SvUTF8_off(sv);
-          sv_setpvn(sv, fbh->data, len);
-          if (fbh->is_utf8)
-            sv_utf8_decode(sv);
-          break;
-        }
-      }
-    }
+    pv = SvPV(sv, len);
+    keys->key[i] = pv;
+    keys->klen[i] = SvUTF8(sv) ? -(I32)len : (I32)len;
+    PERL_HASH(keys->hash[i], pv, len);
+  }
 
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_fetch, %u cols\n", num_fields);
+  return keys;
+}
 
-    return av;
+/*
+  Fetches next row into keys->row, either directly into new scalars or
+  for statements with bound columns via DBI's row buffer. Keys are
+  resolved from attribute keyattrib after the first fetch when *keysp is
+  NULL and reused for next rows of the same call
+  Returns number of columns, 0 at the end of rows and -1 on error
+*/
+static int fetch_hash_row(pTHX_ SV *sth, imp_sth_t *imp_sth, const char *keyattrib, mariadb_hash_keys_t **keysp)
+{
+  mariadb_hash_keys_t *keys;
+  unsigned int i, num_fields;
+  AV *av = Nullav;
+  int rc;
+
+  /* Bound scalars are aliased into DBI's row buffer and have to be updated too */
+  if (imp_sth->bind_col_count)
+  {
+    av = mariadb_st_fetch(sth, imp_sth);
+    if (!av)
+      return DBIc_ERR(imp_sth) && SvTRUE(DBIc_ERR(imp_sth)) ? -1 : 0;
+    num_fields = av_len(av)+1;
   }
   else
   {
-    imp_sth->currow++;
+    rc = mariadb_st_fetch_next(sth, imp_sth, &num_fields);
+    if (rc <= 0)
+      return rc;
+  }
 
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+  /* Column names are available after first fetch of asynchronous query */
+  keys = *keysp;
+  if (!keys)
+  {
+    keys = get_hash_keys(aTHX_ sth, imp_sth, keyattrib, num_fields);
+    if (!keys)
+      return -1;
+    *keysp = keys;
+  }
+
+  if (av)
+  {
+    for (i = 0; i < num_fields; ++i)
+      keys->row[i] = newSVsv(AvARRAY(av)[i]);
+  }
+  else
+  {
+    for (i = 0; i < num_fields; ++i)
+      keys->row[i] = newSV(0);
+    mariadb_st_store_row(sth, imp_sth, keys->row, num_fields);
+  }
+
+  return num_fields > 0 ? (int)num_fields : 1;
+}
+
+/* Stores values of fetched row into hash, ownership of values is taken */
+static void store_hash_row(pTHX_ HV *hv, mariadb_hash_keys_t *keys)
+{
+  unsigned int i;
+
+  for (i = 0; i < keys->count; ++i)
+    (void)hv_store(hv, keys->key[i], keys->klen[i], keys->row[i], keys->hash[i]);
+}
+
+/***************************************************************************
+ *
+ *  Name:    mariadb_st_fetchrow_hashref
+ *
+ *  Purpose: Driver implementation of fetchrow_hashref; names of columns
+ *           and their hashes are computed once per result set and row
+ *           values are stored into the hash without copying
+ *
+ *  Input:   sth - statement handle being fetched
+ *           imp_sth - drivers private statement handle data
+ *           keyattrib - attribute with names of columns, NULL for
+ *                       FetchHashKeyName
+ *
+ *  Returns: mortal reference to hash of row values; undef when there
+ *           are no more rows or on error
+ *
+ **************************************************************************/
+
+SV *
+mariadb_st_fetchrow_hashref(SV *sth, imp_sth_t* imp_sth, const char *keyattrib)
+{
+  dTHX;
+  mariadb_hash_keys_t *keys = NULL;
+  HV *hv;
+  D_imp_xxh(sth);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t-> mariadb_st_fetchrow_hashref\n");
+
+  keyattrib = hash_key_attrib(aTHX_ sth, imp_sth, keyattrib);
+  if (fetch_hash_row(aTHX_ sth, imp_sth, keyattrib, &keys) <= 0)
+    return &PL_sv_undef;
+
+  hv = newHV();
+  hv_ksplit(hv, keys->count);
+  store_hash_row(aTHX_ hv, keys);
+
+  return sv_2mortal(newRV_noinc((SV *)hv));
+}
+
+/*
+  Resolves key fields of fetchall_hashref to column indexes, either by
+  name or by column number starting from 1
+*/
+static bool find_hash_key_fields(pTHX_ SV *sth, mariadb_hash_keys_t *keys, SV **fields, unsigned int num_key_fields, unsigned int *index)
+{
+  unsigned int i, j;
+  SV *field;
+  SV *msg;
+  IV num;
+
+  for (i = 0; i < num_key_fields; ++i)
+  {
+    field = fields[i] ? fields[i] : &PL_sv_undef;
+
+    /* Same as DBI's NAME_hash, last column with given name wins */
+    for (j = keys->count; j > 0; --j)
     {
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tmariadb_st_fetch result set details\n");
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\timp_sth->result=%p\n", imp_sth->result);
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tmysql_num_fields=%u\n",
-                    mysql_num_fields(imp_sth->result));
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tmysql_num_rows=%" SVf "\n",
-                    SVfARG(sv_2mortal(my_ulonglong2sv(mysql_num_rows(imp_sth->result)))));
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tmysql_affected_rows=%" SVf "\n",
-                    SVfARG(sv_2mortal(my_ulonglong2sv(mysql_affected_rows(imp_dbh->pmysql)))));
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tmariadb_st_fetch for %p, currow=%" SVf "\n",
-                    sth, SVfARG(sv_2mortal(my_ulonglong2sv(imp_sth->currow))));
+      if (sv_eq(AvARRAY(keys->names)[j-1], field))
+        break;
     }
 
-    if (!(cols= mysql_fetch_row(imp_sth->result)))
+    if (j > 0)
     {
-      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      {
-        PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tmariadb_st_fetch, no more rows to fetch\n");
-      }
-      if (mysql_errno(imp_dbh->pmysql))
-        mariadb_dr_do_error(sth, mysql_errno(imp_dbh->pmysql),
-                 mysql_error(imp_dbh->pmysql),
-                 mysql_sqlstate(imp_dbh->pmysql));
-      else if (imp_sth->row_num == (my_ulonglong)-2)
-        imp_sth->row_num = mysql_num_rows(imp_sth->result);
-      if (!mysql_more_results(imp_dbh->pmysql))
-        DBIc_ACTIVE_off(imp_sth);
-      return Nullav;
+      index[i] = j-1;
+      continue;
     }
 
-    if (imp_sth->currow >= imp_sth->row_num && !mysql_more_results(imp_dbh->pmysql))
-      DBIc_ACTIVE_off(imp_sth);
+    if (SvOK(field) && looks_like_number(field) && (num = SvIV(field)) >= 1 && (UV)num <= keys->count)
+    {
+      index[i] = num-1;
+      continue;
+    }
 
-    num_fields= mysql_num_fields(imp_sth->result);
-    fields= mysql_fetch_fields(imp_sth->result);
-    lengths= mysql_fetch_lengths(imp_sth->result);
+    msg = sv_2mortal(newSVpvf("Field '%" SVf "' does not exist (not one of", SVfARG(field)));
+    for (j = 0; j < keys->count; ++j)
+      sv_catpvf(msg, " %" SVf, SVfARG(AvARRAY(keys->names)[j]));
+    sv_catpvs(msg, ")");
+    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, SvPV_nolen(msg), "HY000");
+    return FALSE;
+  }
 
-    if ((av= DBIc_FIELDS_AV(imp_sth)) != Nullav)
-    {
-      av_length= av_len(av)+1;
+  return TRUE;
+}
 
-      if (av_length != num_fields)              /* Resize array if necessary */
-      {
-        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-          PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_fetch, size of results array(%u) != num_fields(%u)\n",
-                                   av_length, num_fields);
+/***************************************************************************
+ *
+ *  Name:    mariadb_st_fetchall_hashref
+ *
+ *  Purpose: Driver implementation of fetchall_hashref; fetches all rows
+ *           into hashes nested by values of key fields, names of columns
+ *           and their hashes are computed once per result set
+ *
+ *  Input:   sth - statement handle being fetched
+ *           imp_sth - drivers private statement handle data
+ *           key_field - name or number of key column, or reference to
+ *                       array of them
+ *
+ *  Returns: mortal reference to hash of rows; undef on error
+ *
+ **************************************************************************/
 
-        if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-          PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_fetch, result fields(%d)\n",
-                                   DBIc_NUM_FIELDS(imp_sth));
+SV *
+mariadb_st_fetchall_hashref(SV *sth, imp_sth_t* imp_sth, SV *key_field)
+{
+  dTHX;
+  mariadb_hash_keys_t *keys = NULL;
+  unsigned int i, num_key_fields;
+  unsigned int *index;
+  SV **fields;
+  HV *rows_hv;
+  HV *hv;
+  HE *he;
+  SV *entry;
+  const char *keyattrib;
+  int rc;
+  bool resolved = FALSE;
+  bool failed = FALSE;
+  D_imp_xxh(sth);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t-> mariadb_st_fetchall_hashref\n");
 
-        av_readonly = SvREADONLY(av) ? TRUE : FALSE;
+  if (SvROK(key_field) && SvTYPE(SvRV(key_field)) == SVt_PVAV)
+  {
+    num_key_fields = av_len((AV *)SvRV(key_field))+1;
+    fields = AvARRAY((AV *)SvRV(key_field));
+  }
+  else
+  {
+    num_key_fields = 1;
+    fields = &key_field;
+  }
 
-        if (av_readonly)
-          SvREADONLY_off( av );              /* DBI sets this readonly */
+  rows_hv = newHV();
+  sv_2mortal((SV *)rows_hv);
+  Newx(index, num_key_fields ? num_key_fields : 1, unsigned int);
 
-        while (av_length < num_fields)
-        {
-          av_store(av, av_length++, newSV(0));
-        }
+  /* Names of key attribute and keys are resolved only once for all rows */
+  keyattrib = hash_key_attrib(aTHX_ sth, imp_sth, NULL);
 
-        while (av_length > num_fields)
-        {
-          SvREFCNT_dec(av_pop(av));
-          av_length--;
-        }
-        if (av_readonly)
-          SvREADONLY_on(av);
+  do
+  {
+    /* Temporaries created by fetching of row do not accumulate for all rows */
+    ENTER;
+    SAVETMPS;
+
+    rc = fetch_hash_row(aTHX_ sth, imp_sth, keyattrib, &keys);
+    if (rc > 0 && !resolved)
+    {
+      if (find_hash_key_fields(aTHX_ sth, keys, fields, num_key_fields, index))
+      {
+        resolved = TRUE;
+      }
+      else
+      {
+        for (i = 0; i < keys->count; ++i)
+          SvREFCNT_dec(keys->row[i]);
+        failed = TRUE;
       }
     }
 
-    av= DBIc_DBISTATE(imp_sth)->get_fbav(imp_sth);
-
-    for (i= 0;  i < num_fields; ++i)
+    if (rc > 0 && !failed)
     {
-      char *col= cols[i];
-      SV *sv= AvARRAY(av)[i]; /* Note: we (re)use the SV in the AV	*/
-
-      if (col)
+      hv = rows_hv;
+      for (i = 0; i < num_key_fields; ++i)
       {
-        STRLEN len= lengths[i];
-        if (ChopBlanks)
+        he = hv_fetch_ent(hv, keys->row[index[i]], TRUE, 0);
+        entry = HeVAL(he);
+        if (!SvROK(entry) || SvTYPE(SvRV(entry)) != SVt_PVHV)
         {
-          if (mysql_charsetnr_is_utf8(fields[i].charsetnr))
-          while (len && col[len-1] == ' ')
-          {	--len; }
+          SvREFCNT_dec(entry);
+          HeVAL(he) = entry = newRV_noinc((SV *)newHV());
+          hv_ksplit((HV *)SvRV(entry), keys->count);
         }
+        hv = (HV *)SvRV(entry);
+      }
 
-        /* Set string value returned from mysql server */
-        SvUTF8_off(sv);
-        sv_setpvn(sv, col, len);
-
-        switch (mysql_to_perl_type(fields[i].type)) {
-        case PERL_TYPE_NUMERIC:
-          if (!mysql_field_needs_string_type(&fields[i]))
-          {
-            /* Coerce to double and set scalar as NV */
-            sv_setnv(sv, SvNV(sv));
-          }
-          break;
+      store_hash_row(aTHX_ hv, keys);
+    }
 
-        case PERL_TYPE_INTEGER:
-          if (!mysql_field_needs_string_type(&fields[i]))
-          {
-            /* Coerce to integer and set scalar as UV resp. IV */
-            if (fields[i].flags & UNSIGNED_FLAG)
-              sv_setuv(sv, SvUV_nomg(sv));
-            else
-              sv_setiv(sv, SvIV_nomg(sv));
-          }
-          break;
+    FREETMPS;
+    LEAVE;
+  } while (rc > 0 && !failed);
 
-        case PERL_TYPE_UNDEF:
-          /* Field is NULL, return undef */
-          (void) SvOK_off(sv);
-          break;
+  if (failed)
+  {
+    Safefree(index);
+    return &PL_sv_undef;
+  }
 
-        default:
-          /* TEXT columns can be returned as MYSQL_TYPE_BLOB, so always check for charset */
-          if (mysql_charsetnr_is_utf8(fields[i].charsetnr))
-            sv_utf8_decode(sv);
-          break;
-        }
-      }
-      else
-        (void) SvOK_off(sv);  /*  Field is NULL, return undef  */
+  /* Key fields are checked also for empty result set */
+  if (!resolved && rc == 0)
+  {
+    keys = get_hash_keys(aTHX_ sth, imp_sth, keyattrib, DBIc_NUM_FIELDS(imp_sth) > 0 ? DBIc_NUM_FIELDS(imp_sth) : 0);
+    if (!keys || !find_hash_key_fields(aTHX_ sth, keys, fields, num_key_fields, index))
+    {
+      Safefree(index);
+      return &PL_sv_undef;
     }
-
-    if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
-      PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_fetch, %u cols\n", num_fields);
-    return av;
   }
 
+  Safefree(index);
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t<- mariadb_st_fetchall_hashref\n");
+
+  return sv_2mortal(newRV_inc((SV *)rows_hv));
 }
 
 /***************************************************************************
@@ -5716,10 +8817,7 @@ void mariadb_st_destroy(SV *sth, imp_sth_t *imp_sth) {
   D_imp_xxh(sth);
 
   int i;
-
-  imp_sth_fbh_t *fbh;
   int num_params;
-  int num_fields;
 
   if (!PL_dirty)
   {
@@ -5731,47 +8829,59 @@ void mariadb_st_destroy(SV *sth, imp_sth_t *imp_sth) {
 
   DBIc_ACTIVE_off(imp_sth);
 
-  if (imp_sth->statement)
-    Safefree(imp_sth->statement);
-
   num_params = DBIc_NUM_PARAMS(imp_sth);
   if (num_params > 0)
   {
     if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
       PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\tFreeing %d parameters, bind %p fbind %p\n",
           num_params, imp_sth->bind, imp_sth->fbind);
+  }
+
+  free_fbuffer(imp_sth);
 
-    free_bind(imp_sth->bind);
-    free_fbind(imp_sth->fbind);
+  if (imp_sth->placeholders)
+  {
+    Safefree(imp_sth->placeholders);
+    imp_sth->placeholders= NULL;
   }
 
-  fbh= imp_sth->fbh;
-  if (fbh)
+  if (imp_sth->statement_buffer)
   {
-    num_fields = DBIc_NUM_FIELDS(imp_sth);
-    i = 0;
-    while (i < num_fields)
-    {
-      if (fbh[i].data) Safefree(fbh[i].data);
-      ++i;
-    }
+    Safefree(imp_sth->statement_buffer);
+    imp_sth->statement_buffer= NULL;
+    imp_sth->statement_buffer_size= 0;
+  }
 
-    free_fbuffer(fbh);
-    if (imp_sth->buffer)
-      free_bind(imp_sth->buffer);
+  if (imp_sth->conv)
+  {
+    Safefree(imp_sth->conv);
+    imp_sth->conv= NULL;
+  }
+
+  if (imp_sth->bind_col_type)
+  {
+    Safefree(imp_sth->bind_col_type);
+    imp_sth->bind_col_type= NULL;
+    imp_sth->bind_col_count= 0;
   }
 
   if (imp_sth->stmt)
   {
-    mysql_stmt_close(imp_sth->stmt);
+    if (PL_dirty || !mariadb_db_stmt_cache_put(aTHX_ (imp_dbh_t *)DBIc_PARENT_COM(imp_sth), imp_sth->statement, imp_sth->statement_len, imp_sth->stmt))
+      mysql_stmt_close(imp_sth->stmt);
     imp_sth->stmt= NULL;
   }
 
-  /* Free values allocated by mariadb_st_bind_ph */
+  if (imp_sth->statement)
+    Safefree(imp_sth->statement);
+
+  /* Free values allocated by mariadb_st_bind_ph, bind and fbind are part of params allocation */
   if (imp_sth->params)
   {
     free_param(aTHX_ imp_sth->params, num_params);
     imp_sth->params= NULL;
+    imp_sth->bind= NULL;
+    imp_sth->fbind= NULL;
   }
 
   /* Free cached array attributes */
@@ -5781,6 +8891,7 @@ void mariadb_st_destroy(SV *sth, imp_sth_t *imp_sth) {
       SvREFCNT_dec(imp_sth->av_attr[i]);
     imp_sth->av_attr[i]= Nullav;
   }
+  free_hash_keys(aTHX_ imp_sth);
   /* let DBI know we've done it   */
   DBIc_IMPSET_off(imp_sth);
 }
@@ -5827,6 +8938,37 @@ mariadb_st_STORE_attrib(
     imp_sth->use_mysql_use_result= SvTRUE_nomg(valuesv);
     retval = 1;
   }
+  else if (memEQs(key, kl, "mariadb_cursor_prefetch"))
+  {
+    UV uv = SvOK(valuesv) ? SvUV_nomg(valuesv) : 0;
+    imp_sth->cursor_prefetch = (uv <= ULONG_MAX) ? uv : ULONG_MAX;
+    retval = 1;
+  }
+  else if (memEQs(key, kl, "mariadb_statement_buffer_max"))
+  {
+    UV uv = SvOK(valuesv) ? SvUV_nomg(valuesv) : 0;
+    imp_sth->statement_buffer_max = (uv <= (UV)SSize_t_MAX) ? uv : (UV)SSize_t_MAX;
+    if (imp_sth->statement_buffer_size > imp_sth->statement_buffer_max)
+    {
+      Safefree(imp_sth->statement_buffer);
+      imp_sth->statement_buffer= NULL;
+      imp_sth->statement_buffer_size= 0;
+    }
+    retval = 1;
+  }
+  else if (memEQs(key, kl, "mariadb_temporal_mode"))
+  {
+    retval = parse_temporal_mode(aTHX_ sth, valuesv, &imp_sth->temporal_mode) ? 1 : 0;
+  }
+  else if (memEQs(key, kl, "mariadb_decimal_mode"))
+  {
+    retval = parse_decimal_mode(aTHX_ sth, valuesv, &imp_sth->decimal_mode) ? 1 : 0;
+  }
+  else if (memEQs(key, kl, "LongReadLen"))
+  {
+    /* Value is stored by DBI, only remember that it was set */
+    imp_sth->long_read_len_set = TRUE;
+  }
   else
   {
     if (!skip_attribute(key)) /* Not handled by this driver */
@@ -6066,9 +9208,12 @@ SV* mariadb_st_FETCH_attrib(
             for (i = 0; i < DBIc_NUM_PARAMS(imp_sth); i++)
             {
                 keylen = sprintf(key, "%d", i);
-                sv = newSVpvn(imp_sth->params[i].value, imp_sth->params[i].len);
-                if (!sql_type_is_binary(imp_sth->params[i].type))
-                  sv_utf8_decode(sv);
+                if (imp_sth->params[i].is_int)
+                  sv = imp_sth->params[i].int_is_unsigned ? newSVuv((UV)imp_sth->params[i].int_val) : newSViv(imp_sth->params[i].int_val);
+                else if (imp_sth->params[i].sv)
+                  sv = newSVsv(imp_sth->params[i].sv);
+                else
+                  sv = newSV(0);
                 (void)hv_store(pvhv, key, keylen, sv, 0);
             }
         }
@@ -6115,6 +9260,14 @@ SV* mariadb_st_FETCH_attrib(
         retsv= ST_FETCH_AV(AV_ATTRIB_MAX_LENGTH);
       else if (memEQs(key, kl, "mariadb_use_result"))
         retsv= boolSV(imp_sth->use_mysql_use_result);
+      else if (memEQs(key, kl, "mariadb_cursor_prefetch"))
+        retsv= sv_2mortal(newSVuv(imp_sth->cursor_prefetch));
+      else if (memEQs(key, kl, "mariadb_statement_buffer_max"))
+        retsv= sv_2mortal(newSVuv(imp_sth->statement_buffer_max));
+      else if (memEQs(key, kl, "mariadb_temporal_mode"))
+        retsv= temporal_mode_sv(aTHX_ imp_sth->temporal_mode);
+      else if (memEQs(key, kl, "mariadb_decimal_mode"))
+        retsv= decimal_mode_sv(aTHX_ imp_sth->decimal_mode);
       else if (memEQs(key, kl, "mariadb_warning_count"))
         retsv= sv_2mortal(newSVuv(imp_sth->warning_count));
       else if (memEQs(key, kl, "mariadb_server_prepare"))
@@ -6153,20 +9306,22 @@ SV *mariadb_st_last_insert_id(SV *sth, imp_sth_t *imp_sth,
  *
  *  Name:    mariadb_st_blob_read
  *
- *  Purpose: Used for blob reads if the statement handles "LongTruncOk"
- *           attribute (currently not supported by DBD::MariaDB)
+ *  Purpose: Reads part of BLOB/TEXT column from the current row, used
+ *           for incremental reads of large values, e.g. when they were
+ *           truncated by "LongReadLen" with "LongTruncOk" enabled
  *
  *  Input:   SV* - statement handle from which a blob will be fetched
  *           imp_sth - drivers private statement handle data
- *           field - field number of the blob (note, that a row may
- *               contain more than one blob)
+ *           field - field number of the blob, starting from 0 (note,
+ *               that a row may contain more than one blob)
  *           offset - the offset of the field, where to start reading
  *           len - maximum number of bytes to read
  *           destrv - RV* that tells us where to store
  *           destoffset - destination offset
  *
  *  Returns: 1 for success, 0 otherwise; mariadb_dr_do_error will
- *           be called in the latter case
+ *           be called in the latter case, except when offset points
+ *           to the end of the value or the value is NULL
  *
  **************************************************************************/
 
@@ -6179,15 +9334,159 @@ int mariadb_st_blob_read (
   SV *destrv,
   long destoffset)
 {
-  PERL_UNUSED_ARG(sth);
-  PERL_UNUSED_ARG(imp_sth);
-  PERL_UNUSED_ARG(field);
-  PERL_UNUSED_ARG(offset);
-  PERL_UNUSED_ARG(len);
-  PERL_UNUSED_ARG(destrv);
-  PERL_UNUSED_ARG(destoffset);
-  mariadb_dr_do_error(sth, CR_NOT_IMPLEMENTED, "blob_read not implemented", "HY000");
-  return 0;
+  dTHX;
+  D_imp_xxh(sth);
+  SV *dest;
+  char *buf;
+  char *col;
+  STRLEN buflen;
+  unsigned long length;
+  unsigned long total;
+  unsigned int num_fields;
+  MYSQL_BIND bind;
+
+  if (offset < 0 || len < 0 || destoffset < 0)
+  {
+    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "blob_read offset and length must not be negative", "HY000");
+    return 0;
+  }
+
+  if (!destrv || !SvROK(destrv))
+  {
+    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "blob_read destination must be a scalar reference", "HY000");
+    return 0;
+  }
+
+  col = NULL;
+
+  if (imp_sth->use_server_side_prepare)
+    num_fields = (imp_sth->stmt && imp_sth->fbh) ? mysql_stmt_field_count(imp_sth->stmt) : 0;
+  else
+    num_fields = (imp_sth->result && imp_sth->current_row) ? mysql_num_fields(imp_sth->result) : 0;
+
+  if (num_fields == 0)
+  {
+    mariadb_dr_do_error(sth, CR_NO_DATA, "blob_read called without fetched row", "HY000");
+    return 0;
+  }
+
+  if (field < 0 || (unsigned int)field >= num_fields)
+  {
+    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "blob_read field number is out of range", "HY000");
+    return 0;
+  }
+
+  if (imp_sth->use_server_side_prepare)
+  {
+    if (!mysql_type_needs_allocated_buffer(imp_sth->buffer[field].buffer_type))
+    {
+      mariadb_dr_do_error(sth, CR_NOT_IMPLEMENTED, "blob_read is supported only for string columns", "HY000");
+      return 0;
+    }
+    if (imp_sth->fbh[field].is_null || (unsigned long)offset >= imp_sth->fbh[field].length)
+      return 0;
+    length = imp_sth->fbh[field].length - offset;
+  }
+  else
+  {
+    col = imp_sth->current_row[field];
+    if (!col || (unsigned long)offset >= mysql_fetch_lengths(imp_sth->result)[field])
+      return 0;
+    length = mysql_fetch_lengths(imp_sth->result)[field] - offset;
+  }
+
+  if (length > (unsigned long)len)
+    length = len;
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                  "\t\tmariadb_st_blob_read field %d, offset %ld, length %lu, destoffset %ld\n",
+                  field, offset, length, destoffset);
+
+  dest = SvRV(destrv);
+  if (!SvOK(dest))
+    sv_setpvn(dest, "", 0);
+  (void)SvPVbyte_force(dest, buflen);
+  if ((STRLEN)destoffset > buflen)
+  {
+    mariadb_dr_do_error(sth, CR_UNKNOWN_ERROR, "blob_read destination offset is beyond end of buffer", "HY000");
+    return 0;
+  }
+  buf = SvGROW(dest, destoffset + length + 1);
+
+  if (imp_sth->use_server_side_prepare)
+  {
+    memset(&bind, 0, sizeof(bind));
+    bind.buffer_type = imp_sth->buffer[field].buffer_type;
+    bind.buffer = buf + destoffset;
+    bind.buffer_length = length;
+    bind.length = &total;
+    if (mysql_stmt_fetch_column(imp_sth->stmt, &bind, field, offset))
+    {
+      mariadb_dr_do_error(sth, mysql_stmt_errno(imp_sth->stmt),
+               mysql_stmt_error(imp_sth->stmt),
+               mysql_stmt_sqlstate(imp_sth->stmt));
+      return 0;
+    }
+  }
+  else
+  {
+    Copy(col + offset, buf + destoffset, length, char);
+  }
+
+  SvCUR_set(dest, destoffset + length);
+  *SvEND(dest) = '\0';
+  (void)SvPOK_only(dest);
+  SvSETMAGIC(dest);
+  return 1;
+}
+
+
+/***************************************************************************
+ *
+ *  Name:    mariadb_st_bind_col
+ *
+ *  Purpose: Remembers TYPE of column bound by bind_col, values of columns
+ *           with numeric TYPE are then stored into bound scalars directly
+ *           as numbers; binding itself is done by DBI
+ *
+ *  Input:   sth - statement handle
+ *           imp_sth - drivers private statement handle data
+ *           col - column number, starting from 1
+ *           ref - reference to bound scalar
+ *           sql_type - TYPE attribute
+ *           attribs - bind attributes
+ *
+ *  Returns: 1 for DBI to bind the scalar
+ *
+ **************************************************************************/
+
+int mariadb_st_bind_col(SV *sth, imp_sth_t *imp_sth, SV *col, SV *ref, IV sql_type, SV *attribs)
+{
+  dTHX;
+  D_imp_xxh(sth);
+  IV idx = SvIV(col);
+  IV num_fields = DBIc_NUM_FIELDS(imp_sth);
+  PERL_UNUSED_ARG(ref);
+  PERL_UNUSED_ARG(attribs);
+
+  /* Invalid column number is reported by DBI */
+  if (idx < 1 || idx > num_fields)
+    return 1;
+
+  if ((unsigned int)num_fields > imp_sth->bind_col_count)
+  {
+    Renew(imp_sth->bind_col_type, num_fields, IV);
+    Zero(imp_sth->bind_col_type + imp_sth->bind_col_count, num_fields - imp_sth->bind_col_count, IV);
+    imp_sth->bind_col_count = num_fields;
+  }
+
+  imp_sth->bind_col_type[idx-1] = sql_type_is_numeric(sql_type) ? sql_type : 0;
+
+  if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+    PerlIO_printf(DBIc_LOGPIO(imp_xxh), "\t\tmariadb_st_bind_col column %" IVdf " sql_type %" IVdf "\n", idx, sql_type);
+
+  return 1;
 }
 
 
@@ -6218,9 +9517,10 @@ int mariadb_st_bind_ph(SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
   IV param_num = SvIV(param); /* needs to process get magic */
   int idx;
   char *err_msg;
+  SV **svp;
+  bool stream = FALSE;
   D_imp_xxh(sth);
   D_imp_dbh_from_sth;
-  PERL_UNUSED_ARG(attribs);
   PERL_UNUSED_ARG(maxlen);
 
   char *buffer= NULL;
@@ -6245,11 +9545,27 @@ int mariadb_st_bind_ph(SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
 
   idx = param_num - 1;
 
+  svp = MARIADB_DR_ATTRIB_GET_SVPS(attribs, "mariadb_stream");
+  if (svp && SvTRUE(*svp))
+  {
+    if (!imp_sth->use_server_side_prepare)
+    {
+      mariadb_dr_do_error(sth, CR_NOT_IMPLEMENTED, "mariadb_stream is supported only with server side prepared statements", "HY000");
+      return 0;
+    }
+    if (!((SvROK(value) && (SvTYPE(SvRV(value)) == SVt_PVCV || SvTYPE(SvRV(value)) == SVt_PVGV || SvTYPE(SvRV(value)) == SVt_PVIO)) || isGV_with_GP(value)))
+    {
+      mariadb_dr_do_error(sth, CR_INVALID_PARAMETER_NO, "Value bound with mariadb_stream must be a filehandle or code reference", "HY000");
+      return 0;
+    }
+    stream = TRUE;
+  }
+
   /*
      This fixes the bug whereby no warning was issued upon binding a
      defined non-numeric as numeric
    */
-  if (SvOK(value) && sql_type_is_numeric(sql_type))
+  if (!stream && SvOK(value) && sql_type_is_numeric(sql_type))
   {
     if (! looks_like_number(value))
     {
@@ -6267,12 +9583,26 @@ int mariadb_st_bind_ph(SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
     return 0;
   }
 
-  bind_param(&imp_sth->params[idx], value, sql_type);
+  if (stream)
+  {
+    bind_param(&imp_sth->params[idx], &PL_sv_undef, sql_type);
+    imp_sth->params[idx].stream = newSVsv(value);
+  }
+  else
+    bind_param(&imp_sth->params[idx], value, sql_type);
 
   if (imp_sth->use_server_side_prepare)
   {
-    buffer_is_null = !imp_sth->params[idx].value;
-    if (!buffer_is_null) {
+    buffer_is_null = !imp_sth->params[idx].value && !imp_sth->params[idx].stream;
+    if (stream)
+    {
+      /* Value is sent by mysql_stmt_send_long_data() before execute */
+      buffer_type = sql_type_is_binary(imp_sth->params[idx].type) ? MYSQL_TYPE_BLOB : MYSQL_TYPE_STRING;
+      if (DBIc_TRACE_LEVEL(imp_xxh) >= 2)
+        PerlIO_printf(DBIc_LOGPIO(imp_xxh),
+                      "   SCALAR sql_type %" IVdf " IS A STREAM\n", sql_type);
+    }
+    else if (!buffer_is_null) {
       buffer_type= sql_to_mysql_type(sql_type);
       switch (buffer_type) {
       case MYSQL_TYPE_TINY:
@@ -6457,8 +9787,14 @@ int mariadb_st_bind_ph(SV *sth, imp_sth_t *imp_sth, SV *param, SV *value,
                       "   SCALAR sql_type %"IVdf" IS A NULL VALUE", sql_type);
     }
 
-    /* Column was changed, force rebind */
-    imp_sth->has_been_bound = FALSE;
+    /* Client library keeps its own copy of MYSQL_BIND and reads only value,
+     * length and NULL indicator through buffer pointers at execute, so rebind
+     * is needed only when type or location of the buffer was changed */
+    if (imp_sth->bind[idx].buffer_type != buffer_type ||
+        imp_sth->bind[idx].buffer != buffer ||
+        imp_sth->bind[idx].buffer_length != buffer_length ||
+        !imp_sth->bind[idx].is_unsigned != !buffer_is_unsigned)
+      imp_sth->has_been_bound = FALSE;
 
     imp_sth->bind[idx].buffer_type= buffer_type;
     imp_sth->bind[idx].buffer= buffer;
@@ -6759,6 +10095,110 @@ SV *mariadb_db_last_insert_id(SV *dbh, imp_dbh_t *imp_dbh,
   return sv_2mortal(my_ulonglong2sv(imp_dbh->insertid));
 }
 
+#ifdef HAVE_ASYNC_STMT
+/*
+  Waits for socket events requested in status by non-blocking API, when
+  block is FALSE only checks them; returns events suitable for *_cont()
+  functions, 0 when no event occurred or negative errno on error
+*/
+static int mariadb_dr_socket_wait(MYSQL *sock, int fd, int status, bool block)
+{
+  dTHX;
+  struct timeval timeout;
+  struct timeval *timeout_ptr;
+  unsigned int timeout_ms;
+  fd_set rfds, wfds, efds;
+  int retval;
+
+  do
+  {
+    FD_ZERO(&rfds);
+    FD_ZERO(&wfds);
+    FD_ZERO(&efds);
+    if (status & MYSQL_WAIT_READ)
+      FD_SET(fd, &rfds);
+    if (status & MYSQL_WAIT_WRITE)
+      FD_SET(fd, &wfds);
+    if (status & MYSQL_WAIT_EXCEPT)
+      FD_SET(fd, &efds);
+
+    timeout_ptr = &timeout;
+    if (!block)
+    {
+      timeout.tv_sec = 0;
+      timeout.tv_usec = 0;
+    }
+    else if (status & MYSQL_WAIT_TIMEOUT)
+    {
+      timeout_ms = mysql_get_timeout_value_ms(sock);
+      timeout.tv_sec = timeout_ms / 1000;
+      timeout.tv_usec = (timeout_ms % 1000) * 1000;
+    }
+    else
+    {
+      timeout_ptr = NULL;
+    }
+
+    retval = select(fd+1, &rfds, &wfds, &efds, timeout_ptr);
+  } while (retval < 0 && errno == EINTR && block);
+
+  if (retval < 0)
+    return errno > 0 ? -errno : -EINVAL;
+
+  if (retval == 0)
+    return block ? MYSQL_WAIT_TIMEOUT : 0;
+
+  retval = 0;
+  if (FD_ISSET(fd, &rfds))
+    retval |= MYSQL_WAIT_READ;
+  if (FD_ISSET(fd, &wfds))
+    retval |= MYSQL_WAIT_WRITE;
+  if (FD_ISSET(fd, &efds))
+    retval |= MYSQL_WAIT_EXCEPT;
+  return retval;
+}
+
+/*
+  Continues asynchronous execution of server side prepared statement, after
+  execute finishes also stores its result set unless it is read later by
+  mysql_stmt_fetch(); without block returns 0 when socket is not ready yet,
+  1 when everything finished or negative errno on error
+*/
+static int mariadb_st_async_continue41(imp_dbh_t *imp_dbh, imp_sth_t *imp_sth, bool block)
+{
+  int status;
+
+  while (imp_sth->async_stmt_step != MARIADB_ASYNC_STMT_DONE)
+  {
+    if (imp_sth->async_stmt_status)
+    {
+      status = mariadb_dr_socket_wait(imp_dbh->pmysql, imp_dbh->sock_fd, imp_sth->async_stmt_status, block);
+      if (status <= 0)
+        return status;
+      if (imp_sth->async_stmt_step == MARIADB_ASYNC_STMT_EXECUTE)
+        imp_sth->async_stmt_status = mysql_stmt_execute_cont(&imp_sth->async_stmt_retval, imp_sth->stmt, status);
+      else
+        imp_sth->async_stmt_status = mysql_stmt_store_result_cont(&imp_sth->async_stmt_retval, imp_sth->stmt, status);
+      continue;
+    }
+
+    if (imp_sth->async_stmt_step == MARIADB_ASYNC_STMT_EXECUTE && !imp_sth->async_stmt_retval &&
+        !imp_sth->use_mysql_use_result && !imp_sth->cursor_prefetch && mysql_stmt_field_count(imp_sth->stmt) > 0)
+    {
+      imp_sth->async_stmt_step = MARIADB_ASYNC_STMT_STORE_RESULT;
+      imp_sth->async_stmt_status = mysql_stmt_store_result_start(&imp_sth->async_stmt_retval, imp_sth->stmt);
+    }
+    else
+    {
+      imp_sth->async_stmt_step = MARIADB_ASYNC_STMT_DONE;
+    }
+  }
+
+  return 1;
+}
+
+#endif
+
 my_ulonglong mariadb_db_async_result(SV* h, MYSQL_RES** resp)
 {
   dTHX;
@@ -6826,6 +10266,53 @@ my_ulonglong mariadb_db_async_result(SV* h, MYSQL_RES** resp)
     *resp = NULL;
   }
 
+#ifdef HAVE_ASYNC_STMT
+  if (htype == DBIt_ST)
+  {
+    D_imp_sth(h);
+    if (imp_sth->use_server_side_prepare)
+    {
+      int status = mariadb_st_async_continue41(dbh, imp_sth, TRUE);
+      if (status < 0)
+      {
+        mariadb_dr_do_error(h, CR_UNKNOWN_ERROR, SvPVX(sv_2mortal(newSVpvf("mariadb_async_result failed: %s", strerror(-status)))), "HY000");
+        return -1;
+      }
+
+      if (imp_sth->async_stmt_retval)
+      {
+        mariadb_dr_do_error(h, mysql_stmt_errno(imp_sth->stmt), mysql_stmt_error(imp_sth->stmt),
+                 mysql_stmt_sqlstate(imp_sth->stmt));
+        mysql_stmt_reset(imp_sth->stmt);
+        return -1;
+      }
+
+      retval = mariadb_st_internal_result41(h, imp_sth->stmt, resp, use_mysql_use_result, imp_sth->cursor_prefetch, TRUE);
+      if (retval == (my_ulonglong)-1)
+        return -1;
+
+      imp_sth->row_num = retval;
+      if (!*resp)
+      {
+        dbh->insertid = imp_sth->insertid = mysql_insert_id(svsock);
+        if (mysql_more_results(svsock))
+          DBIc_ACTIVE_on(imp_sth);
+      }
+      else
+      {
+        num_fields = mysql_num_fields(*resp);
+        DBIc_NUM_FIELDS(imp_sth) = (num_fields <= INT_MAX) ? num_fields : INT_MAX;
+        if (imp_sth->row_num)
+          DBIc_ACTIVE_on(imp_sth);
+        if (!fbuffer_matches_fields(imp_sth, mysql_fetch_fields(*resp), DBIc_NUM_FIELDS(imp_sth)))
+          imp_sth->done_desc = FALSE;
+      }
+      imp_sth->warning_count = mysql_warning_count(svsock);
+      return retval;
+    }
+  }
+#endif
+
   if (!mysql_read_query_result(svsock))
   {
     *resp = use_mysql_use_result ? mysql_use_result(svsock) : mysql_store_result(svsock);
@@ -6863,6 +10350,7 @@ my_ulonglong mariadb_db_async_result(SV* h, MYSQL_RES** resp)
           DBIc_NUM_FIELDS(imp_sth) = (num_fields <= INT_MAX) ? num_fields : INT_MAX;
           if (imp_sth->row_num)
             DBIc_ACTIVE_on(imp_sth);
+          imp_sth->done_desc = FALSE;
         }
       imp_sth->warning_count = mysql_warning_count(imp_dbh->pmysql);
     }
@@ -6935,7 +10423,20 @@ int mariadb_db_async_ready(SV* h)
 
   if(dbh->async_query_in_flight) {
       if (dbh->async_query_in_flight == imp_xxh) {
-          int retval = mariadb_dr_socket_ready(dbh->sock_fd);
+          int retval;
+#ifdef HAVE_ASYNC_STMT
+          if (htype == DBIt_ST) {
+              D_imp_sth(h);
+              if (imp_sth->use_server_side_prepare) {
+                  retval = mariadb_st_async_continue41(dbh, imp_sth, FALSE);
+                  if(retval < 0) {
+                      mariadb_dr_do_error(h, CR_UNKNOWN_ERROR, SvPVX(sv_2mortal(newSVpvf("mariadb_async_ready failed: %s", strerror(-retval)))), "HY000");
+                  }
+                  return retval;
+              }
+          }
+#endif
+          retval = mariadb_dr_socket_ready(dbh->sock_fd);
           if(retval < 0) {
               mariadb_dr_do_error(h, CR_UNKNOWN_ERROR, SvPVX(sv_2mortal(newSVpvf("mariadb_async_ready failed: %s", strerror(-retval)))), "HY000");
           }
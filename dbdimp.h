@@ -42,6 +42,10 @@
 #include <DBIXS.h>  /* installed by the DBI module */
 #include <stdint.h> /* For uint32_t */
 
+#ifdef __SSE2__
+#include <emmintrin.h> /* For escaping of parameters */
+#endif
+
 
 /*******************************************************************************
  * Standard MariaDB macros which are not defined in every MySQL/MariaDB client *
@@ -112,6 +116,9 @@
 #define SSize_t_MAX (SSize_t)(~(Size_t)0 >> 1)
 #endif
 
+/* Default maximal size of statement buffer kept by sth between executes */
+#define MARIADB_STATEMENT_BUFFER_MAX (1024*1024)
+
 /* _set_osfhnd() is copied from Perl source file win32.h */
 #ifdef _WIN32
 /* __pioinfo[] is exported only for msvcrt builds, not for UCRT builds */
@@ -368,6 +375,16 @@ PERL_STATIC_INLINE unsigned long mariadb_get_client_version(void)
 #define mysql_rollback(mysql) ((my_bool)(mysql_real_query((mysql), "ROLLBACK", 8)))
 #endif
 
+/* Bulk execution of prepared statement with array binding (COM_STMT_BULK_EXECUTE) is supported only by MariaDB Connector/C 3.0.2+ */
+#if defined(MARIADB_PACKAGE_VERSION) && defined(MARIADB_PACKAGE_VERSION_ID) && MARIADB_PACKAGE_VERSION_ID >= 30002 && defined(MARIADB_CLIENT_STMT_BULK_OPERATIONS)
+#define HAVE_BULK_EXECUTE
+#endif
+
+/* Non-blocking API (mysql_stmt_execute_start() and MYSQL_OPT_NONBLOCK) for asynchronous server side prepared statements is supported only by MariaDB clients */
+#if defined(MARIADB_BASE_VERSION) && defined(MYSQL_WAIT_READ)
+#define HAVE_ASYNC_STMT
+#endif
+
 /* MYSQL_SECURE_AUTH became a no-op from MySQL 5.7.5 and is removed from MySQL 8.0.3 */
 #if defined(MARIADB_BASE_VERSION) || MYSQL_VERSION_ID <= 50704
 #define HAVE_SECURE_AUTH
@@ -492,6 +509,36 @@ struct mariadb_list_entry {
   } STMT_END
 
 
+/* Server side prepared statement in imp_dbh->stmt_cache list */
+struct mariadb_stmt_cache_entry {
+    char *statement;
+    STRLEN statement_len;
+    MYSQL_STMT *stmt;
+};
+
+/* Representation of DATE, TIME, DATETIME and TIMESTAMP column values */
+enum mariadb_temporal_mode {
+    MARIADB_TEMPORAL_STRING,  /* string in the same format as sent by server */
+    MARIADB_TEMPORAL_EPOCH,   /* number of seconds since 1970-01-01 00:00:00 */
+    MARIADB_TEMPORAL_ARRAY    /* reference to array of date and time components */
+};
+
+/* Representation of DECIMAL column values */
+enum mariadb_decimal_mode {
+    MARIADB_DECIMAL_STRING,   /* string in the same format as sent by server */
+    MARIADB_DECIMAL_NV,       /* floating point number stored as NV */
+    MARIADB_DECIMAL_IV_SCALED /* integer multiplied by 10^scale stored as IV */
+};
+
+#ifdef HAVE_ASYNC_STMT
+enum mariadb_async_stmt_step {
+    MARIADB_ASYNC_STMT_EXECUTE,      /* mysql_stmt_execute_start() was called */
+    MARIADB_ASYNC_STMT_STORE_RESULT, /* mysql_stmt_store_result_start() was called */
+    MARIADB_ASYNC_STMT_DONE          /* Both execute and storing of result finished */
+};
+#endif
+
+
 /*
  *  This is our part of the driver handle. We receive the handle as
  *  an "SV*", say "drh", and receive a pointer to the structure below
@@ -547,7 +594,20 @@ struct imp_dbh_st {
     bool use_server_side_prepare;
     bool disable_fallback_for_server_prepare;
     bool use_multi_statements;
+    unsigned long cursor_prefetch; /* Rows fetched at once by server side cursor, 0 for no cursor */
+    STRLEN statement_buffer_max; /* Maximal size of statement buffer kept by sth between executes */
+    enum mariadb_temporal_mode temporal_mode; /* Representation of temporal column values */
+    enum mariadb_decimal_mode decimal_mode;   /* Representation of DECIMAL column values */
+    bool long_read_len_set;   /* LongReadLen was set explicitly, inherited by statements */
+    struct mariadb_list_entry *stmt_cache; /* List of cached server side prepared statements */
+    HV *stmt_cache_hv;                     /* Entries of stmt_cache list keyed by SQL statement */
+    unsigned int stmt_cache_size;          /* Maximal number of cached statements */
+    unsigned int stmt_cache_count;         /* Number of cached statements */
+    unsigned long server_max_allowed_packet; /* Cached value of server max_allowed_packet, 0 if unknown */
     void* async_query_in_flight;
+#ifdef HAVE_ASYNC_STMT
+    bool async_nonblock;   /* MYSQL_OPT_NONBLOCK was enabled on pmysql */
+#endif
     my_ulonglong insertid;
     struct {
 	    unsigned int auto_reconnects_ok;
@@ -561,10 +621,16 @@ struct imp_dbh_st {
  *  parameters.
  */
 typedef struct imp_sth_ph_st {
-    char* value;
+    SV* sv;         /* Private copy of bound value, shares buffer with bound SV when possible */
+    char* value;    /* Encoded value in buffer of sv, not allocated */
+    SV* stream;     /* Filehandle or code reference for mysql_stmt_send_long_data() */
     STRLEN len;
     int type;
     bool bound;
+    bool is_int;          /* value is decimal representation of int_val in int_buf, sv is not used */
+    bool int_is_unsigned; /* int_val is UV                            */
+    IV int_val;           /* Bound integer value                      */
+    char int_buf[24];     /* Decimal representation of int_val        */
 } imp_sth_ph_t;
 
 /*
@@ -577,6 +643,7 @@ typedef union numeric_val_u {
     my_ulonglong llval;
     float fval;
     double dval;
+    MYSQL_TIME time;
 } numeric_val_t;
 
 /*
@@ -598,10 +665,51 @@ typedef struct imp_sth_fbh_st {
     my_bool        is_null;
     my_bool        error;
     char           *data;
+    bool           data_allocated;  /* data is not part of imp_sth->fbh allocation */
     numeric_val_t  numeric_val;
     bool           is_utf8;
+    unsigned int   decimals;  /* Fractional digits of temporal or DECIMAL column */
+    bool           is_decimal;
 } imp_sth_fbh_t;
 
+/*
+ *  The mariadb_st_describe computes for text protocol result sets
+ *  conversion of every column value to Perl scalar.
+ */
+enum mariadb_conv {
+    MARIADB_CONV_NULL,      /* always undef */
+    MARIADB_CONV_INTEGER,   /* signed integer stored as IV */
+    MARIADB_CONV_UNSIGNED,  /* unsigned integer stored as UV */
+    MARIADB_CONV_DOUBLE,    /* floating point number stored as NV */
+    MARIADB_CONV_UTF8,      /* UTF-8 decoded string */
+    MARIADB_CONV_BINARY,    /* string of octets */
+    MARIADB_CONV_DECIMAL,   /* DECIMAL in representation by decimal_mode */
+    MARIADB_CONV_TEMPORAL   /* DATE, TIME, DATETIME or TIMESTAMP */
+};
+
+
+/*
+ *  Column names used as keys of hashes created by fetchrow_hashref and
+ *  fetchall_hashref, computed once per result set.
+ */
+typedef struct mariadb_hash_keys_st {
+    char *attrib;       /* Attribute from which names were taken, e.g. NAME_lc */
+    AV *names;          /* Column names, owns key strings          */
+    unsigned int count; /* Number of columns                       */
+    const char **key;   /* Column name                             */
+    I32 *klen;          /* Length of name, negative for UTF-8 name */
+    U32 *hash;          /* Precomputed hash of name                */
+    SV **row;           /* Values of currently fetched row         */
+} mariadb_hash_keys_t;
+
+/*
+ *  Placeholder of client side prepared statement found by
+ *  parse_placeholders, offset is after leading whitespaces of statement
+ */
+typedef struct imp_sth_placeholder_st {
+    STRLEN offset;  /* Offset of '?' in statement              */
+    bool limit;     /* Placeholder is a part of LIMIT clause   */
+} imp_sth_placeholder_t;
 
 typedef struct imp_sth_fbind_st {
    unsigned long   * length;
@@ -629,11 +737,16 @@ struct imp_sth_st {
     MYSQL_BIND       *buffer;
     imp_sth_phb_t    *fbind;
     imp_sth_fbh_t    *fbh;
+    int              fbh_num_fields; /* number of fields in fbh and buffer */
     bool             has_been_bound;
     bool use_server_side_prepare;  /* server side prepare statements? */
     bool disable_fallback_for_server_prepare;
 
     MYSQL_RES* result;       /* result                                 */
+    MYSQL_ROW current_row;   /* last row returned by mysql_fetch_row() */
+    enum mariadb_conv *conv; /* conversions of text protocol columns   */
+    IV *bind_col_type;       /* TYPE of columns bound by bind_col      */
+    unsigned int bind_col_count; /* number of elements in bind_col_type */
     my_ulonglong currow;  /* number of current row                  */
     my_ulonglong row_num;         /* total number of rows                   */
 
@@ -643,13 +756,30 @@ struct imp_sth_st {
     my_ulonglong insertid; /* ID of auto insert                      */
     unsigned int warning_count;  /* Number of warnings after execute()     */
     imp_sth_ph_t* params; /* Pointer to parameter array             */
+    imp_sth_placeholder_t *placeholders; /* Placeholders of client side prepare */
+    int num_placeholders; /* Number of elements in placeholders     */
+    bool placeholders_parsed;   /* placeholders were already found */
+    bool placeholders_comments; /* bind_comment_placeholders used for finding them */
     AV* av_attr[AV_ATTRIB_LAST];/*  For caching array attributes        */
+    mariadb_hash_keys_t *hash_keys; /* Cached keys for fetchrow_hashref */
     bool  use_mysql_use_result;  /*  TRUE if execute should use     */
                           /* mysql_use_result rather than           */
                           /* mysql_store_result */
+    unsigned long cursor_prefetch; /* Rows fetched at once by server side cursor, 0 for no cursor */
+    char *statement_buffer; /* Buffer for statement with parameters of client side prepare */
+    STRLEN statement_buffer_size; /* Size of statement_buffer */
+    STRLEN statement_buffer_max;  /* Maximal size of statement_buffer kept between executes */
+    enum mariadb_temporal_mode temporal_mode; /* Representation of temporal column values */
+    enum mariadb_decimal_mode decimal_mode;   /* Representation of DECIMAL column values */
+    bool long_read_len_set;   /* LongReadLen was set explicitly, BLOB/TEXT values may be truncated */
 
     bool is_async;
     bool async_result;
+#ifdef HAVE_ASYNC_STMT
+    enum mariadb_async_stmt_step async_stmt_step; /* Current step of asynchronous execution */
+    int async_stmt_status; /* Wait status of current step, 0 when the step finished */
+    int async_stmt_retval; /* Return value of current step */
+#endif
 };
 
 
@@ -680,6 +810,7 @@ struct imp_sth_st {
 #define dbd_st_FETCH_attrib	mariadb_st_FETCH_attrib
 #define dbd_st_last_insert_id	mariadb_st_last_insert_id
 #define dbd_bind_ph		mariadb_st_bind_ph
+#define dbd_st_bind_col		mariadb_st_bind_col
 
 #include <dbd_xsh.h>
 
@@ -709,6 +840,11 @@ SV* mariadb_dr_my_ulonglong2sv(pTHX_ my_ulonglong val);
 void    mariadb_dr_do_error (SV* h, unsigned int rc, const char *what, const char *sqlstate);
 
 bool mariadb_st_more_results(SV*, imp_sth_t*);
+SV* mariadb_st_fetch_chunk(SV*, imp_sth_t*, IV);
+SV* mariadb_st_fetch_columns(SV*, imp_sth_t*, IV, bool);
+SV* mariadb_st_fetchrow_hashref(SV*, imp_sth_t*, const char*);
+SV* mariadb_st_fetchall_hashref(SV*, imp_sth_t*, SV*);
+int mariadb_st_execute_for_fetch(SV*, imp_sth_t*, SV*, SV*, IV*, IV*, IV*);
 
 AV* mariadb_db_type_info_all(void);
 SV* mariadb_db_quote(SV*, SV*, SV*);
@@ -44,6 +44,9 @@ sub driver{
 	DBD::MariaDB::db->install_method('mariadb_async_ready');
 	DBD::MariaDB::st->install_method('mariadb_async_result');
 	DBD::MariaDB::st->install_method('mariadb_async_ready');
+	DBD::MariaDB::st->install_method('mariadb_fetch_chunk');
+	DBD::MariaDB::st->install_method('mariadb_fetch_columns');
+	DBD::MariaDB::st->install_method('mariadb_blob_read_to_file');
 
         # for older DBI versions register our last_insert_id statement method
         if (not eval { DBI->VERSION(1.642) }) {
@@ -936,6 +939,17 @@ BEGIN {
     }
 }
 
+# Generic XS selectall_arrayref from DBI's Driver.xst fetches rows one by one
+# and copies each of them, so use DBI's Perl implementation which calls our
+# fetchall_arrayref. Assigned at runtime, after XS code was bootstrapped.
+{
+    no warnings qw(once redefine);
+    *selectall_arrayref = sub {
+        my $dbh = shift;
+        return $dbh->SUPER::selectall_arrayref(@_);
+    };
+}
+
 
 # ====== STATEMENT ======
 package # hide from PAUSE
@@ -943,22 +957,11 @@ package # hide from PAUSE
 
 use strict;
 
+# fetchrow_hashref and fetchall_hashref are implemented in XS, they read
+# column names after the first row was fetched, so also for asynchronous
+# queries.
 BEGIN {
-    my @needs_async_result = qw/fetchrow_hashref fetchall_hashref/;
-    my @needs_async_check = qw/bind_param_array bind_col bind_columns execute_for_fetch/;
-
-    foreach my $method (@needs_async_result) {
-        no strict 'refs';
-
-        my $super = "SUPER::$method";
-        *$method = sub {
-            my $sth = shift;
-            if(defined $sth->mariadb_async_ready) {
-                return unless $sth->mariadb_async_result;
-            }
-            return $sth->$super(@_);
-        };
-    }
+    my @needs_async_check = qw/bind_param_array bind_col bind_columns/;
 
     foreach my $method (@needs_async_check) {
         no strict 'refs';
@@ -972,4 +975,46 @@ BEGIN {
     }
 }
 
+# Execute tuples in batches via MariaDB bulk execution when it is supported by
+# client, server and statement, otherwise DBI executes tuples one by one.
+sub execute_for_fetch {
+    my ($sth, $fetch_tuple_sub, $tuple_status) = @_;
+    return unless $sth->func('_async_check');
+    my @ret = DBD::MariaDB::st::_execute_for_fetch($sth, $fetch_tuple_sub, $tuple_status);
+    return $sth->SUPER::execute_for_fetch($fetch_tuple_sub, $tuple_status) unless @ret;
+    return undef unless defined $ret[0];
+    my ($tuples, $rc_total, $err_count) = @ret;
+    return $sth->set_err($DBI::stderr, "executing $tuples generated $err_count errors")
+        if $err_count;
+    $tuples ||= '0E0';
+    return $tuples unless wantarray;
+    return ($tuples, $rc_total);
+}
+
+# Copy value of column from the current row to filehandle in blocks read by
+# blob_read, so the whole value does not have to be in Perl memory.
+sub mariadb_blob_read_to_file {
+    my ($sth, $field, $fh, $blocksize) = @_;
+    $blocksize ||= 65536;
+    my ($len, $buf) = (0, '');
+    while (defined $sth->blob_read($field, $len, $blocksize, \$buf)) {
+        print {$fh} $buf or return $sth->set_err($DBI::stderr, "Cannot write to filehandle: $!");
+        $len += length $buf;
+    }
+    return undef if $sth->err;
+    return $len;
+}
+
+# Fetch all rows in one XS call which stores values directly into the
+# returned arrays. Slices are handled by DBI. Assigned at runtime, after
+# generic XS fetchall_arrayref from DBI's Driver.xst was bootstrapped.
+{
+    no warnings qw(once redefine);
+    *fetchall_arrayref = sub {
+        my ($sth, $slice, $max_rows) = @_;
+        return $sth->SUPER::fetchall_arrayref($slice, $max_rows) if defined $slice;
+        return DBD::MariaDB::st::mariadb_fetch_chunk($sth, $max_rows);
+    };
+}
+
 1;
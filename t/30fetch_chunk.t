@@ -0,0 +1,51 @@
+use strict;
+use warnings;
+
+use Test::More;
+use Test::Deep;
+use DBI;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password);
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+    { RaiseError => 1, PrintError => 0 });
+
+plan tests => 2 * 2 * 12 + 1;
+
+$dbh->do('CREATE TEMPORARY TABLE t(id INT, name VARCHAR(20), value DOUBLE)');
+$dbh->do('INSERT INTO t VALUES(?, ?, ?)', undef, $_, "name$_", $_ / 2) foreach 1..10;
+$dbh->do('INSERT INTO t VALUES(11, NULL, NULL)');
+
+my @expected = ((map { [ $_, "name$_", $_ / 2 ] } 1..10), [ 11, undef, undef ]);
+
+for my $server_prepare (0, 1) {
+  for my $use_result (0, 1) {
+    note "Testing with server_prepare=$server_prepare and use_result=$use_result";
+    local $dbh->{mariadb_server_prepare} = $server_prepare;
+    local $dbh->{mariadb_use_result} = $use_result;
+
+    my $sth = $dbh->prepare('SELECT id, name, value FROM t ORDER BY id');
+    ok($sth->execute());
+    my $rows = $sth->mariadb_fetch_chunk(4);
+    cmp_deeply($rows, [ @expected[0..3] ], 'first chunk');
+    $rows = $sth->mariadb_fetch_chunk(4);
+    cmp_deeply($rows, [ @expected[4..7] ], 'second chunk');
+    $rows = $sth->mariadb_fetch_chunk(4);
+    cmp_deeply($rows, [ @expected[8..10] ], 'last chunk');
+    ok(!$sth->{Active}, 'statement is not active');
+    is($sth->mariadb_fetch_chunk(4), undef, 'undef after all rows were fetched');
+
+    ok($sth->execute());
+    cmp_deeply($sth->mariadb_fetch_chunk(), \@expected, 'all rows without max_rows');
+
+    isnt($rows->[0], $rows->[1], 'rows are distinct arrays');
+
+    cmp_deeply($dbh->selectall_arrayref('SELECT id, name, value FROM t ORDER BY id'), \@expected, 'selectall_arrayref');
+    cmp_deeply($dbh->selectall_arrayref('SELECT id, name, value FROM t ORDER BY id', { MaxRows => 2 }), [ @expected[0..1] ], 'selectall_arrayref with MaxRows');
+    cmp_deeply($dbh->selectall_arrayref('SELECT id, name FROM t WHERE id < ? ORDER BY id', { Slice => {} }, 3), [ { id => 1, name => 'name1' }, { id => 2, name => 'name2' } ], 'selectall_arrayref with Slice');
+  }
+}
+
+ok($dbh->disconnect());
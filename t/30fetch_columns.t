@@ -0,0 +1,53 @@
+use strict;
+use warnings;
+
+use Test::More;
+use Test::Deep;
+use DBI;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password);
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+    { RaiseError => 1, PrintError => 0 });
+
+plan tests => 2 * 2 * 10 + 1;
+
+$dbh->do('CREATE TEMPORARY TABLE t(id INT, name VARCHAR(20), value DOUBLE, num INT)');
+$dbh->do('INSERT INTO t VALUES(?, ?, ?, ?)', undef, $_, "name$_", $_ / 2, -$_) foreach 1..10;
+$dbh->do('INSERT INTO t VALUES(11, NULL, NULL, -11)');
+
+my @ids = (1..11);
+my @names = ((map { "name$_" } 1..10), undef);
+my @values = ((map { $_ / 2 } 1..10), undef);
+my @nums = map { -$_ } 1..11;
+
+for my $server_prepare (0, 1) {
+  for my $use_result (0, 1) {
+    note "Testing with server_prepare=$server_prepare and use_result=$use_result";
+    local $dbh->{mariadb_server_prepare} = $server_prepare;
+    local $dbh->{mariadb_use_result} = $use_result;
+
+    my $sth = $dbh->prepare('SELECT id, name, value, num FROM t ORDER BY id');
+    ok($sth->execute());
+    my $columns = $sth->mariadb_fetch_columns(4);
+    cmp_deeply($columns, [ [ @ids[0..3] ], [ @names[0..3] ], [ @values[0..3] ], [ @nums[0..3] ] ], 'first chunk');
+    $columns = $sth->mariadb_fetch_columns(8);
+    cmp_deeply($columns, [ [ @ids[4..10] ], [ @names[4..10] ], [ @values[4..10] ], [ @nums[4..10] ] ], 'last chunk');
+    ok(!$sth->{Active}, 'statement is not active');
+    is($sth->mariadb_fetch_columns(4), undef, 'undef after all rows were fetched');
+
+    ok($sth->execute());
+    $columns = $sth->mariadb_fetch_columns(undef, 1);
+    is(ref $columns->[0], '', 'integer column is packed');
+    cmp_deeply([ unpack('j*', $columns->[0]), $columns->[1], $columns->[2], unpack('j*', $columns->[3]) ], [ @ids, \@names, \@values, @nums ], 'packed columns, column with NULL is array');
+
+    $sth = $dbh->prepare('SELECT id, value FROM t WHERE id <= 10 ORDER BY id');
+    ok($sth->execute());
+    $columns = $sth->mariadb_fetch_columns(undef, 1);
+    cmp_deeply([ unpack('j*', $columns->[0]), unpack('d*', $columns->[1]) ], [ @ids[0..9], @values[0..9] ], 'packed integer and double columns');
+  }
+}
+
+ok($dbh->disconnect());
@@ -0,0 +1,73 @@
+use strict;
+use warnings;
+
+use Test::More;
+use Test::Deep;
+use DBI;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password);
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+    { RaiseError => 1, PrintError => 0 });
+
+plan tests => 2 * 12 + 1;
+
+ok($dbh->do('CREATE TEMPORARY TABLE t(Id INT, Name VARCHAR(20), Grp INT)'));
+$dbh->do('INSERT INTO t VALUES(?, ?, ?)', undef, $_, "name$_", $_ % 2) foreach 1..4;
+
+for my $server_prepare (0, 1) {
+  note "Testing with server_prepare=$server_prepare";
+  local $dbh->{mariadb_server_prepare} = $server_prepare;
+
+  my $sth = $dbh->prepare('SELECT Id, Name, Grp FROM t ORDER BY Id');
+  $sth->execute();
+  cmp_deeply($sth->fetchrow_hashref(), { Id => 1, Name => 'name1', Grp => 1 }, 'fetchrow_hashref uses NAME');
+  cmp_deeply($sth->fetchrow_hashref('NAME_lc'), { id => 2, name => 'name2', grp => 0 }, 'fetchrow_hashref uses NAME_lc');
+  {
+    local $sth->{FetchHashKeyName} = 'NAME_uc';
+    cmp_deeply($sth->fetchrow_hashref(), { ID => 3, NAME => 'name3', GRP => 1 }, 'fetchrow_hashref uses FetchHashKeyName');
+  }
+  cmp_deeply($sth->fetchrow_hashref(), { Id => 4, Name => 'name4', Grp => 0 }, 'fetchrow_hashref uses NAME again');
+  is($sth->fetchrow_hashref(), undef, 'fetchrow_hashref returns undef after last row');
+
+  my $name;
+  $sth->execute();
+  $sth->bind_col(2, \$name);
+  cmp_deeply($sth->fetchrow_hashref(), { Id => 1, Name => 'name1', Grp => 1 }, 'fetchrow_hashref with bound column');
+  SKIP: {
+    skip 'DBI 1.611 is required for passing bind_col to driver', 1 unless eval { DBI->VERSION(1.611) };
+    is($name, 'name1', 'bound column is updated by fetchrow_hashref');
+  }
+  $sth->finish();
+
+  $sth = $dbh->prepare('SELECT Id, Name, Grp FROM t ORDER BY Id');
+  $sth->execute();
+  cmp_deeply($sth->fetchall_hashref('Id'), {
+    1 => { Id => 1, Name => 'name1', Grp => 1 },
+    2 => { Id => 2, Name => 'name2', Grp => 0 },
+    3 => { Id => 3, Name => 'name3', Grp => 1 },
+    4 => { Id => 4, Name => 'name4', Grp => 0 },
+  }, 'fetchall_hashref with key name');
+
+  $sth->execute();
+  cmp_deeply($sth->fetchall_hashref([ 3, 'Id' ]), {
+    0 => { 2 => { Id => 2, Name => 'name2', Grp => 0 }, 4 => { Id => 4, Name => 'name4', Grp => 0 } },
+    1 => { 1 => { Id => 1, Name => 'name1', Grp => 1 }, 3 => { Id => 3, Name => 'name3', Grp => 1 } },
+  }, 'fetchall_hashref with column number and key name');
+
+  $sth->execute();
+  {
+    local $sth->{FetchHashKeyName} = 'NAME_lc';
+    cmp_deeply($sth->fetchall_hashref('grp'), {
+      0 => { id => 4, name => 'name4', grp => 0 },
+      1 => { id => 3, name => 'name3', grp => 1 },
+    }, 'fetchall_hashref with FetchHashKeyName keeps last row');
+  }
+
+  $sth->execute();
+  ok(!defined eval { $sth->fetchall_hashref('unknown') }, 'fetchall_hashref with unknown key fails');
+  like($@, qr/Field 'unknown' does not exist/, 'error message');
+  $sth->finish();
+}
@@ -0,0 +1,39 @@
+use strict;
+use warnings;
+
+use B qw(svref_2object SVf_IOK SVf_NOK SVf_POK);
+use Test::More;
+use DBI;
+use vars qw($test_dsn $test_user $test_password);
+use lib 't', '.';
+require 'lib.pl';
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+  { RaiseError => 1, PrintError => 0 });
+
+plan skip_all => 'DBI 1.611 is required for passing bind_col TYPE to driver' unless eval { DBI->VERSION(1.611) };
+
+plan tests => 2*11+2;
+
+ok($dbh->do('CREATE TEMPORARY TABLE t40bindcol (id INT, str VARCHAR(20), amount DECIMAL(10,2), big DECIMAL(65,2))'), 'create table');
+ok($dbh->do(q{INSERT INTO t40bindcol VALUES (1, '42', '12.50', '123456789012345678901234567890.25'), (2, 'text', NULL, NULL)}), 'insert');
+
+for my $server_prepare (0, 1) {
+    my $note = $server_prepare ? ' (server side prepare)' : '';
+    my $sth = $dbh->prepare('SELECT id, str, amount, big FROM t40bindcol ORDER BY id', { mariadb_server_prepare => $server_prepare });
+    ok($sth->execute(), "execute$note");
+
+    my ($id, $str, $amount, $big);
+    ok($sth->bind_col(1, \$id), "bind id$note");
+    ok($sth->bind_col(2, \$str, { TYPE => DBI::SQL_INTEGER() }), "bind str as integer$note");
+    ok($sth->bind_col(3, \$amount, { TYPE => DBI::SQL_DOUBLE() }), "bind amount as double$note");
+    ok($sth->bind_col(4, \$big, { TYPE => DBI::SQL_DECIMAL() }), "bind big as decimal$note");
+
+    ok($sth->fetch(), "fetch$note");
+    ok($str == 42 && (svref_2object(\$str)->FLAGS & SVf_IOK) && !(svref_2object(\$str)->FLAGS & SVf_POK), "string column bound as integer is stored as IV$note");
+    ok($amount == 12.5 && (svref_2object(\$amount)->FLAGS & SVf_NOK) && !(svref_2object(\$amount)->FLAGS & SVf_POK), "decimal column bound as double is stored as NV$note");
+    is($big, '123456789012345678901234567890.25', "decimal column bound as decimal keeps precision$note");
+
+    ok($sth->fetch(), "fetch$note");
+    ok($id == 2 && $str eq 'text' && !defined $amount, "values which are not numbers are kept$note");
+}
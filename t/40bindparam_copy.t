@@ -0,0 +1,47 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use vars qw($test_dsn $test_user $test_password);
+use lib 't', '.';
+require 'lib.pl';
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+  { RaiseError => 1, PrintError => 0 });
+
+plan tests => 2 * 9 + 1;
+
+for my $server_prepare (0, 1) {
+  note "Testing with server_prepare=$server_prepare";
+  local $dbh->{mariadb_server_prepare} = $server_prepare;
+
+  ok($dbh->do('CREATE TEMPORARY TABLE t40bindparamcopy (id INT, txt LONGTEXT, data LONGBLOB)'), 'create table');
+
+  my $sth = $dbh->prepare('INSERT INTO t40bindparamcopy VALUES (?, ?, ?)');
+
+  my $txt = "caf\xe9 " . ('x' x 100000);
+  my $data = "\x00\xff" x 50000;
+  my $expected_txt = $txt;
+  my $expected_data = $data;
+
+  ok($sth->bind_param(1, 1), 'bind id');
+  ok($sth->bind_param(2, $txt), 'bind text');
+  ok($sth->bind_param(3, $data, DBI::SQL_BLOB), 'bind blob');
+  ok(!utf8::is_utf8($txt), 'bound variable was not upgraded');
+
+  my $values = $sth->{ParamValues};
+  is_deeply([ @{$values}{sort keys %{$values}} ], [ 1, $expected_txt, $expected_data ], 'ParamValues');
+
+  # Bound values are copied, changes after bind_param must not be visible
+  substr($txt, 0, 4, 'CAFE');
+  $data = 'changed';
+  ok($sth->execute(), 'execute');
+
+  my $row = $dbh->selectrow_arrayref('SELECT txt, data FROM t40bindparamcopy WHERE id = 1');
+  ok($row->[0] eq $expected_txt && $row->[1] eq $expected_data, 'values from bind time were inserted');
+
+  ok($dbh->do('DROP TEMPORARY TABLE t40bindparamcopy'), 'drop table');
+}
+
+ok($dbh->disconnect());
@@ -0,0 +1,42 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use Config;
+
+use vars qw($test_dsn $test_user $test_password);
+use lib 't', '.';
+require 'lib.pl';
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password, { RaiseError => 1, PrintError => 0, AutoCommit => 0 });
+
+my @values = (0, 1, -1, 42, -2147483648, 4294967295);
+push @values, ('-9223372036854775808' + 0, 9223372036854775807, 18446744073709551615) if $Config{ivsize} >= 8;
+
+plan tests => 2 * (3 * @values + 3) + 1;
+
+for my $server_prepare (0, 1) {
+    $dbh->{mariadb_server_prepare} = $server_prepare;
+    my $mode = $server_prepare ? 'server side prepare' : 'client side prepare';
+
+    ok $dbh->do('CREATE TEMPORARY TABLE t(id INT, num DECIMAL(20,0), str VARCHAR(30))'), "create table with $mode";
+
+    my $sth = $dbh->prepare('INSERT INTO t(id, num, str) VALUES(?, ?, ?)');
+    for my $id (0..$#values) {
+        my $value = $values[$id];
+        $sth->bind_param(1, $id, DBI::SQL_INTEGER());
+        $sth->bind_param(2, $value, DBI::SQL_BIGINT());
+        $sth->bind_param(3, $value);
+        ok $sth->execute(), "insert $value with $mode";
+        is_deeply $sth->{ParamValues}, { 0 => $id, 1 => $value, 2 => $value }, "ParamValues for $value with $mode";
+    }
+
+    my $rows = $dbh->selectall_arrayref('SELECT num, str FROM t ORDER BY id LIMIT ?', undef, scalar @values);
+    is scalar @{$rows}, scalar @values, "integer bound after LIMIT with $mode";
+    ok $rows->[$_][0] eq "$values[$_]" && $rows->[$_][1] eq "$values[$_]", "value $values[$_] with $mode" foreach 0..$#values;
+
+    ok $dbh->do('DROP TEMPORARY TABLE t'), "drop table with $mode";
+}
+
+ok $dbh->disconnect();
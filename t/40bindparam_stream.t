@@ -0,0 +1,47 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use vars qw($test_dsn $test_user $test_password);
+use lib 't', '.';
+require 'lib.pl';
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+  { RaiseError => 1, PrintError => 0, mariadb_server_prepare => 1, mariadb_server_prepare_disable_fallback => 1 });
+
+plan tests => 15;
+
+ok($dbh->do('CREATE TEMPORARY TABLE t40bindparamstream (id INT, txt LONGTEXT, data LONGBLOB)'), 'create table');
+
+my $data = join '', map { chr($_ % 256) } 0..(3*1024*1024);
+my $txt = "\x{263A}" x 100000;
+
+my $sth = $dbh->prepare('INSERT INTO t40bindparamstream VALUES (?, ?, ?)');
+
+open my $fh, '<', \$data or die;
+binmode $fh;
+my @chunks = ($txt, $txt);
+ok($sth->bind_param(1, 1), 'bind id');
+ok($sth->bind_param(2, sub { shift @chunks }, { mariadb_stream => 1 }), 'bind code reference');
+ok($sth->bind_param(3, $fh, { TYPE => DBI::SQL_BLOB, mariadb_stream => 1 }), 'bind filehandle');
+ok($sth->execute(), 'execute');
+close $fh;
+
+my $row = $dbh->selectrow_arrayref('SELECT txt, data FROM t40bindparamstream WHERE id = 1');
+ok($row->[0] eq $txt x 2, 'text from code reference');
+ok($row->[1] eq $data, 'data from filehandle');
+
+ok($sth->bind_param(1, 2), 'bind id');
+ok($sth->bind_param(2, sub { return }, { mariadb_stream => 1 }), 'bind empty stream');
+ok($sth->bind_param(3, undef), 'bind NULL');
+ok($sth->execute(), 'execute');
+$row = $dbh->selectrow_arrayref('SELECT txt, data FROM t40bindparamstream WHERE id = 2');
+is_deeply($row, [ '', undef ], 'empty stream and NULL');
+
+ok(!eval { $sth->bind_param(2, 'string', { mariadb_stream => 1 }) }, 'string cannot be streamed');
+
+my $sth2 = $dbh->prepare('INSERT INTO t40bindparamstream VALUES (?, ?, ?)', { mariadb_server_prepare => 0 });
+ok(!eval { $sth2->bind_param(2, sub { return }, { mariadb_stream => 1 }) }, 'stream needs server side prepare');
+
+ok($dbh->disconnect(), 'disconnect');
@@ -0,0 +1,83 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use vars qw($test_dsn $test_user $test_password);
+use lib 't', '.';
+require 'lib.pl';
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+  { RaiseError => 1, PrintError => 0 });
+
+plan tests => 2*17+1;
+
+my $data = join '', map { chr($_ % 256) } 0..(1024*1024);
+my $txt = "\x{263A}" x 1000;
+
+ok($dbh->do('CREATE TEMPORARY TABLE t40blobread (id INT, data LONGBLOB, txt LONGTEXT)'), 'create table');
+
+for my $server_prepare (0, 1) {
+    my $note = $server_prepare ? ' (server side prepare)' : '';
+    $dbh->do('DELETE FROM t40blobread');
+    $dbh->do('INSERT INTO t40blobread VALUES (?, ?, ?)', undef, 1, $data, $txt);
+    $dbh->do('INSERT INTO t40blobread VALUES (?, ?, ?)', undef, 2, undef, undef);
+
+    my $sth = $dbh->prepare('SELECT data, txt FROM t40blobread ORDER BY id', { mariadb_server_prepare => $server_prepare });
+    ok($sth->execute(), "execute$note");
+    my $row = $sth->fetchrow_arrayref();
+    ok($row->[0] eq $data, "whole value without LongTruncOk$note");
+
+    my $buf;
+    is($sth->blob_read(0, 10, 5, \$buf), substr($data, 10, 5), "blob_read slice$note");
+    is($sth->blob_read(0, 100, 5, \$buf, 5), substr($data, 10, 5) . substr($data, 100, 5), "blob_read with destination offset$note");
+    is($sth->blob_read(0, length($data) - 3, 100, \$buf), substr($data, -3), "blob_read at end of value$note");
+    ok(!defined $sth->blob_read(0, length($data), 100, \$buf) && !$sth->err, "blob_read after end of value$note");
+
+    my $content = '';
+    open my $fh, '>', \$content or die;
+    is($sth->mariadb_blob_read_to_file(0, $fh, 4096), length($data), "mariadb_blob_read_to_file$note");
+    close $fh;
+    ok($content eq $data, "mariadb_blob_read_to_file content$note");
+
+    ok(!eval { $sth->blob_read(2, 0, 10, \$buf) }, "blob_read invalid field$note");
+
+    $row = $sth->fetchrow_arrayref();
+    ok(!defined $sth->blob_read(0, 0, 10, \$buf) && !$sth->err, "blob_read NULL value$note");
+    $sth->finish();
+
+    $sth->{LongTruncOk} = 1;
+    $sth->execute();
+    $row = $sth->fetchrow_arrayref();
+    ok($row->[0] eq $data, "default LongReadLen does not truncate$note");
+    $sth->finish();
+
+    $sth->{LongReadLen} = 100;
+    ok($sth->execute(), "execute with LongTruncOk$note");
+    $row = $sth->fetchrow_arrayref();
+    ok($row->[0] eq substr($data, 0, 100), "value truncated to LongReadLen$note");
+    is($row->[1], "\x{263A}" x 33, "text truncated on character boundary$note");
+
+    $buf = '';
+    my $offset = 0;
+    while (defined $sth->blob_read(0, $offset, 65536, \$buf, $offset)) {
+        $offset = length $buf;
+    }
+    ok($buf eq $data, "whole value read by blob_read$note");
+
+    $buf = '';
+    $offset = 0;
+    while (defined $sth->blob_read(1, $offset, 7, \$buf, $offset)) {
+        $offset = length $buf;
+    }
+    ok(utf8::decode($buf) && $buf eq $txt, "whole text read by blob_read$note");
+    $sth->finish();
+
+    $sth->{LongReadLen} = 0;
+    $sth->execute();
+    $row = $sth->fetchrow_arrayref();
+    is_deeply($row, [ '', '' ], "LongReadLen 0$note");
+    $sth->finish();
+}
+
+ok($dbh->disconnect(), 'disconnect');
@@ -0,0 +1,49 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use vars qw($test_dsn $test_user $test_password);
+use lib 't', '.';
+require 'lib.pl';
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+  { RaiseError => 1, PrintError => 0 });
+
+plan tests => 2*7+4;
+
+ok($dbh->do('CREATE TEMPORARY TABLE t40decimal (id INT, amount DECIMAL(18,4), whole DECIMAL(10,0), big DECIMAL(65,2))'), 'create table');
+ok($dbh->do(q{INSERT INTO t40decimal VALUES (1, '-12.3400', 42, '123456789012345678901234567890.25'), (2, '0.0001', -7, '1.50'), (3, NULL, NULL, NULL)}), 'insert');
+
+my $sql = 'SELECT amount, whole, big FROM t40decimal ORDER BY id';
+
+for my $server_prepare (0, 1) {
+    my $note = $server_prepare ? ' (server side prepare)' : '';
+
+    my $sth = $dbh->prepare($sql, { mariadb_server_prepare => $server_prepare });
+    is($sth->{mariadb_decimal_mode}, 'string', "default mode$note");
+    $sth->execute();
+    is_deeply($sth->fetchall_arrayref(), [ [ '-12.3400', '42', '123456789012345678901234567890.25' ], [ '0.0001', '-7', '1.50' ], [ undef, undef, undef ] ], "string mode$note");
+
+    $sth = $dbh->prepare($sql, { mariadb_server_prepare => $server_prepare, mariadb_decimal_mode => 'nv' });
+    $sth->execute();
+    my $rows = $sth->fetchall_arrayref();
+    ok($rows->[0]->[0] == -12.34 && $rows->[0]->[1] == 42 && $rows->[1]->[0] == 0.0001 && $rows->[1]->[2] == 1.5, "nv mode$note");
+
+    $sth = $dbh->prepare($sql, { mariadb_server_prepare => $server_prepare, mariadb_decimal_mode => 'iv_scaled' });
+    $sth->execute();
+    is_deeply($sth->fetchall_arrayref(), [ [ -123400, 42, '123456789012345678901234567890.25' ], [ 1, -7, 150 ], [ undef, undef, undef ] ], "iv_scaled mode$note");
+    is_deeply($sth->{SCALE}, [ 4, 0, 2 ], "scale of columns$note");
+
+    $sth->{mariadb_decimal_mode} = 'string';
+    $sth->execute();
+    is_deeply($sth->fetchrow_arrayref(), [ '-12.3400', '42', '123456789012345678901234567890.25' ], "string mode after change$note");
+    $sth->finish();
+
+    ok(!eval { $dbh->prepare($sql, { mariadb_server_prepare => $server_prepare, mariadb_decimal_mode => 'invalid' }) }, "invalid mode$note");
+}
+
+$dbh->{mariadb_decimal_mode} = 'iv_scaled';
+is($dbh->selectrow_arrayref('SELECT amount FROM t40decimal WHERE id = 1')->[0], -123400, 'mode inherited from database handle');
+
+ok($dbh->disconnect(), 'disconnect');
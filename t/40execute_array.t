@@ -0,0 +1,82 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use lib 't', '.';
+require 'lib.pl';
+
+use vars qw($test_dsn $test_user $test_password);
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+    { RaiseError => 1, PrintError => 0 });
+
+plan tests => 2 * 20 + 1;
+
+for my $server_prepare (0, 1) {
+  note "Testing with server_prepare=$server_prepare";
+  local $dbh->{mariadb_server_prepare} = $server_prepare;
+
+  $dbh->do('CREATE TEMPORARY TABLE t40executearray(id INT PRIMARY KEY, name VARCHAR(300), data BLOB) ENGINE=InnoDB');
+  $dbh->begin_work();
+
+  my @ids = (1..5000);
+  my @names = map { $_ % 10 ? "name\x{263A}$_" . ('x' x 200) : undef } @ids;
+  my @data = map { pack('N', $_) . "\0\xff" } @ids;
+
+  my $sth = $dbh->prepare('INSERT INTO t40executearray VALUES(?, ?, ?)');
+  $sth->bind_param_array(1, \@ids);
+  $sth->bind_param_array(2, \@names);
+  $sth->bind_param_array(3, \@data, DBI::SQL_BLOB);
+  my @status;
+  my ($tuples, $rows) = $sth->execute_array({ ArrayTupleStatus => \@status });
+  is($tuples, 5000, 'all tuples executed');
+  is($rows, 5000, 'all rows inserted');
+  is(scalar @status, 5000, 'status for all tuples');
+  ok(!(grep { ref $_ } @status), 'no tuple failed');
+
+  is($dbh->selectrow_array('SELECT COUNT(*) FROM t40executearray'), 5000, 'rows are in table');
+  my $row = $dbh->selectrow_arrayref('SELECT id, name, data FROM t40executearray WHERE id = 1234');
+  is_deeply($row, [ 1234, $names[1233], $data[1233] ], 'row values');
+  $row = $dbh->selectrow_arrayref('SELECT id, name FROM t40executearray WHERE id = 1230');
+  is_deeply($row, [ 1230, undef ], 'NULL value');
+
+  my $src = $dbh->prepare('SELECT id + 10000, name, data FROM t40executearray WHERE id <= 100 ORDER BY id', { mariadb_server_prepare => 0 });
+  $src->execute();
+  $tuples = $sth->execute_for_fetch(sub { $src->fetchrow_arrayref() });
+  is($tuples, 100, 'execute_for_fetch from fetchrow_arrayref');
+  is($dbh->selectrow_array('SELECT COUNT(*) FROM t40executearray WHERE id > 10000'), 100, 'fetched rows are in table');
+
+  @status = ();
+  $tuples = eval { $sth->execute_array({ ArrayTupleStatus => \@status }, [ 20001, 1, 20002 ], 'dup', undef) };
+  ok(!defined $tuples, 'execute_array with duplicate key failed');
+  ok($sth->err, 'error is set');
+  is(scalar @status, 3, 'status for all tuples');
+  ok(ref $status[1], 'status of duplicate tuple is error');
+  is($dbh->selectrow_array('SELECT COUNT(*) FROM t40executearray WHERE id = 1'), 1, 'duplicate was not inserted');
+
+  $sth = $dbh->prepare('INSERT INTO t40executearray (id, name) VALUE (?, ?) ON DUPLICATE KEY UPDATE name = VALUES(name)');
+  $tuples = $sth->execute_array({}, [ 1, 2, 30001 ], [ 'one', 'two', 'new' ]);
+  is($tuples, 3, 'execute_array with ON DUPLICATE KEY UPDATE');
+  is_deeply($dbh->selectcol_arrayref('SELECT name FROM t40executearray WHERE id IN (1, 2, 30001) ORDER BY id'), [ 'one', 'two', 'new' ], 'rows were updated and inserted');
+
+  $sth = $dbh->prepare('UPDATE t40executearray SET name = ? WHERE id = ?');
+  @status = ();
+  ($tuples, $rows) = $sth->execute_array({ ArrayTupleStatus => \@status }, [ 'a', 'b', 'c' ], [ 3, 4, 99999 ]);
+  is($tuples, 3, 'execute_array with UPDATE');
+  is($rows, 2, 'two rows were updated');
+  $dbh->commit();
+
+  SKIP: {
+    skip 'bulk execution of server side prepared statement', 2 if $server_prepare;
+    $sth = $dbh->prepare('INSERT INTO t40executearray (id, name) VALUES (?, ?)');
+    @status = ();
+    $tuples = eval { $sth->execute_array({ ArrayTupleStatus => \@status }, [ 40001, 1, 40002 ], 'dup') };
+    ok(!ref $status[0] && ref $status[1] && !ref $status[2], 'with AutoCommit only duplicate tuple failed');
+    is($dbh->selectrow_array('SELECT COUNT(*) FROM t40executearray WHERE id > 40000'), 2, 'other tuples were inserted');
+  }
+
+  $dbh->do('DROP TEMPORARY TABLE t40executearray');
+}
+
+ok($dbh->disconnect());
@@ -0,0 +1,58 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use lib 't', '.';
+require 'lib.pl';
+use vars qw($test_dsn $test_user $test_password);
+
+$test_dsn .= ";mariadb_server_prepare=1;mariadb_server_prepare_disable_fallback=1";
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 0, PrintError => 0 });
+plan skip_all => 'Async mode is not supported for Embedded server' if $dbh->{mariadb_hostinfo} eq 'Embedded';
+
+$dbh->do('CREATE TEMPORARY TABLE t40async (id INT AUTO_INCREMENT PRIMARY KEY, name VARCHAR(20))') or die $dbh->errstr;
+
+my $insert = $dbh->prepare('INSERT INTO t40async (name) VALUES (?)', { mariadb_async => 1 });
+plan skip_all => 'Async option is not supported with server side prepare by client library' if !$insert && $dbh->errstr =~ /Async option not supported with server side prepare/;
+plan tests => 25;
+
+ok($insert, 'prepare async insert') or die $dbh->errstr;
+
+ok($insert->execute('a'), 'execute async insert');
+ok($insert->{Active}, 'insert is active');
+1 until $insert->mariadb_async_ready() or $insert->err;
+ok(!$insert->err, 'async ready without error');
+is($insert->mariadb_async_result(), 1, 'one row inserted');
+ok(!$insert->{Active}, 'insert is not active');
+is($insert->last_insert_id(), 1, 'insert id of first row');
+
+ok($insert->execute('b'), 'execute async insert again');
+is($insert->mariadb_async_result(), 1, 'one row inserted without waiting for ready');
+is($dbh->last_insert_id(undef, undef, undef, undef), 2, 'insert id of second row');
+
+my $sth = $dbh->prepare('SELECT id, name, SLEEP(0.1) FROM t40async WHERE id >= ? ORDER BY id', { mariadb_async => 1 });
+ok($sth, 'prepare async select');
+ok($sth->execute(1), 'execute async select');
+1 until $sth->mariadb_async_ready() or $sth->err;
+is($sth->mariadb_async_result(), 2, 'two rows selected');
+is_deeply($sth->fetchall_arrayref(), [ [ 1, 'a', 0 ], [ 2, 'b', 0 ] ], 'rows are fetched');
+
+ok($sth->execute(2), 'execute async select again');
+is_deeply($sth->fetchall_arrayref(), [ [ 2, 'b', 0 ] ], 'fetch waits for async result');
+
+my $dup = $dbh->prepare('INSERT INTO t40async (id, name) VALUES (?, ?)', { mariadb_async => 1 });
+ok($dup, 'prepare async insert with id');
+ok($dup->execute(1, 'x'), 'execute async insert of duplicate id');
+ok(!defined $dup->mariadb_async_result(), 'async result of duplicate id fails');
+like($dup->errstr, qr/Duplicate/, 'error message about duplicate id');
+
+is_deeply($dbh->selectall_arrayref('SELECT name FROM t40async ORDER BY id'), [ [ 'a' ], [ 'b' ] ], 'connection is usable after async error');
+
+ok(!defined $dbh->do('SELECT 1', { mariadb_async => 1 }), 'async do is not server side prepared');
+like($dbh->errstr, qr/Async option not supported with server side prepare/, 'error message about async do');
+
+ok($dbh->do('DROP TEMPORARY TABLE t40async'), 'drop table');
+ok($dbh->disconnect(), 'disconnect');
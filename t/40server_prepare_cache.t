@@ -0,0 +1,63 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use lib 't', '.';
+require 'lib.pl';
+use vars qw($test_dsn $test_user $test_password);
+
+$test_dsn.= ";mariadb_server_prepare=1;mariadb_server_prepare_disable_fallback=1";
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0, mariadb_stmt_cache_size => 2 });
+
+plan tests => 22;
+
+sub prepare_count {
+  my (undef, $count) = $dbh->selectrow_array("SHOW SESSION STATUS LIKE 'Com_stmt_prepare'", { mariadb_server_prepare => 0 });
+  return $count;
+}
+
+is($dbh->{mariadb_stmt_cache_size}, 2, 'cache size from connect');
+
+ok($dbh->do("CREATE TEMPORARY TABLE t40serverpreparecache (id INT)"), 'create table');
+
+my $count = prepare_count();
+my $sth = $dbh->prepare("INSERT INTO t40serverpreparecache VALUES (?)");
+ok($sth->execute(1), 'execute insert');
+undef $sth;
+is(prepare_count(), $count+1, 'statement was prepared');
+
+$sth = $dbh->prepare("INSERT INTO t40serverpreparecache VALUES (?)");
+ok($sth->execute(2), 'execute cached insert');
+undef $sth;
+is(prepare_count(), $count+1, 'cached statement was reused by prepare');
+
+ok($dbh->do("INSERT INTO t40serverpreparecache VALUES (?)", undef, 3), 'do with cached statement');
+is(prepare_count(), $count+1, 'cached statement was reused by do');
+
+my $select = "SELECT id FROM t40serverpreparecache WHERE id >= ? ORDER BY id";
+is_deeply($dbh->selectcol_arrayref($select, undef, 2), [2, 3], 'select');
+is_deeply($dbh->selectcol_arrayref($select, undef, 3), [3], 'select with cached statement');
+is(prepare_count(), $count+2, 'select was prepared only once');
+
+$sth = $dbh->prepare($select);
+my $sth2 = $dbh->prepare($select);
+is(prepare_count(), $count+3, 'statement used by other handle is not shared');
+ok($sth->execute(1), 'execute first handle');
+ok($sth2->execute(2), 'execute second handle');
+is_deeply($sth->fetchall_arrayref(), [[1], [2], [3]], 'fetch first handle');
+is_deeply($sth2->fetchall_arrayref(), [[2], [3]], 'fetch second handle');
+undef $sth;
+undef $sth2;
+
+$dbh->{mariadb_stmt_cache_size} = 0;
+is($dbh->{mariadb_stmt_cache_size}, 0, 'cache disabled');
+$count = prepare_count();
+is_deeply($dbh->selectcol_arrayref($select, undef, 3), [3], 'select without cache');
+is_deeply($dbh->selectcol_arrayref($select, undef, 3), [3], 'select again without cache');
+is(prepare_count(), $count+2, 'statements were prepared again');
+
+ok($dbh->do("DROP TEMPORARY TABLE t40serverpreparecache"), 'drop table');
+ok($dbh->disconnect(), 'disconnect');
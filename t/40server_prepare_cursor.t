@@ -0,0 +1,51 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use lib 't', '.';
+require 'lib.pl';
+use vars qw($test_dsn $test_user $test_password);
+
+$test_dsn .= ";mariadb_server_prepare=1;mariadb_server_prepare_disable_fallback=1;mariadb_cursor_prefetch=2";
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0 });
+
+plan tests => 17;
+
+is($dbh->{mariadb_cursor_prefetch}, 2, 'mariadb_cursor_prefetch is set from DSN');
+
+ok($dbh->do('CREATE TEMPORARY TABLE t40cursor (id INT, data LONGTEXT)'), 'create table');
+ok($dbh->do('INSERT INTO t40cursor VALUES ' . join ', ', map { "($_, REPEAT('x', $_ * 100))" } 1..5), 'insert rows');
+
+my $sth = $dbh->prepare('SELECT id, data FROM t40cursor ORDER BY id');
+is($sth->{mariadb_cursor_prefetch}, 2, 'mariadb_cursor_prefetch is inherited from dbh');
+ok($sth->execute(), 'execute with cursor');
+is($sth->rows, -1, 'number of rows is unknown before fetching');
+is_deeply($sth->fetchall_arrayref(), [ map { [ $_, 'x' x ($_ * 100) ] } 1..5 ], 'all rows are fetched from cursor');
+is($sth->rows, 5, 'number of rows is known after fetching all rows');
+
+# With cursors more statements can be fetched on one connection at the same time
+my $sth1 = $dbh->prepare('SELECT id FROM t40cursor ORDER BY id');
+my $sth2 = $dbh->prepare('SELECT id FROM t40cursor ORDER BY id DESC');
+ok($sth1->execute(), 'execute first statement');
+ok($sth2->execute(), 'execute second statement');
+my @ids;
+while (my ($id1) = $sth1->fetchrow_array()) {
+  my ($id2) = $sth2->fetchrow_array();
+  push @ids, [ $id1, $id2 ];
+}
+is_deeply(\@ids, [ map { [ $_, 6 - $_ ] } 1..5 ], 'rows of both statements are interleaved');
+
+$sth = $dbh->prepare('SELECT id FROM t40cursor ORDER BY id', { mariadb_cursor_prefetch => 0 });
+is($sth->{mariadb_cursor_prefetch}, 0, 'mariadb_cursor_prefetch is disabled by prepare attribute');
+ok($sth->execute(), 'execute without cursor');
+is($sth->rows, 5, 'number of rows is known without cursor');
+$sth->finish();
+
+$sth->{mariadb_cursor_prefetch} = 3;
+ok($sth->execute(), 'execute after enabling cursor');
+is_deeply($sth->fetchall_arrayref(), [ map { [ $_ ] } 1..5 ], 'rows are fetched from cursor');
+
+ok($dbh->disconnect(), 'disconnect');
@@ -0,0 +1,41 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use lib 't', '.';
+require 'lib.pl';
+use vars qw($test_dsn $test_user $test_password);
+
+$test_dsn .= ";mariadb_server_prepare=1;mariadb_server_prepare_disable_fallback=1";
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0 });
+
+my $text = 'abc' x 100;
+my @rows = (
+    [ 1, 10, 'a', 0.5 ],
+    [ 2, 20, 'bb', 1.5 ],
+    [ 3, undef, undef, undef ],
+    [ 4, 4294967295, $text, -2.25 ],
+    [ 5, -7, $text, 3 ],
+    [ 6, undef, 'c', 0.25 ],
+    [ 7, 18, '', undef ],
+);
+
+plan tests => @rows + 3;
+
+ok($dbh->do('CREATE TEMPORARY TABLE t40rebind (id INT, num BIGINT, str TEXT, dbl DOUBLE)'), 'create table');
+
+my $sth = $dbh->prepare('INSERT INTO t40rebind VALUES (?, ?, ?, ?)');
+foreach my $row (@rows) {
+    $sth->bind_param(1, $row->[0], DBI::SQL_INTEGER());
+    $sth->bind_param(2, $row->[1], DBI::SQL_BIGINT());
+    $sth->bind_param(3, $row->[2]);
+    $sth->bind_param(4, $row->[3], DBI::SQL_DOUBLE());
+    ok($sth->execute(), "insert row $row->[0] with rebound parameters");
+}
+
+is_deeply($dbh->selectall_arrayref('SELECT id, num, str, dbl FROM t40rebind ORDER BY id'), \@rows, 'all rows were inserted with correct values');
+
+ok($dbh->disconnect(), 'disconnect');
@@ -0,0 +1,39 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use lib 't', '.';
+require 'lib.pl';
+use vars qw($test_dsn $test_user $test_password);
+
+$test_dsn .= ";mariadb_server_prepare=1;mariadb_server_prepare_disable_fallback=1";
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0 });
+
+my @rows = map { [ $_, ($_ % 3 ? 'x' x ($_ * 700) : undef), $_ / 4 ] } 1..10;
+
+plan tests => 2 * @rows + 12;
+
+ok($dbh->do('CREATE TEMPORARY TABLE t40reexecute (id INT, data TEXT, num DOUBLE)'), 'create table');
+my $insert = $dbh->prepare('INSERT INTO t40reexecute VALUES (?, ?, ?)');
+ok($insert->execute(@{$_}), "insert row $_->[0]") foreach @rows;
+
+my $sth = $dbh->prepare('SELECT id, data, num FROM t40reexecute WHERE id = ?');
+foreach my $row (reverse(@rows), @rows[0..2]) {
+    $sth->execute($row->[0]);
+    is_deeply($sth->fetchall_arrayref(), [ $row ], "row $row->[0] is fetched by re-executed statement");
+}
+
+my %hash;
+ok($sth->execute(3), 'execute before fetching into hash');
+ok($sth->bind_columns(\@hash{qw(id data num)}), 'bind columns');
+ok($sth->fetch(), 'fetch into bound columns');
+is_deeply(\%hash, { id => 3, data => undef, num => 0.75 }, 'bound columns contain row 3');
+
+ok($sth->execute(2), 'execute again with bound columns');
+ok($sth->fetch(), 'fetch into bound columns again');
+is_deeply(\%hash, { id => 2, data => 'x' x 1400, num => 0.5 }, 'bound columns contain row 2');
+
+ok($dbh->disconnect(), 'disconnect');
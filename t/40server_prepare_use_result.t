@@ -0,0 +1,33 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use lib 't', '.';
+require 'lib.pl';
+use vars qw($test_dsn $test_user $test_password);
+
+$test_dsn .= ";mariadb_server_prepare=1;mariadb_server_prepare_disable_fallback=1;mariadb_use_result=1";
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+                      { RaiseError => 1, PrintError => 0 });
+
+plan tests => 12;
+
+ok($dbh->do('CREATE TEMPORARY TABLE t40useresult (id INT, data LONGBLOB)'), 'create table');
+ok($dbh->do('INSERT INTO t40useresult VALUES ' . join ', ', map { "($_, REPEAT('x', $_ * 1000))" } 1..5), 'insert rows');
+
+my $sth = $dbh->prepare('SELECT id, data FROM t40useresult ORDER BY id');
+ok($sth->{mariadb_use_result}, 'mariadb_use_result is inherited from dbh');
+is($sth->execute(), -1, 'execute returns unknown number of rows');
+is($sth->rows, -1, 'number of rows is unknown before fetching');
+is_deeply($sth->fetchall_arrayref(), [ map { [ $_, 'x' x ($_ * 1000) ] } 1..5 ], 'all rows with growing values are fetched');
+is($sth->rows, 5, 'number of rows is known after fetching all rows');
+ok(!$sth->{Active}, 'statement is not active after fetching all rows');
+
+ok($sth->execute(), 'execute again');
+is_deeply($sth->fetchrow_arrayref(), [ 1, 'x' x 1000 ], 'fetch first row');
+$sth->finish();
+is_deeply($dbh->selectrow_arrayref('SELECT COUNT(*) FROM t40useresult', { mariadb_use_result => 0 }), [ 5 ], 'connection can be used after finish of partially fetched statement');
+
+ok($dbh->disconnect(), 'disconnect');
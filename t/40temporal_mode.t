@@ -0,0 +1,73 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+use vars qw($test_dsn $test_user $test_password);
+use lib 't', '.';
+require 'lib.pl';
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+  { RaiseError => 1, PrintError => 0 });
+
+if ($dbh->{mariadb_serverversion} < 50604) {
+    plan skip_all => 'Fractional seconds require MySQL 5.6.4';
+}
+
+plan tests => 2*7+5;
+
+# Allow zero dates
+$dbh->do(q{SET SESSION sql_mode = ''});
+ok($dbh->do('CREATE TEMPORARY TABLE t40temporal (d DATE, t TIME, dt DATETIME, dt3 DATETIME(3), ts TIMESTAMP NULL, t6 TIME(6))'), 'create table');
+ok($dbh->do(q{INSERT INTO t40temporal VALUES ('2019-12-31', '-838:59:59', '1969-12-31 23:59:59', '2000-02-29 12:34:56.789', '2038-01-19 03:14:07', '-00:00:01.500000')}), 'insert');
+ok($dbh->do(q{INSERT INTO t40temporal VALUES (NULL, '00:00:00', '0000-00-00 00:00:00', NULL, NULL, NULL)}), 'insert');
+ok($dbh->do(q{INSERT INTO t40temporal VALUES ('2024-01-01', '12:00:00', '2024-01-01 00:00:00', '2024-01-01 00:00:00', '2024-01-01 00:00:00', '00:00:00')}), 'insert midnight');
+
+my @string = (
+  [ '2019-12-31', '-838:59:59', '1969-12-31 23:59:59', '2000-02-29 12:34:56.789', '2038-01-19 03:14:07', '-00:00:01.500000' ],
+  [ '2024-01-01', '12:00:00', '2024-01-01 00:00:00', '2024-01-01 00:00:00.000', '2024-01-01 00:00:00', '00:00:00.000000' ],
+  [ undef, '00:00:00', '0000-00-00 00:00:00', undef, undef, undef ],
+);
+my @epoch = (
+  [ 1577750400, -(838*3600+59*60+59), -1, 951827696.789, 2147483647, -1.5 ],
+  [ 1704067200, 43200, 1704067200, 1704067200, 1704067200, 0 ],
+  [ undef, 0, undef, undef, undef, undef ],
+);
+my @array = (
+  [ [2019, 12, 31, 0, 0, 0, 0], [0, 0, 0, -838, -59, -59, 0], [1969, 12, 31, 23, 59, 59, 0], [2000, 2, 29, 12, 34, 56, 789000000], [2038, 1, 19, 3, 14, 7, 0], [0, 0, 0, 0, 0, -1, -500000000] ],
+  [ [2024, 1, 1, 0, 0, 0, 0], [0, 0, 0, 12, 0, 0, 0], [2024, 1, 1, 0, 0, 0, 0], [2024, 1, 1, 0, 0, 0, 0], [2024, 1, 1, 0, 0, 0, 0], [0, 0, 0, 0, 0, 0, 0] ],
+  [ undef, [0, 0, 0, 0, 0, 0, 0], [0, 0, 0, 0, 0, 0, 0], undef, undef, undef ],
+);
+
+for my $server_prepare (0, 1) {
+    my $note = $server_prepare ? ' (server side prepare)' : '';
+    my $sql = 'SELECT d, t, dt, dt3, ts, t6 FROM t40temporal ORDER BY d IS NULL, d';
+
+    my $sth = $dbh->prepare($sql, { mariadb_server_prepare => $server_prepare });
+    is($sth->{mariadb_temporal_mode}, 'string', "default mode$note");
+    $sth->execute();
+    is_deeply($sth->fetchall_arrayref(), \@string, "string mode$note");
+
+    $sth = $dbh->prepare($sql, { mariadb_server_prepare => $server_prepare, mariadb_temporal_mode => 'epoch' });
+    $sth->execute();
+    my $rows = $sth->fetchall_arrayref();
+    $rows->[0]->[3] = sprintf('%.3f', $rows->[0]->[3]);
+    is_deeply($rows, [ [ @{$epoch[0]}[0..2], '951827696.789', @{$epoch[0]}[4..5] ], @epoch[1..2] ], "epoch mode$note");
+
+    $sth = $dbh->prepare($sql, { mariadb_server_prepare => $server_prepare, mariadb_temporal_mode => 'array' });
+    $sth->execute();
+    is_deeply($sth->fetchall_arrayref(), \@array, "array mode$note");
+
+    $sth->{mariadb_temporal_mode} = 'string';
+    is($sth->{mariadb_temporal_mode}, 'string', "mode changed on statement handle$note");
+    $sth->execute();
+    is_deeply($sth->fetchrow_arrayref(), $string[0], "string mode after change$note");
+    $sth->finish();
+
+    ok(!eval { $dbh->prepare($sql, { mariadb_server_prepare => $server_prepare, mariadb_temporal_mode => 'invalid' }) }, "invalid mode$note");
+}
+
+$dbh->{mariadb_temporal_mode} = 'epoch';
+is($dbh->selectrow_arrayref('SELECT d FROM t40temporal WHERE d IS NOT NULL ORDER BY d')->[0], 1577750400, 'mode inherited from database handle');
+
+ok($dbh->disconnect(), 'disconnect');
@@ -0,0 +1,40 @@
+use strict;
+use warnings;
+
+use DBI;
+use Test::More;
+use vars qw($test_dsn $test_user $test_password);
+use lib 't', '.';
+require 'lib.pl';
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password,
+  { RaiseError => 1, PrintError => 0, mariadb_server_prepare => 1, mariadb_server_prepare_disable_fallback => 1 });
+
+my @sizes = (0, 1, 10, 5, 1000, 999, 1001, 3000, 10, 70000, 100, 200000, 1);
+
+plan tests => 3 + 3*@sizes;
+
+ok($dbh->do('CREATE TEMPORARY TABLE t41blobssizes (id INT, txt TEXT, data LONGBLOB, name VARCHAR(300) CHARACTER SET utf8mb4)'), 'create table');
+
+my $insert = $dbh->prepare('INSERT INTO t41blobssizes VALUES (?, ?, ?, ?)');
+my @rows;
+for my $id (0..$#sizes) {
+    my $txt = join '', map { chr(0x100 + ($id + $_) % 512) } 1..($sizes[$id] % 20000);
+    my $data = join '', map { chr(($id * 7 + $_) % 256) } 1..$sizes[-$id-1];
+    my $name = join '', map { chr(0x1F600 + ($id + $_) % 64) } 1..($sizes[$id] % 301);
+    $insert->execute($id, $txt, $data, $name);
+    push @rows, [ $txt, $data, $name ];
+}
+
+# Values of growing and shrinking sizes in one result set must not be mixed
+# with parts of values from previous rows kept in reused buffers
+my $sth = $dbh->prepare('SELECT txt, data, name FROM t41blobssizes ORDER BY id');
+ok($sth->execute(), 'execute');
+for my $id (0..$#sizes) {
+    my $row = $sth->fetchrow_arrayref();
+    ok($row->[0] eq $rows[$id]->[0], "text of row $id");
+    ok($row->[1] eq $rows[$id]->[1], "data of row $id");
+    ok($row->[2] eq $rows[$id]->[2], "name of row $id");
+}
+
+ok($dbh->disconnect(), 'disconnect');
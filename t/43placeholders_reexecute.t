@@ -0,0 +1,33 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+
+use vars qw($test_dsn $test_user $test_password);
+use lib 't', '.';
+require 'lib.pl';
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password, { RaiseError => 1, PrintError => 0, AutoCommit => 0, mariadb_server_prepare => 0 });
+
+plan tests => 19;
+
+ok $dbh->do('CREATE TEMPORARY TABLE t(id INT, name VARCHAR(20))');
+ok my $insert = $dbh->prepare("  INSERT INTO t(id, name) VALUES (?, CONCAT(?, '?', \"?\")) /* ? */");
+ok $insert->execute($_, "n$_") foreach 1..5;
+is_deeply $dbh->selectall_arrayref('SELECT id, name FROM t ORDER BY id'), [ map { [ $_, "n$_??" ] } 1..5 ], 'placeholders in strings and comment are not replaced';
+
+ok my $sth = $dbh->prepare('SELECT id FROM t WHERE id > ? ORDER BY id LIMIT ?, ?');
+ok $sth->execute(1, 0, 2);
+is_deeply $sth->fetchall_arrayref(), [ [2], [3] ], 'first execute';
+ok $sth->execute(2, 1, 1);
+is_deeply $sth->fetchall_arrayref(), [ [4] ], 'second execute with different values';
+
+ok $sth = $dbh->prepare("SELECT id FROM t WHERE id = ? -- ?\n");
+ok $sth->execute(3);
+is_deeply $sth->fetchall_arrayref(), [ [3] ], 'placeholder in comment is ignored';
+$dbh->{mariadb_bind_comment_placeholders} = 1;
+ok $sth->execute(3);
+is_deeply $sth->fetchall_arrayref(), [ [3] ], 'execute after change of mariadb_bind_comment_placeholders';
+
+ok $dbh->disconnect;
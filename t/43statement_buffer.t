@@ -0,0 +1,33 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+
+use vars qw($test_dsn $test_user $test_password);
+use lib 't', '.';
+require 'lib.pl';
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password, { RaiseError => 1, PrintError => 0, AutoCommit => 0, mariadb_server_prepare => 0, mariadb_statement_buffer_max => 1000 });
+
+my @values = ('a', 'b' x 2000, 'c' x 10, undef, 'd' x 500, "'" x 600);
+
+plan tests => 7 + 2 * @values;
+
+is $dbh->{mariadb_statement_buffer_max}, 1000, 'mariadb_statement_buffer_max is set on dbh';
+ok $dbh->do('CREATE TEMPORARY TABLE t(id INT, value TEXT)');
+
+my $sth = $dbh->prepare('INSERT INTO t(id, value) VALUES(?, ?)');
+is $sth->{mariadb_statement_buffer_max}, 1000, 'mariadb_statement_buffer_max is inherited from dbh';
+
+ok $sth->execute($_, $values[$_]), "insert value $_" foreach 0..$#values;
+$sth->{mariadb_statement_buffer_max} = 0;
+is $sth->{mariadb_statement_buffer_max}, 0, 'mariadb_statement_buffer_max is changed on sth';
+ok $sth->execute($_ + @values, $values[$_]), "insert value $_ again" foreach 0..$#values;
+
+$sth = $dbh->prepare('SELECT value FROM t WHERE id = ?', { mariadb_statement_buffer_max => 10 });
+is $sth->{mariadb_statement_buffer_max}, 10, 'mariadb_statement_buffer_max is set by prepare';
+
+is_deeply $dbh->selectcol_arrayref('SELECT value FROM t ORDER BY id'), [ @values, @values ], 'all values were inserted';
+
+ok $dbh->disconnect();
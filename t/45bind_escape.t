@@ -0,0 +1,51 @@
+use strict;
+use warnings;
+
+use Test::More;
+use DBI;
+
+use vars qw($test_dsn $test_user $test_password);
+use lib 't', '.';
+require 'lib.pl';
+
+my $dbh = DbiTestConnect($test_dsn, $test_user, $test_password, { RaiseError => 1, PrintError => 0, AutoCommit => 0, mariadb_server_prepare => 0 });
+
+my $special = qq(\0\n\r\\'"\032);
+my @strings = (
+    '',
+    $special,
+    'plain string without special characters',
+    ('x' x 15) . $special . ('y' x 17),
+    join('', map { "$_$special" } 1..20),
+    "\x{263A} '\x{10437}' \\ \x{E9}" x 10,
+);
+my $bytes = join '', map { chr } 0..255;
+
+my $no_backslash = ($dbh->{mariadb_serverversion} >= 50001);
+
+plan tests => 2 + ($no_backslash ? 2 * (2 * @strings + 2) + 1 : 2 * @strings + 2);
+
+ok $dbh->do('CREATE TEMPORARY TABLE t(id INT, str TEXT CHARACTER SET utf8mb4, bin BLOB)');
+
+foreach my $mode ('', ($no_backslash ? 'NO_BACKSLASH_ESCAPES' : ())) {
+    ok $dbh->do("SET sql_mode = '$mode'") if $mode;
+    $dbh->do('DELETE FROM t');
+
+    my $sth = $dbh->prepare('INSERT INTO t(id, str, bin) VALUES(?, ?, ?)');
+    foreach my $id (0..$#strings) {
+        $sth->bind_param(1, $id);
+        $sth->bind_param(2, $strings[$id]);
+        $sth->bind_param(3, $bytes x $id, DBI::SQL_BINARY());
+        ok $sth->execute(), "insert string $id" . ($mode ? " with $mode" : '');
+    }
+
+    my $rows = $dbh->selectall_arrayref('SELECT id, str, bin FROM t ORDER BY id');
+    is scalar @{$rows}, scalar @strings, 'all rows were inserted' . ($mode ? " with $mode" : '');
+    foreach my $row (@{$rows}) {
+        ok $row->[1] eq $strings[$row->[0]] && $row->[2] eq $bytes x $row->[0], "string $row->[0] was not changed" . ($mode ? " with $mode" : '');
+    }
+
+    ok $dbh->selectrow_array('SELECT COUNT(*) FROM t WHERE str = ?', undef, $special) == 1, 'string with special characters is found' . ($mode ? " with $mode" : '');
+}
+
+ok $dbh->disconnect();